@@ -52,6 +52,7 @@
 #endif
 
 #include "dc_schedd.h"
+#include "param_handle.h"
 
 using std::vector;
 using std::string;
@@ -382,6 +383,8 @@ void CollectorDaemon::Init()
 	// install command handlers for updates
 	daemonCore->Register_CommandWithPayload(UPDATE_STARTD_AD,"UPDATE_STARTD_AD",
 		receive_update,"receive_update",ADVERTISE_STARTD_PERM);
+	daemonCore->Register_CommandWithPayload(UPDATE_STARTD_ADS_BATCHED,"UPDATE_STARTD_ADS_BATCHED",
+		receive_batched_update,"receive_batched_update",ADVERTISE_STARTD_PERM);
 	daemonCore->Register_CommandWithPayload(MERGE_STARTD_AD,"MERGE_STARTD_AD",
 		receive_update,"receive_update",NEGOTIATOR);
 	daemonCore->Register_CommandWithPayload(UPDATE_SCHEDD_AD,"UPDATE_SCHEDD_AD",
@@ -1322,6 +1325,59 @@ int CollectorDaemon::receive_update(int command, Stream* sock)
 	return TRUE;
 }
 
+// A batch of startd ads, each ad is collected as if it had arrived
+// in its own UPDATE_STARTD_AD message.
+int CollectorDaemon::receive_batched_update(int command, Stream* sock)
+{
+	std::vector<CollectorRecord*> records;
+	_condor_auto_accum_runtime<collector_runtime_probe> rt(CollectorEngine_receive_update_runtime);
+
+	condor_sockaddr from = ((Sock*)sock)->peer_addr();
+
+	int num_ads = collector.collectBatch(command, (Sock*)sock, from, records);
+	if (num_ads < 0) {
+		daemonCore->dc_stats.AddToAnyProbe("UpdatesReceived", 1);
+		return FALSE;
+	}
+	daemonCore->dc_stats.AddToAnyProbe("UpdatesReceived", num_ads);
+	dprintf(D_FULLDEBUG, "Collected %d of %d startd ads from batched update\n",
+			(int)records.size(), num_ads);
+
+	// the plugins expect a flat ad, so give them a copy when the slot ad
+	// is chained to a shared base ad.
+	bool want_flat_ad = offline_plugin_.enabled();
+#if defined(UNIX) && !defined(DARWIN)
+	want_flat_ad = want_flat_ad || ! CollectorPluginManager::getPlugins().empty();
+#endif
+
+	for (auto * record : records) {
+		ClassAd flat_ad;
+		ClassAd * plugin_ad = record->m_publicAd;
+		if (record->m_sharedAd && want_flat_ad) {
+			flat_ad.CopyFromChain(*record->m_publicAd);
+			plugin_ad = &flat_ad;
+		}
+
+		offline_plugin_.update(UPDATE_STARTD_AD, *plugin_ad);
+
+#if defined(UNIX) && !defined(DARWIN)
+		CollectorPluginManager::Update(UPDATE_STARTD_AD, *plugin_ad);
+#endif
+
+		forward_classad_to_view_collector(UPDATE_STARTD_AD,
+										  ATTR_MY_TYPE,
+										  record->m_pvtAd);
+	}
+
+	if( sock->type() == Stream::reli_sock ) {
+			// stash this socket for future updates...
+		return stashSocket( (ReliSock *)sock );
+	}
+
+	// let daemon core clean up the socket
+	return TRUE;
+}
+
 int CollectorDaemon::receive_update_expect_ack(int command,
 												Stream *stream )
 {
@@ -1615,7 +1671,8 @@ int CollectorDaemon::setAttrLastHeardFrom (ClassAd* cad, unsigned long time)
 
 void CollectorDaemon::process_invalidation (AdTypes whichAds, ClassAd &query, Stream *sock)
 {
-	if (param_boolean("IGNORE_INVALIDATE", false)) {
+	static param_handle<bool> ignore_invalidate("IGNORE_INVALIDATE", false);
+	if (ignore_invalidate) {
 		dprintf(D_ALWAYS, "Ignoring invalidate (IGNORE_INVALIDATE=TRUE)\n");
 		return;
 	}
@@ -1625,7 +1682,9 @@ void CollectorDaemon::process_invalidation (AdTypes whichAds, ClassAd &query, St
 
 	bool query_contains_hash_key = false;
 
-    bool expireInvalidatedAds = param_boolean( "EXPIRE_INVALIDATED_ADS", false );
+    static param_handle<bool> expire_invalidated_ads("EXPIRE_INVALIDATED_ADS", false);
+    bool expireInvalidatedAds = expire_invalidated_ads;
+    static param_handle<bool> housekeeping_on_invalidate("HOUSEKEEPING_ON_INVALIDATE", true);
     if( expireInvalidatedAds ) {
         __numAds__ = collector.expire( whichAds, query, &query_contains_hash_key );
     } else {        
@@ -1660,7 +1719,7 @@ void CollectorDaemon::process_invalidation (AdTypes whichAds, ClassAd &query, St
         {
             collector.walkHashTable (whichAds, expiration_scanFunc);
             collector.invokeHousekeeper (whichAds);
-        } else if (param_boolean("HOUSEKEEPING_ON_INVALIDATE", true)) 
+        } else if (housekeeping_on_invalidate) 
 		{
 			// first set all the "LastHeardFrom" attributes to low values ...
 			collector.walkHashTable (whichAds, invalidation_scanFunc);
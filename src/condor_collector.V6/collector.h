@@ -102,6 +102,7 @@ public:
 	static AdTypes receive_query_public( int );
 	static int receive_invalidation(int, Stream*);
 	static int receive_update(int, Stream*);
+	static int receive_batched_update(int, Stream*);
     static int receive_update_expect_ack(int, Stream*);
 
 	static void process_query_public(AdTypes, ClassAd*, List<CollectorRecord>*);
@@ -28,6 +28,7 @@
 #include "condor_attributes.h"
 #include "condor_daemon_core.h"
 #include "classad_merge.h"
+#include "classad_batch.h"
 
 //-------------------------------------------------------------
 
@@ -62,6 +63,7 @@ CollectorEngine::CollectorEngine (CollectorStats *stats ) :
 	machineUpdateInterval = 30;
 	m_forwardInterval = machineUpdateInterval / 3;
 	m_forwardFilteringEnabled = false;
+	m_shareStartdBaseAds = false;
 	housekeeperTimerID = -1;
 
 	m_allowOnlyOneNegotiator = param_boolean("COLLECTOR_ALLOW_ONLY_ONE_NEGOTIATOR", false);
@@ -142,6 +144,11 @@ scheduleHousekeeper (int timeout)
 
 	m_forwardFilteringEnabled = param_boolean( "COLLECTOR_FORWARD_FILTERING", false );
 
+	m_shareStartdBaseAds = param_boolean( "COLLECTOR_SHARE_STARTD_BASE_ADS", true );
+	if ( ! m_shareStartdBaseAds) {
+		m_startdBaseAds.clear();
+	}
+
 	// cancel outstanding housekeeping requests
 	if (housekeeperTimerID != -1)
 	{
@@ -410,6 +417,143 @@ collect (int command, Sock *sock, const condor_sockaddr& from, int &insert)
 	return rval;
 }
 
+int CollectorEngine::
+collectBatch (int command, Sock *sock, const condor_sockaddr& from, std::vector<CollectorRecord*> & records)
+{
+	ClassAd batch, pvtBatch;
+	std::vector<ClassAd*> items, pvtItems;
+
+	records.clear();
+	sock->timeout(1);
+
+	if( !getClassAdEx(sock, batch, m_get_ad_options) ) {
+		dprintf (D_ALWAYS,"Command %d on Sock not followed by ClassAd (or timeout occured)\n",
+				command);
+		sock->end_of_message();
+		return -1;
+	}
+	if( !getClassAdEx(sock, pvtBatch, m_get_ad_options) ) {
+		dprintf(D_FULLDEBUG,"\t(Could not get startd's private ads)\n");
+	}
+	if (!sock->end_of_message()) {
+		dprintf(D_FULLDEBUG,"Warning: Command %d; maybe shedding data on eom\n",
+				 command);
+	}
+
+	if ( ! GetClassAdBatchItems(batch, items)) {
+		dprintf (D_ALWAYS, "Received malformed batch from command (%d). Ignoring.\n", command);
+		return -1;
+	}
+	GetClassAdBatchItems(pvtBatch, pvtItems);
+
+	const char* authn_user = sock->getFullyQualifiedUser();
+	const char* authn_method = sock->getAuthenticationMethodUsed();
+
+	std::shared_ptr<ClassAd> base;
+	if (m_shareStartdBaseAds) {
+		base = getStartdBaseAd(batch);
+	}
+
+	for (size_t ix = 0; ix < items.size(); ++ix) {
+		ClassAd * clientAd = new ClassAd();
+		UnpackClassAdBatchItem(batch, *items[ix], *clientAd);
+
+		// insert the authenticated user into each ad, same as for a single ad
+		if (authn_user) {
+			clientAd->Assign(ATTR_AUTHENTICATED_IDENTITY, authn_user);
+			clientAd->Assign(ATTR_AUTHENTICATION_METHOD, authn_method);
+		} else {
+			clientAd->Delete(ATTR_AUTHENTICATED_IDENTITY);
+			clientAd->Delete(ATTR_AUTHENTICATION_METHOD);
+		}
+
+		ClassAd * pvtAd = NULL;
+		if (ix < pvtItems.size()) {
+			pvtAd = new ClassAd();
+			UnpackClassAdBatchItem(pvtBatch, *pvtItems[ix], *pvtAd);
+		}
+
+		int insert = -3;
+		CollectorRecord * record = collect(UPDATE_STARTD_AD, clientAd, from, insert, NULL, pvtAd);
+		if (record) {
+			if (base) { chainToStartdBaseAd(record, base); }
+			records.push_back(record);
+		} else {
+			delete clientAd;
+		}
+	}
+
+	return (int)items.size();
+}
+
+// Returns the base ad that the slots of a batched update should chain to.
+// The base starts out as the attributes the slots of the batch have in common.
+// As later batches arrive the base is narrowed down to the attributes they
+// all agree on, so that attributes that only happened to be the same (like
+// State) fall out of it and the base stays stable. When a batch disagrees with
+// most of the base, the machine has changed and we start over.
+std::shared_ptr<ClassAd> CollectorEngine::
+getStartdBaseAd(const ClassAd & batch)
+{
+	std::string key;
+	if ( ! batch.LookupString(ATTR_STARTD_IP_ADDR, key)) {
+		return nullptr;
+	}
+
+	ClassAd candidate;
+	for (auto & [name, expr] : batch) {
+		if (strcasecmp(name.c_str(), ATTR_BATCHED_ADS) == 0 ||
+			strcasecmp(name.c_str(), ATTR_AUTHENTICATED_IDENTITY) == 0 ||
+			strcasecmp(name.c_str(), ATTR_AUTHENTICATION_METHOD) == 0 ||
+			ClassAdAttributeIsPrivateAny(name)) {
+			continue;
+		}
+		candidate.Insert(name, expr->Copy());
+	}
+
+	std::shared_ptr<ClassAd> & base = m_startdBaseAds[key];
+	if (base) {
+		std::shared_ptr<ClassAd> common = std::make_shared<ClassAd>();
+		for (auto & [name, expr] : *base) {
+			ExprTree * tree = candidate.Lookup(name);
+			if (tree && tree->SameAs(expr)) {
+				common->Insert(name, expr->Copy());
+			}
+		}
+		if (common->size() == base->size()) {
+			return base;
+		}
+		if (common->size() * 2 >= candidate.size()) {
+			base = common;
+			return base;
+		}
+	}
+
+	base = std::make_shared<ClassAd>(candidate);
+	return base;
+}
+
+void CollectorEngine::
+chainToStartdBaseAd(CollectorRecord * record, const std::shared_ptr<ClassAd> & base)
+{
+	ClassAd * ad = record->m_publicAd;
+	if (ad->GetChainedParentAd()) {
+		return;
+	}
+
+	// an attribute that is in the base but not in the slot ad would show
+	// through the chain, so such a slot ad has to stay flat.
+	for (auto & [name, expr] : *base) {
+		if ( ! ad->Lookup(name)) {
+			return;
+		}
+	}
+
+	ad->ChainToAd(base.get());
+	ad->PruneChildAd();
+	record->m_sharedAd = base;
+}
+
 bool CollectorEngine::ValidateClassAd(int command,ClassAd *clientAd,Sock *sock)
 {
 
@@ -533,10 +677,10 @@ bool CollectorEngine::ValidateClassAd(int command,ClassAd *clientAd,Sock *sock)
 bool   last_updateClassAd_was_insert;
 
 CollectorRecord *CollectorEngine::
-collect (int command,ClassAd *clientAd,const condor_sockaddr& from,int &insert,Sock *sock)
+collect (int command,ClassAd *clientAd,const condor_sockaddr& from,int &insert,Sock *sock,ClassAd *pvtAdIn)
 {
 	CollectorRecord* retVal;
-	ClassAd		*pvtAd;
+	ClassAd		*pvtAd = pvtAdIn;
 	int		insPvt;
 	AdNameHashKey		hk;
 	std::string hashString;
@@ -553,6 +697,7 @@ collect (int command,ClassAd *clientAd,const condor_sockaddr& from,int &insert,S
 
 	if( !ValidateClassAd(command,clientAd,sock) ) {
 	    insert = -4;
+		delete pvtAd;
 		return NULL;
 	}
 
@@ -590,22 +735,23 @@ collect (int command,ClassAd *clientAd,const condor_sockaddr& from,int &insert,S
 #endif
 
 		// if we want to store private ads
-		if (!sock)
+		if (!sock && !pvtAd)
 		{
 			dprintf (D_ALWAYS, "Want private ads, but no socket given!\n");
 			break;
 		}
 		else
 		{
-			if (!(pvtAd = new ClassAd))
-			{
-				EXCEPT ("Memory error!");
-			}
-			if( !getClassAdEx(sock, *pvtAd, m_get_ad_options) )
-			{
-				dprintf(D_FULLDEBUG,"\t(Could not get startd's private ad)\n");
-				delete pvtAd;
-				break;
+			// the private ad of a batched update has already been read
+			if (!pvtAd) {
+				pvtAd = new ClassAd;
+				if( !getClassAdEx(sock, *pvtAd, m_get_ad_options) )
+				{
+					dprintf(D_FULLDEBUG,"\t(Could not get startd's private ad)\n");
+					delete pvtAd;
+					pvtAd = NULL;
+					break;
+				}
 			}
 
 				// Fix up some stuff in the private ad that we depend on.
@@ -632,6 +778,7 @@ collect (int command,ClassAd *clientAd,const condor_sockaddr& from,int &insert,S
 			(void) updateClassAd (StartdPrivateAds, "StartdPvtAd  ",
 								  "StartdPvt", pvtAd, hk, hashString, insPvt,
 								  from );
+			pvtAd = NULL;
 #ifdef PROFILE_RECEIVE_UPDATE
 			if (last_updateClassAd_was_insert) { CollectorEngine_rucc_insertPvtAd_runtime.Add(rt.tick(rt_last));
 			} else { CollectorEngine_rucc_updatePvtAd_runtime.Add(rt.tick(rt_last)); }
@@ -905,6 +1052,9 @@ collect (int command,ClassAd *clientAd,const condor_sockaddr& from,int &insert,S
 	}
 #endif
 
+	// a private ad that was passed in but not stored belongs to us
+	delete pvtAd;
+
 
 	// return the updated ad
 	return retVal;
@@ -1249,6 +1399,15 @@ housekeeper()
 		cleanHashTable (*cht, now, makeGenericAdHashKey);
 	}
 
+	// forget the base ads of startds that no longer have any slot ads
+	for (auto it = m_startdBaseAds.begin(); it != m_startdBaseAds.end(); ) {
+		if (it->second.use_count() <= 1) {
+			it = m_startdBaseAds.erase(it);
+		} else {
+			++it;
+		}
+	}
+
 	dprintf (D_ALWAYS, "Housekeeper:  Done cleaning\n");
 }
 
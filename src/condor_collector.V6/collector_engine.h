@@ -31,10 +31,13 @@ struct CollectorRecord
 		: m_publicAd(public_ad), m_pvtAd(pvt_ad) { m_pvtAd->ChainToAd(m_publicAd); }
 	~CollectorRecord() { delete m_publicAd; delete m_pvtAd; }
 	void ReplaceAds(ClassAd* public_ad, ClassAd* pvt_ad)
-	{ delete m_publicAd; delete m_pvtAd; m_publicAd=public_ad; m_pvtAd=pvt_ad; m_pvtAd->ChainToAd(m_publicAd); }
+	{ delete m_publicAd; delete m_pvtAd; m_sharedAd.reset(); m_publicAd=public_ad; m_pvtAd=pvt_ad; m_pvtAd->ChainToAd(m_publicAd); }
 
 	ClassAd* m_publicAd;
 	ClassAd* m_pvtAd;
+	// when set, m_publicAd is chained to this ad, which holds the machine
+	// attributes shared by all of the slots of a startd
+	std::shared_ptr<ClassAd> m_sharedAd;
 };
 
 // type for the hash tables ...
@@ -57,7 +60,10 @@ class CollectorEngine : public Service
 
 	// perform the collect operation of the given command
 	CollectorRecord *collect (int, Sock *, const condor_sockaddr&, int &);
-	CollectorRecord *collect (int, ClassAd *, const condor_sockaddr&, int &, Sock* = NULL);
+	CollectorRecord *collect (int, ClassAd *, const condor_sockaddr&, int &, Sock* = NULL, ClassAd * pvtAd = NULL);
+	// collect each of the startd ads of an UPDATE_STARTD_ADS_BATCHED message,
+	// returns the number of ads in the batch or -1 if the message could not be read
+	int collectBatch (int, Sock *, const condor_sockaddr&, std::vector<CollectorRecord*> & records);
 
 	// lookup classad in the specified table with the given hashkey
 	CollectorRecord *lookup (AdTypes, AdNameHashKey &);
@@ -200,6 +206,14 @@ class CollectorEngine : public Service
 	bool m_forwardFilteringEnabled;
 	StringList m_forwardWatchList;
 	int m_forwardInterval;
+
+	// attributes common to all of the slots of a startd, keyed by StartdIpAddr.
+	// slot ads from batched updates are chained to these instead of each
+	// holding a copy
+	std::shared_ptr<ClassAd> getStartdBaseAd(const ClassAd & batch);
+	void chainToStartdBaseAd(CollectorRecord * record, const std::shared_ptr<ClassAd> & base);
+	std::map<std::string, std::shared_ptr<ClassAd>> m_startdBaseAds;
+	bool m_shareStartdBaseAds;
 public: // so that the config code can set it.
 	bool m_allowOnlyOneNegotiator; // prior to 8.5.8, this was hard-coded to be true.
 	int  m_get_ad_options; // new for 8.7.0, may be temporary
@@ -26,6 +26,7 @@
 #include "internet.h"
 #include "ipv6_hostname.h"
 #include "condor_daemon_core.h"
+#include "classad_batch.h"
 
 #include <vector>
 
@@ -287,8 +288,18 @@ CollectorList::sendUpdates (int cmd, ClassAd * ad1, ClassAd* ad2, bool nonblocki
 	// advance the sequence numbers for these ads
 	//
 	time_t now = time(NULL);
-	DCCollectorAdSeq * seqgen = adSeq->getAdSeq(*ad1);
-	if (seqgen) { seqgen->advance(now); }
+	if (cmd == UPDATE_STARTD_ADS_BATCHED) {
+		// each ad in the batch has its own sequence
+		std::vector<ClassAd*> items;
+		GetClassAdBatchItems(*ad1, items);
+		for (auto * item : items) {
+			DCCollectorAdSeq * seqgen = adSeq->getAdSeq(*item);
+			if (seqgen) { seqgen->advance(now); }
+		}
+	} else {
+		DCCollectorAdSeq * seqgen = adSeq->getAdSeq(*ad1);
+		if (seqgen) { seqgen->advance(now); }
+	}
 
 	this->rewind();
 	int num_collectors = this->Number();
@@ -26,6 +26,7 @@
 #include "daemon.h"
 #include "condor_daemon_core.h"
 #include "dc_collector.h"
+#include "classad_batch.h"
 
 #include <sstream>
 #include <algorithm>
@@ -296,6 +297,12 @@ DCCollector::sendUpdate( int cmd, ClassAd* ad1, DCCollectorAdSequences& adSeq, C
 		nonblocking = false;
 	}
 
+	// a collector that does not know the batched command would drop the
+	// whole batch, so unless we know that it does, send the ads one by one
+	if ( ad1 && cmd == UPDATE_STARTD_ADS_BATCHED && ! supportsBatchedUpdates() ) {
+		return sendBatchItems( ad1, adSeq, ad2, nonblocking, callback_fn, miscdata );
+	}
+
 	// Add start time & seq # to the ads before we publish 'em
 	if ( ad1 ) {
 		ad1->Assign(ATTR_DAEMON_START_TIME, startTime);
@@ -306,7 +313,20 @@ DCCollector::sendUpdate( int cmd, ClassAd* ad1, DCCollectorAdSequences& adSeq, C
 		ad2->Assign(ATTR_DAEMON_LAST_RECONFIG_TIME, reconfigTime);
 	}
 
-	if ( ad1 ) {
+	if ( ad1 && cmd == UPDATE_STARTD_ADS_BATCHED ) {
+		// the sequence numbers go into the items, item N of the private
+		// batch goes with item N of the public batch
+		std::vector<ClassAd*> items, pvt_items;
+		GetClassAdBatchItems(*ad1, items);
+		if (ad2) { GetClassAdBatchItems(*ad2, pvt_items); }
+		for (size_t ix = 0; ix < items.size(); ++ix) {
+			DCCollectorAdSeq* seqgen = adSeq.getAdSeq(*items[ix]);
+			if ( ! seqgen) continue;
+			long long seq = seqgen->getSequence();
+			items[ix]->Assign(ATTR_UPDATE_SEQUENCE_NUMBER, seq);
+			if (ix < pvt_items.size()) { pvt_items[ix]->Assign(ATTR_UPDATE_SEQUENCE_NUMBER, seq); }
+		}
+	} else if ( ad1 ) {
 		DCCollectorAdSeq* seqgen = adSeq.getAdSeq(*ad1);
 		if (seqgen) {
 			long long seq = seqgen->getSequence();
@@ -384,6 +404,54 @@ DCCollector::sendUpdate( int cmd, ClassAd* ad1, DCCollectorAdSequences& adSeq, C
 
 
 
+// UPDATE_STARTD_ADS_BATCHED was added in 10.5.0. The peer version of the
+// update socket is the best source, the version from the collector ad is
+// used until we have one. an unknown version does not get batches.
+bool
+DCCollector::supportsBatchedUpdates()
+{
+	CondorVersionInfo const *verinfo = update_rsock ? update_rsock->get_peer_version() : nullptr;
+	if (verinfo) {
+		return verinfo->built_since_version(10, 5, 0);
+	}
+	if (_version && _version[0]) {
+		CondorVersionInfo vi(_version);
+		return vi.built_since_version(10, 5, 0);
+	}
+	return false;
+}
+
+// send each item of a batch as its own UPDATE_STARTD_AD. the sequence numbers
+// of the items were already advanced by the caller. the callback, if any, is
+// given to the last update, since miscdata belongs to exactly one callback.
+bool
+DCCollector::sendBatchItems( ClassAd* ad1, DCCollectorAdSequences& adSeq, ClassAd* ad2, bool nonblocking, StartCommandCallbackType callback_fn, void *miscdata )
+{
+	std::vector<ClassAd*> items, pvt_items;
+	GetClassAdBatchItems(*ad1, items);
+	if (ad2) { GetClassAdBatchItems(*ad2, pvt_items); }
+
+	dprintf(D_FULLDEBUG, "Collector %s may not accept batched updates, sending %d ads separately\n",
+			addr() ? addr() : "(null)", (int)items.size());
+
+	bool success = true;
+	for (size_t ix = 0; ix < items.size(); ++ix) {
+		ClassAd pub_ad, pvt_ad;
+		UnpackClassAdBatchItem(*ad1, *items[ix], pub_ad);
+		bool has_pvt = ix < pvt_items.size();
+		if (has_pvt) { UnpackClassAdBatchItem(*ad2, *pvt_items[ix], pvt_ad); }
+		bool last = (ix + 1 == items.size());
+		if ( ! sendUpdate(UPDATE_STARTD_AD, &pub_ad, adSeq, has_pvt ? &pvt_ad : nullptr, nonblocking,
+				last ? callback_fn : nullptr, last ? miscdata : nullptr)) {
+			success = false;
+		}
+	}
+	if (items.empty() && callback_fn) {
+		(*callback_fn)(false, nullptr, nullptr, "", false, miscdata);
+	}
+	return success;
+}
+
 bool
 DCCollector::finishUpdate( DCCollector *self, Sock* sock, ClassAd* ad1, ClassAd* ad2, StartCommandCallbackType callback_fn, void *miscdata )
 {
@@ -421,8 +489,11 @@ DCCollector::finishUpdate( DCCollector *self, Sock* sock, ClassAd* ad1, ClassAd*
 		}
 		return false;
 	}
-		// This is always a private ad.
-	if( ad2 && ! putClassAd(sock, *ad2, 0) ) {
+		// This is always a private ad.  The items of a batched private ad
+		// are nested inside of BatchedAds, where putClassAd does not look
+		// for private attributes, so the whole list is sent encrypted.
+	static const classad::References batch_secrets = { ATTR_BATCHED_ADS };
+	if( ad2 && ! putClassAd(sock, *ad2, 0, nullptr, &batch_secrets) ) {
 		if(self) {
 			self->newError( CA_COMMUNICATION_ERROR,
 			          "Failed to send ClassAd #2 to collector" );
@@ -60,10 +60,12 @@
 #include "generic_stats.h"
 #include "filesystem_remap.h"
 #include "daemon_keep_alive.h"
+#include "worker_pool.h"
 
 #include <vector>
 #include <memory>
 #include <deque>
+#include <map>
 
 #include "../condor_procd/proc_family_io.h"
 class ProcFamilyInterface;
@@ -1533,13 +1535,21 @@ class DaemonCore : public Service
 			   could be set to 1, or 128, or -1, or 255.... or anything 
 			   except 0.  Example: start_func returns 0, the reaper exit_status
 			   will be 0, and only 0.
+			@param thread_safe The start_func only touches arg, sock and
+			   data that the parent will not change while it runs, so it
+			   may be run on a real thread in this process rather than in
+			   a forked child.  This is only done when CREATE_THREAD_POOL_SIZE
+			   is non-zero and this daemon does not switch uids, otherwise
+			   the thread is forked as usual.  A pooled thread cannot be
+			   killed or suspended, and the tid returned for it is not a pid.
 			@return The tid of the newly created thread.
 		*/
 	int Create_Thread(
 		ThreadStartFunc	start_func,
 		void			*arg = NULL,
 		Stream			*sock = NULL,
-		int				reaper_id = 1
+		int				reaper_id = 1,
+		bool			thread_safe = false
 		);
 
 		// On some platforms (currently Windows), we do not want
@@ -1547,6 +1557,10 @@ class DaemonCore : public Service
 		// just about nothing in Condor is thread safe at this time.
 	bool DoFakeCreateThread() const { return m_fake_create_thread; }
 
+		// true if tid is a Create_Thread worker that is running on the
+		// thread pool rather than in a child process.
+	bool IsPooledThread(int tid) const;
+
 	///
 	int Suspend_Thread(int tid);
 
@@ -1760,6 +1774,21 @@ class DaemonCore : public Service
        stats_entry_recent<Probe> PumpCycle;   // count of pump cycles plus sum of cycle time with min/max/avg/std 
        stats_entry_sum_ema_rate<int> Commands;
 
+       // when DCSTATISTICS_PROFILE_HANDLERS is true, a latency histogram is kept for each
+       // command, timer, signal, socket and pipe handler, and for the time spent in select.
+       struct HandlerProfile {
+          std::string name;         // name of the histogram in the Pool
+          std::string attr;         // attribute names for publishing the histogram
+          std::string recent_attr;
+          stats_entry_recent_histogram<double> latency;
+          double max_runtime;       // longest single call
+          HandlerProfile() : max_runtime(0.0) {}
+       };
+       std::map<std::string, HandlerProfile> HandlerProfiles; // keyed by probe name
+       stats_entry_recent_histogram<double> SelectWaitHistogram;
+       bool   profile_handlers;
+       int    profile_top_n;       // number of handlers to publish in DCSlowestHandlers
+
        StatisticsPool          Pool;          // pool of statistics probes and Publish attrib names
 	   std::shared_ptr<stats_ema_config> ema_config;	// Exponential moving average config for this pool.
 
@@ -1790,6 +1819,7 @@ class DaemonCore : public Service
        double AddSample(const char * name, int as, double val);
        double AddRuntime(const char * name, double before); // returns current time.
        double AddRuntimeSample(const char * name, int as, double before);
+       void AddHandlerLatency(const char * name, double runtime);
 
 	} dc_stats;
 
@@ -2042,6 +2072,23 @@ class DaemonCore : public Service
 
 	bool m_fake_create_thread;
 
+		// Create_Thread workers that are run on threads rather than forked.
+		// When a worker finishes, it queues its tid and exit status and wakes
+		// up select, the main thread then moves them into the WaitpidQueue
+		// so the reaper is called just like it would be for a forked worker.
+	WorkerPool m_create_thread_pool;
+	std::mutex m_pooled_exit_mutex;
+	std::deque<std::pair<int,int>> m_pooled_exits; // tid, exit_status
+	int m_next_pooled_tid;
+	void ServicePooledThreadExits();
+		// the pool size from CREATE_THREAD_POOL_SIZE. resizing joins the
+		// workers, so it waits until the pool is idle.
+	int m_create_thread_pool_size;
+	void ResizeCreateThreadPool();
+		// the config that pooled workers read, see param_snapshot()
+	std::shared_ptr<class ParamSnapshot> m_pooled_config;
+	unsigned int m_pooled_config_generation;
+
 #if defined(WIN32)
 	typedef PipeEnd* PipeHandle;
 #else
@@ -32,6 +32,9 @@
 
 #include "dc_service.h"
 #include "condor_timeslice.h"
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
 
 #ifdef WIN32
 #include <time.h>
@@ -83,7 +86,8 @@ struct tagTimer {
     /** Not_Yet_Documented */ TimerHandler             handler;
     /** Not_Yet_Documented */ TimerHandlercpp          handlercpp;
     /** Not_Yet_Documented */ class Service*    service; 
-    /** Not_Yet_Documented */ struct tagTimer*  next;
+    /** position in the timer heap, or < 0 when not in the heap */ int heap_index;
+    /** order in which the timer was queued, breaks ties in when */ unsigned long long seq;
     /** Not_Yet_Documented */ char*             event_descrip;
     /** Not_Yet_Documented */ void*             data_ptr;
     /** Not_Yet_Documented */ Timeslice *       timeslice;
@@ -249,19 +253,31 @@ class TimerManager
                   unsigned   period          =  0,
 				  const Timeslice *timeslice = NULL);
 
-	void RemoveTimer( Timer *timer, Timer *prev );
-	void InsertTimer( Timer *new_timer );
+	void RemoveTimer( Timer *timer );
+	void InsertTimer( Timer *new_timer, bool requeue = false );
 	void DeleteTimer( Timer *timer );
 
 	/*
 	  @param id The id of the timer to find
-	  @param prev If not NULL, this will be set to previous timer in list
 	  @return pointer to timer with specified id or NULL if not found
 	 */
-	Timer *GetTimer( int id, Timer **prev );
-
-    Timer*  timer_list;
-	Timer*  list_tail;
+	Timer *GetTimer( int id );
+
+	// The timers are kept in a 4-ary min-heap ordered on (when, seq) so that
+	// inserting, resetting and cancelling a timer is O(log n) rather than a walk
+	// of a sorted list.  Timers with the same when fire in the order they were queued.
+	static bool TimerBefore( const Timer *a, const Timer *b );
+	void HeapSiftUp( size_t ix );
+	void HeapSiftDown( size_t ix );
+	void CollectReadyTimers( size_t ix, time_t now, std::unordered_set<int> & ids );
+	Timer *FirstTimer() const { return timer_heap.empty() ? NULL : timer_heap[0]; }
+
+	std::vector<Timer*> timer_heap;
+	std::unordered_map<int, Timer*> timers_by_id;
+	// timers that were due but skipped by Timeout() because they were added
+	// or reset by a handler, they are put back in the heap at the end of Timeout()
+	std::vector<Timer*> parked_timers;
+	unsigned long long timer_seq;
     int     timer_ids;
     Timer*  in_timeout;
     bool    did_reset;
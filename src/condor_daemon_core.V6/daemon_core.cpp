@@ -38,6 +38,9 @@
 
 static const int DEFAULT_MAXPIPES = 8;
 static const int DEFAULT_MAX_PID_COLLISIONS = 9;
+// tids handed out for pooled Create_Thread workers start above PID_MAX_LIMIT
+// on Linux (and the pid limit of every other unix we run on)
+static const int POOLED_THREAD_TID_MIN = (1 << 22) + 1;
 static const char* DEFAULT_INDENT = "DaemonCore--> ";
 static const int MIN_FILE_DESCRIPTOR_SAFETY_LIMIT = 20;
 static const int MIN_REGISTERED_SOCKET_SAFETY_LIMIT = 15;
@@ -445,6 +448,9 @@ DaemonCore::DaemonCore(int ComSize,int SigSize,
 #endif
 
 	m_fake_create_thread = false;
+	m_next_pooled_tid = POOLED_THREAD_TID_MIN;
+	m_create_thread_pool_size = 0;
+	m_pooled_config_generation = 0;
 
 	m_refresh_dns_timer = -1;
 
@@ -465,6 +471,10 @@ DaemonCore::~DaemonCore()
 	abort_pid_watcher_threads = true;
 	#endif
 
+	// let any pooled Create_Thread workers finish before we tear down
+	// the async_pipe that they use to wake us up.
+	m_create_thread_pool.stop();
+
 	if( m_ccb_listeners ) {
 		delete m_ccb_listeners;
 		m_ccb_listeners = NULL;
@@ -3044,6 +3054,18 @@ DaemonCore::reconfig(void) {
 #else
 		// Under unix, Create_Thread() is actually a fork, so it is safe.
 	m_fake_create_thread = param_boolean("FAKE_CREATE_THREAD",false);
+
+		// CREATE_THREAD_POOL_SIZE lets Create_Thread run workers that are
+		// marked as thread safe on real threads rather than forking.
+		// priv state is per process, so we can't do this if we switch uids.
+	int create_thread_pool_size = param_integer("CREATE_THREAD_POOL_SIZE", 0, 0, 256);
+	if (create_thread_pool_size > 0 && can_switch_ids()) {
+		dprintf(D_ALWAYS, "Ignoring CREATE_THREAD_POOL_SIZE=%d because this daemon switches uids; "
+			"Create_Thread will fork\n", create_thread_pool_size);
+		create_thread_pool_size = 0;
+	}
+	m_create_thread_pool_size = create_thread_pool_size;
+	ResizeCreateThreadPool();
 #endif
 
 	m_DaemonKeepAlive.reconfig();
@@ -3458,6 +3480,11 @@ void DaemonCore::Driver()
 		// Just keep reading while something is there.  async_pipe is set to
 		// non-blocking mode via fcntl, so the read below will not block.
 		while( read(async_pipe[0],asyncpipe_buf,8) > 0 ) { }
+
+		// now that the pipe is empty, pick up any pooled Create_Thread
+		// workers that finished. any that finish after this will write
+		// into the pipe again.
+		ServicePooledThreadExits();
 #else
 		// windows version of this code is after selector.execute()
 #endif
@@ -3639,6 +3666,9 @@ void DaemonCore::Driver()
 		// update statistics on time spent waiting in select.
 		runtime = _condor_debug_get_time_double();
 		dc_stats.SelectWaittime += (runtime - group_runtime);
+		if (dc_stats.profile_handlers) {
+			dc_stats.SelectWaitHistogram.Add(runtime - group_runtime);
+		}
 		//dc_stats.StatsLifetime = now - dc_stats.InitTime;
 
 		tmpErrno = errno;
@@ -5284,6 +5314,12 @@ int DaemonCore::Suspend_Thread(int tid)
 	dprintf(D_DAEMONCORE,"called DaemonCore::Suspend_Thread(%d)\n",
 		tid);
 
+	if (IsPooledThread(tid)) {
+		dprintf(D_ALWAYS,"DaemonCore:Suspend_Thread(%d) failed, pooled threads cannot be suspended\n",
+			tid);
+		return FALSE;
+	}
+
 	// verify the tid passed in to us is valid
 	if ( (pidTable->lookup(tid, pidinfo) < 0)	// is it not in our table?
 #ifdef WIN32
@@ -5320,6 +5356,12 @@ int DaemonCore::Continue_Thread(int tid)
 	dprintf(D_DAEMONCORE,"called DaemonCore::Continue_Thread(%d)\n",
 		tid);
 
+	if (IsPooledThread(tid)) {
+		dprintf(D_ALWAYS,"DaemonCore:Continue_Thread(%d) failed, pooled threads cannot be suspended\n",
+			tid);
+		return FALSE;
+	}
+
 	// verify the tid passed in to us is valid
 	if ( (pidTable->lookup(tid, pidinfo) < 0)	// is it not in our table?
 #ifdef WIN32
@@ -8431,7 +8473,7 @@ FakeCreateThreadReaperCaller::CallReaper() {
 
 int
 DaemonCore::Create_Thread(ThreadStartFunc start_func, void *arg, Stream *sock,
-						  int reaper_id)
+						  int reaper_id, bool thread_safe)
 {
 	// check reaper_id validity
 	if ( reaper_id > 0 && reaper_id < nextReapId ) {
@@ -8506,6 +8548,58 @@ DaemonCore::Create_Thread(ThreadStartFunc start_func, void *arg, Stream *sock,
 	// buffer which will make it thread safe when called from SendSignal().
 	(void)InfoCommandSinfulString();
 
+#ifndef WIN32
+	ResizeCreateThreadPool();
+	if (thread_safe && m_create_thread_pool_size > 0 && m_create_thread_pool.size() > 0) {
+			// pooled tids are above the largest possible pid, so that a
+			// Send_Signal or kill() of one can never hit a real process.
+		int tid = m_next_pooled_tid;
+		PidEntry *pidinfo = NULL;
+		while (pidTable->lookup(tid, pidinfo) >= 0) {
+			tid = (tid >= INT_MAX - 1) ? POOLED_THREAD_TID_MIN : tid + 1;
+		}
+		m_next_pooled_tid = (tid >= INT_MAX - 1) ? POOLED_THREAD_TID_MIN : tid + 1;
+
+		PidEntry *pidtmp = new PidEntry;
+		pidtmp->pid = tid;
+		pidtmp->new_process_group = FALSE;
+		pidtmp->is_local = TRUE;
+		pidtmp->parent_is_local = TRUE;
+		pidtmp->reaper_id = reaper_id;
+		int insert_result = pidTable->insert(tid, pidtmp);
+		ASSERT( insert_result == 0 );
+
+			// the worker reads a copy of the config, so that we can reconfig
+			// without waiting for it. one copy is shared by all of the workers
+			// started between changes to the config.
+		if ( ! m_pooled_config || m_pooled_config_generation != param_generation()) {
+			m_pooled_config_generation = param_generation();
+			m_pooled_config = param_snapshot();
+		}
+		std::shared_ptr<ParamSnapshot> config = m_pooled_config;
+
+			// need to copy the sock because our caller is going to delete/close it
+		Stream *s = sock ? sock->CloneStream() : (Stream *)NULL;
+		m_create_thread_pool.submit([this, tid, start_func, arg, s, config]() {
+			param_use_snapshot(config.get());
+			int exit_status = start_func(arg, s);
+			param_use_snapshot(NULL);
+			if (s) { delete s; }
+			if (arg) { free(arg); }		// arg should point to malloc()'ed data
+			{
+				std::unique_lock<std::mutex> guard(m_pooled_exit_mutex);
+				// make the exit status look like what waitpid() would return
+				// for a forked thread that called exit(exit_status)
+				m_pooled_exits.emplace_back(tid, (exit_status & 0xff) << 8);
+			}
+			Do_Wake_up_select();
+		});
+
+		dprintf(D_DAEMONCORE,"Create_Thread: queued new pooled thread, tid=%d\n",tid);
+		return tid;
+	}
+#endif
+
 #ifdef WIN32
 	unsigned tid = 0;
 	HANDLE hThread = NULL;
@@ -8659,10 +8753,65 @@ DaemonCore::Create_Thread(ThreadStartFunc start_func, void *arg, Stream *sock,
 	return tid;
 }
 
+bool
+DaemonCore::IsPooledThread(int tid) const
+{
+	PidEntry *pidinfo = NULL;
+	return tid >= POOLED_THREAD_TID_MIN && pidTable->lookup(tid, pidinfo) >= 0;
+}
+
+// resize the pool to CREATE_THREAD_POOL_SIZE once it has nothing to do.
+// until then, a busy pool keeps its old size, and if the new size is 0
+// Create_Thread forks rather than queue more work for it.
+void
+DaemonCore::ResizeCreateThreadPool()
+{
+	if (m_create_thread_pool_size == m_create_thread_pool.size() || m_create_thread_pool.busy()) {
+		return;
+	}
+	int num_threads = m_create_thread_pool.start(m_create_thread_pool_size);
+	dprintf(D_ALWAYS, "Using %d threads for thread safe Create_Thread workers\n", num_threads);
+	if ( ! num_threads) {
+		m_pooled_config.reset();
+	}
+}
+
+void
+DaemonCore::ServicePooledThreadExits()
+{
+	std::deque<std::pair<int,int>> exits;
+	{
+		std::unique_lock<std::mutex> guard(m_pooled_exit_mutex);
+		exits.swap(m_pooled_exits);
+	}
+	if (exits.empty()) {
+		return;
+	}
+
+	// hand these to the same code that reaps forked threads, so the reapers
+	// are called at the same point in the loop and at the same rate.
+	for (auto & ex : exits) {
+		WaitpidEntry wait_entry;
+		wait_entry.child_pid = ex.first;
+		wait_entry.exit_status = ex.second;
+		WaitpidQueue.push_back(wait_entry);
+	}
+	Signal_Myself(DC_SERVICEWAITPIDS);
+
+	// a reconfig may have changed the pool size while it was busy
+	ResizeCreateThreadPool();
+}
+
 int
 DaemonCore::Kill_Thread(int tid)
 {
 	dprintf(D_DAEMONCORE,"called DaemonCore::Kill_Thread(%d)\n", tid);
+	if (IsPooledThread(tid)) {
+			// like TerminateThread() on windows, there is no safe way to
+			// do this, the thread will run to completion and be reaped then.
+		dprintf(D_ALWAYS, "DaemonCore:Kill_Thread(%d) ignored, pooled threads cannot be killed\n", tid);
+		return FALSE;
+	}
 #if defined(WIN32)
 	/*
 	  My Life of Pain:  Yuck.  This is a no-op on WinNT because
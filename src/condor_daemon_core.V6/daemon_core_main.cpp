@@ -788,6 +788,28 @@ void clean_files()
 }
 
 
+// When SEC_SESSION_SNAPSHOT is true, the incoming security sessions are
+// saved when the daemon exits and restored when it starts again, so that a
+// restart does not make every peer authenticate with us at the same time.
+static void
+dc_session_snapshot( bool save )
+{
+	if ( ! daemonCore || ! param_boolean("SEC_SESSION_SNAPSHOT", false) ) {
+		return;
+	}
+	std::string filename;
+	if ( ! param(filename, "SEC_SESSION_SNAPSHOT_FILE") ) {
+		dprintf(D_ALWAYS, "SEC_SESSION_SNAPSHOT is true, but SEC_SESSION_SNAPSHOT_FILE is not set\n");
+		return;
+	}
+	if ( save ) {
+		daemonCore->getSecMan()->WriteSessionSnapshot(filename.c_str());
+	} else if ( access(filename.c_str(), F_OK) == 0 ) {
+		daemonCore->getSecMan()->ReadSessionSnapshot(filename.c_str());
+	}
+}
+
+
 // All daemons call this function when they want daemonCore to really
 // exit.  Put any daemon-wide shutdown code in here.   
 void
@@ -797,6 +819,9 @@ DC_Exit( int status, const char *shutdown_program )
 		// address file or the pid file.
 	clean_files();
 
+		// Save our security sessions for the next time we start up
+	dc_session_snapshot(true);
+
 #ifdef LINUX
 		// Remove any keys stored in the kernel (for ecryptfs)
 	FilesystemRemap::EcryptfsUnlinkKeys();
@@ -1292,6 +1317,7 @@ unix_sig_coredump(int signum, siginfo_t *s_info, void *)
 	log_args[2] = s_info->si_pid;
 	log_args[3] = s_info->si_uid;
 	log_args[4] = (unsigned long)s_info->si_addr;
+	dprintf_flush_log_writer_on_crash();
 	dprintf_async_safe("Caught signal %0: si_code=%1, si_pid=%2, si_uid=%3, si_addr=0x%x4\n", log_args, 5);
 
 	dprintf_dump_stack();
@@ -4379,6 +4405,10 @@ int dc_main( int argc, char** argv )
 	// in their environment
 	SetEnv( envName, daemonCore->sec_man->my_unique_id() );
 
+	// pick up the security sessions saved when we last exited, before
+	// any of our peers get a chance to try to resume them.
+	dc_session_snapshot(false);
+
 	// create a database connection object
 	//DBObj = createConnection();
 
@@ -25,6 +25,7 @@
 #include "condor_config.h"   // for param
 #include "../condor_procapi/procapi.h"
 #include <limits>
+#include <algorithm>
 
 int configured_statistics_window_quantum() {
     int quantum = param_integer("STATISTICS_WINDOW_QUANTUM_DAEMONCORE", INT_MAX, 1, INT_MAX);
@@ -160,6 +161,11 @@ bool SelfMonitorData::ExportData(ClassAd *ad, bool verbose /*=false*/) const
 //------------------------------------------------------------------------------------------
 //                          DaemonCore Statistics
 
+// upper bounds of the buckets of the handler latency and select wait histograms, in seconds
+static const double handler_latency_levels[] = {
+   0.001, 0.005, 0.01, 0.05, 0.1, 0.5, 1.0, 5.0, 10.0, 60.0,
+   };
+static const char handler_latency_set[] = "1ms, 5ms, 10ms, 50ms, 100ms, 500ms, 1Sec, 5Sec, 10Sec, 1Min";
 
 void DaemonCore::Stats::Reconfig()
 {
@@ -177,6 +183,13 @@ void DaemonCore::Stats::Reconfig()
        this->PublishFlags = generic_stats_ParseConfigString(tmp, "DC", "DAEMONCORE", this->PublishFlags);
        free(tmp);
     }
+    this->profile_handlers = param_boolean("DCSTATISTICS_PROFILE_HANDLERS", false);
+    this->profile_top_n = param_integer("DCSTATISTICS_PROFILE_TOP_N", 10, 0, 1000);
+    if (this->profile_handlers && this->enabled && SelectWaitHistogram.value.cLevels <= 0) {
+       SelectWaitHistogram.set_levels(handler_latency_levels, COUNTOF(handler_latency_levels));
+       STATS_POOL_ADD_VAL_PUB_RECENT(Pool, "DC", SelectWaitHistogram, IF_BASICPUB | IF_NONZERO);
+    }
+
     SetWindowSize(this->RecentWindowMax);
 
     std::string strWhitelist;
@@ -215,6 +228,8 @@ void DaemonCore::Stats::Init(bool enable)
    this->RecentWindowQuantum = configured_statistics_window_quantum();
    this->RecentWindowMax = this->RecentWindowQuantum; 
    this->PublishFlags    = -1;
+   this->profile_handlers = false;
+   this->profile_top_n = 0;
    if ( ! enable) return;
 
    // insert static items into the stats pool so we can use the pool 
@@ -301,6 +316,9 @@ void DaemonCore::Stats::Clear()
    this->StatsLastUpdateTime = 0;
    this->RecentStatsTickTime = 0;
    this->RecentStatsLifetime = 0;
+   for (auto & it : HandlerProfiles) {
+      it.second.max_runtime = 0.0;
+   }
    Pool.Clear();
 }
 
@@ -352,6 +370,31 @@ void DaemonCore::Stats::Publish(ClassAd & ad, int flags) const
    }
    ad.Assign("RecentDaemonCoreDutyCycle", dDutyCycle);
 
+   if (this->profile_handlers && (flags & IF_PUBLEVEL) > 0) {
+      ad.Assign("DCHandlerLatencyHistogramBuckets", handler_latency_set);
+
+      // the handlers with the longest single call, slowest first
+      std::vector<std::pair<double, const std::string*> > slowest;
+      for (auto & it : HandlerProfiles) {
+         if (it.second.max_runtime > 0.0) {
+            slowest.emplace_back(it.second.max_runtime, &it.first);
+         }
+      }
+      size_t top_n = MIN(slowest.size(), (size_t)this->profile_top_n);
+      std::partial_sort(slowest.begin(), slowest.begin() + top_n, slowest.end(),
+         [](const std::pair<double, const std::string*> & a, const std::pair<double, const std::string*> & b) {
+            return a.first > b.first;
+         });
+      std::string str;
+      for (size_t ix = 0; ix < top_n; ++ix) {
+         if ( ! str.empty()) str += ", ";
+         formatstr_cat(str, "%.3f %s", slowest[ix].first, slowest[ix].second->c_str());
+      }
+      if ( ! str.empty()) {
+         ad.Assign("DCSlowestHandlers", str);
+      }
+   }
+
    Pool.Publish(ad, flags);
 }
 
@@ -364,6 +407,8 @@ void DaemonCore::Stats::Unpublish(ClassAd & ad) const
    ad.Delete("DCRecentWindowMax");
    ad.Delete("DaemonCoreDutyCycle");
    ad.Delete("RecentDaemonCoreDutyCycle");
+   ad.Delete("DCHandlerLatencyHistogramBuckets");
+   ad.Delete("DCSlowestHandlers");
    Pool.Unpublish(ad);
 }
 
@@ -458,6 +503,8 @@ double DaemonCore::Stats::AddRuntime(const char * name, double before)
    stats_entry_probe<double> * probe = Pool.GetProbe< stats_entry_probe<double> >(name);
    if (probe)
       probe->Add(now - before);
+   if (this->profile_handlers)
+      AddHandlerLatency(name, now - before);
    return now;
 }
 
@@ -496,6 +543,8 @@ double DaemonCore::Stats::AddRuntime(const char * name, double before)
    stats_recent_counter_timer * probe = Pool.GetProbe<stats_recent_counter_timer>(name);
    if (probe)
       probe->Add(now - before);
+   if (this->profile_handlers)
+      AddHandlerLatency(name, now - before);
    return now;
 }
 
@@ -533,6 +582,27 @@ double DaemonCore::Stats::AddRuntimeSample(const char * name, int as, double bef
 
 #endif
 
+void DaemonCore::Stats::AddHandlerLatency(const char * name, double runtime)
+{
+   auto it = HandlerProfiles.find(name);
+   if (it == HandlerProfiles.end())
+      return;
+
+   // the histogram is added to the pool the first time that the handler
+   // is called with profiling enabled.
+   HandlerProfile & prof = it->second;
+   if (prof.latency.value.cLevels <= 0) {
+      prof.latency.set_levels(handler_latency_levels, COUNTOF(handler_latency_levels));
+      prof.latency.SetRecentMax(this->RecentWindowMax / this->RecentWindowQuantum);
+      Pool.AddProbe(prof.name.c_str(), &prof.latency, prof.attr.c_str(), IF_BASICPUB | IF_NONZERO | prof.latency.PubValue);
+      Pool.AddPublish(("Recent" + prof.name).c_str(), &prof.latency, prof.recent_attr.c_str(),
+                      IF_BASICPUB | IF_RECENTPUB | IF_NONZERO | prof.latency.PubRecent);
+   }
+   prof.latency.Add(runtime);
+   if (runtime > prof.max_runtime)
+      prof.max_runtime = runtime;
+}
+
 void* DaemonCore::Stats::NewProbe(const char * category, const char * name, int as)
 {
    if ( ! this->enabled) return NULL;
@@ -541,6 +611,16 @@ void* DaemonCore::Stats::NewProbe(const char * category, const char * name, int
    formatstr(attr, "DC%s_%s", category, name);
    cleanStringForUseAsAttr(attr);
 
+   // remember the names for the latency histogram of each handler's runtime probe
+   if ((as & (AS_TYPE_MASK | IS_CLASS_MASK)) == (AS_COUNT | IS_RCT)) {
+      HandlerProfile & prof = HandlerProfiles[name];
+      if (prof.name.empty()) {
+         prof.name = std::string(name) + "Latency";
+         prof.attr = attr + "Latency";
+         prof.recent_attr = "Recent" + prof.attr;
+      }
+   }
+
    void * ret = NULL;
    switch (as & (AS_TYPE_MASK | IS_CLASS_MASK))
       {
@@ -25,11 +25,16 @@
 #include "condor_daemon_core.h"
 #include "condor_config.h"
 #include <unordered_set>
+#include <algorithm>
 
 static const char* DEFAULT_INDENT = "DaemonCore--> ";
 
 static	TimerManager*	_t = NULL;
 
+// values of Timer::heap_index for timers that are not in the heap
+static const int TIMER_NOT_QUEUED = -1;
+static const int TIMER_PARKED = -2;
+
 extern void **curr_dataptr;
 extern void **curr_regdataptr;
 
@@ -52,8 +57,7 @@ TimerManager::TimerManager()
 	{
 		EXCEPT("TimerManager object exists!");
 	}
-	timer_list = NULL;
-	list_tail = NULL;
+	timer_seq = 0;
 	timer_ids = 0;
 	in_timeout = NULL;
 	_t = this; 
@@ -159,8 +163,10 @@ int TimerManager::NewTimer(Service* s, unsigned deltawhen,
 
 
 	new_timer->id = timer_ids++;		
+	new_timer->heap_index = TIMER_NOT_QUEUED;
+	new_timer->seq = 0;
 
-
+	timers_by_id[new_timer->id] = new_timer;
 	InsertTimer( new_timer );
 
 	DumpTimerList(D_DAEMONCORE | D_FULLDEBUG);
@@ -185,7 +191,7 @@ bool TimerManager::ResetTimerTimeslice(int id, Timeslice const &new_timeslice)
 
 bool TimerManager::GetTimerTimeslice(int id, Timeslice &timeslice)
 {
-	Timer *timer_ptr = GetTimer( id, NULL );
+	Timer *timer_ptr = GetTimer( id );
 	if( !timer_ptr || !timer_ptr->timeslice ) {
 		return false;
 	}
@@ -195,7 +201,7 @@ bool TimerManager::GetTimerTimeslice(int id, Timeslice &timeslice)
 
 time_t TimerManager::GetNextRuntime(int id)
 {
-	Timer *timer_ptr = GetTimer( id, NULL );
+	Timer *timer_ptr = GetTimer( id );
 	if (!timer_ptr) { return false; }
 
 	return timer_ptr->when;
@@ -205,26 +211,28 @@ int TimerManager::ResetTimer(int id, unsigned when, unsigned period,
 							 Timeslice const *new_timeslice)
 {
 	Timer*			timer_ptr;
-	Timer*			trail_ptr;
 
 	dprintf( D_DAEMONCORE,
 			 "In reset_timer(), id=%d, time=%d, period=%d\n",id,when,period);
-	if (timer_list == NULL) {
+	if (timers_by_id.empty()) {
 		dprintf( D_DAEMONCORE, "Reseting Timer from empty list!\n");
 		return -1;
 	}
 
-	timer_ptr = timer_list;
-	trail_ptr = NULL;
-	while ( timer_ptr && timer_ptr->id != id ) {
-		trail_ptr = timer_ptr;
-		timer_ptr = timer_ptr->next;
-	}
-
+	timer_ptr = GetTimer( id );
 	if ( timer_ptr == NULL ) {
 		dprintf( D_ALWAYS, "Timer %d not found\n",id );
 		return -1;
 	}
+	if ( timer_ptr->timeslice && ! new_timeslice ) {
+		dprintf( D_DAEMONCORE, "Timer %d with timeslice can't be reset\n",
+				 id );
+		return 0;
+	}
+
+	// the heap is ordered on when, so take the timer out before changing it
+	RemoveTimer( timer_ptr );
+
 	if ( new_timeslice ) {
 		if( timer_ptr->timeslice == NULL ) {
 			timer_ptr->timeslice = new Timeslice( *new_timeslice );
@@ -234,11 +242,6 @@ int TimerManager::ResetTimer(int id, unsigned when, unsigned period,
 		}
 
 		timer_ptr->when = timer_ptr->timeslice->getNextStartTime();
-	}
-	else if ( timer_ptr->timeslice ) {
-		dprintf( D_DAEMONCORE, "Timer %d with timeslice can't be reset\n",
-				 id );
-		return 0;
 	} else if( recompute_when ) {
 		time_t old_when = timer_ptr->when;
 
@@ -278,7 +281,6 @@ int TimerManager::ResetTimer(int id, unsigned when, unsigned period,
 	}
 	timer_ptr->period = period;
 
-	RemoveTimer( timer_ptr, trail_ptr );
 	InsertTimer( timer_ptr );
 
 	if ( in_timeout == timer_ptr ) {
@@ -293,32 +295,27 @@ int TimerManager::ResetTimer(int id, unsigned when, unsigned period,
 int TimerManager::CancelTimer(int id)
 {
 	Timer*		timer_ptr;
-	Timer*		trail_ptr;
 
 	dprintf( D_DAEMONCORE, "In cancel_timer(), id=%d\n",id);
-	if (timer_list == NULL) {
+	if (timers_by_id.empty()) {
 		dprintf( D_DAEMONCORE, "Removing Timer from empty list!\n");
 		return -1;
 	}
 
-	timer_ptr = timer_list;
-	trail_ptr = NULL;
-	while ( timer_ptr && timer_ptr->id != id ) {
-		trail_ptr = timer_ptr;
-		timer_ptr = timer_ptr->next;
-	}
-
+	timer_ptr = GetTimer( id );
 	if ( timer_ptr == NULL ) {
 		dprintf( D_ALWAYS, "Timer %d not found\n",id );
 		return -1;
 	}
 
-	RemoveTimer( timer_ptr, trail_ptr );
+	RemoveTimer( timer_ptr );
 
 	if ( in_timeout == timer_ptr ) {
 		// We're inside the handler for this timer. Don't delete it,
 		// since Timeout() still needs it. Timeout() will delete it once
-		// it's done with it.
+		// it's done with it. Forget the id now, so that another cancel
+		// or reset of it from the handler finds no timer.
+		timers_by_id.erase( id );
 		did_cancel = true;
 	} else {
 		DeleteTimer( timer_ptr );
@@ -329,11 +326,13 @@ int TimerManager::CancelTimer(int id)
 
 void TimerManager::CancelAllTimers()
 {
-	Timer		*timer_ptr;
+	std::vector<Timer*> all_timers;
+	all_timers.swap(timer_heap);
+	all_timers.insert(all_timers.end(), parked_timers.begin(), parked_timers.end());
+	parked_timers.clear();
 
-	while( timer_list != NULL ) {
-		timer_ptr = timer_list;
-		timer_list = timer_list->next;
+	for (Timer *timer_ptr : all_timers) {
+		timer_ptr->heap_index = TIMER_NOT_QUEUED;
 		if( in_timeout == timer_ptr ) {
 				// We get here if somebody calls exit from inside a timer.
 			did_cancel = true;
@@ -342,8 +341,6 @@ void TimerManager::CancelAllTimers()
 			DeleteTimer( timer_ptr );
 		}
 	}
-	timer_list = NULL;
-	list_tail = NULL;
 }
 
 // Timeout() is called when a select() time out.  Returns number of seconds
@@ -361,10 +358,10 @@ TimerManager::Timeout(int * pNumFired /*= NULL*/, double * pruntime /*=NULL*/)
 
 	if ( in_timeout != NULL ) {
 		dprintf(D_DAEMONCORE,"DaemonCore Timeout() called and in_timeout is non-NULL\n");
-		if ( timer_list == NULL ) {
+		if ( FirstTimer() == NULL || ! parked_timers.empty() ) {
 			result = 0;
 		} else {
-			result = (timer_list->when) - time(NULL);
+			result = (FirstTimer()->when) - time(NULL);
 		}
 		if ( result < 0 ) {
 			result = 0;
@@ -374,7 +371,7 @@ TimerManager::Timeout(int * pNumFired /*= NULL*/, double * pruntime /*=NULL*/)
 		
 	dprintf( D_DAEMONCORE, "In DaemonCore Timeout()\n");
 
-	if (timer_list == NULL) {
+	if (FirstTimer() == NULL) {
 		dprintf( D_DAEMONCORE, "Empty timer list, nothing to do\n" );
 	}
 
@@ -388,57 +385,44 @@ TimerManager::Timeout(int * pNumFired /*= NULL*/, double * pruntime /*=NULL*/)
     // timer handlers themselves.
     std::unordered_set<int> readyTimerIds;
     if (max_timer_events_per_cycle == INT_MAX) {
-        in_timeout = timer_list;
-        while ((in_timeout != NULL) && (in_timeout->when <= now)) {
-            readyTimerIds.insert(in_timeout->id);
-            in_timeout = in_timeout->next;
-        }
-        in_timeout = NULL;
+        CollectReadyTimers(0, now, readyTimerIds);
     }
 
 	// loop until all handlers that should have been called by now or before
 	// are invoked and renewed if periodic.  Remember that NewTimer and CancelTimer
-	// keep the timer_list happily sorted on "when" for us.  We use "now" as a 
+	// keep the timer heap happily ordered on "when" for us.  We use "now" as a 
 	// variable so that if some of these handler functions run for a long time,
 	// we do not sit in this loop forever.
 	// we make certain we do not call more than "max_fires" handlers in a 
 	// single timeout --- this ensures that timers don't starve out the rest
 	// of daemonCore if a timer handler resets itself to 0.
-	while( (timer_list != NULL) && (timer_list->when <= now ) &&
+	while( (FirstTimer() != NULL) && (FirstTimer()->when <= now ) &&
 		   (num_fires < max_timer_events_per_cycle))
 	{
-        in_timeout = timer_list;
+        in_timeout = FirstTimer();
 
         // In this code block, if there is no limit on how many timer handlers we will invoke,
         // we want to skip over timers that got  added or reset by other timer handlers to make
         // certain we aren't stuck here forever. So we will only call timer handlers that
         // were ready to fire when we first entered Timeout().
         if (max_timer_events_per_cycle == INT_MAX) {
-            std::unordered_set<int>::iterator it;
-            bool call_handler = false;
-            // Skip handlers already invoked or added
-            do {
-                it = readyTimerIds.find(in_timeout->id);
-                if (it == readyTimerIds.end()) {
-                    // this timer was not ready when we first looked, so it must have been
-                    // added or reset by another timer callback.  in this case, skip this timer
-                    // callback (we will deal with it next time through the daemoncore loop).
-                    dprintf(D_DAEMONCORE, "Timer %d not fired (SKIPPED) cause added\n", in_timeout->id);
-                    in_timeout = in_timeout->next;
-                }
-                else {
-                    // this timer was ready to fire when we first looked at the timer list, so
-                    // we are going to go ahead and call its handler.  Erase it from our readyTimerIds
-                    // list, and then break out of loop to go ahead and call the handler.
-                    call_handler = true;
-                    readyTimerIds.erase(it);
-                }
-            } while ((!call_handler) && (in_timeout != NULL) && (in_timeout->when <= now));
-
-            if (!call_handler) {
-                // no timers left that we want to fire at this time, break out of outer while loop
-                break;
+            std::unordered_set<int>::iterator it = readyTimerIds.find(in_timeout->id);
+            if (it == readyTimerIds.end()) {
+                // this timer was not ready when we first looked, so it must have been
+                // added or reset by another timer callback.  in this case, skip this timer
+                // callback (we will deal with it next time through the daemoncore loop).
+                // It is set aside until the end of Timeout() so we can get at the timers behind it.
+                dprintf(D_DAEMONCORE, "Timer %d not fired (SKIPPED) cause added\n", in_timeout->id);
+                RemoveTimer( in_timeout );
+                in_timeout->heap_index = TIMER_PARKED;
+                parked_timers.push_back( in_timeout );
+                in_timeout = NULL;
+                continue;
             }
+            // this timer was ready to fire when we first looked at the timer list, so
+            // we are going to go ahead and call its handler.  Erase it from our readyTimerIds
+            // list, and then go ahead and call the handler.
+            readyTimerIds.erase(it);
         }  // end of block if max_timer_events_per_cycle == INT_MAX
 
         num_fires++;
@@ -489,12 +473,14 @@ TimerManager::Timeout(int * pNumFired /*= NULL*/, double * pruntime /*=NULL*/)
 			}
 		}
 
-		if (pruntime) {           
+		if (pruntime && daemonCore) {
 			*pruntime = daemonCore->dc_stats.AddRuntime(in_timeout->event_descrip, *pruntime);
 		}
 
         // Make sure we didn't leak our priv state
-		daemonCore->CheckPrivState();
+		if (daemonCore) {
+			daemonCore->CheckPrivState();
+		}
 
 		// Clear curr_dataptr
 		curr_dataptr = NULL;
@@ -510,12 +496,10 @@ TimerManager::Timeout(int * pNumFired /*= NULL*/, double * pruntime /*=NULL*/)
 			// If a new timer was added at a time in the past
 			// (possible when resetting a timeslice timer), then
 			// it may have landed before the timer we just processed,
-			// meaning that we cannot assume prev==NULL in the call
-			// to RemoveTimer() below.
+			// so it is not necessarily still the first timer.
 
-			Timer *prev = NULL;
-			ASSERT( GetTimer(in_timeout->id,&prev) == in_timeout );
-			RemoveTimer( in_timeout, prev );
+			ASSERT( GetTimer(in_timeout->id) == in_timeout );
+			RemoveTimer( in_timeout );
 
 			if ( in_timeout->period > 0 || in_timeout->timeslice ) {
 				in_timeout->period_started = time(NULL);
@@ -538,16 +522,24 @@ TimerManager::Timeout(int * pNumFired /*= NULL*/, double * pruntime /*=NULL*/)
 		}
 	}  // end of while loop
 
+	// put back the timers that we skipped, they keep their place in line
+	// relative to the timers that were queued before they were.
+	in_timeout = NULL;
+	for (Timer *timer_ptr : parked_timers) {
+		timer_ptr->heap_index = TIMER_NOT_QUEUED;
+		InsertTimer( timer_ptr, true );
+	}
+	parked_timers.clear();
 
 	// set result to number of seconds until next event.  get an update on the
 	// time from time() in case the handlers we called above took significant time.
-	if ( timer_list == NULL ) {
+	if ( FirstTimer() == NULL ) {
 		// we set result to be -1 so that we do not busy poll.
 		// a -1 return value will tell the DaemonCore:Driver to use select with
 		// no timeout.
 		result = -1;
 	} else {
-		result = (timer_list->when) - time(NULL);
+		result = (FirstTimer()->when) - time(NULL);
 		if (result < 0)
 			result = 0;
 	}
@@ -577,11 +569,17 @@ void TimerManager::DumpTimerList(int flag, const char* indent)
 	if ( indent == NULL) 
 		indent = DEFAULT_INDENT;
 
+	// show the timers in the order they will fire
+	std::vector<Timer*> sorted(timer_heap);
+	sorted.insert(sorted.end(), parked_timers.begin(), parked_timers.end());
+	std::sort(sorted.begin(), sorted.end(), TimerBefore);
+
 	dprintf(flag, "\n");
 	dprintf(flag, "%sTimers\n", indent);
 	dprintf(flag, "%s~~~~~~\n", indent);
-	for(timer_ptr = timer_list; timer_ptr != NULL; timer_ptr = timer_ptr->next)
+	for (size_t ix = 0; ix < sorted.size(); ++ix)
 	{
+		timer_ptr = sorted[ix];
 		if ( timer_ptr->event_descrip )
 			ptmp = timer_ptr->event_descrip;
 		else
@@ -648,71 +646,132 @@ void TimerManager::Start()
 	}
 }
 
-void TimerManager::RemoveTimer( Timer *timer, Timer *prev )
+bool TimerManager::TimerBefore( const Timer *a, const Timer *b )
 {
-	if ( timer == NULL || ( prev && prev->next != timer ) ||
-		 ( !prev && timer != timer_list ) ) {
-		EXCEPT( "Bad call to TimerManager::RemoveTimer()!" );
+	if ( a->when != b->when ) {
+		return a->when < b->when;
+	}
+	return a->seq < b->seq;
+}
+
+// the heap has 4 children per node, which keeps it shallow and
+// the children of a node together in memory.
+#define TIMER_HEAP_PARENT(ix) (((ix) - 1) / 4)
+#define TIMER_HEAP_CHILD(ix)  ((ix) * 4 + 1)
+
+void TimerManager::HeapSiftUp( size_t ix )
+{
+	Timer *timer = timer_heap[ix];
+	while ( ix > 0 ) {
+		size_t parent = TIMER_HEAP_PARENT(ix);
+		if ( ! TimerBefore( timer, timer_heap[parent] ) ) {
+			break;
+		}
+		timer_heap[ix] = timer_heap[parent];
+		timer_heap[ix]->heap_index = (int)ix;
+		ix = parent;
 	}
+	timer_heap[ix] = timer;
+	timer->heap_index = (int)ix;
+}
 
-	if ( timer == timer_list ) {
-		timer_list = timer_list->next;
+void TimerManager::HeapSiftDown( size_t ix )
+{
+	Timer *timer = timer_heap[ix];
+	size_t count = timer_heap.size();
+	for (;;) {
+		size_t first = TIMER_HEAP_CHILD(ix);
+		if ( first >= count ) {
+			break;
+		}
+		size_t last = std::min( first + 4, count );
+		size_t best = first;
+		for ( size_t child = first + 1; child < last; ++child ) {
+			if ( TimerBefore( timer_heap[child], timer_heap[best] ) ) {
+				best = child;
+			}
+		}
+		if ( ! TimerBefore( timer_heap[best], timer ) ) {
+			break;
+		}
+		timer_heap[ix] = timer_heap[best];
+		timer_heap[ix]->heap_index = (int)ix;
+		ix = best;
 	}
-	if ( timer == list_tail ) {
-		list_tail = prev;
+	timer_heap[ix] = timer;
+	timer->heap_index = (int)ix;
+}
+
+// add the ids of all of the timers in the heap at or below ix that are due by now
+void TimerManager::CollectReadyTimers( size_t ix, time_t now, std::unordered_set<int> & ids )
+{
+	if ( ix >= timer_heap.size() || timer_heap[ix]->when > now ) {
+		// children of a timer that is not due are not due either
+		return;
 	}
-	if ( prev ) {
-		prev->next = timer->next;
+	ids.insert( timer_heap[ix]->id );
+	size_t first = TIMER_HEAP_CHILD(ix);
+	for ( size_t child = first; child < first + 4; ++child ) {
+		CollectReadyTimers( child, now, ids );
 	}
 }
 
-void TimerManager::InsertTimer( Timer *new_timer )
+void TimerManager::RemoveTimer( Timer *timer )
 {
-	if ( timer_list == NULL ) {
-		// list is empty, place ours in front
-		timer_list = new_timer;
-		list_tail = new_timer;
-		new_timer->next = NULL;
-			// since we have a new first timer, we must wake up select
-		daemonCore->Wake_up_select();
-	} else {
-		// list is not empty, so keep timer_list ordered from soonest to
-		// farthest (i.e. sorted on "when").
-		// Note: when doing the comparisons, we always use "<" instead
-		// of "<=" -- this makes certain we "round-robin" across 
-		// timers that constantly reset themselves to zero.
-		if ( new_timer->when < timer_list->when ) {
-			// make the this new timer first in line
-			new_timer->next = timer_list;
-			timer_list = new_timer;
-			// since we have a new first timer, we must wake up select
-			daemonCore->Wake_up_select();
-		} else if ( new_timer->when == TIME_T_NEVER ) {
-			// Our new timer goes to the very back of the list.
-			new_timer->next = NULL;
-			list_tail->next = new_timer;
-			list_tail = new_timer;
+	if ( timer == NULL ) {
+		EXCEPT( "Bad call to TimerManager::RemoveTimer()!" );
+	}
+
+	if ( timer->heap_index == TIMER_PARKED ) {
+		auto it = std::find( parked_timers.begin(), parked_timers.end(), timer );
+		ASSERT( it != parked_timers.end() );
+		parked_timers.erase( it );
+		timer->heap_index = TIMER_NOT_QUEUED;
+		return;
+	}
+
+	if ( timer->heap_index < 0 || (size_t)timer->heap_index >= timer_heap.size() ||
+		 timer_heap[timer->heap_index] != timer ) {
+		EXCEPT( "Bad call to TimerManager::RemoveTimer()!" );
+	}
+
+	size_t ix = (size_t)timer->heap_index;
+	Timer *last = timer_heap.back();
+	timer_heap.pop_back();
+	timer->heap_index = TIMER_NOT_QUEUED;
+	if ( last != timer ) {
+		// move the last timer into the hole and restore the heap order
+		timer_heap[ix] = last;
+		last->heap_index = (int)ix;
+		if ( ix > 0 && TimerBefore( last, timer_heap[TIMER_HEAP_PARENT(ix)] ) ) {
+			HeapSiftUp( ix );
 		} else {
-			Timer* timer_ptr;
-			Timer* trail_ptr = NULL;
-			for (timer_ptr = timer_list; timer_ptr != NULL; 
-				 timer_ptr = timer_ptr->next ) 
-			{
-				if (new_timer->when < timer_ptr->when) {
-					break;
-				}
-				trail_ptr = timer_ptr;
-			}
-			ASSERT( trail_ptr );
-			new_timer->next = timer_ptr;
-			trail_ptr->next = new_timer;
-			if ( trail_ptr == list_tail ) {
-				list_tail = new_timer;
-			}
+			HeapSiftDown( ix );
 		}
 	}
 }
 
+// requeue is true when putting back a timer that Timeout() skipped, in that
+// case it keeps its original place in line among timers with the same when.
+void TimerManager::InsertTimer( Timer *new_timer, bool requeue )
+{
+	ASSERT( new_timer->heap_index == TIMER_NOT_QUEUED );
+
+	// Note: timers with the same when are ordered by seq, so that we
+	// "round-robin" across timers that constantly reset themselves to zero.
+	if ( ! requeue ) {
+		new_timer->seq = timer_seq++;
+	}
+
+	timer_heap.push_back( new_timer );
+	HeapSiftUp( timer_heap.size() - 1 );
+
+	if ( new_timer->heap_index == 0 && daemonCore ) {
+		// since we have a new first timer, we must wake up select
+		daemonCore->Wake_up_select();
+	}
+}
+
 void TimerManager::DeleteTimer( Timer *timer )
 {
 	// free the data_ptr
@@ -725,6 +784,11 @@ void TimerManager::DeleteTimer( Timer *timer )
 	// free event_descrip
 	free( timer->event_descrip );
 
+	auto it = timers_by_id.find( timer->id );
+	if ( it != timers_by_id.end() && it->second == timer ) {
+		timers_by_id.erase( it );
+	}
+
 	// set curr_dataptr to NULL if a handler is removing itself. 
 	if ( curr_dataptr == &(timer->data_ptr) )
 		curr_dataptr = NULL;
@@ -735,18 +799,11 @@ void TimerManager::DeleteTimer( Timer *timer )
 	delete timer;
 }
 
-Timer *TimerManager::GetTimer( int id, Timer **prev )
+Timer *TimerManager::GetTimer( int id )
 {
-	Timer *timer_ptr = timer_list;
-	if( prev ) {
-		*prev = NULL;
-	}
-	while ( timer_ptr && timer_ptr->id != id ) {
-		if( prev ) {
-			*prev = timer_ptr;
-		}
-		timer_ptr = timer_ptr->next;
+	auto it = timers_by_id.find( id );
+	if ( it == timers_by_id.end() ) {
+		return NULL;
 	}
-
-	return timer_ptr;
+	return it->second;
 }
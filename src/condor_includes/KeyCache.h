@@ -68,6 +68,13 @@ class KeyCacheEntry {
 	std::string           getLastPeerVersion() const { return _last_peer_version; }
 
 	void                  renewLease();
+
+		// used to save and restore a session (see SecMan::WriteSessionSnapshot)
+	const std::vector<KeyInfo*>& keys() const { return _keys; }
+	int                   lifetimeExpiration() const { return _expiration; }
+	int                   leaseInterval() const { return _lease_interval; }
+	time_t                leaseExpiration() const { return _lease_expiration; }
+	void                  setLeaseExpiration(time_t lease_expiration) { _lease_expiration = lease_expiration; }
  private:
 
 	void delete_storage();
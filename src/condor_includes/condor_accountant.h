@@ -30,6 +30,8 @@
 #include <map>
 #include <set>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 
 // this is the required minimum separation between two priorities for them
 // to be considered distinct values
@@ -89,6 +91,15 @@ public:
   double GetLimitMax(const std::string& limit);
   void ReportLimits(ClassAd *attrList);
 
+  // Concurrency limits are interned as small integer ids so that the negotiator can
+  // parse a job's limits once and then check them against the counts by index.
+  struct ConcurrencyLimit { int id; double increment; };
+  int GetLimitId(const std::string& limit); // adds the limit if it is not already known
+  void ParseLimits(const std::string& limits, std::vector<ConcurrencyLimit>& parsed);
+  double GetLimit(int id) const { return limitTable[id].count; }
+  double GetLimitMax(int id) const { return limitTable[id].max; }
+  const std::string& GetLimitName(int id) const { return limitTable[id].name; }
+
   ClassAd* ReportState(bool rollup = false);
   ClassAd* ReportState(const std::string& CustomerName);
   bool ReportState(ClassAd& queryAd, ClassAdList & ads, bool rollup = false);
@@ -107,6 +118,14 @@ public:
 
   bool UsingWeightedSlots() const;
 
+  // Groups whose usage was changed by AddMatch or RemoveMatch since the last call to
+  // TakeChangedGroups, so that HGQ can update subtree usage for just those groups.
+  void NoteGroupUsageChanged(GroupEntry* group) { ChangedGroups.insert(group); }
+  void TakeChangedGroups(std::vector<GroupEntry*>& groups) {
+      groups.assign(ChangedGroups.begin(), ChangedGroups.end());
+      ChangedGroups.clear();
+  }
+
   struct ci_less {
       bool operator()(const std::string& a, const std::string& b) const {
           return strcasecmp(a.c_str(), b.c_str()) < 0;
@@ -148,6 +167,7 @@ private:
   int	MaxAcctLogSize;		// Max size of log file
   bool  DiscountSuspendedResources;
   bool  UseSlotWeights; 
+  int   CheckpointInterval;  // seconds between checkpoints of the log, 0 for none
 
   //--------------------------------------------------------
   // Data members
@@ -155,10 +175,26 @@ private:
 
   ClassAdLog<std::string, ClassAd*> * AcctLog;
   int LastUpdateTime;
-
-  HashTable<std::string, double> concurrencyLimits;
+  time_t LastCheckpointTime;
+
+  // In memory indexes of the records in AcctLog, so that each cycle does not
+  // have to walk and prefix match every customer and resource record.
+  // They are kept current by the methods below that create and destroy records.
+  std::unordered_set<std::string> CustomerNames;  // customers that have a record
+  std::unordered_map<std::string, std::string> MatchedResources; // resource -> customer, empty for a cp placeholder
+
+  // concurrency limits indexed by the ids handed out by GetLimitId
+  struct LimitEntry {
+      std::string name;
+      double count{0};
+      double max{0};        // from config, refreshed by LoadLimits
+      bool in_use{false};   // has ever been incremented or decremented
+  };
+  std::unordered_map<std::string, int> limitIds;
+  std::vector<LimitEntry> limitTable;
 
   GroupEntry* hgq_root_group;
+  std::unordered_set<GroupEntry*> ChangedGroups;
   std::map<std::string, GroupEntry*, ci_less> hgq_submitter_group_map;
 
   //--------------------------------------------------------
@@ -181,6 +217,8 @@ private:
   static std::string GetDomain(const std::string& CustomerName);
 
   bool DeleteClassAd(const std::string& Key);
+  void NewClassAdIfNeeded(const std::string& Key);
+  void BuildIndexes();
 
   void SetAttributeInt(const std::string& Key, const std::string& AttrName, int AttrValue);
   void SetAttributeFloat(const std::string& Key, const std::string& AttrName, double AttrValue);
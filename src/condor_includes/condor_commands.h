@@ -363,6 +363,14 @@ const int UPDATE_OWN_SUBMITTOR_AD = 80;
 // Request a collector to retrieve an identity token from a schedd.
 const int IMPERSONATION_TOKEN_REQUEST = 81;
 
+// Several startd ads in a single message, the shared attributes are sent once.
+// see classad_batch.h for the format of the ads.
+const int UPDATE_STARTD_ADS_BATCHED = 82;
+
+// Several sockets passed from the shared port server to an endpoint in
+// a single SCM_RIGHTS message, the count follows the command.
+const int SHARED_PORT_PASS_SOCKS = 83;
+
 /* these comments are used to control command_table_generator.pl
 NAMETABLE_DIRECTIVE:END_SECTION:collector
 */
@@ -29,6 +29,7 @@
 #include <vector>
 #include <string>
 #include <limits>
+#include <memory>
 
 typedef std::vector<const char *> MACRO_SOURCES;
 class CondorError;
@@ -216,6 +217,20 @@ typedef struct macro_eval_context_ex : macro_eval_context {
 
 	char* param_with_full_path(const char *name);
 
+	// returns a counter that changes every time the config table may have changed,
+	// i.e. on (re)config and when params are inserted at runtime.  Code that caches
+	// values derived from param() can compare this to know when to look them up again.
+	// see param_handle.h
+	unsigned int param_generation();
+
+	// A private copy of the config for a worker thread. param_snapshot makes one,
+	// it must be called on the main thread. After the worker thread calls
+	// param_use_snapshot, its param calls read the copy, so the main thread may
+	// reconfig while the worker runs. Pass NULL to go back to the global config.
+	class ParamSnapshot;
+	std::shared_ptr<ParamSnapshot> param_snapshot();
+	void param_use_snapshot(ParamSnapshot * snapshot);
+
 	// helper function, parse and/or evaluate string and return true if it is a valid boolean
 	// if it is a valid boolean, the value is returned in 'result', otherwise result is unchanged.
 	bool string_is_boolean_param(const char * string, bool& result, ClassAd *me = NULL, ClassAd *target = NULL, const char * name=NULL);
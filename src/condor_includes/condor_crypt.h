@@ -60,7 +60,8 @@ public:
     // duration
     KeyInfo       m_keyInfo;
 
-	// holds encryption and decryption cipher contexts for methods (3DES and BLOWFISH)
+	// holds encryption and decryption cipher contexts for methods (3DES and BLOWFISH),
+	// and the keyed per-direction contexts for AESGCM (created on first use)
 #if OPENSSL_VERSION_NUMBER < 0x30000000L
 	const
 #endif
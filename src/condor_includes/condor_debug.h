@@ -225,6 +225,14 @@ void dprintf_async_safe( char const *msg, unsigned long *args, unsigned int num_
 
 void dprintf_dump_stack(void);
 
+/* Write out any log records that are waiting for the async log writer
+ * (see <SUBSYS>_LOG_ASYNC). EXCEPT calls this through _EXCEPT_Flush
+ * before the process exits.
+ */
+void dprintf_flush_log_writer(void);
+/* Same, but takes no locks, for use in a fatal signal handler */
+void dprintf_flush_log_writer_on_crash(void);
+
 /* If outputs haven't been configured yet, stop buffering dprintf()
  * output until they are configured.
  */
@@ -298,6 +306,7 @@ extern const char	*_EXCEPT_File;		/* File name of the exception      */
 extern int	_EXCEPT_Errno;			/* errno from most recent system call */
 extern int (*_EXCEPT_Cleanup)(int,int,const char*);	/* Function to call to clean up (or NULL) */
 extern void (*_EXCEPT_Reporter)(const char * msg, int line, const char * file); /* called instead of dprintf if non-NULL */
+extern void (*_EXCEPT_Flush)(void);	/* called before exit to flush buffered log output (or NULL) */
 extern PREFAST_NORETURN void _EXCEPT_(const char*, ...) CHECK_PRINTF_FORMAT(1,2) GCC_NORETURN;
 
 class dprintf_on_function_exit {
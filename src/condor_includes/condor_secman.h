@@ -316,6 +316,20 @@ public:
 		// session, the lingering session will simply be replaced.
 	bool SetSessionLingerFlag(char const *session_id);
 
+		// Save the incoming sessions that were negotiated with our peers
+		// and have not expired to an encrypted file, so that after a restart
+		// those peers can resume their sessions instead of all of them
+		// authenticating again at once.  Returns the number of sessions
+		// saved, or -1 if the file could not be written.
+	int WriteSessionSnapshot(const char *filename);
+
+		// Add the sessions saved by WriteSessionSnapshot() to the session
+		// cache, skipping any that have since expired or whose token has been
+		// revoked by SEC_TOKEN_REVOCATION_EXPR.  The file is removed once it
+		// has been read.  Returns the number of sessions restored, or -1 if
+		// the file could not be read or decrypted.
+	int ReadSessionSnapshot(const char *filename);
+
 		// Given a list of crypto methods, return the first valid protocol name.
 	static Protocol getCryptProtocolNameToEnum(char const *name);
 	static const char *getCryptProtocolEnumToName(Protocol proto);
@@ -137,6 +137,11 @@ struct dprintf_output_settings
 
 void dprintf_set_outputs(const struct dprintf_output_settings *p_info, int c_info);
 
+// start and stop the async log writer thread, dprintf_set_outputs calls these
+// around changing the outputs.
+void dprintf_start_log_writer();
+void dprintf_stop_log_writer();
+
 void * dprintf_get_onerror_data();
 
 const char* _format_global_header(int cat_and_flags, int hdr_flags, DebugHeaderInfo & info);
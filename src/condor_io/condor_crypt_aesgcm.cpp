@@ -62,6 +62,49 @@ int Condor_Crypt_AESGCM::ciphertext_size_with_cs(int plaintext_size, StreamCrypt
     return ct_sz;
 }
 
+// The key schedule for a session is done once per direction, the first
+// time that direction is used, and the keyed context is kept in the crypto
+// state.  Each message after that only loads a new IV into the context.
+static EVP_CIPHER_CTX * get_keyed_context(Condor_Crypto_State *cs, bool for_encrypt)
+{
+    EVP_CIPHER_CTX *& ctx = for_encrypt ? cs->enc_ctx : cs->dec_ctx;
+    if (ctx) {
+        return ctx;
+    }
+
+    std::unique_ptr<EVP_CIPHER_CTX, decltype(&EVP_CIPHER_CTX_free)> new_ctx(EVP_CIPHER_CTX_new(), &EVP_CIPHER_CTX_free);
+    if (!new_ctx) {
+        dprintf(D_ALWAYS, "Condor_Crypt_AESGCM: ERROR: Failed to allocate new EVP method.\n");
+        return nullptr;
+    }
+
+    int rc = for_encrypt ? EVP_EncryptInit_ex(new_ctx.get(), EVP_aes_256_gcm(), NULL, NULL, NULL)
+                         : EVP_DecryptInit_ex(new_ctx.get(), EVP_aes_256_gcm(), NULL, NULL, NULL);
+    if (1 != rc) {
+        dprintf(D_ALWAYS, "Condor_Crypt_AESGCM: ERROR: Failed to create AES-GCM-256 mode.\n");
+        return nullptr;
+    }
+
+    if (1 != EVP_CIPHER_CTX_ctrl(new_ctx.get(), EVP_CTRL_GCM_SET_IVLEN, IV_SIZE, NULL)) {
+        dprintf(D_ALWAYS, "Condor_Crypt_AESGCM: ERROR: Failed to set IV length to %d.\n", IV_SIZE);
+        return nullptr;
+    }
+
+    const unsigned char *kdp = cs->m_keyInfo.getKeyData();
+    dprintf(D_NETWORK | D_VERBOSE, "Condor_Crypt_AESGCM DUMP : about to init %s key %0x %0x %0x %0x.\n",
+        for_encrypt ? "encrypt" : "decrypt", *(kdp), *(kdp + 15), *(kdp + 16), *(kdp + 31));
+
+    rc = for_encrypt ? EVP_EncryptInit_ex(new_ctx.get(), NULL, NULL, kdp, NULL)
+                     : EVP_DecryptInit_ex(new_ctx.get(), NULL, NULL, kdp, NULL);
+    if (1 != rc) {
+        dprintf(D_ALWAYS, "Condor_Crypt_AESGCM: ERROR: Failed to initialize key.\n");
+        return nullptr;
+    }
+
+    ctx = new_ctx.release();
+    return ctx;
+}
+
 bool Condor_Crypt_AESGCM::encrypt(Condor_Crypto_State *cs,
                                   const unsigned char *aad,
                                   int                  aad_len,
@@ -91,22 +134,6 @@ bool Condor_Crypt_AESGCM::encrypt(Condor_Crypto_State *cs,
     // Authentication tag is an additional 16 bytes; IV is 16 bytes
     output_len += MAC_SIZE + (sending_IV ? IV_SIZE : 0);
 
-    std::unique_ptr<EVP_CIPHER_CTX, decltype(&EVP_CIPHER_CTX_free)> ctx(EVP_CIPHER_CTX_new(), &EVP_CIPHER_CTX_free);
-    if (!ctx) {
-        dprintf(D_ALWAYS, "Condor_Crypt_AESGCM::encrypt: ERROR: Failed to allocate new EVP method.\n");
-        return false;
-    }
-
-    if (1 != EVP_EncryptInit_ex(ctx.get(), EVP_aes_256_gcm(), NULL, NULL, NULL)) {
-        dprintf(D_ALWAYS, "Condor_Crypt_AESGCM::encrypt: ERROR: Failed to create AES-GCM-256 mode.\n");
-        return false;
-    }
-
-    if (1 != EVP_CIPHER_CTX_ctrl(ctx.get(), EVP_CTRL_GCM_SET_IVLEN, IV_SIZE, NULL)) {
-        dprintf(D_ALWAYS, "Condor_Crypt_AESGCM::encrypt: ERROR: Failed to set IV length.\n");
-        return false;
-    }
-
     // here we do the math to change the IV.  we take the lowest 4 bytes, treat
     // it as an int, add the message counter, and put it back.  this guarantees
     // the IV changes from packet to packet.  if we max out, we don't want to
@@ -147,12 +174,13 @@ bool Condor_Crypt_AESGCM::encrypt(Condor_Crypto_State *cs,
         return false;
     }
 
-    const unsigned char *kdp = cs->m_keyInfo.getKeyData();
-    dprintf(D_NETWORK | D_VERBOSE, "Condor_Crypt_AESGCM::encrypt DUMP : about to init key %0x %0x %0x %0x.\n",
-        *(kdp), *(kdp + 15), *(kdp + 16), *(kdp + 31));
+    EVP_CIPHER_CTX *ctx = get_keyed_context(cs, true);
+    if (!ctx) {
+        return false;
+    }
 
-    if (1 != EVP_EncryptInit_ex(ctx.get(), NULL, NULL, cs->m_keyInfo.getKeyData(), iv)) {
-        dprintf(D_ALWAYS, "Condor_Crypt_AESGCM::encrypt: ERROR: Failed to initialize key and IV.\n");
+    if (1 != EVP_EncryptInit_ex(ctx, NULL, NULL, NULL, iv)) {
+        dprintf(D_ALWAYS, "Condor_Crypt_AESGCM::encrypt: ERROR: Failed to initialize IV.\n");
         return false;
     }
 
@@ -160,13 +188,13 @@ bool Condor_Crypt_AESGCM::encrypt(Condor_Crypto_State *cs,
     int len;
     dprintf(D_NETWORK | D_VERBOSE, "Condor_Crypt_AESGCM::encrypt DUMP : We have %d bytes of AAD data: %s...\n",
         aad_len, debug_hex_dump(hexdbg, reinterpret_cast<const char *>(aad), std::min(16, aad_len)));
-    if (aad && (1 != EVP_EncryptUpdate(ctx.get(), NULL, &len, aad, aad_len))) {
+    if (aad && (1 != EVP_EncryptUpdate(ctx, NULL, &len, aad, aad_len))) {
         dprintf(D_ALWAYS, "Condor_Crypt_AESGCM::encrypt: ERROR: Failed to authenticate caller input data.\n");
         return false;
     }
 
     dprintf(D_NETWORK | D_VERBOSE, "Condor_Crypt_AESGCM::encrypt DUMP : We have %d bytes of plaintext\n", input_len);
-    if (1 != EVP_EncryptUpdate(ctx.get(), output + (sending_IV ? IV_SIZE : 0),
+    if (1 != EVP_EncryptUpdate(ctx, output + (sending_IV ? IV_SIZE : 0),
         &len, input, input_len))
     {
         dprintf(D_ALWAYS, "Condor_Crypt_AESGCM::encrypt: ERROR: Failed to encrypt plaintext buffer.\n");
@@ -175,7 +203,7 @@ bool Condor_Crypt_AESGCM::encrypt(Condor_Crypto_State *cs,
     dprintf(D_NETWORK | D_VERBOSE, "Condor_Crypt_AESGCM::encrypt DUMP : First %d bytes written to ciphertext.\n", len);
 
     int len2;
-    if (1 != EVP_EncryptFinal_ex(ctx.get(), output + (sending_IV ? IV_SIZE : 0) + len, &len2)) {
+    if (1 != EVP_EncryptFinal_ex(ctx, output + (sending_IV ? IV_SIZE : 0) + len, &len2)) {
         dprintf(D_ALWAYS, "Condor_Crypt_AESGCM::encrypt: ERROR: Failed to finalize cipher text.\n");
         return false;
     }
@@ -210,7 +238,7 @@ bool Condor_Crypt_AESGCM::encrypt(Condor_Crypto_State *cs,
 	}
 
     // extract the tag directly into the output stream to be given to CEDAR
-    if (1 != EVP_CIPHER_CTX_ctrl(ctx.get(), EVP_CTRL_GCM_GET_TAG, MAC_SIZE, output + output_len - MAC_SIZE)) {
+    if (1 != EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_GET_TAG, MAC_SIZE, output + output_len - MAC_SIZE)) {
         dprintf(D_ALWAYS, "Condor_Crypt_AESGCM::encrypt: ERROR: Failed to get tag.\n");
         return false;
     }
@@ -233,8 +261,6 @@ bool Condor_Crypt_AESGCM::decrypt(Condor_Crypto_State *cs,
                                   unsigned char *        output, 
                                   int&                   output_len)
 {
-    std::unique_ptr<EVP_CIPHER_CTX, decltype(&EVP_CIPHER_CTX_free)> ctx(EVP_CIPHER_CTX_new(), &EVP_CIPHER_CTX_free);
-
     dprintf(D_NETWORK | D_VERBOSE, "Condor_Crypt_AESGCM::decrypt **********************\n");
     dprintf(D_NETWORK | D_VERBOSE, "Condor_Crypt_AESGCM::decrypt with input buffer %d.\n", input_len);
     StreamCryptoState *stream_state = &(cs->m_stream_crypto_state);
@@ -248,23 +274,13 @@ bool Condor_Crypt_AESGCM::decrypt(Condor_Crypto_State *cs,
         return false;
     }
 
-    if (!ctx) {
-        dprintf(D_ALWAYS, "Condor_Crypt_AESGCM::decrypt: ERROR: Failed to initialize EVP object.\n");
-        return false;
-    }
-
-    if (!EVP_DecryptInit_ex(ctx.get(), EVP_aes_256_gcm(), NULL, NULL, NULL)) {
-        dprintf(D_ALWAYS, "Condor_Crypt_AESGCM::decrypt: ERROR: Failed to initialize AES-GCM-256 mode.\n");
-        return false;
-    }
-
-    if (!EVP_CIPHER_CTX_ctrl(ctx.get(), EVP_CTRL_GCM_SET_IVLEN, IV_SIZE, NULL)) {
-        dprintf(D_ALWAYS, "Condor_Crypt_AESGCM::decrypt: ERROR: Failed to initialize IV length to %d.\n", IV_SIZE);
+    if (cs->m_keyInfo.getProtocol() != CONDOR_AESGCM) {
+        dprintf(D_ALWAYS, "Condor_Crypt_AESGCM::decrypt: ERROR: failed due to the wrong protocol.\n");
         return false;
     }
 
-    if (cs->m_keyInfo.getProtocol() != CONDOR_AESGCM) {
-        dprintf(D_ALWAYS, "Condor_Crypt_AESGCM::decrypt: ERROR: failed due to the wrong protocol.\n");
+    EVP_CIPHER_CTX *ctx = get_keyed_context(cs, false);
+    if (!ctx) {
         return false;
     }
 
@@ -297,10 +313,6 @@ bool Condor_Crypt_AESGCM::decrypt(Condor_Crypto_State *cs,
     memcpy(iv, &ctr_encoded, sizeof(ctr_encoded));
     memcpy(iv + sizeof(ctr_encoded), stream_state->m_iv_dec.iv + sizeof(ctr_encoded), IV_SIZE - sizeof(ctr_encoded));
 
-    const unsigned char *kdp = cs->m_keyInfo.getKeyData();
-    dprintf(D_NETWORK | D_VERBOSE, "Condor_Crypt_AESGCM::decrypt DUMP : about to init key %0x %0x %0x %0x.\n",
-        *(kdp), *(kdp + 15), *(kdp + 16), *(kdp + 31));
-
     // for debugging, hexdbg at different times needs to hold hex
     // representation of IV, MAC, or initial AAD bytes.  currently
     // none are larger than 16 so the 128 is plenty.
@@ -309,15 +321,15 @@ bool Condor_Crypt_AESGCM::decrypt(Condor_Crypto_State *cs,
         debug_hex_dump(hexdbg,
         reinterpret_cast<const char *>(iv), IV_SIZE));
 
-    if (!EVP_DecryptInit_ex(ctx.get(), NULL, NULL, kdp, iv)) {
-        dprintf(D_ALWAYS, "Condor_Crypt_AESGCM::decrypt: ERROR: failed due to failed init.\n");
+    if (!EVP_DecryptInit_ex(ctx, NULL, NULL, NULL, iv)) {
+        dprintf(D_ALWAYS, "Condor_Crypt_AESGCM::decrypt: ERROR: failed due to failed IV init.\n");
         return false;
     }
 
     int len;
     dprintf(D_NETWORK | D_VERBOSE, "Condor_Crypt_AESGCM::decrypt DUMP : We have %d bytes of AAD data: %s...\n",
         aad_len, debug_hex_dump(hexdbg, reinterpret_cast<const char *>(aad), std::min(16, aad_len)));
-    if (aad && !EVP_DecryptUpdate(ctx.get(), NULL, &len, aad, aad_len)) {
+    if (aad && !EVP_DecryptUpdate(ctx, NULL, &len, aad, aad_len)) {
         dprintf(D_ALWAYS, "Condor_Crypt_AESGCM::decrypt: ERROR: failed when authenticating user AAD.\n");
         return false;
     }
@@ -332,7 +344,7 @@ bool Condor_Crypt_AESGCM::decrypt(Condor_Crypto_State *cs,
         return false;
     }
 
-    if (!EVP_DecryptUpdate(ctx.get(), output, &len, input + (receiving_IV ? IV_SIZE : 0), input_len - (receiving_IV ? IV_SIZE : 0) - MAC_SIZE)) {
+    if (!EVP_DecryptUpdate(ctx, output, &len, input + (receiving_IV ? IV_SIZE : 0), input_len - (receiving_IV ? IV_SIZE : 0) - MAC_SIZE)) {
         dprintf(D_ALWAYS, "Condor_Crypt_AESGCM::decrypt: ERROR: failed due to failed cipher text update.\n");
         return false;
     }
@@ -361,7 +373,7 @@ bool Condor_Crypt_AESGCM::decrypt(Condor_Crypto_State *cs,
 				*(output + len - 1));
 	}
 
-    if (!EVP_CIPHER_CTX_ctrl(ctx.get(), EVP_CTRL_GCM_SET_TAG, MAC_SIZE, const_cast<unsigned char *>(input + input_len - MAC_SIZE))) {
+    if (!EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_TAG, MAC_SIZE, const_cast<unsigned char *>(input + input_len - MAC_SIZE))) {
         dprintf(D_ALWAYS, "Condor_Crypt_AESGCM::decrypt: ERROR: failed due to failed set of tag.\n");
         return false;
     }
@@ -371,7 +383,7 @@ bool Condor_Crypt_AESGCM::decrypt(Condor_Crypto_State *cs,
         debug_hex_dump(hex2, reinterpret_cast<const char*>(input + input_len - MAC_SIZE), MAC_SIZE));
 
     dprintf(D_NETWORK | D_VERBOSE, "Condor_Crypt_AESGCM::decrypt DUMP : about to finalize output (len is %i).\n", len);
-    if (!EVP_DecryptFinal_ex(ctx.get(), output + len, &len)) {
+    if (!EVP_DecryptFinal_ex(ctx, output + len, &len)) {
         dprintf(D_ALWAYS, "Condor_Crypt_AESGCM::decrypt: ERROR: failed due to finalize decryption and check of tag.\n");
        return false;
     }
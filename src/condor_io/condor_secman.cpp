@@ -43,9 +43,14 @@
 #include "condor_auth_passwd.h"
 #include "condor_auth_ssl.h"
 #include "condor_base64.h"
+#include "secure_file.h"
+#include "store_cred.h"
 #include "globus_utils.h" // for warn_on_gsi_config()
 
+#include <openssl/evp.h>
+#include <openssl/rand.h>
 #include <sstream>
+#include <memory>
 #include <algorithm>
 #include <string>
 
@@ -4311,3 +4316,287 @@ SecMan::SetSessionLingerFlag(char const *session_id) {
 
 	return true;
 }
+
+// A session snapshot is one new ClassAd per line, one ad per saved session,
+// encrypted with AES-256-GCM under a key derived from the POOL token signing
+// key, so the file is no use to anyone who cannot already read that key (and
+// rotating the signing key throws the saved sessions away).  The file is
+//    magic | salt | iv | ciphertext | tag
+#define SESSION_SNAPSHOT_MAGIC "CSESSNP1"
+#define SESSION_SNAPSHOT_MAGIC_LEN 8
+#define SESSION_SNAPSHOT_SALT_LEN 16
+#define SESSION_SNAPSHOT_IV_LEN 12
+#define SESSION_SNAPSHOT_TAG_LEN 16
+#define SESSION_SNAPSHOT_KEY_LEN 32
+
+#define SNAPSHOT_ATTR_ID "Id"
+#define SNAPSHOT_ATTR_KEYS "Keys"
+#define SNAPSHOT_ATTR_POLICY "Policy"
+#define SNAPSHOT_ATTR_EXPIRATION "Expiration"
+#define SNAPSHOT_ATTR_LEASE_INTERVAL "LeaseInterval"
+#define SNAPSHOT_ATTR_LEASE_EXPIRATION "LeaseExpiration"
+
+static bool
+session_snapshot_key(const unsigned char *salt, unsigned char *key)
+{
+	std::string signing_key;
+	CondorError err;
+	if ( ! getTokenSigningKey("", signing_key, &err)) {
+		dprintf(D_ALWAYS, "SECMAN: no POOL signing key for the session snapshot: %s\n", err.getFullText().c_str());
+		return false;
+	}
+	const char info[] = "condor session snapshot";
+	int rc = Condor_Auth_Passwd::hkdf(reinterpret_cast<const unsigned char *>(signing_key.data()), signing_key.size(),
+		salt, SESSION_SNAPSHOT_SALT_LEN,
+		reinterpret_cast<const unsigned char *>(info), sizeof(info)-1,
+		key, SESSION_SNAPSHOT_KEY_LEN);
+	return rc == 0;
+}
+
+// encrypt (or decrypt) in with AES-256-GCM, the magic bytes are authenticated but not encrypted
+static bool
+session_snapshot_crypt(bool encrypt, const unsigned char *key, const unsigned char *iv,
+	const unsigned char *in, int in_len, unsigned char *out, unsigned char *tag)
+{
+	std::unique_ptr<EVP_CIPHER_CTX, decltype(&EVP_CIPHER_CTX_free)> ctx(EVP_CIPHER_CTX_new(), &EVP_CIPHER_CTX_free);
+	int len = 0;
+	if ( ! ctx ||
+		1 != EVP_CipherInit_ex(ctx.get(), EVP_aes_256_gcm(), NULL, NULL, NULL, encrypt ? 1 : 0) ||
+		1 != EVP_CIPHER_CTX_ctrl(ctx.get(), EVP_CTRL_GCM_SET_IVLEN, SESSION_SNAPSHOT_IV_LEN, NULL) ||
+		1 != EVP_CipherInit_ex(ctx.get(), NULL, NULL, key, iv, encrypt ? 1 : 0) ||
+		1 != EVP_CipherUpdate(ctx.get(), NULL, &len, reinterpret_cast<const unsigned char *>(SESSION_SNAPSHOT_MAGIC), SESSION_SNAPSHOT_MAGIC_LEN) ||
+		1 != EVP_CipherUpdate(ctx.get(), out, &len, in, in_len)) {
+		return false;
+	}
+	if ( ! encrypt && 1 != EVP_CIPHER_CTX_ctrl(ctx.get(), EVP_CTRL_GCM_SET_TAG, SESSION_SNAPSHOT_TAG_LEN, tag)) {
+		return false;
+	}
+	if (1 != EVP_CipherFinal_ex(ctx.get(), out + len, &len)) {
+		return false;
+	}
+	if (encrypt && 1 != EVP_CIPHER_CTX_ctrl(ctx.get(), EVP_CTRL_GCM_GET_TAG, SESSION_SNAPSHOT_TAG_LEN, tag)) {
+		return false;
+	}
+	return true;
+}
+
+// returns true if SEC_TOKEN_REVOCATION_EXPR says that the token the session
+// was authenticated with has been revoked. the expression is written in terms
+// of token claims, so we put the claims that the session policy kept under
+// their claim names.  as with tokens, failing to evaluate counts as revoked.
+static bool
+session_token_revoked(classad::ExprTree *revocation_expr, ClassAd &policy)
+{
+	if ( ! revocation_expr || ! policy.Lookup(ATTR_TOKEN_ID)) {
+		return false;
+	}
+	classad::ClassAd claims;
+	std::string val;
+	if (policy.LookupString(ATTR_TOKEN_ID, val)) { claims.InsertAttr("jti", val); }
+	if (policy.LookupString(ATTR_TOKEN_ISSUER, val)) { claims.InsertAttr("iss", val); }
+	if (policy.LookupString(ATTR_TOKEN_SUBJECT, val)) { claims.InsertAttr("sub", val); }
+	if (policy.LookupString(ATTR_TOKEN_SCOPES, val)) { claims.InsertAttr("scope", val); }
+
+	classad::EvalState state;
+	state.SetScopes(&claims);
+	classad::Value result;
+	bool revoked = true;
+	if ( ! revocation_expr->Evaluate(state, result) || ! result.IsBooleanValueEquiv(revoked)) {
+		return true;
+	}
+	return revoked;
+}
+
+int
+SecMan::WriteSessionSnapshot(const char *filename)
+{
+	time_t now = time(NULL);
+	int min_remaining = param_integer("SEC_SESSION_SNAPSHOT_MIN_REMAINING", 60, 0);
+
+	std::string plaintext;
+	classad::ClassAdUnParser unparser;
+	unparser.SetOldClassAd(false);
+	int num_sessions = 0;
+
+	KeyCacheEntry *entry = NULL;
+	m_default_session_cache.key_table->startIterations();
+	while (m_default_session_cache.key_table->iterate(entry)) {
+			// only incoming sessions that were negotiated with the peer
+			// and that will still be good for a while are worth saving.
+			// outgoing sessions and the sessions that were handed to us
+			// (family and claim sessions) will be made again after a restart.
+		if ( ! entry->addr().empty() || entry->getLingerFlag() || ! entry->policy()) {
+			continue;
+		}
+		bool negotiated = false;
+		entry->policy()->LookupBool(ATTR_SEC_NEGOTIATED_SESSION, negotiated);
+		if ( ! negotiated || ! entry->expiration() || entry->expiration() < now + min_remaining) {
+			continue;
+		}
+
+		ClassAd ad;
+		ad.Assign(SNAPSHOT_ATTR_ID, entry->id());
+		ad.Assign(SNAPSHOT_ATTR_EXPIRATION, entry->lifetimeExpiration());
+		ad.Assign(SNAPSHOT_ATTR_LEASE_INTERVAL, entry->leaseInterval());
+		ad.Assign(SNAPSHOT_ATTR_LEASE_EXPIRATION, (long long)entry->leaseExpiration());
+		std::string keys;
+		for (const KeyInfo *key : entry->keys()) {
+			char *encoded = condor_base64_encode(key->getKeyData(), key->getKeyLength(), false);
+			formatstr_cat(keys, "%s%d:%s", keys.empty() ? "" : ",", (int)key->getProtocol(), encoded);
+			free(encoded);
+		}
+		ad.Assign(SNAPSHOT_ATTR_KEYS, keys);
+		ad.Insert(SNAPSHOT_ATTR_POLICY, new ClassAd(*entry->policy()));
+
+		unparser.Unparse(plaintext, &ad);
+		plaintext += '\n';
+		++num_sessions;
+	}
+
+	unsigned char salt[SESSION_SNAPSHOT_SALT_LEN], iv[SESSION_SNAPSHOT_IV_LEN], key[SESSION_SNAPSHOT_KEY_LEN];
+	if (1 != RAND_bytes(salt, sizeof(salt)) || 1 != RAND_bytes(iv, sizeof(iv)) || ! session_snapshot_key(salt, key)) {
+		dprintf(D_ALWAYS, "SECMAN: unable to make a key for the session snapshot, not writing %s\n", filename);
+		return -1;
+	}
+
+	std::vector<unsigned char> file(SESSION_SNAPSHOT_MAGIC_LEN + sizeof(salt) + sizeof(iv) + plaintext.size() + SESSION_SNAPSHOT_TAG_LEN);
+	unsigned char *ptr = file.data();
+	memcpy(ptr, SESSION_SNAPSHOT_MAGIC, SESSION_SNAPSHOT_MAGIC_LEN); ptr += SESSION_SNAPSHOT_MAGIC_LEN;
+	memcpy(ptr, salt, sizeof(salt)); ptr += sizeof(salt);
+	memcpy(ptr, iv, sizeof(iv)); ptr += sizeof(iv);
+	bool ok = session_snapshot_crypt(true, key, iv, reinterpret_cast<const unsigned char *>(plaintext.data()),
+		(int)plaintext.size(), ptr, ptr + plaintext.size());
+	OPENSSL_cleanse(key, sizeof(key));
+	OPENSSL_cleanse(&plaintext[0], plaintext.size());
+	if ( ! ok) {
+		dprintf(D_ALWAYS, "SECMAN: failed to encrypt the session snapshot, not writing %s\n", filename);
+		return -1;
+	}
+
+	if ( ! replace_secure_file(filename, ".tmp", file.data(), file.size(), false)) {
+		return -1;
+	}
+	dprintf(D_ALWAYS, "SECMAN: saved %d security sessions to %s\n", num_sessions, filename);
+	return num_sessions;
+}
+
+int
+SecMan::ReadSessionSnapshot(const char *filename)
+{
+	void *data = NULL;
+	size_t len = 0;
+	if ( ! read_secure_file(filename, &data, &len, false)) {
+		return -1;
+	}
+	std::unique_ptr<unsigned char, decltype(&free)> file(static_cast<unsigned char *>(data), &free);
+
+		// a snapshot is only good for one restart
+	if (unlink(filename) != 0) {
+		dprintf(D_ALWAYS, "SECMAN: failed to remove session snapshot %s (errno %d), ignoring it\n", filename, errno);
+		return -1;
+	}
+
+	const size_t header_len = SESSION_SNAPSHOT_MAGIC_LEN + SESSION_SNAPSHOT_SALT_LEN + SESSION_SNAPSHOT_IV_LEN;
+	if (len < header_len + SESSION_SNAPSHOT_TAG_LEN ||
+		memcmp(file.get(), SESSION_SNAPSHOT_MAGIC, SESSION_SNAPSHOT_MAGIC_LEN) != 0) {
+		dprintf(D_ALWAYS, "SECMAN: %s is not a session snapshot, ignoring it\n", filename);
+		return -1;
+	}
+	const unsigned char *salt = file.get() + SESSION_SNAPSHOT_MAGIC_LEN;
+	const unsigned char *iv = salt + SESSION_SNAPSHOT_SALT_LEN;
+	const unsigned char *ciphertext = iv + SESSION_SNAPSHOT_IV_LEN;
+	int ciphertext_len = (int)(len - header_len - SESSION_SNAPSHOT_TAG_LEN);
+	unsigned char tag[SESSION_SNAPSHOT_TAG_LEN];
+	memcpy(tag, ciphertext + ciphertext_len, SESSION_SNAPSHOT_TAG_LEN);
+
+	unsigned char key[SESSION_SNAPSHOT_KEY_LEN];
+	if ( ! session_snapshot_key(salt, key)) {
+		return -1;
+	}
+	std::string plaintext(ciphertext_len, '\0');
+	bool ok = session_snapshot_crypt(false, key, iv, ciphertext, ciphertext_len,
+		reinterpret_cast<unsigned char *>(&plaintext[0]), tag);
+	OPENSSL_cleanse(key, sizeof(key));
+	if ( ! ok) {
+		dprintf(D_ALWAYS, "SECMAN: failed to decrypt session snapshot %s (has the POOL signing key changed?), ignoring it\n", filename);
+		return -1;
+	}
+
+	std::unique_ptr<classad::ExprTree> revocation_expr;
+	std::string revocation;
+	if ( ! param(revocation, "SEC_TOKEN_REVOCATION_EXPR")) {
+		param(revocation, "SEC_TOKEN_BLACKLIST_EXPR");
+	}
+	if ( ! revocation.empty()) {
+		classad::ExprTree *expr = NULL;
+		if ( ! ParseClassAdRvalExpr(revocation.c_str(), expr)) {
+			revocation_expr.reset(expr);
+		} else {
+			dprintf(D_ALWAYS, "SECMAN: unable to parse SEC_TOKEN_REVOCATION_EXPR, not restoring token sessions\n");
+			revocation_expr.reset(classad::Literal::MakeBool(true));
+		}
+	}
+
+	time_t now = time(NULL);
+	int num_restored = 0, num_expired = 0, num_revoked = 0, num_bad = 0;
+	classad::ClassAdParser parser;
+	size_t pos = 0;
+	while (pos < plaintext.size()) {
+		size_t eol = plaintext.find('\n', pos);
+		if (eol == std::string::npos) { eol = plaintext.size(); }
+		std::unique_ptr<classad::ClassAd> ad(parser.ParseClassAd(plaintext.substr(pos, eol - pos)));
+		pos = eol + 1;
+
+		std::string id, keys;
+		int expiration = 0, lease_interval = 0;
+		long long lease_expiration = 0;
+		classad::ClassAd *policy = NULL;
+		if ( ! ad || ! ad->EvaluateAttrString(SNAPSHOT_ATTR_ID, id) ||
+			! ad->EvaluateAttrString(SNAPSHOT_ATTR_KEYS, keys) ||
+			! ad->EvaluateAttrInt(SNAPSHOT_ATTR_EXPIRATION, expiration) ||
+			! ad->EvaluateAttrInt(SNAPSHOT_ATTR_LEASE_INTERVAL, lease_interval) ||
+			! ad->EvaluateAttrInt(SNAPSHOT_ATTR_LEASE_EXPIRATION, lease_expiration) ||
+			! (policy = dynamic_cast<classad::ClassAd*>(ad->Lookup(SNAPSHOT_ATTR_POLICY)))) {
+			++num_bad;
+			continue;
+		}
+		ClassAd policy_ad(*policy);
+		policy_ad.SetParentScope(NULL); // the copy would otherwise point back into ad
+
+		std::vector<KeyInfo*> keyvec;
+		StringList key_list(keys.c_str());
+		key_list.rewind();
+		const char *item;
+		while ((item = key_list.next())) {
+			const char *colon = strchr(item, ':');
+			if ( ! colon) { continue; }
+			unsigned char *key_data = NULL;
+			int key_len = 0;
+			condor_base64_decode(colon + 1, &key_data, &key_len, false);
+			if (key_data && key_len > 0) {
+				keyvec.push_back(new KeyInfo(key_data, key_len, (Protocol)atoi(item), 0));
+			}
+			free(key_data);
+		}
+		KeyCacheEntry entry(id, "", keyvec, &policy_ad, expiration, lease_interval);
+		entry.setLeaseExpiration((time_t)lease_expiration);
+
+		if ( ! entry.expiration() || entry.expiration() <= now) {
+			++num_expired;
+			continue;
+		}
+		if (session_token_revoked(revocation_expr.get(), policy_ad)) {
+			dprintf(D_SECURITY, "SECMAN: not restoring session %s, its token has been revoked\n", id.c_str());
+			++num_revoked;
+			continue;
+		}
+		if (m_default_session_cache.insert(entry)) {
+			++num_restored;
+		}
+	}
+	OPENSSL_cleanse(&plaintext[0], plaintext.size());
+
+	dprintf(D_ALWAYS, "SECMAN: restored %d security sessions from %s (%d expired, %d revoked, %d unreadable)\n",
+		num_restored, filename, num_expired, num_revoked, num_bad);
+	return num_restored;
+}
@@ -35,6 +35,14 @@
 
 #define MAX_MESSAGE_SIZE (1024*1024)
 
+// AES-GCM authenticates every packet separately, so when it is on we send
+// larger packets than CONDOR_IO_BUF_SIZE to cut the number of tags, headers
+// and cipher calls per message.  Peers accept packets up to 1MB.  The send
+// buffer also has room for the IV and tag, so that a packet can be encrypted
+// in place (see SndMsg::snd_packet).
+#define AESGCM_RECORD_SIZE (64*1024)
+#define AESGCM_RECORD_SLACK 32
+
 /**************************************************************/
 
 /* 
@@ -653,9 +661,11 @@ ReliSock::put_bytes_after_encryption(const void *dta, int sz) {
 	int		nw;
 	int 	tw = 0;
 	int		header_size = isOutgoing_Hash_on() ? MAX_HEADER_SIZE:NORMAL_HEADER_SIZE;
+	bool	aesgcm = get_encryption() && crypto_state_->m_keyInfo.getProtocol() == CONDOR_AESGCM;
+	int		packet_size = aesgcm ? header_size + AESGCM_RECORD_SIZE : snd_msg.buf.max_size();
 	for(nw=0;;) {
 		
-		if (snd_msg.buf.full()) {
+		if (snd_msg.buf.full() || snd_msg.buf.num_used() >= packet_size) {
 			int retval = snd_msg.snd_packet(peer_description(), _sock, FALSE, _timeout);
 			// This would block and the user asked us to work non-buffered - force the
 			// buffer to grow to hold the data for now.
@@ -669,10 +679,13 @@ ReliSock::put_bytes_after_encryption(const void *dta, int sz) {
 		}
 		
 		if (snd_msg.buf.empty()) {
+			if (aesgcm && snd_msg.buf.max_size() < packet_size + AESGCM_RECORD_SLACK) {
+				snd_msg.buf.grow_buf(packet_size + AESGCM_RECORD_SLACK);
+			}
 			snd_msg.buf.seek(header_size);
 		}
 		
-		if (dta && (tw = snd_msg.buf.put_max(&((const char *)dta)[nw], sz-nw)) < 0) {
+		if (dta && (tw = snd_msg.buf.put_max(&((const char *)dta)[nw], MIN(sz-nw, packet_size-snd_msg.buf.num_used()))) < 0) {
 			return -1;
 		}
 		
@@ -1187,14 +1200,6 @@ int ReliSock::SndMsg::snd_packet( char const *peer_description, int _sock, int e
 		ns = cipher_sz;
 		len = (int) htonl(ns);
 
-		// TODO In a large message, this code will grow the max packet
-		//   size by 16 bytes per packet sent. When a small packet
-		//   comes through (at the end of a message), the max packet
-		//   size will shrink back down (but no smaller than
-		//   CONDOR_IO_BUF_SIZE).
-		Buf new_buf(p_sock);
-		new_buf.grow_buf(cipher_sz + header_size);
-		new_buf.alloc_buf();
 		memcpy(&hdr[1], &len, 4);
 		unsigned char *aad_data = reinterpret_cast<unsigned char *>(hdr);
 		int aad_len = header_size;
@@ -1247,20 +1252,44 @@ int ReliSock::SndMsg::snd_packet( char const *peer_description, int _sock, int e
 				debug_hex_dump(hex, reinterpret_cast<char*>(aad_data), 32*2 + 5));
 		}
 
-		if ( ! ((Condor_Crypt_AESGCM*)p_sock->get_crypto())->encrypt(
-                        p_sock->crypto_state_,
-			aad_data,
-			aad_len,
-                        static_cast<unsigned char *>(buf.get_ptr()),
-			buf.num_untouched(),
-			static_cast<unsigned char *>(new_buf.get_ptr()) + header_size,
-			cipher_sz))
-		{
-			dprintf(D_SECURITY, "IO: Failed to encrypt packet\n");
-			return false;
+		// Once the IV has been sent, the ciphertext is the plaintext plus a
+		// trailing tag, so if the buffer has room for the tag we encrypt in
+		// place rather than allocating and copying into a new packet buffer.
+		bool in_place = p_sock->get_crypto_state()->m_stream_crypto_state.m_ctr_enc != 0 &&
+			buf.max_size() - buf.num_touched() >= cipher_sz;
+		if (in_place) {
+			if ( ! ((Condor_Crypt_AESGCM*)p_sock->get_crypto())->encrypt(
+				p_sock->crypto_state_,
+				aad_data,
+				aad_len,
+				static_cast<unsigned char *>(buf.get_ptr()),
+				buf.num_untouched(),
+				static_cast<unsigned char *>(buf.get_ptr()),
+				cipher_sz))
+			{
+				dprintf(D_SECURITY, "IO: Failed to encrypt packet\n");
+				return false;
+			}
+			buf.truncate(cipher_sz);
+		} else {
+			Buf new_buf(p_sock);
+			new_buf.grow_buf(cipher_sz + header_size);
+			new_buf.alloc_buf();
+			if ( ! ((Condor_Crypt_AESGCM*)p_sock->get_crypto())->encrypt(
+				p_sock->crypto_state_,
+				aad_data,
+				aad_len,
+				static_cast<unsigned char *>(buf.get_ptr()),
+				buf.num_untouched(),
+				static_cast<unsigned char *>(new_buf.get_ptr()) + header_size,
+				cipher_sz))
+			{
+				dprintf(D_SECURITY, "IO: Failed to encrypt packet\n");
+				return false;
+			}
+			buf.swap(new_buf);
+			buf.truncate(cipher_sz + header_size);
 		}
-		buf.swap(new_buf);
-		buf.truncate(cipher_sz + header_size);
 	}
 
 		// For non-AES-GCM encryption or unexpectedly large headers, release the memory...
@@ -32,6 +32,11 @@ unsigned int SharedPortClient::m_maxPendingPassSocketCalls = 0;
 unsigned int SharedPortClient::m_successPassSocketCalls = 0;
 unsigned int SharedPortClient::m_failPassSocketCalls = 0;
 unsigned int SharedPortClient::m_wouldBlockPassSocketCalls = 0;
+unsigned int SharedPortClient::m_batchedPassSocketCalls = 0;
+double SharedPortClient::m_passSocketLatencySum = 0.0;
+double SharedPortClient::m_passSocketLatencyMax = 0.0;
+unsigned int SharedPortClient::m_passSocketLatencyCount = 0;
+std::set<std::string> SharedPortClient::m_batchEndpoints;
 
 
 #ifdef HAVE_SCM_RIGHTS_PASSFD
@@ -44,8 +49,10 @@ unsigned int SharedPortClient::m_wouldBlockPassSocketCalls = 0;
 class SharedPortState: Service {
 
 public:
-	SharedPortState(ReliSock *sock, const char *shared_port_id, const char *requested_by, bool non_blocking)
-		: m_sock(sock),
+	SharedPortState(const std::vector<ReliSock*> & socks, const char *shared_port_id, const char *requested_by, bool non_blocking, double start_time)
+		: m_sock(socks[0]),
+		  m_socks(socks),
+		  m_start_time(start_time),
 		  m_shared_port_id(shared_port_id),
 		  m_requested_by(requested_by ? requested_by : ""),
 		  m_sock_name("UNKNOWN"),
@@ -56,7 +63,7 @@ public:
 		// Ctor
 
 		// keep a count of how many shared_port forwards are happening...
-		SharedPortClient::m_currentPendingPassSocketCalls++;
+		SharedPortClient::m_currentPendingPassSocketCalls += (unsigned int)m_socks.size();
 		// keep track of the max number for forwards happening...
 		if ( SharedPortClient::m_maxPendingPassSocketCalls <
 			 SharedPortClient::m_currentPendingPassSocketCalls )
@@ -68,9 +75,11 @@ public:
 
 	~SharedPortState() {
 		// keep a count of how many shared_port forwards are happening...
-		SharedPortClient::m_currentPendingPassSocketCalls--;
-		if ( m_dealloc_sock && m_sock ) {
-			delete m_sock;
+		SharedPortClient::m_currentPendingPassSocketCalls -= (unsigned int)m_socks.size();
+		if ( m_dealloc_sock ) {
+			for (ReliSock * sock : m_socks) {
+				delete sock;
+			}
 		}
 	}
 
@@ -82,6 +91,8 @@ private:
 
 	enum SPState {INVALID, UNBOUND, SEND_HEADER, SEND_FD, RECV_RESP};
 	ReliSock *m_sock;
+	std::vector<ReliSock*> m_socks; // m_sock and any others being passed with it
+	double m_start_time;
 	const char * m_shared_port_id;
 	std::string m_requested_by;
 	std::string m_sock_name;
@@ -345,8 +356,10 @@ SharedPortClient::PassSocket(Sock *sock_to_pass,char const *shared_port_id,char
 
 	/* Handle most (all?) Linux/Unix and MacOS platforms */
 
-	SharedPortState * state = new SharedPortState(static_cast<ReliSock*>(sock_to_pass),
-									shared_port_id, requested_by, non_blocking);
+	std::vector<ReliSock*> socks(1, static_cast<ReliSock*>(sock_to_pass));
+	SharedPortState * state = new SharedPortState(socks,
+									shared_port_id, requested_by, non_blocking,
+									_condor_debug_get_time_double());
 
 	int result = state->Handle();
 
@@ -381,6 +394,47 @@ SharedPortClient::PassSocket(Sock *sock_to_pass,char const *shared_port_id,char
 #endif
 }
 
+int
+SharedPortClient::PassSockets(const std::vector<Sock*> & socks_to_pass,char const *shared_port_id,double queued_time)
+{
+#if defined(HAVE_SHARED_PORT) && !defined(WIN32) && HAVE_SCM_RIGHTS_PASSFD
+	if (socks_to_pass.empty()) {
+		return TRUE;
+	}
+
+	std::vector<ReliSock*> socks;
+	for (Sock * sock : socks_to_pass) {
+		socks.push_back(static_cast<ReliSock*>(sock));
+	}
+	SharedPortState * state = new SharedPortState(socks, shared_port_id, NULL, true, queued_time);
+
+	int result = state->Handle();
+	switch (result)
+	{
+	case KEEP_STREAM:
+		break;
+	case SharedPortState::FAILED:
+		result = FALSE;
+		break;
+	case SharedPortState::DONE:
+		result = TRUE;
+		break;
+	default:
+		EXCEPT("ERROR SharedPortState::Handle() unexpected return code %d",result);
+		break;
+	}
+	return result;
+#else
+	// only the fd passing implementation can send more than one socket at a time
+	int result = TRUE;
+	for (Sock * sock : socks_to_pass) {
+		if (PassSocket(sock, shared_port_id) != TRUE) { result = FALSE; }
+	}
+	(void)queued_time;
+	return result;
+#endif
+}
+
 #ifdef HAVE_SCM_RIGHTS_PASSFD
 int
 SharedPortState::Handle(Stream *s)
@@ -424,10 +478,10 @@ SharedPortState::Handle(Stream *s)
 
 	// Update result statistics
 	if (result == DONE) {
-		SharedPortClient::m_successPassSocketCalls++;
+		SharedPortClient::m_successPassSocketCalls += (unsigned int)m_socks.size();
 	}
 	if (result == FAILED) {
-		SharedPortClient::m_failPassSocketCalls++;
+		SharedPortClient::m_failPassSocketCalls += (unsigned int)m_socks.size();
 	}
 
 	// If we are done, clean up and dellocate
@@ -660,8 +714,16 @@ SharedPortState::HandleHeader(Stream *&s)
 
 	ReliSock *sock = static_cast<ReliSock*>(s);
 	sock->encode();
-	if( !sock->put((int)SHARED_PORT_PASS_SOCK) ||
-		!sock->end_of_message() )
+	bool sent;
+	if (m_socks.size() > 1) {
+		sent = sock->put((int)SHARED_PORT_PASS_SOCKS) &&
+			sock->put((int)m_socks.size()) &&
+			sock->end_of_message();
+	} else {
+		sent = sock->put((int)SHARED_PORT_PASS_SOCK) &&
+			sock->end_of_message();
+	}
+	if( !sent )
 	{
 		dprintf(D_ALWAYS,"SharedPortClient: failed to send SHARED_PORT_PASS_FD to %s%s: %s\n",
 			m_sock_name.c_str(),
@@ -685,12 +747,13 @@ SharedPortState::HandleFD(Stream *&s)
 		// to the size of the cmsghdr buffer and then after initializing
 		// cmsghdr(s) to set it to the sum of CMSG_LEN() across all cmsghdrs.
 
+	size_t num_fds = m_socks.size();
 	struct msghdr msg;
-	char buf[CMSG_SPACE(sizeof(int))];
+	std::vector<char> buf(CMSG_SPACE(sizeof(int) * num_fds));
 	msg.msg_name = NULL;
 	msg.msg_namelen = 0;
-	msg.msg_control = buf;
-	msg.msg_controllen = CMSG_SPACE(sizeof(int));
+	msg.msg_control = buf.data();
+	msg.msg_controllen = buf.size();
 	msg.msg_flags = 0;
 
 		// I have found that on MacOS X 10.5, we must send at least 1 byte,
@@ -706,12 +769,14 @@ SharedPortState::HandleFD(Stream *&s)
 	void *cmsg_data = CMSG_DATA(cmsg);
 	ASSERT( cmsg && cmsg_data );
 
-	cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+	cmsg->cmsg_len = CMSG_LEN(sizeof(int) * num_fds);
 	cmsg->cmsg_level = SOL_SOCKET;
 	cmsg->cmsg_type = SCM_RIGHTS;
 
-	int fd_to_pass = m_sock->get_file_desc();
-	memcpy(cmsg_data,&fd_to_pass,sizeof(int));
+	for (size_t ix = 0; ix < num_fds; ++ix) {
+		int fd_to_pass = m_socks[ix]->get_file_desc();
+		memcpy((char*)cmsg_data + ix*sizeof(int),&fd_to_pass,sizeof(int));
+	}
 
 	msg.msg_controllen = cmsg->cmsg_len;
 
@@ -797,38 +862,63 @@ SharedPortState::HandleFD(Stream *&s)
 
 			// We can't use m_requested_by because it was supplied by the
 			// remote process (and therefore can't be trusted).
-			dprintf( D_AUDIT, *sock,
-				"Forwarding connection to PID = %d, UID = %d, GID = %d [executable '%s'; command line '%s'] via %s from %s.\n",
-				cred.pid, cred.uid, cred.gid,
-				procExe,
-				procCmdLine,
-				addr.sun_path,
-				m_sock->peer_addr().to_ip_and_port_string().c_str()
-			);
+			for (ReliSock * passed : m_socks) {
+				dprintf( D_AUDIT, *sock,
+					"Forwarding connection to PID = %d, UID = %d, GID = %d [executable '%s'; command line '%s'] via %s from %s.\n",
+					cred.pid, cred.uid, cred.gid,
+					procExe,
+					procCmdLine,
+					addr.sun_path,
+					passed->peer_addr().to_ip_and_port_string().c_str()
+				);
+			}
 		}
 	}
 #endif
 
 	if( sendmsg(sock->get_file_desc(),&msg,0) != 1 ) {
-		dprintf(D_ALWAYS,"SharedPortClient: failed to pass socket to %s%s: %s\n",
+		dprintf(D_ALWAYS,"SharedPortClient: failed to pass %d socket(s) to %s%s: %s\n",
+			(int)num_fds,
 			m_sock_name.c_str(),
 			m_requested_by.c_str(),
 			strerror(errno));
 		return FAILED;
 	}
 
+	double latency = _condor_debug_get_time_double() - m_start_time;
+	SharedPortClient::m_passSocketLatencySum += latency * num_fds;
+	SharedPortClient::m_passSocketLatencyCount += (unsigned int)num_fds;
+	if (latency > SharedPortClient::m_passSocketLatencyMax) {
+		SharedPortClient::m_passSocketLatencyMax = latency;
+	}
+	if (num_fds > 1) {
+		SharedPortClient::m_batchedPassSocketCalls += (unsigned int)num_fds;
+	}
+
 	m_state = RECV_RESP;
 	return WAIT;
 }
 
 SharedPortState::HandlerResult
-SharedPortState::HandleResp(Stream *&)
+SharedPortState::HandleResp(Stream *&s)
 {
     // We no longer send an ACK, since it's no longer necessary on Mac OS X,
     // and not doing so makes the protocol fully non-blocking.
+	// But an endpoint that can receive several sockets at once says so by
+	// sending a single byte before it closes the connection, older endpoints
+	// just close it.
+	if (s && m_non_blocking) {
+		char batch_ok = 0;
+		if (recv(static_cast<Sock*>(s)->get_file_desc(), &batch_ok, 1, MSG_DONTWAIT) == 1 &&
+			batch_ok == SHARED_PORT_BATCH_OK)
+		{
+			SharedPortClient::m_batchEndpoints.insert(m_sock_name);
+		}
+	}
 
 	dprintf(D_FULLDEBUG,
-		"SharedPortClient: passed socket to %s%s\n",
+		"SharedPortClient: passed %d socket(s) to %s%s\n",
+		(int)m_socks.size(),
 		m_sock_name.c_str(),
 		m_requested_by.c_str());
 
@@ -22,6 +22,8 @@
 
 #include "MyString.h"
 #include "reli_sock.h"
+#include <set>
+#include <vector>
 
 class SharedPortState;
 
@@ -37,6 +39,18 @@ friend class SharedPortState;
 	// the operation is still pending (it will be deleted once the operation is complete).
 	int PassSocket(Sock *sock_to_pass,char const *shared_port_id,char const *requested_by=NULL, bool non_blocking = false);
 
+	// PassSockets() is a non-blocking PassSocket() for several sockets going to
+	// the same shared_port_id, which are sent to the endpoint in a single message.
+	// Returns the same values as PassSocket(), KEEP_STREAM meaning that all of the
+	// sockets will be deleted once the operation is complete. queued_time is when
+	// the caller got the requests, for the pass latency statistics.
+	int PassSockets(const std::vector<Sock*> & socks_to_pass,char const *shared_port_id,double queued_time);
+
+	// true if the endpoint with this id has told us that it can receive
+	// several sockets at once (see SHARED_PORT_PASS_SOCKS).
+	static bool EndpointTakesBatches(const std::string & shared_port_id)
+		{return m_batchEndpoints.count(shared_port_id) > 0;}
+
 	unsigned int get_currentPendingPassSocketCalls() 
 		{return m_currentPendingPassSocketCalls;}
 	unsigned int get_maxPendingPassSocketCalls() 
@@ -47,6 +61,12 @@ friend class SharedPortState;
 		{return m_failPassSocketCalls;}
 	unsigned int get_wouldBlockPassSocketCalls() 
 		{return m_wouldBlockPassSocketCalls;}
+	unsigned int get_batchedPassSocketCalls()
+		{return m_batchedPassSocketCalls;}
+	double get_avgPassSocketLatency()
+		{return m_passSocketLatencyCount ? m_passSocketLatencySum / m_passSocketLatencyCount : 0.0;}
+	double get_maxPassSocketLatency()
+		{return m_passSocketLatencyMax;}
 
  private:
 	std::string myName();
@@ -64,6 +84,11 @@ friend class SharedPortState;
 	static unsigned int m_successPassSocketCalls;
 	static unsigned int m_failPassSocketCalls;
 	static unsigned int m_wouldBlockPassSocketCalls;
+	static unsigned int m_batchedPassSocketCalls; // sockets passed together with others
+	static double m_passSocketLatencySum; // seconds from request to sendmsg()
+	static double m_passSocketLatencyMax;
+	static unsigned int m_passSocketLatencyCount;
+	static std::set<std::string> m_batchEndpoints;
 };
 
 #endif
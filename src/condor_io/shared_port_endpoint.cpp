@@ -1084,7 +1084,20 @@ SharedPortEndpoint::DoListenerAccept(ReliSock *return_remote_sock)
 		return;
 	}
 
-	if( cmd != SHARED_PORT_PASS_SOCK ) {
+	int num_socks = 1;
+	if( cmd == SHARED_PORT_PASS_SOCKS ) {
+			// SharedPortClient::PassSockets() sends several sockets in one
+			// message, the count can't be more than the kernel allows in a
+			// single SCM_RIGHTS message.
+		if( !accepted_sock->get(num_socks) || num_socks < 1 || num_socks > SHARED_PORT_MAX_PASS_SOCKS ) {
+			dprintf(D_ALWAYS,
+					"SharedPortEndpoint: failed to read a valid socket count on %s\n",
+					m_full_name.c_str());
+			delete accepted_sock;
+			return;
+		}
+	}
+	else if( cmd != SHARED_PORT_PASS_SOCK ) {
 		dprintf(D_ALWAYS,
 				"SharedPortEndpoint: received unexpected command %d (%s) on named socket %s\n",
 				cmd,
@@ -1104,11 +1117,13 @@ SharedPortEndpoint::DoListenerAccept(ReliSock *return_remote_sock)
 	}
 
 	dprintf(D_COMMAND|D_FULLDEBUG,
-			"SharedPortEndpoint: received command %d SHARED_PORT_PASS_SOCK on named socket %s\n",
+			"SharedPortEndpoint: received command %d %s (%d sockets) on named socket %s\n",
 			cmd,
+			getCommandString(cmd),
+			num_socks,
 			m_full_name.c_str());
 
-	ReceiveSocket(accepted_sock,return_remote_sock);
+	ReceiveSocket(accepted_sock,return_remote_sock,num_socks);
 
 	delete accepted_sock;
 #endif
@@ -1116,7 +1131,7 @@ SharedPortEndpoint::DoListenerAccept(ReliSock *return_remote_sock)
 
 #ifndef WIN32
 void
-SharedPortEndpoint::ReceiveSocket( ReliSock *named_sock, ReliSock *return_remote_sock )
+SharedPortEndpoint::ReceiveSocket( ReliSock *named_sock, ReliSock *return_remote_sock, int num_socks )
 {
 #ifndef HAVE_SHARED_PORT
 	dprintf(D_ALWAYS,"SharedPortEndpoint::ReceiveSocket() not supported.\n");
@@ -1130,11 +1145,11 @@ SharedPortEndpoint::ReceiveSocket( ReliSock *named_sock, ReliSock *return_remote
 	// cmsghdr(s) to set it to the sum of CMSG_LEN() across all cmsghdrs.
 
 	struct msghdr msg;
-	char *buf = (char *) malloc(CMSG_SPACE(sizeof(int)));
+	char *buf = (char *) malloc(CMSG_SPACE(sizeof(int) * num_socks));
 	msg.msg_name = NULL;
 	msg.msg_namelen = 0;
 	msg.msg_control = buf;
-	msg.msg_controllen = CMSG_SPACE(sizeof(int));
+	msg.msg_controllen = CMSG_SPACE(sizeof(int) * num_socks);
 	msg.msg_flags = 0;
 
 		// I have found that on MacOS X 10.5, we must send at least 1 byte,
@@ -1150,12 +1165,12 @@ SharedPortEndpoint::ReceiveSocket( ReliSock *named_sock, ReliSock *return_remote
 	void *cmsg_data = CMSG_DATA(cmsg);
 	ASSERT( cmsg && cmsg_data );
 
-	cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+	cmsg->cmsg_len = CMSG_LEN(sizeof(int) * num_socks);
 	cmsg->cmsg_level = SOL_SOCKET;
 	cmsg->cmsg_type = SCM_RIGHTS;
 
-	int passed_fd = -1;
-	memcpy(cmsg_data,&passed_fd,sizeof(int));
+	std::vector<int> passed_fds(num_socks, -1);
+	memcpy(cmsg_data,passed_fds.data(),sizeof(int) * num_socks);
 
 	msg.msg_controllen = cmsg->cmsg_len;
 
@@ -1182,39 +1197,61 @@ SharedPortEndpoint::ReceiveSocket( ReliSock *named_sock, ReliSock *return_remote
 		return;
 	}
 
-	memcpy(&passed_fd,CMSG_DATA( cmsg ),sizeof(int));
+	int num_fds = 0;
+	if( cmsg->cmsg_len > CMSG_LEN(0) ) {
+		num_fds = (int)((cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int));
+	}
+	if( num_fds > num_socks ) { num_fds = num_socks; }
+	memcpy(passed_fds.data(),CMSG_DATA( cmsg ),sizeof(int) * num_fds);
+	free(buf);
 
-	if( passed_fd == -1 ) {
-		dprintf(D_ALWAYS,"ERROR: SharedPortEndpoint: got passed fd -1.\n");
-		free(buf);
-		return;
+	if( num_fds != num_socks ) {
+		dprintf(D_ALWAYS,"ERROR: SharedPortEndpoint: expected %d passed fds but got %d.\n",
+				num_socks, num_fds);
 	}
 
-		// create a socket object for the file descriptor we just received
+		// Let the SharedPortServer know that we can take several sockets
+		// at once.  Older servers never read this, which is harmless.
+	char batch_ok = SHARED_PORT_BATCH_OK;
+	IGNORE_RETURN send(named_sock->get_file_desc(),&batch_ok,1,MSG_DONTWAIT);
 
-	ReliSock *remote_sock = return_remote_sock;
-	if( !remote_sock ) {
-		remote_sock = new ReliSock();
-	}
-	// Don't EXCEPT if the connection we just accepted isn't of the same
-	// protocol as the connection we were expecting, which can happen
-	// a CCB client calls back a daemon.  See the comment for this
-	// function in condor_includes/sock.h.
-	remote_sock->assignCCBSocket( passed_fd );
-	remote_sock->enter_connected_state();
-	remote_sock->isClient(false);
+	for( int ix = 0; ix < num_fds; ++ix ) {
+		int passed_fd = passed_fds[ix];
+		if( passed_fd == -1 ) {
+			dprintf(D_ALWAYS,"ERROR: SharedPortEndpoint: got passed fd -1.\n");
+			continue;
+		}
+
+			// create a socket object for the file descriptor we just received.
+			// if the caller wants one socket back, it gets the first one.
 
-	dprintf(D_FULLDEBUG|D_COMMAND,
-			"SharedPortEndpoint: received forwarded connection from %s.\n",
-			remote_sock->peer_description());
+		ReliSock *remote_sock = (ix == 0) ? return_remote_sock : NULL;
+		bool return_it = remote_sock != NULL;
+		if( !remote_sock ) {
+			if( !daemonCore ) {
+				dprintf(D_ALWAYS,"SharedPortEndpoint: no place to put forwarded connection, closing it.\n");
+				close(passed_fd);
+				continue;
+			}
+			remote_sock = new ReliSock();
+		}
+		// Don't EXCEPT if the connection we just accepted isn't of the same
+		// protocol as the connection we were expecting, which can happen
+		// a CCB client calls back a daemon.  See the comment for this
+		// function in condor_includes/sock.h.
+		remote_sock->assignCCBSocket( passed_fd );
+		remote_sock->enter_connected_state();
+		remote_sock->isClient(false);
 
+		dprintf(D_FULLDEBUG|D_COMMAND,
+				"SharedPortEndpoint: received forwarded connection from %s.\n",
+				remote_sock->peer_description());
 
-	if( !return_remote_sock ) {
-		ASSERT( daemonCore );
-		daemonCore->HandleReqAsync(remote_sock);
-		remote_sock = NULL; // daemonCore took ownership of remote_sock
+		if( !return_it ) {
+			daemonCore->HandleReqAsync(remote_sock);
+			remote_sock = NULL; // daemonCore took ownership of remote_sock
+		}
 	}
-	free(buf);
 #else
 #error HAVE_SHARED_PORT is defined, but no method for passing fds is enabled.
 #endif
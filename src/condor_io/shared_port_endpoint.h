@@ -176,7 +176,7 @@ class SharedPortEndpoint: Service {
 
 	int HandleListenerAccept( Stream * stream );
 #ifndef WIN32
-	void ReceiveSocket( ReliSock *local_sock, ReliSock *return_remote_sock );
+	void ReceiveSocket( ReliSock *local_sock, ReliSock *return_remote_sock, int num_socks = 1 );
 #endif
 	bool InitRemoteAddress();
 	void RetryInitRemoteAddress();
@@ -25,6 +25,14 @@
 
 #include <sys/un.h>
 
+// The byte a SharedPortEndpoint sends back after receiving sockets, to say
+// that it also understands SHARED_PORT_PASS_SOCKS.
+#define SHARED_PORT_BATCH_OK 'B'
+
+// The most sockets that SHARED_PORT_PASS_SOCKS sends in one message, Linux
+// refuses SCM_RIGHTS messages with more than 253 fds.
+#define SHARED_PORT_MAX_PASS_SOCKS 253
+
 // Systems such as Solaris do not define the following macros.
 
 #ifndef SUN_LEN
@@ -26,7 +26,9 @@
 
 SharedPortServer::SharedPortServer():
 	m_registered_handlers(false),
-	m_publish_addr_timer(-1)
+	m_publish_addr_timer(-1),
+	m_pass_batch_size(1),
+	m_flush_passes_timer(-1)
 {
 }
 
@@ -42,6 +44,15 @@ SharedPortServer::~SharedPortServer() {
 	if( m_publish_addr_timer != -1 ) {
 		daemonCore->Cancel_Timer( m_publish_addr_timer );
 	}
+
+	if( m_flush_passes_timer != -1 ) {
+		daemonCore->Cancel_Timer( m_flush_passes_timer );
+	}
+	for (auto & it : m_pending_passes) {
+		for (PendingPass & pass : it.second) {
+			delete pass.sock;
+		}
+	}
 }
 
 void
@@ -95,6 +106,8 @@ SharedPortServer::InitAndReconfig() {
 	forker.Initialize();
 	int max_workers = param_integer("SHARED_PORT_MAX_WORKERS",50,0);
 	forker.setMaxWorkers( max_workers );
+
+	m_pass_batch_size = param_integer("SHARED_PORT_PASS_BATCH_SIZE",32,1,200);
 }
 
 void
@@ -151,6 +164,9 @@ SharedPortServer::PublishAddress()
 	ad.Assign("RequestsSucceeded",m_shared_port_client.get_successPassSocketCalls());
 	ad.Assign("RequestsFailed",m_shared_port_client.get_failPassSocketCalls());
 	ad.Assign("RequestsBlocked",m_shared_port_client.get_wouldBlockPassSocketCalls());
+	ad.Assign("RequestsBatched",m_shared_port_client.get_batchedPassSocketCalls());
+	ad.Assign("PassLatencyAvg",m_shared_port_client.get_avgPassSocketLatency());
+	ad.Assign("PassLatencyMax",m_shared_port_client.get_maxPassSocketLatency());
 	ad.Assign("ForkedChildrenCurrent",forker.getNumWorkers());
 	ad.Assign("ForkedChildrenPeak",forker.getPeakWorkers());
 
@@ -280,6 +296,24 @@ SharedPortServer::PassRequest(Sock *sock, const char *shared_port_id)
 		// Note: the HAVE_SCM_RIGHTS_PASSFD implementation of PassSocket()
 		// is nonblocking.  See gt #4094.
 		// Note: returns TRUE, FALSE, or KEEP_STREAM if operation is still pending...
+	if (m_pass_batch_size > 1) {
+			// Hold on to the request until daemonCore has accepted everything
+			// that is waiting on the command port, then send all of the requests
+			// for each target at once.
+		PendingPass pass = { sock, _condor_debug_get_time_double() };
+		m_pending_passes[shared_port_id].push_back(pass);
+		if (m_flush_passes_timer == -1) {
+			m_flush_passes_timer = daemonCore->Register_Timer(
+				0,
+				(TimerHandlercpp)&SharedPortServer::FlushPendingPasses,
+				"SharedPortServer::FlushPendingPasses",
+				this );
+		}
+		if (m_flush_passes_timer != -1) {
+			return KEEP_STREAM;
+		}
+		m_pending_passes[shared_port_id].pop_back();
+	}
 	result = m_shared_port_client.PassSocket((Sock *)sock, shared_port_id, NULL, true);
 #else
 		// Because of an ACK in the PassSocket protocol, this may block
@@ -309,6 +343,47 @@ SharedPortServer::PassRequest(Sock *sock, const char *shared_port_id)
 	return result;
 }
 
+void
+SharedPortServer::FlushPendingPasses()
+{
+	m_flush_passes_timer = -1;
+
+	std::map<std::string, std::vector<PendingPass> > pending;
+	pending.swap(m_pending_passes);
+
+	for (auto & it : pending) {
+		const std::string & shared_port_id = it.first;
+		std::vector<PendingPass> & passes = it.second;
+
+			// Until a target has told us that it understands batches, it gets
+			// the requests one at a time like always.
+		size_t batch_size = m_pass_batch_size;
+		if ( ! SharedPortClient::EndpointTakesBatches(shared_port_id)) {
+			batch_size = 1;
+		}
+
+		for (size_t start = 0; start < passes.size(); start += batch_size) {
+			size_t end = MIN(passes.size(), start + batch_size);
+			std::vector<Sock*> socks;
+			for (size_t ix = start; ix < end; ++ix) {
+				socks.push_back(passes[ix].sock);
+			}
+
+				// a batch of one is sent with the old SHARED_PORT_PASS_SOCK
+			int result = m_shared_port_client.PassSockets(socks, shared_port_id.c_str(), passes[start].queued_time);
+
+				// daemonCore has already forgotten about these sockets, so
+				// unless the client is still working on them, they are ours
+				// to close.
+			if (result != KEEP_STREAM) {
+				for (Sock * sock : socks) {
+					delete sock;
+				}
+			}
+		}
+	}
+}
+
 int
 SharedPortServer::HandleDefaultRequest(int cmd,Stream *sock)
 {
@@ -22,6 +22,8 @@
 
 #include "shared_port_client.h"
 #include "forkwork.h"
+#include <map>
+#include <vector>
 
 // SharedPortServer forwards connections received on this daemon's
 // command port to other daemons on the same machine through their
@@ -48,9 +50,20 @@ class SharedPortServer: Service {
 	std::string m_default_id;
 	ForkWork forker;
 
+		// Requests that arrived in this pass through the event loop, by target
+		// id, waiting to be sent to the target a batch at a time.
+	struct PendingPass {
+		Sock *sock;
+		double queued_time;
+	};
+	std::map<std::string, std::vector<PendingPass> > m_pending_passes;
+	int m_pass_batch_size;
+	int m_flush_passes_timer;
+
 	int HandleConnectRequest(int cmd,Stream *sock);
 	int HandleDefaultRequest(int cmd,Stream *sock);
 	int PassRequest(Sock *sock, const char *shared_port_id);
+	void FlushPendingPasses();
 	void PublishAddress();
 };
 
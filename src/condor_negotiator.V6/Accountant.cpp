@@ -74,8 +74,7 @@ GCC_DIAG_OFF(float-equal)
 // Constructor - One time initialization
 //------------------------------------------------------------------
 
-Accountant::Accountant():
-	concurrencyLimits(hashFunction)
+Accountant::Accountant()
 {
   MinPriority=0.5;
   AcctLog=NULL;
@@ -84,6 +83,8 @@ Accountant::Accountant():
   DefaultPriorityFactor = 1e3;
   HalfLifePeriod = 1.0f;
   LastUpdateTime = 0;
+  LastCheckpointTime = 0;
+  CheckpointInterval = 0;
   MaxAcctLogSize = 1000000;
   NiceUserPriorityFactor = 1e10;
   RemoteUserPriorityFactor = 1e7;
@@ -96,7 +97,10 @@ Accountant::Accountant():
 
 Accountant::~Accountant()
 {
-  if (AcctLog) delete AcctLog;
+  if (AcctLog) {
+    if (CheckpointInterval > 0) AcctLog->WriteCheckpoint();
+    delete AcctLog;
+  }
 }
 
 //------------------------------------------------------------------
@@ -116,6 +120,7 @@ void Accountant::Initialize(GroupEntry* root_group)
 
   // Set up HGQ accounting-group related information
   hgq_root_group = root_group;
+  ChangedGroups.clear();
   GroupEntry::Initialize(hgq_root_group);
   
   HalfLifePeriod = param_double("PRIORITY_HALFLIFE");
@@ -156,6 +161,7 @@ void Accountant::Initialize(GroupEntry* root_group)
   }
 
   MaxAcctLogSize = param_integer("MAX_ACCOUNTANT_DATABASE_SIZE",1000000);
+  CheckpointInterval = param_integer("ACCOUNTANT_DATABASE_CHECKPOINT_INTERVAL", 0, 0);
 
   if ( ! param(LogFileName, "ACCOUNTANT_DATABASE_FILE")) {
 	tmp = param("SPOOL");
@@ -181,14 +187,23 @@ void Accountant::Initialize(GroupEntry* root_group)
 				  AccountantLocalDomain.c_str());
   dprintf( D_ACCOUNTANT, "MAX_ACCOUNTANT_DATABASE_SIZE=%d\n",
 		   MaxAcctLogSize );
+  dprintf( D_ACCOUNTANT, "ACCOUNTANT_DATABASE_CHECKPOINT_INTERVAL=%d\n",
+		   CheckpointInterval );
 
+  // the checkpoint is loaded by InitLogFile, so that only the tail of the log is replayed
+  std::string CheckpointFileName = LogFileName + ".ckpt";
   if (!AcctLog) {
     AcctLog=new ClassAdLog<std::string,ClassAd*>();
+    AcctLog->SetCheckpointFilename(CheckpointInterval > 0 ? CheckpointFileName.c_str() : NULL);
     if (!AcctLog->InitLogFile(LogFileName.c_str())) {
       EXCEPT("Failed to initialize Accountant log!");
     }
     dprintf(D_ACCOUNTANT,"Accountant::Initialize - LogFileName=%s\n",
 					LogFileName.c_str());
+    BuildIndexes();
+    LastCheckpointTime = time(NULL);
+  } else {
+    AcctLog->SetCheckpointFilename(CheckpointInterval > 0 ? CheckpointFileName.c_str() : NULL);
   }
 
   // get last update time
@@ -199,8 +214,6 @@ void Accountant::Initialize(GroupEntry* root_group)
   // if at startup, do a sanity check to make certain number of resource
   // records for a user and what the user record says jives
   if ( first_time ) {
-	  std::string HK;
-	  ClassAd* ad;
 	  StringList users;
 	  int resources_used, resources_used_really;
 	  int total_overestimated_resources = 0;
@@ -214,18 +227,27 @@ void Accountant::Initialize(GroupEntry* root_group)
 	  dprintf(D_ACCOUNTANT,"Sanity check on number of resources per user\n");
 
 		// first find all the users
-	  AcctLog->table.startIterations();
-	  while (AcctLog->table.iterate(HK,ad)) {
-		char const *key = HK.c_str();
-			// skip records that are not customer records...
-		if (strncmp(CustomerRecord.c_str(),key,CustomerRecord.length())) continue;
-		char const *thisUser = &(key[CustomerRecord.length()]);
+	  for (const auto & name : CustomerNames) {
+		char const *thisUser = name.c_str();
 		if (! isalpha(*thisUser)) {
 			dprintf(D_ALWAYS, "questionable user %s\n", thisUser);
 		}
 			// if we made it here, append to our list of users
 		users.append( thisUser );
 	  }
+
+		// count the resources matched to each user and each group in a single
+		// pass, rather than walking all of the matches once for every user
+	  std::unordered_map<std::string, std::pair<int,double>> user_tally, group_tally;
+	  for (const auto & [ResourceName, rname] : MatchedResources) {
+		if (rname.empty()) continue;
+		double SlotWeight = 1.0;
+		GetAttributeFloat(ResourceRecord+ResourceName, SlotWeightAttr, SlotWeight);
+		auto & ut = user_tally[rname];
+		ut.first += 1; ut.second += SlotWeight;
+		auto & gt = group_tally[GroupEntry::GetAssignedGroup(hgq_root_group, rname)->name];
+		gt.first += 1; gt.second += SlotWeight;
+	  }
 		// ok, now StringList users has all the users.  for each user,
 		// compare what the customer record claims for usage -vs- actual
 		// number of resources
@@ -235,7 +257,18 @@ void Accountant::Initialize(GroupEntry* root_group)
 		  resources_used = GetResourcesUsed(user);
 		  resourcesRW_used = GetWeightedResourcesUsed(user);
 
-		  CheckResources(user, resources_used_really, resourcesRW_used_really);
+		  resources_used_really = 0;
+		  resourcesRW_used_really = 0;
+		  bool isGroup = false;
+		  std::string cgrp = GroupEntry::GetAssignedGroup(hgq_root_group, user, isGroup)->name;
+		  if ( ! isGroup || cgrp == user) {
+			  auto & tally = isGroup ? group_tally : user_tally;
+			  auto it = tally.find(user);
+			  if (it != tally.end()) {
+				  resources_used_really = it->second.first;
+				  resourcesRW_used_really = it->second.second;
+			  }
+		  }
 
 		  if ( resources_used == resources_used_really ) {
 			dprintf(D_ACCOUNTANT,"Customer %s using %d resources\n",next_user,
@@ -419,13 +452,9 @@ void Accountant::ResetAllUsage()
 {
   dprintf(D_ACCOUNTANT,"Accountant::ResetAllUsage\n");
   time_t T=time(0);
-  std::string HK;
-  ClassAd* ad;
 
-  AcctLog->table.startIterations();
-  while (AcctLog->table.iterate(HK,ad)) {
-	char const *key = HK.c_str();
-	if (strncmp(CustomerRecord.c_str(),key,CustomerRecord.length())) continue;
+  for (const auto & name : CustomerNames) {
+	std::string key = CustomerRecord + name;
 	AcctLog->BeginTransaction();
     SetAttributeFloat(key,AccumulatedUsageAttr,0);
     SetAttributeFloat(key,WeightedAccumulatedUsageAttr,0);
@@ -575,9 +604,9 @@ void Accountant::AddMatch(const std::string& CustomerName, ClassAd* ResourceAd)
       ResourceName += suffix;
   } else {
       // Check if the resource is used
-	  std::string RemoteUser;
-      if (GetAttributeString(ResourceRecord+ResourceName,RemoteUserAttr,RemoteUser)) {
-        if (CustomerName==RemoteUser) {
+      auto it = MatchedResources.find(ResourceName);
+      if (it != MatchedResources.end() && ! it->second.empty()) {
+        if (CustomerName==it->second) {
     	  dprintf(D_ACCOUNTANT,"Match already existed!\n");
           return;
         }
@@ -611,7 +640,9 @@ void Accountant::AddMatch(const std::string& CustomerName, ClassAd* ResourceAd)
 
   // Do everything we just to update the customer's record a second time if
   // there is a group record to update
-  std::string GroupName = GroupEntry::GetAssignedGroup(hgq_root_group, CustomerName)->name;
+  GroupEntry* Group = GroupEntry::GetAssignedGroup(hgq_root_group, CustomerName);
+  std::string GroupName = Group->name;
+  NoteGroupUsageChanged(Group);
 
 
   int GroupResourcesUsed=0;
@@ -658,6 +689,7 @@ void Accountant::AddMatch(const std::string& CustomerName, ClassAd* ResourceAd)
 
   // Set resource's info: user, and start-time
   SetAttributeString(ResourceRecord+ResourceName,RemoteUserAttr,CustomerName);
+  MatchedResources[ResourceName] = CustomerName;
   SetAttributeFloat(ResourceRecord+ResourceName,SlotWeightAttr,SlotWeight);
   SetAttributeInt(ResourceRecord+ResourceName,StartTimeAttr,T);
 
@@ -726,7 +758,9 @@ void Accountant::RemoveMatch(const std::string& ResourceName, time_t T)
   double WeightedGroupUnchargedTime=0.0;
   double HierWeightedResourcesUsed = 0.0;
   
-  std::string GroupName = GroupEntry::GetAssignedGroup(hgq_root_group, CustomerName)->name;
+  GroupEntry* Group = GroupEntry::GetAssignedGroup(hgq_root_group, CustomerName);
+  std::string GroupName = Group->name;
+  NoteGroupUsageChanged(Group);
   dprintf(D_ACCOUNTANT, "Customername %s GroupName is: %s\n",CustomerName.c_str(), GroupName.c_str());
   
   GetAttributeInt(CustomerRecord+GroupName,ResourcesUsedAttr,GroupResourcesUsed);
@@ -817,16 +851,7 @@ void Accountant::DisplayLog()
 
 void Accountant::DisplayMatches()
 {
-  std::string HK;
-  ClassAd* ad;
-  std::string ResourceName;
-  AcctLog->table.startIterations();
-  while (AcctLog->table.iterate(HK,ad)) {
-	char const *key = HK.c_str();
-    if (strncmp(ResourceRecord.c_str(),key,ResourceRecord.length())) continue;
-    ResourceName=key+ResourceRecord.length();
-    std::string RemoteUser;
-    ad->LookupString(RemoteUserAttr,RemoteUser);
+  for (const auto & [ResourceName, RemoteUser] : MatchedResources) {
     printf("Customer=%s , Resource=%s\n",RemoteUser.c_str(),ResourceName.c_str());
   }
 }
@@ -855,23 +880,27 @@ void Accountant::UpdatePriorities()
 
   dprintf(D_ACCOUNTANT,"(ACCOUNTANT) Updating priorities - AgingFactor=%8.3f , TimePassed=%d\n",AgingFactor,TimePassed);
 
-  std::string HK;
-  ClassAd* ad;
-
 	  // Each iteration of the loop should be atomic for consistency,
 	  // but instead of doing one transaction per iteration, wrap the
 	  // whole loop in one transaction for efficiency.
   AcctLog->BeginTransaction();
 
-  AcctLog->table.startIterations();
-  while (AcctLog->table.iterate(HK,ad)) {
-	char const *key = HK.c_str();
-	if (strncmp(CustomerRecord.c_str(),key,CustomerRecord.length())) continue;
-		UpdateOnePriority(T, TimePassed, AgingFactor, key, ad);
+	  // UpdateOnePriority may delete the record, so walk a copy of the names
+  std::vector<std::string> customers(CustomerNames.begin(), CustomerNames.end());
+  std::string key;
+  for (const auto & name : customers) {
+	key = CustomerRecord + name;
+	ClassAd* ad = GetClassAd(key);
+	if (ad) UpdateOnePriority(T, TimePassed, AgingFactor, key.c_str(), ad);
   }
 
   AcctLog->CommitTransaction();
 
+  if (CheckpointInterval > 0 && T - LastCheckpointTime >= CheckpointInterval) {
+	  AcctLog->WriteCheckpoint();
+	  LastCheckpointTime = T;
+  }
+
   // Check if the log needs to be truncated
   struct stat statbuf;
   if( stat(LogFileName.c_str(),&statbuf) ) {
@@ -1012,10 +1041,7 @@ void Accountant::CheckMatches(ClassAdListDoesNotDeleteAds& ResourceList)
   dprintf(D_ACCOUNTANT,"(Accountant) Checking Matches\n");
 
   ClassAd* ResourceAd;
-  std::string HK;
-  ClassAd* ad;
   std::string ResourceName;
-  std::string CustomerName;
 
 	  // Create a hash table for speedier lookups of Resource ads.
   HashTable<std::string,ClassAd *> resource_hash(hashFunction);
@@ -1030,25 +1056,22 @@ void Accountant::CheckMatches(ClassAdListDoesNotDeleteAds& ResourceList)
   }
   ResourceList.Close();
 
-  // Remove matches that were broken
-  AcctLog->table.startIterations();
-  while (AcctLog->table.iterate(HK,ad)) {
-    char const *key = HK.c_str();
-    if (strncmp(ResourceRecord.c_str(),key,ResourceRecord.length())) continue;
-    ResourceName=key+ResourceRecord.length();
-    if( resource_hash.lookup(ResourceName,ResourceAd) < 0 ) {
-      dprintf(D_ACCOUNTANT,"Resource %s class-ad wasn't found in the resource list.\n",ResourceName.c_str());
-      RemoveMatch(ResourceName);
+  // Remove matches that were broken, RemoveMatch changes MatchedResources
+  // so we collect the broken matches first
+  std::vector<std::string> broken;
+  for (const auto & [MatchName, MatchCustomer] : MatchedResources) {
+    if( resource_hash.lookup(MatchName,ResourceAd) < 0 ) {
+      dprintf(D_ACCOUNTANT,"Resource %s class-ad wasn't found in the resource list.\n",MatchName.c_str());
+      broken.push_back(MatchName);
     }
-	else {
-		// Here we need to figure out the CustomerName.
-      ad->LookupString(RemoteUserAttr,CustomerName);
-      if (!CheckClaimedOrMatched(ResourceAd, CustomerName)) {
-        dprintf(D_ACCOUNTANT,"Resource %s was not claimed by %s - removing match\n",ResourceName.c_str(),CustomerName.c_str());
-        RemoveMatch(ResourceName);
-      }
+    else if (!CheckClaimedOrMatched(ResourceAd, MatchCustomer)) {
+      dprintf(D_ACCOUNTANT,"Resource %s was not claimed by %s - removing match\n",MatchName.c_str(),MatchCustomer.c_str());
+      broken.push_back(MatchName);
     }
   }
+  for (const auto & name : broken) {
+    RemoveMatch(name);
+  }
 
   // Scan startd ads and add matches that are not registered
   ResourceList.Open();
@@ -1071,8 +1094,6 @@ void Accountant::CheckMatches(ClassAdListDoesNotDeleteAds& ResourceList)
 ClassAd* Accountant::ReportState(const std::string& CustomerName) {
     dprintf(D_ACCOUNTANT,"Reporting State for customer %s\n",CustomerName.c_str());
 
-    std::string HK;
-    ClassAd* ResourceAd;
     int StartTime;
 
     ClassAd* ad = new ClassAd();
@@ -1083,12 +1104,8 @@ ClassAd* Accountant::ReportState(const std::string& CustomerName) {
     if (isGroup && (cgrp != CustomerName)) return ad;
 
     int ResourceNum=1;
-    AcctLog->table.startIterations();
-    while (AcctLog->table.iterate(HK,ResourceAd)) {
-        if (strncmp(ResourceRecord.c_str(), HK.c_str(), ResourceRecord.length())) continue;
-
-        std::string rname;
-        if (ResourceAd->LookupString(RemoteUserAttr, rname)==0) continue;
+    for (const auto & [ResourceName, rname] : MatchedResources) {
+        if (rname.empty()) continue;
 
         if (isGroup) {
 			std::string rgrp = GroupEntry::GetAssignedGroup(hgq_root_group, rname)->name;
@@ -1099,9 +1116,9 @@ ClassAd* Accountant::ReportState(const std::string& CustomerName) {
 
 			std::string tmp;
             formatstr(tmp, "Name%d", ResourceNum);
-            ad->Assign(tmp, HK.c_str()+ResourceRecord.length());
+            ad->Assign(tmp, ResourceName);
 
-            if (ResourceAd->LookupInteger(StartTimeAttr,StartTime)==0) StartTime=0;
+            if ( ! GetAttributeInt(ResourceRecord+ResourceName,StartTimeAttr,StartTime)) StartTime=0;
             formatstr(tmp, "StartTime%d", ResourceNum);
             ad->Assign(tmp, StartTime);
         }
@@ -1123,14 +1140,8 @@ void Accountant::CheckResources(const std::string& CustomerName, int& NumResourc
     // This is a defunct group:
     if (isGroup && (cgrp != CustomerName)) return;
 
-    std::string HK;
-    ClassAd* ResourceAd;
-    AcctLog->table.startIterations();
-    while (AcctLog->table.iterate(HK, ResourceAd)) {
-        if (strncmp(ResourceRecord.c_str(), HK.c_str(), ResourceRecord.length())) continue;
-
-		std::string rname;
-        if (ResourceAd->LookupString(RemoteUserAttr, rname) == 0) continue;
+    for (const auto & [ResourceName, rname] : MatchedResources) {
+        if (rname.empty()) continue;
 
         if (isGroup) {
             if (cgrp != GroupEntry::GetAssignedGroup(hgq_root_group, rname)->name) continue;
@@ -1140,7 +1151,7 @@ void Accountant::CheckResources(const std::string& CustomerName, int& NumResourc
 
         NumResources += 1;
         double SlotWeight = 1.0;
-        ResourceAd->LookupFloat(SlotWeightAttr, SlotWeight);
+        GetAttributeFloat(ResourceRecord+ResourceName, SlotWeightAttr, SlotWeight);
         NumResourcesRW += SlotWeight;
     }
 }
@@ -1174,12 +1185,9 @@ ClassAd* Accountant::ReportState(bool rollup) {
     // attributes up the group hierarchy
     ReportGroups(hgq_root_group, ad, rollup, gnmap);
 
-    std::string HK;
-    ClassAd* CustomerAd = NULL;
-    AcctLog->table.startIterations();
-    while (AcctLog->table.iterate(HK,CustomerAd)) {
-        if (strncmp(CustomerRecord.c_str(), HK.c_str(), CustomerRecord.length())) continue;
-		std::string CustomerName = HK.c_str()+CustomerRecord.length();
+    for (const auto & CustomerName : CustomerNames) {
+        ClassAd* CustomerAd = GetClassAd(CustomerRecord+CustomerName);
+        if ( ! CustomerAd) continue;
 
         bool isGroup=false;
         GroupEntry* cgrp = GroupEntry::GetAssignedGroup(hgq_root_group, CustomerName, isGroup);
@@ -1439,12 +1447,9 @@ bool Accountant::ReportState(ClassAd& queryAd, ClassAdList & ads, bool rollup /*
 	long long result_limit = 0;
 	bool has_limit = queryAd.EvaluateAttrInt(ATTR_LIMIT_RESULTS, result_limit);
 
-	std::string HK;
-	ClassAd* CustomerAd = NULL;
-	AcctLog->table.startIterations();
-	while (AcctLog->table.iterate(HK, CustomerAd)) {
-		if (strncmp(CustomerRecord.c_str(), HK.c_str(), CustomerRecord.length())) continue;
-		std::string CustomerName = HK.c_str() + CustomerRecord.length();
+	for (const auto & CustomerName : CustomerNames) {
+		ClassAd* CustomerAd = GetClassAd(CustomerRecord + CustomerName);
+		if ( ! CustomerAd) continue;
 
 		if (has_limit && ads.Length() >= result_limit) {
 			break;
@@ -1675,19 +1680,65 @@ bool Accountant::DeleteClassAd(const std::string& Key)
 
   LogDestroyClassAd* log=new LogDestroyClassAd(Key.c_str());
   AcctLog->AppendLog(log);
+
+  if ( ! Key.compare(0, CustomerRecord.length(), CustomerRecord)) {
+    CustomerNames.erase(Key.substr(CustomerRecord.length()));
+  } else if ( ! Key.compare(0, ResourceRecord.length(), ResourceRecord)) {
+    MatchedResources.erase(Key.substr(ResourceRecord.length()));
+  }
   return true;
 }
 
+//------------------------------------------------------------------
+// Create a Class Ad (if it doesn't exist yet) and index it
+//------------------------------------------------------------------
+
+void Accountant::NewClassAdIfNeeded(const std::string& Key)
+{
+  if (AcctLog->AdExistsInTableOrTransaction(Key)) return;
+
+  LogNewClassAd* log=new LogNewClassAd(Key.c_str(),"*","*");
+  AcctLog->AppendLog(log);
+
+  if ( ! Key.compare(0, CustomerRecord.length(), CustomerRecord)) {
+    CustomerNames.insert(Key.substr(CustomerRecord.length()));
+  } else if ( ! Key.compare(0, ResourceRecord.length(), ResourceRecord)) {
+    MatchedResources.emplace(Key.substr(ResourceRecord.length()), "");
+  }
+}
+
+//------------------------------------------------------------------
+// Build the customer and match indexes from the loaded log
+//------------------------------------------------------------------
+
+void Accountant::BuildIndexes()
+{
+  CustomerNames.clear();
+  MatchedResources.clear();
+
+  std::string HK;
+  ClassAd* ad;
+  AcctLog->table.startIterations();
+  while (AcctLog->table.iterate(HK,ad)) {
+    if ( ! HK.compare(0, CustomerRecord.length(), CustomerRecord)) {
+      CustomerNames.insert(HK.substr(CustomerRecord.length()));
+    } else if ( ! HK.compare(0, ResourceRecord.length(), ResourceRecord)) {
+      std::string RemoteUser;
+      ad->LookupString(RemoteUserAttr, RemoteUser);
+      MatchedResources[HK.substr(ResourceRecord.length())] = RemoteUser;
+    }
+  }
+  dprintf(D_ACCOUNTANT, "Accountant has %d customer and %d resource records\n",
+          (int)CustomerNames.size(), (int)MatchedResources.size());
+}
+
 //------------------------------------------------------------------
 // Set an Integer attribute
 //------------------------------------------------------------------
 
 void Accountant::SetAttributeInt(const std::string& Key, const std::string& AttrName, int AttrValue)
 {
-  if (AcctLog->AdExistsInTableOrTransaction(Key) == false) {
-    LogNewClassAd* log=new LogNewClassAd(Key.c_str(),"*","*");
-    AcctLog->AppendLog(log);
-  }
+  NewClassAdIfNeeded(Key);
   char value[50];
   snprintf(value,sizeof(value),"%d",AttrValue);
   LogSetAttribute* log=new LogSetAttribute(Key.c_str(),AttrName.c_str(),value);
@@ -1700,10 +1751,7 @@ void Accountant::SetAttributeInt(const std::string& Key, const std::string& Attr
 
 void Accountant::SetAttributeFloat(const std::string& Key, const std::string& AttrName, double AttrValue)
 {
-  if (AcctLog->AdExistsInTableOrTransaction(Key) == false) {
-    LogNewClassAd* log=new LogNewClassAd(Key.c_str(),"*","*");
-    AcctLog->AppendLog(log);
-  }
+  NewClassAdIfNeeded(Key);
   
   char value[255];
   snprintf(value,sizeof(value),"%f",AttrValue);
@@ -1717,10 +1765,7 @@ void Accountant::SetAttributeFloat(const std::string& Key, const std::string& At
 
 void Accountant::SetAttributeString(const std::string& Key, const std::string& AttrName, const std::string& AttrValue)
 {
-  if (AcctLog->AdExistsInTableOrTransaction(Key) == false) {
-    LogNewClassAd* log=new LogNewClassAd(Key.c_str(),"*","*");
-    AcctLog->AppendLog(log);
-  }
+  NewClassAdIfNeeded(Key);
   
   std::string value;
   formatstr(value,"\"%s\"",AttrValue.c_str());
@@ -1837,6 +1882,11 @@ void Accountant::LoadLimits(ClassAdListDoesNotDeleteAds &resourceList)
 	}
 	resourceList.Close();
 
+		// Pick up any changes to the configured maximums
+	for (auto & lim : limitTable) {
+		lim.max = GetLimitMax(lim.name);
+	}
+
 		// Print out the new limits, at D_ACCOUNTANT. This is useful
 		// because the list printed from ClearLimits can be compared
 		// to see if anything may be going wrong
@@ -1846,15 +1896,48 @@ void Accountant::LoadLimits(ClassAdListDoesNotDeleteAds &resourceList)
 
 double Accountant::GetLimit(const  std::string& limit)
 {
-	double count = 0;
-
-	if (-1 == concurrencyLimits.lookup(limit, count)) {
+	auto it = limitIds.find(limit);
+	if (it == limitIds.end() || ! limitTable[it->second].in_use) {
 		dprintf(D_ACCOUNTANT,
 				"Looking for Limit '%s' count, which does not exist\n",
 				limit.c_str());
+		return 0;
+	}
+
+	return limitTable[it->second].count;
+}
+
+int Accountant::GetLimitId(const std::string& limit)
+{
+	auto it = limitIds.find(limit);
+	if (it != limitIds.end()) {
+		return it->second;
 	}
 
-	return count;
+	int id = (int)limitTable.size();
+	limitIds.emplace(limit, id);
+	limitTable.emplace_back();
+	limitTable.back().name = limit;
+	limitTable.back().max = GetLimitMax(limit);
+	return id;
+}
+
+void Accountant::ParseLimits(const std::string& limits, std::vector<ConcurrencyLimit>& parsed)
+{
+	parsed.clear();
+
+	StringList list(limits.c_str());
+	char *limit;
+	list.rewind();
+	while ((limit = list.next())) {
+		double increment;
+		if ( !ParseConcurrencyLimit(limit, increment) ) {
+			dprintf( D_FULLDEBUG, "Ignoring invalid concurrency limit '%s'\n",
+					 limit );
+			continue;
+		}
+		parsed.push_back({GetLimitId(limit), increment});
+	}
 }
 
 double Accountant::GetLimitMax(const  std::string& limit)
@@ -1871,39 +1954,33 @@ double Accountant::GetLimitMax(const  std::string& limit)
 
 void Accountant::DumpLimits()
 {
-	std::string limit;
- 	double count;
-	concurrencyLimits.startIterations();
-	while (concurrencyLimits.iterate(limit, count)) {
-		dprintf(D_ACCOUNTANT, "  Limit: %s = %f\n", limit.c_str(), count);
+	for (const auto & lim : limitTable) {
+		if ( ! lim.in_use) continue;
+		dprintf(D_ACCOUNTANT, "  Limit: %s = %f\n", lim.name.c_str(), lim.count);
 	}
 }
 
 void Accountant::ReportLimits(ClassAd *attrList)
 {
-	std::string limit;
- 	double count;
-	concurrencyLimits.startIterations();
-	while (concurrencyLimits.iterate(limit, count)) {
+	for (const auto & lim : limitTable) {
+		if ( ! lim.in_use) continue;
 		std::string attr;
-        formatstr(attr, "ConcurrencyLimit_%s", limit.c_str());
+        formatstr(attr, "ConcurrencyLimit_%s", lim.name.c_str());
         // classad wire protocol doesn't currently support attribute names that include
         // punctuation or symbols outside of '_'.  If we want to include '.' or any other
         // punct, we need to either model these as string values, or add support for quoted
         // attribute names in wire protocol:
         std::replace(attr.begin(), attr.end(), '.', '_');
-        attrList->Assign(attr, count);
+        attrList->Assign(attr, lim.count);
 	}
 }
 
 void Accountant::ClearLimits()
 {
-	std::string limit;
- 	double count;
-	concurrencyLimits.startIterations();
-	while (concurrencyLimits.iterate(limit, count)) {
-		concurrencyLimits.insert(limit, 0, true);
-		dprintf(D_ACCOUNTANT, "  Limit: %s = %f\n", limit.c_str(), count);
+	for (auto & lim : limitTable) {
+		if ( ! lim.in_use) continue;
+		dprintf(D_ACCOUNTANT, "  Limit: %s = %f\n", lim.name.c_str(), lim.count);
+		lim.count = 0;
 	}
 }
 
@@ -1916,7 +1993,9 @@ void Accountant::IncrementLimit(const std::string& _limit)
 
 	if ( ParseConcurrencyLimit(limit, increment) ) {
 
-		concurrencyLimits.insert(limit, GetLimit(limit) + increment, true);
+		LimitEntry & lim = limitTable[GetLimitId(limit)];
+		lim.count += increment;
+		lim.in_use = true;
 
 	} else {
 		dprintf( D_FULLDEBUG, "Ignoring invalid concurrency limit '%s'\n",
@@ -1935,7 +2014,9 @@ void Accountant::DecrementLimit(const std::string& _limit)
 
 	if ( ParseConcurrencyLimit(limit, increment) ) {
 
-		concurrencyLimits.insert(limit, GetLimit(limit) - increment, true);
+		LimitEntry & lim = limitTable[GetLimitId(limit)];
+		lim.count -= increment;
+		lim.in_use = true;
 
 	} else {
 		dprintf( D_FULLDEBUG, "Ignoring invalid concurrency limit '%s'\n",
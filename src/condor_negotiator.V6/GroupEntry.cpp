@@ -14,13 +14,30 @@ double calculate_subtree_usage(Accountant &accountant, GroupEntry *group) {
 	for (std::vector<GroupEntry*>::iterator i(group->children.begin());  i != group->children.end();  i++) {
 		subtree_usage += calculate_subtree_usage(accountant, *i);
 	}
-	subtree_usage += accountant.GetWeightedResourcesUsed(group->name);
+	group->own_usage = accountant.GetWeightedResourcesUsed(group->name);
+	subtree_usage += group->own_usage;
 
 	group->subtree_usage = subtree_usage;;
 	dprintf(D_FULLDEBUG, "subtree_usage at %s is %g\n", group->name.c_str(), subtree_usage);
 	return subtree_usage;
 }
 
+// Bring subtree_usage up to date after calculate_subtree_usage by applying the
+// usage changes of just the groups the accountant has matched or unmatched since,
+// rather than walking the whole tree again.
+void update_subtree_usage(Accountant &accountant) {
+	std::vector<GroupEntry*> changed;
+	accountant.TakeChangedGroups(changed);
+	for (GroupEntry *group: changed) {
+		double usage = accountant.GetWeightedResourcesUsed(group->name);
+		double delta = usage - group->own_usage;
+		group->own_usage = usage;
+		for (GroupEntry *g = group; g != NULL; g = g->parent) {
+			g->subtree_usage += delta;
+		}
+	}
+}
+
 GroupEntry::GroupEntry():
 	name(),
 	config_quota(0),
@@ -36,6 +53,7 @@ GroupEntry::GroupEntry():
 	subtree_quota(0),
 	subtree_requested(0),
 	subtree_usage(0),
+	own_usage(0),
 	rr(false),
 	rr_time(0),
 	subtree_rr_time(0),
@@ -266,6 +284,12 @@ GroupEntry::hgq_prepare_for_matchmaking(double hgq_total_quota, GroupEntry *hgq_
 		group->usage = accountant.GetWeightedResourcesUsed(group->name);
 	}
 
+	// The HGQ codes uses number of idle jobs to determine how to allocate
+	// surplus.  This should really be weighted demand when slot weights
+	// and paritionable slot are in use.  The schedd can tell us the cpu-weighed
+	// demand in ATTR_WEIGHTED_IDLE_JOBS.  If this knob is set, use it.
+	const bool use_weighted_demand = param_boolean("NEGOTIATOR_USE_WEIGHTED_DEMAND", true);
+
 	// cycle through the submitter ads, and load them into the appropriate group node in the tree
 	dprintf(D_ALWAYS, "group quotas: assigning %d submitters to accounting groups\n", int(submitterAds.size()));
 	for (ClassAd *ad: submitterAds) {
@@ -297,12 +321,7 @@ GroupEntry::hgq_prepare_for_matchmaking(double hgq_total_quota, GroupEntry *hgq_
 		int numrunning=0;
 		ad->LookupInteger(ATTR_RUNNING_JOBS, numrunning);
 
-		// The HGQ codes uses number of idle jobs to determine how to allocate
-		// surplus.  This should really be weighted demand when slot weights
-		// and paritionable slot are in use.  The schedd can tell us the cpu-weighed
-		// demand in ATTR_WEIGHTED_IDLE_JOBS.  If this knob is set, use it.
-
-		if (param_boolean("NEGOTIATOR_USE_WEIGHTED_DEMAND", true)) {
+		if (use_weighted_demand) {
 			double weightedIdle = numidle;
 			double weightedRunning = numrunning;
 
@@ -337,7 +356,7 @@ GroupEntry::hgq_prepare_for_matchmaking(double hgq_total_quota, GroupEntry *hgq_
 		dprintf(D_ALWAYS, "group quotas: autoregroup mode: appended %lu submitters to group %s negotiation\n", n, hgq_root_group->name.c_str());
 	}
 
-	hgq_root_group->hgq_assign_quotas(hgq_total_quota);
+	hgq_root_group->hgq_assign_quotas(hgq_total_quota, param_boolean("NEGOTIATOR_ALLOW_QUOTA_OVERSUBSCRIPTION", false));
 
 	dprintf(D_ALWAYS, "group quota: Quotas have been assigned to the following groups\n");
 	hgq_root_group->displayGroups(D_ALWAYS, false);
@@ -359,6 +378,7 @@ GroupEntry::hgq_negotiate_with_all_groups(GroupEntry *hgq_root_group, std::vecto
 	}
 
 	const bool ConsiderPreemption = param_boolean("NEGOTIATOR_CONSIDER_PREEMPTION",true);
+	const bool StrictEnforceQuota = param_boolean("NEGOTIATOR_STRICT_ENFORCE_QUOTA", true);
 	const bool autoregroup = hgq_root_group->autoregroup;
 
 	// The allocation of slots may occur multiple times, if rejections
@@ -456,6 +476,14 @@ GroupEntry::hgq_negotiate_with_all_groups(GroupEntry *hgq_root_group, std::vecto
 		std::vector<GroupEntry*> negotiating_groups(hgq_groups);
 		std::sort(negotiating_groups.begin(), negotiating_groups.end(), group_order(autoregroup, hgq_root_group));
 
+		// Strict quota enforcement needs the usage of every subtree as it changes with each negotiation.
+		// Compute it once for the round here, and afterwards only apply the accountant's changes.
+		if (StrictEnforceQuota) {
+			std::vector<GroupEntry*> changed;
+			accountant.TakeChangedGroups(changed);
+			calculate_subtree_usage(accountant, hgq_root_group);
+		}
+
 		// This loop implements "weighted round-robin" behavior to gracefully handle case of multiple groups competing
 		// for same subset of available slots.  It gives greatest weight to groups with the greatest difference
 		// between allocated and their current usage
@@ -501,7 +529,9 @@ GroupEntry::hgq_negotiate_with_all_groups(GroupEntry *hgq_root_group, std::vecto
 					slots = floor(slots);
 				}
 
-				slots = group->strict_enforce_quota(accountant, hgq_root_group, slots);
+				if (StrictEnforceQuota) {
+					slots = group->strict_enforce_quota(accountant, slots);
+				}
 
 				dprintf(D_ALWAYS, "Group %s - BEGIN NEGOTIATION with a quota limit of %g\n", group->name.c_str(), slots);
 				
@@ -551,11 +581,9 @@ GroupEntry::hgq_negotiate_with_all_groups(GroupEntry *hgq_root_group, std::vecto
 }
 
 void
-GroupEntry::hgq_assign_quotas(double quota) {
+GroupEntry::hgq_assign_quotas(double quota, bool allow_quota_oversub) {
 	dprintf(D_FULLDEBUG, "group quotas: subtree %s receiving quota= %g\n", this->name.c_str(), quota);
 
-	bool allow_quota_oversub = param_boolean("NEGOTIATOR_ALLOW_QUOTA_OVERSUBSCRIPTION", false);
-
 	// if quota is zero, we can leave this subtree with default quotas of zero
 	if (quota <= 0) return;
 
@@ -605,7 +633,7 @@ GroupEntry::hgq_assign_quotas(double quota) {
 			dprintf(D_ALWAYS, "group quotas: WARNING: dynamic quota for group %s rescaled from %g to %g\n", child->name.c_str(), child->config_quota, child->config_quota / Zd);
 		}
 
-		child->hgq_assign_quotas(q);
+		child->hgq_assign_quotas(q, allow_quota_oversub);
 		chq += q;
 	}
 
@@ -1015,39 +1043,37 @@ void hgq_allocate_surplus_loop(
 }
 
 double
-GroupEntry::strict_enforce_quota(Accountant &accountant, GroupEntry *hgq_root_group, double slots) {
-	if (param_boolean("NEGOTIATOR_STRICT_ENFORCE_QUOTA", true)) {
-		dprintf(D_FULLDEBUG, "NEGOTIATOR_STRICT_ENFORCE_QUOTA is true, current proposed allocation for %s is %g\n", this->name.c_str(), slots);
-		calculate_subtree_usage(accountant, hgq_root_group); // usage changes with every negotiation
-		GroupEntry *limitingGroup = this;
-
-		double my_new_allocation = slots - this->usage; // resources above what we already have
-		if (my_new_allocation < 0) {
-			//continue; // shouldn't get here
-		}
+GroupEntry::strict_enforce_quota(Accountant &accountant, double slots) {
+	dprintf(D_FULLDEBUG, "NEGOTIATOR_STRICT_ENFORCE_QUOTA is true, current proposed allocation for %s is %g\n", this->name.c_str(), slots);
+	update_subtree_usage(accountant); // usage changes with every negotiation
+	GroupEntry *limitingGroup = this;
+
+	double my_new_allocation = slots - this->usage; // resources above what we already have
+	if (my_new_allocation < 0) {
+		//continue; // shouldn't get here
+	}
 
-		while (limitingGroup != NULL) {
-			if (limitingGroup->accept_surplus == false) {
-				// This is the extra available at this node
-				double subtree_available = -1;
-				if (limitingGroup->static_quota) {
-					subtree_available = limitingGroup->config_quota - limitingGroup->subtree_usage;
-				} else {
-					subtree_available = limitingGroup->subtree_quota - limitingGroup->subtree_usage;
-				}
-				if (subtree_available < 0) subtree_available = 0;
-				dprintf(D_FULLDEBUG, "\tmy_new_allocation is %g subtree_available is %g\n", my_new_allocation, subtree_available);
-				if (my_new_allocation > subtree_available) {
-					dprintf(D_ALWAYS, "Group %s with accept_surplus=false has total usage = %g and config quota of %g -- constraining allocation in subgroup %s to %g\n",
-							limitingGroup->name.c_str(), limitingGroup->subtree_usage, limitingGroup->config_quota, this->name.c_str(), subtree_available + this->usage);
+	while (limitingGroup != NULL) {
+		if (limitingGroup->accept_surplus == false) {
+			// This is the extra available at this node
+			double subtree_available = -1;
+			if (limitingGroup->static_quota) {
+				subtree_available = limitingGroup->config_quota - limitingGroup->subtree_usage;
+			} else {
+				subtree_available = limitingGroup->subtree_quota - limitingGroup->subtree_usage;
+			}
+			if (subtree_available < 0) subtree_available = 0;
+			dprintf(D_FULLDEBUG, "\tmy_new_allocation is %g subtree_available is %g\n", my_new_allocation, subtree_available);
+			if (my_new_allocation > subtree_available) {
+				dprintf(D_ALWAYS, "Group %s with accept_surplus=false has total usage = %g and config quota of %g -- constraining allocation in subgroup %s to %g\n",
+						limitingGroup->name.c_str(), limitingGroup->subtree_usage, limitingGroup->config_quota, this->name.c_str(), subtree_available + this->usage);
 
-					my_new_allocation = subtree_available; // cap new allocation to the available
-				}
+				my_new_allocation = subtree_available; // cap new allocation to the available
 			}
-			limitingGroup = limitingGroup->parent;
 		}
-		slots = my_new_allocation + this->usage; // negotiation units are absolute quota, not new
+		limitingGroup = limitingGroup->parent;
 	}
+	slots = my_new_allocation + this->usage; // negotiation units are absolute quota, not new
 	return slots;
 }
 
@@ -25,13 +25,13 @@ struct GroupEntry {
 			bool &global_autoregroup,
 			bool &global_accept_surplus);
 
-        void hgq_assign_quotas(double quota);
+        void hgq_assign_quotas(double quota, bool allow_quota_oversub);
 
 		double hgq_fairshare();
 		double hgq_allocate_surplus(double surplus);
 		double hgq_recover_remainders();
 		double hgq_round_robin(double surplus);
-		double strict_enforce_quota(Accountant &accountant, GroupEntry *hgq_root_group, double slots);
+		double strict_enforce_quota(Accountant &accountant, double slots);
 
 		static void hgq_prepare_for_matchmaking(
 				double hgq_total_quota,
@@ -90,6 +90,8 @@ struct GroupEntry {
 
 		// sum of usage of this node and all children
 		double subtree_usage;
+		// usage of this node alone that subtree_usage was last computed from
+		double own_usage;
 		// true if this group got served by most recent round robin
 		bool rr;
 		// timestamp of most recent allocation from round robin
@@ -127,6 +129,7 @@ struct group_order {
 		group_order() : autoregroup(false), root_group(0) {}
 };
 double calculate_subtree_usage(Accountant &accountant, GroupEntry *group);
+void update_subtree_usage(Accountant &accountant);
 
 struct ord_by_rr_time {
 		std::vector<GroupEntry*>* data;
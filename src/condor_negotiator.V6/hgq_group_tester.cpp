@@ -3,34 +3,149 @@
 #include "compat_classad_list.h"
 #include "condor_common.h"
 #include "condor_config.h"
+#include "condor_attributes.h"
 
 #include <algorithm>
 // Test accountant
 // Just enough of the accountant to test
 
-std::map<std::string, float> usage;
+// usage: hgq_group_tester [-v] [num_groups]
 
-float
+std::map<std::string, double> usage;
+bool verbose = false;
+
+double
 Accountant::GetWeightedResourcesUsed(const std::string &name) {
-	float result = usage[name];
-	printf("GetWeightedResourcesUsed called for %s returning %g\n", name.c_str(), result);
+	double result = usage[name];
+	if (verbose) printf("GetWeightedResourcesUsed called for %s returning %g\n", name.c_str(), result);
 	return result;
 }
 
 bool
 Accountant::UsingWeightedSlots() const {return true;}
 
-Accountant::Accountant() : concurrencyLimits(hashFunction) {}
+Accountant::Accountant() {}
 Accountant::~Accountant() {}
 
-int main(int /*argc*/, char ** /*argv*/) {
+#define REQUIRE( condition ) \
+	if(! ( condition )) { \
+		fprintf( stderr, "Failed requirement '%s' on line %d.\n", #condition, __LINE__ ); \
+		return 1; \
+	} else if( verbose ) { \
+		fprintf( stdout, "Passed requirement '%s' on line %d.\n", #condition, __LINE__ ); \
+	}
+
+// Configure a tree of about num_groups groups, a level of parents with a level of
+// children under each, half of them with static quotas, and a submitter for each
+// child that wants more than its quota.
+static void make_tree(int num_groups, int total_cores, std::vector<ClassAd*> &submitterAds)
+{
+	int fanout = std::max(1, (int)sqrt((double)num_groups));
+	std::string names;
+	std::string knob, value;
+	for (int ix = 0; ix < fanout; ++ix) {
+		std::string parent;
+		formatstr(parent, "g%d", ix);
+		names += parent + ",";
+		formatstr(knob, "GROUP_QUOTA_DYNAMIC_%s", parent.c_str());
+		formatstr(value, "%g", 1.0 / fanout);
+		param_insert(knob.c_str(), value.c_str());
+		for (int jx = 0; jx < fanout - 1; ++jx) {
+			std::string child;
+			formatstr(child, "%s.s%d", parent.c_str(), jx);
+			names += child + ",";
+			if (jx & 1) {
+				formatstr(knob, "GROUP_QUOTA_%s", child.c_str());
+				formatstr(value, "%d", total_cores / num_groups);
+			} else {
+				formatstr(knob, "GROUP_QUOTA_DYNAMIC_%s", child.c_str());
+				formatstr(value, "%g", 1.0 / fanout);
+			}
+			param_insert(knob.c_str(), value.c_str());
+
+			ClassAd *ad = new ClassAd();
+			ad->Assign(ATTR_NAME, child + ".user@submit.example.com");
+			ad->Assign(ATTR_WEIGHTED_IDLE_JOBS, 1 + 2 * (total_cores / num_groups));
+			ad->Assign(ATTR_WEIGHTED_RUNNING_JOBS, 0);
+			submitterAds.push_back(ad);
+			usage[child] = 0;
+		}
+	}
+	param_insert("GROUP_NAMES", names.c_str());
+	param_insert("GROUP_ACCEPT_SURPLUS", "false");
+}
+
+// Negotiate with a large tree, checking that the subtree usage kept up to date from
+// the accountant's changes matches a full walk of the tree, and time it against
+// walking the whole tree for every group as strict quota enforcement used to.
+static int benchmark(int num_groups)
+{
+	int total_cores = num_groups * 10;
+	std::vector<ClassAd*> submitterAds;
+	make_tree(num_groups, total_cores, submitterAds);
+
+	bool autoregroup = false;
+	bool accept_surplus = false;
+	std::vector<GroupEntry*> hgq_groups;
+	groupQuotasHashType groupQuotasHash(hashFunction);
+	Accountant accountant;
+
+	GroupEntry *root_group = GroupEntry::hgq_construct_tree(hgq_groups, autoregroup, accept_surplus);
+	GroupEntry::Initialize(root_group);
+	REQUIRE( (int)hgq_groups.size() >= num_groups / 2 );
+
+	double secs[2];
+	for (int pass = 0; pass < 2; ++pass) {
+		for (auto & u : usage) { u.second = 0; }
+		bool full_walk = pass == 0;
+		auto callback = [&accountant, root_group, full_walk](GroupEntry *g, int quota) {
+			double new_usage = std::min(usage[g->name] + g->currently_requested, (double)quota);
+			if (new_usage != usage[g->name]) {
+				usage[g->name] = new_usage;
+				accountant.NoteGroupUsageChanged(g);
+			}
+			if (full_walk) calculate_subtree_usage(accountant, root_group);
+		};
+
+		double dstart = _condor_debug_get_time_double();
+		GroupEntry::hgq_prepare_for_matchmaking(total_cores, root_group, hgq_groups, accountant, submitterAds);
+		GroupEntry::hgq_negotiate_with_all_groups(root_group, hgq_groups, &groupQuotasHash, total_cores, accountant, callback, accept_surplus);
+		secs[pass] = _condor_debug_get_time_double() - dstart;
+
+		// usage was handed out to the children, and the incremental totals agree with a full walk
+		update_subtree_usage(accountant);
+		std::vector<double> incremental;
+		for (GroupEntry *group : hgq_groups) { incremental.push_back(group->subtree_usage); }
+		double total = calculate_subtree_usage(accountant, root_group);
+		REQUIRE( total > 0 && total <= total_cores );
+		for (size_t ix = 0; ix < hgq_groups.size(); ++ix) {
+			REQUIRE( fabs(incremental[ix] - hgq_groups[ix]->subtree_usage) < 0.001 );
+		}
+	}
+
+	printf("%d groups, %d submitters: full walk %.3fs, incremental %.3fs\n",
+		(int)hgq_groups.size(), (int)submitterAds.size(), secs[0], secs[1]);
+
+	delete root_group;
+	for (ClassAd *ad : submitterAds) { delete ad; }
+	return 0;
+}
+
+int main(int argc, char ** argv) {
+	int num_groups = 10000;
+	for (int ix = 1; ix < argc; ++ix) {
+		if (strcmp(argv[ix], "-v") == 0) { verbose = true; }
+		else { num_groups = atoi(argv[ix]); }
+	}
 
 	//const char * root_config = "ONLY_ENV";
 	//int config_options = CONFIG_OPT_WANT_META | CONFIG_OPT_USE_THIS_ROOT_CONFIG | CONFIG_OPT_NO_EXIT;
 	//config_host(NULL, config_options, root_config);
 	config();
 
-	dprintf_set_tool_debug("TOOL", 0);
+	// dprintf must be configured, or the negotiation log for a large tree is saved up in memory
+	if (verbose) dprintf_set_tool_debug("TOOL", 0);
+	else dprintf_set_tool_debug_log("TOOL", 0, "/dev/null");
 
 	bool autoregroup = false;
 	bool accept_surplus = false;
@@ -40,7 +155,7 @@ int main(int /*argc*/, char ** /*argv*/) {
 
 	int total_available_cores = 100;
 	classad::ClassAdParser	parser;
-	ClassAdListDoesNotDeleteAds submitterAds;
+	std::vector<ClassAd*> submitterAds;
 
 	std::string adtext;
 	ClassAd *ad = nullptr;
@@ -49,38 +164,40 @@ int main(int /*argc*/, char ** /*argv*/) {
 	adtext = "[ Name = \"group_a.user1@chevre.cs.wisc.edu\"; WeightedIdleJobs = 100; WeightedRunningJobs = 7;] ";
 	ad = parser.ParseClassAd(adtext);
 	usage["group_a"] = 7;
-	submitterAds.Insert(ad);
+	submitterAds.push_back(ad);
 
 	adtext = "[ Name = \"group_a.user2@chevre.cs.wisc.edu\"; WeightedIdleJobs = 2000; WeightedRunningJobs = 7;] ";
 	ad = parser.ParseClassAd(adtext);
 	usage["group_a"] += 7;
-	submitterAds.Insert(ad);
+	submitterAds.push_back(ad);
 	*/
 
 	adtext = "[ Name = \"group_b.user3@chevre.cs.wisc.edu\"; WeightedIdleJobs = 100; WeightedRunningJobs = 7;] ";
 	ad = parser.ParseClassAd(adtext);
 	usage["group_b"] = 7;
-	submitterAds.Insert(ad);
+	submitterAds.push_back(ad);
 
 	adtext = "[ Name = \"group_a.user4@chevre.cs.wisc.edu\"; WeightedIdleJobs = 100; WeightedRunningJobs = 1;] ";
 	ad = parser.ParseClassAd(adtext);
 	usage["group_a"] = 1;
-	submitterAds.Insert(ad);
+	submitterAds.push_back(ad);
 
-	auto callback = [](GroupEntry *g, int quota) {
-		float currentUsage = usage[g->name];
+	Accountant accountant;
+
+	auto callback = [&accountant](GroupEntry *g, int quota) {
+		double currentUsage = usage[g->name];
 		int new_usage = std::min(int(currentUsage + g->currently_requested), quota);
 		usage[g->name] = new_usage;
-		printf("Callback fired for group %s with %d submitters with limit %d requested is %g new_usage is %d\n", g->name.c_str(),g->submitterAds->Length(), quota, g->currently_requested, new_usage);
+		accountant.NoteGroupUsageChanged(g);
+		if (verbose) printf("Callback fired for group %s with %d submitters with limit %d requested is %g new_usage is %d\n", g->name.c_str(),(int)g->submitterAds->size(), quota, g->currently_requested, new_usage);
 	};
 
-	Accountant accountant;
 	GroupEntry *root_group = GroupEntry::hgq_construct_tree(hgq_groups, autoregroup, accept_surplus);
 
 	GroupEntry::hgq_prepare_for_matchmaking(total_available_cores, root_group, hgq_groups, accountant, submitterAds);
 
 	GroupEntry::hgq_negotiate_with_all_groups(
-			root_group, 
+			root_group,
 			hgq_groups,
 			groupQuotasHash,
 			total_available_cores,
@@ -91,5 +208,8 @@ int main(int /*argc*/, char ** /*argv*/) {
 	dprintf(D_ALWAYS, "After negotiate with all, groups look like\n");
 	root_group->displayGroups(D_ALWAYS, true);
 
-	return 0;
+	delete root_group;
+	usage.clear();
+
+	return benchmark(num_groups);
 }
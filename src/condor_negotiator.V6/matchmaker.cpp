@@ -55,6 +55,7 @@
 #endif
 
 #include "matchmaker.h"
+#include "param_handle.h"
 
 extern bool user_map_do_mapping(const char * mapname, const char * input, MyString & output);
 
@@ -1759,6 +1760,7 @@ negotiationTime ()
 	// ----- Recalculate priorities for schedds
 	accountant.UpdatePriorities();
 	accountant.CheckMatches( startdAds );
+	parsedConcurrencyLimits.clear();
 
 	if ( !groupQuotasHash ) {
 		groupQuotasHash = new groupQuotasHashType(hashFunction);
@@ -4190,7 +4192,8 @@ negotiate(char const* groupName, char const *submitterName, const ClassAd *submi
         }
         dprintf(D_FULLDEBUG, "Match completed, match cost= %g\n", match_cost);
 
-		if (param_boolean("NEGOTIATOR_DEPTH_FIRST", false)) {
+		static param_handle<bool> depth_first("NEGOTIATOR_DEPTH_FIRST", false);
+		if (depth_first) {
 			schedd_will_match = jobsInSlot(request, *offer);
 		}
 
@@ -4288,22 +4291,20 @@ rejectForConcurrencyLimits(std::string &limits)
 		return true;
 	}
 
-	StringList list(limits.c_str());
-	char *limit;
-	std::string str;
-	list.rewind();
-	while ((limit = list.next())) {
-		double increment;
-		if ( !ParseConcurrencyLimit(limit, increment) ) {
-			dprintf( D_FULLDEBUG, "Ignoring invalid concurrency limit '%s'\n",
-					 limit );
-			continue;
-		}
+	// each distinct limits string is parsed into limit ids once per cycle, after that
+	// checking the limits is just a lookup of the count and max for each id.
+	auto found = parsedConcurrencyLimits.find(limits);
+	if (found == parsedConcurrencyLimits.end()) {
+		found = parsedConcurrencyLimits.emplace(limits, std::vector<Accountant::ConcurrencyLimit>()).first;
+		accountant.ParseLimits(limits, found->second);
+	}
 
-		str = limit;
-		double count = accountant.GetLimit(str);
+	for (const auto & lim : found->second) {
+		const char * limit = accountant.GetLimitName(lim.id).c_str();
+		double increment = lim.increment;
+		double count = accountant.GetLimit(lim.id);
 
-		double max = accountant.GetLimitMax(str);
+		double max = accountant.GetLimitMax(lim.id);
 
 		dprintf(D_FULLDEBUG,
 			"Concurrency Limit: %s is %f of max %f\n",
@@ -4530,13 +4531,15 @@ matchmakingAlgorithm(const char *submitterName, const char *scheddAddr, ClassAd
 	rejPreemptForRank = 0;
 	rejForSubmitterLimit = 0;
 
-	bool allow_pslot_preemption = param_boolean("ALLOW_PSLOT_PREEMPTION", false);
+	static param_handle<bool> allow_pslot_preemption_knob("ALLOW_PSLOT_PREEMPTION", false);
+	bool allow_pslot_preemption = allow_pslot_preemption_knob;
 	double allocatedWeight = 0.0;
 		// Set up for parallel matchmaking, if enabled
 	std::vector<ClassAd *> par_candidates;
 	std::vector<ClassAd *> par_matches;
 
-	int num_threads =  param_integer("NEGOTIATOR_NUM_THREADS", 1);
+	static param_handle<int> negotiator_num_threads("NEGOTIATOR_NUM_THREADS", 1);
+	int num_threads = negotiator_num_threads;
 	if (num_threads > 1) {
 		startdAds.Open();
 		par_candidates.reserve(startdAds.Length());
@@ -5241,7 +5244,8 @@ Matchmaker::calculateSubmitterLimit(
 	submitterUsage = accountant.GetWeightedResourcesUsed( submitterName );
 	submitterShare = maxPrioValue/(submitterPrio*normalFactor);
 
-	if ( param_boolean("NEGOTIATOR_IGNORE_USER_PRIORITIES",false) ) {
+	static param_handle<bool> ignore_user_priorities("NEGOTIATOR_IGNORE_USER_PRIORITIES", false);
+	if ( ignore_user_priorities ) {
 		submitterLimit = DBL_MAX;
 	} else {
 		submitterLimit = (submitterShare*slotWeightTotal)-submitterUsage;
@@ -5432,10 +5436,8 @@ addRemoteUserPrios( ClassAd	*ad )
 		ad->Assign(ATTR_CURRENT_RANK, preemptingRank);
 	}
 		
-	char* resource_prefix = param("STARTD_RESOURCE_PREFIX");
-	if (!resource_prefix) {
-		resource_prefix = strdup("slot");
-	}
+	static param_handle<std::string> startd_resource_prefix("STARTD_RESOURCE_PREFIX", "slot");
+	const char * resource_prefix = startd_resource_prefix.get().c_str();
 	total_slots = 0;
 	if (!ad->LookupInteger(ATTR_TOTAL_SLOTS, total_slots)) {
 		total_slots = 0;
@@ -5478,7 +5480,6 @@ addRemoteUserPrios( ClassAd	*ad )
 			}
 		}	
 	}
-	free( resource_prefix );
 }
 
 void
@@ -34,6 +34,7 @@
 #include <vector>
 #include <string>
 #include <map>
+#include <unordered_map>
 #include <algorithm>
 
 typedef struct MapEntry {
@@ -395,6 +396,8 @@ class Matchmaker : public Service
 		int rejForSubmitterCeiling;   //   - not enough submitter ceiling ?
 	std::set<std::string> rejectedConcurrencyLimits;
 	std::string lastRejectedConcurrencyString;
+	// ConcurrencyLimits strings that have been parsed this cycle -> interned limits
+	std::unordered_map<std::string, std::vector<Accountant::ConcurrencyLimit>> parsedConcurrencyLimits;
 		bool m_dryrun;
 
 
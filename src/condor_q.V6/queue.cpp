@@ -376,6 +376,7 @@ static struct {
 } app;
 
 bool g_stream_results = false;
+const char * g_stream_sort_by = NULL; // attribute the schedd sorts streamed results by
 
 
 class CondorQClassAdFileParseHelper : public CondorClassAdFileParseHelper
@@ -1600,8 +1601,10 @@ processCommandLineArguments (int argc, const char *argv[])
 			}
 		}
 		else
-		if (is_dash_arg_prefix (dash_arg, "stream-results", 2)) {
+		if (is_dash_arg_colon_prefix (dash_arg, "stream-results", &pcolon, 2)) {
 			g_stream_results = true;
+			// the schedd sorts the results so that we can print them as they arrive
+			g_stream_sort_by = (pcolon && pcolon[1]) ? pcolon+1 : "JobId";
 			if( dash_dag || (qdo_mode == QDO_Progress)) {
 				fprintf( stderr, "-stream-results and -dag or -batch are incompatible\n" );
 				usage( argv[0] );
@@ -2088,7 +2091,8 @@ usage (const char *myName, int other)
 		"\t-idle\t\t\t Get information about idle jobs\n"
 		"\t-run\t\t\t Get information about running jobs\n"
 		"\t-totals\t\t\t Display only job totals\n"
-		"\t-stream-results \t Produce output as jobs are fetched\n"
+		"\t-stream-results[:<attr>] Produce output as jobs are fetched, in order\n"
+		"\t\t\t\t of <attr> and then job id, or of job id by default\n"
 		"\t-version\t\t Print the HTCondor version and exit\n"
 		"\t-wide[:<width>]\t\t Don't truncate data to fit in 80 columns.\n"
 		"\t\t\t\t Truncates to console width or <width> argument.\n"
@@ -3796,7 +3800,8 @@ show_schedd_queue(const char* scheddAddress, const char* scheddName, const char*
 		pfnProcess = AddJobToClassAdCollection;
 		pvProcess = &ads;
 	} else if (g_stream_results) {
-		pfnProcess = streaming_print_job;
+		// the cache optimizer only holds on to a few ads, so memory use stays constant
+		pfnProcess = init_cache_optimizer(streaming_print_job);
 		pvProcess = &writer;
 		// we are about to print out the jobads, so print an output header now.
 		print_full_header(source_label.c_str());
@@ -3841,6 +3846,9 @@ show_schedd_queue(const char* scheddAddress, const char* scheddName, const char*
 			// we do this so that a subsequent "condor_q -jobs <file> -nobatch" will show the correct job times.
 			Q.requestServerTime(true);
 		}
+		if (g_stream_results) {
+			Q.requestSortBy(g_stream_sort_by);
+		}
 		fetchResult = Q.fetchQueueFromHostAndProcess(scheddAddress, *pattrs, fetch_opts, g_match_limit, pfnProcess, pvProcess, useFastPath, &errstack, &summary_ad);
 		// In support of HTCONDOR-1125, grab queue time from summary ad if it is there.
 		if (summary_ad) { summary_ad->LookupInteger(ATTR_SERVER_TIME, queue_time); }
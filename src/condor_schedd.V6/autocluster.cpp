@@ -26,6 +26,8 @@
 #include "qmgmt.h"
 #include "schedd_stats.h" // for schedd_runtime_probe
 
+#include <openssl/sha.h>
+
 // this is a placeholder for a future class that will compactly hold a set of jobs
 // by taking into account the fact that it is common for only the cluster to be significant
 // and that consecutive cluster id's are often owned by the same user.
@@ -64,6 +66,8 @@ JobCluster::~JobCluster()
 void JobCluster::clear()
 {
 	cluster_map.clear();
+	cluster_hash_map.clear();
+	cluster_sigs.clear();
 #ifdef USE_AUTOCLUSTER_TO_JOBID_MAP
 	cluster_use.clear();
 	cluster_gone.clear();
@@ -195,13 +199,98 @@ void JobCluster::collect_garbage(bool brute_force) // free the deleted clusters
 		}
 		// advance here so that we can erase the previous entry if needed.
 		JobSigidMap::iterator last = it++;
-		if (gone) { cluster_map.erase(last); }
+		if (gone) { forget_cluster(last->second); cluster_map.erase(last); }
 	}
 	cluster_gone.clear();
 }
 
 #endif
 
+// remove the signature hashes and attributes of a cluster that is being deleted
+void JobCluster::forget_cluster(int id)
+{
+	auto it = cluster_sigs.find(id);
+	if (it == cluster_sigs.end()) {
+		return;
+	}
+	for (const auto & hash : it->second.hashes) {
+		auto hit = cluster_hash_map.find(hash);
+		if (hit != cluster_hash_map.end() && hit->second == id) {
+			cluster_hash_map.erase(hit);
+		}
+	}
+	cluster_sigs.erase(it);
+}
+
+// builds a JobSigHash from the first 128 bits of a SHA-256 of the names and values.
+// A hash hit puts a job into an autocluster without comparing signatures, so the
+// hash must be one that a user can't construct collisions for.
+class JobSigHasher {
+public:
+	JobSigHasher() : bytes(buffer()) { bytes.clear(); }
+	void add(const void * data, size_t len) { bytes.append((const char *)data, len); }
+	void add(char tag) { bytes += tag; }
+	void add(const std::string & str) {
+		size_t len = str.size();
+		add(&len, sizeof(len));
+		bytes.append(str);
+	}
+	void result(uint64_t & rlo, uint64_t & rhi) const {
+		unsigned char md[SHA256_DIGEST_LENGTH];
+		SHA256((const unsigned char *)bytes.data(), bytes.size(), md);
+		memcpy(&rlo, md, sizeof(rlo));
+		memcpy(&rhi, md + sizeof(rlo), sizeof(rhi));
+	}
+private:
+	// reused between jobs, so hashing does not allocate
+	static std::string & buffer() { static thread_local std::string buf; return buf; }
+	std::string & bytes;
+};
+
+// hash the value of a significant attribute.  Literals are hashed by type and value,
+// anything else is hashed by its unparsed text, which is what the signature string uses.
+static void hash_sig_value(JobSigHasher & hasher, ExprTree * tree, classad::ClassAdUnParser & unp, std::string & buf)
+{
+	if ( ! tree) {
+		hasher.add('\0');
+		return;
+	}
+	ExprTree * expr = tree;
+	if (expr->GetKind() == classad::ExprTree::EXPR_ENVELOPE) {
+		expr = ((classad::CachedExprEnvelope*)expr)->get();
+	}
+	if (expr && expr->GetKind() == classad::ExprTree::LITERAL_NODE) {
+		classad::Value val;
+		classad::Value::NumberFactor factor;
+		((classad::Literal*)expr)->GetComponents(val, factor);
+		long long ival;
+		double rval;
+		bool bval;
+		const char * sval;
+		if (val.IsIntegerValue(ival)) {
+			hasher.add('i'); hasher.add(&ival, sizeof(ival)); hasher.add((char)factor);
+			return;
+		} else if (val.IsRealValue(rval)) {
+			hasher.add('r'); hasher.add(&rval, sizeof(rval)); hasher.add((char)factor);
+			return;
+		} else if (val.IsBooleanValue(bval)) {
+			hasher.add(bval ? 'T' : 'F');
+			return;
+		} else if (val.IsStringValue(sval)) {
+			size_t len = strlen(sval);
+			hasher.add('s'); hasher.add(&len, sizeof(len)); hasher.add(sval, len);
+			return;
+		} else if (val.IsUndefinedValue()) {
+			hasher.add('u');
+			return;
+		}
+	}
+	buf.clear();
+	unp.Unparse(buf, tree);
+	hasher.add('x');
+	hasher.add(buf);
+}
+
 extern int    last_autocluster_classad_cache_hit;
 
 int JobCluster::getClusterid(JobQueueJob & job, bool expand_refs, std::string * final_list)
@@ -264,58 +353,90 @@ int JobCluster::getClusterid(JobQueueJob & job, bool expand_refs, std::string *
 	}
 
 	// sigset now contains the values of all the attributes we need,
-	// significant attibutes are first, followed by expanded attributes
-	// we build a signature essentially by printing it all out in one big string
+	// significant attibutes are first, followed by expanded attributes.
+	// hash the names and values in that order, jobs that have the same hash
+	// as an existing autocluster belong to it, and we don't need the signature string.
 	//
-	bool need_sep = false; // true after the first item, (when we need to print separators)
-	std::string signature;
-	signature.reserve(strlen(significant_attrs) + exattrs.size()*20 + sigset.size()*20); // make a guess as to how much space the signature will take.
-
 	classad::ClassAdUnParser unp;
 	unp.SetOldClassAd( true, true );
 
-	// first put the pre-defined significant attrs in the sig
+	JobSigHasher hasher;
+	std::string buf;
 	list.rewind();
 	int ix = 0;
 	while ((attr = list.next_string())) {
-		ExprTree * tree = sigset[ix];
-		signature += *attr;
-		signature += " = ";
-		if (tree) { unp.Unparse(signature, tree); }
-		signature += '\n';
-		if (final_list) {
-			if (need_sep) { (*final_list) += ','; }
-			final_list->append(*attr);
+		hasher.add(*attr);
+		hash_sig_value(hasher, sigset[ix++], unp, buf);
+	}
+	for (classad::References::iterator it = exattrs.begin(); it != exattrs.end(); ++it) {
+		hasher.add(*it);
+		hash_sig_value(hasher, sigset[ix++], unp, buf);
+	}
+	JobSigHash sighash;
+	hasher.result(sighash.lo, sighash.hi);
+
+	JobSighashMap::iterator hit = cluster_hash_map.find(sighash);
+	if (hit != cluster_hash_map.end()) {
+		cur_id = hit->second;
+		if (final_list) { *final_list = cluster_sigs[cur_id].attrs; }
+	} else {
+		// a new hash, we build the signature essentially by printing it all out in one big string
+		// the signature is still the key of the cluster map, so that a value that hashes
+		// differently but unparses the same (i.e. 1.0 vs 1.00) goes into the same autocluster
+		bool need_sep = false; // true after the first item, (when we need to print separators)
+		std::string signature;
+		std::string attrs_list;
+		signature.reserve(strlen(significant_attrs) + exattrs.size()*20 + sigset.size()*20); // make a guess as to how much space the signature will take.
+
+		// first put the pre-defined significant attrs in the sig
+		list.rewind();
+		ix = 0;
+		while ((attr = list.next_string())) {
+			ExprTree * tree = sigset[ix];
+			signature += *attr;
+			signature += " = ";
+			if (tree) { unp.Unparse(signature, tree); }
+			signature += '\n';
+			if (need_sep) { attrs_list += ','; }
+			attrs_list.append(*attr);
 			need_sep = true;
+			++ix;
 		}
-		++ix;
-	}
 
-	// now put out the expanded attribs (if any)
-	for (classad::References::iterator it = exattrs.begin(); it != exattrs.end(); ++it) {
-		ExprTree * tree = sigset[ix];
-		signature += *it;
-		signature += " = ";
-		if (tree) { unp.Unparse(signature, tree); }
-		signature += '\n';
-		if (final_list) {
-			if (need_sep) { (*final_list) += ','; }
-			final_list->append(*it);
+		// now put out the expanded attribs (if any)
+		for (classad::References::iterator it = exattrs.begin(); it != exattrs.end(); ++it) {
+			ExprTree * tree = sigset[ix];
+			signature += *it;
+			signature += " = ";
+			if (tree) { unp.Unparse(signature, tree); }
+			signature += '\n';
+			if (need_sep) { attrs_list += ','; }
+			attrs_list.append(*it);
 			need_sep = true;
+			++ix;
 		}
-		++ix;
-	}
 
-	// now check the signature against the current cluster map
-	// and either return the matching cluster id, or a new cluster id.
-	JobSigidMap::iterator it;
-	it = cluster_map.find(signature);
-	if (it != cluster_map.end()) {
-		cur_id = it->second;
-	}
-	else {
-		cur_id = next_id++;
-		cluster_map.insert(JobSigidMap::value_type(signature,cur_id));
+		// now check the signature against the current cluster map
+		// and either return the matching cluster id, or a new cluster id.
+		JobSigidMap::iterator it;
+		it = cluster_map.find(signature);
+		if (it != cluster_map.end()) {
+			cur_id = it->second;
+		}
+		else {
+			cur_id = next_id++;
+			cluster_map.insert(JobSigidMap::value_type(signature,cur_id));
+		}
+
+		ClusterSig & csig = cluster_sigs[cur_id];
+		if (csig.hashes.empty()) {
+			csig.attrs = attrs_list;
+			StringTokenIterator sti(attrs_list);
+			while ((attr = sti.next_string())) { csig.attr_set.insert(*attr); }
+		}
+		csig.hashes.push_back(sighash);
+		cluster_hash_map[sighash] = cur_id;
+		if (final_list) { *final_list = attrs_list; }
 	}
 
 #ifdef USE_AUTOCLUSTER_TO_JOBID_MAP
@@ -561,6 +682,7 @@ void AutoCluster::sweep()
 		if (in_use == cluster_in_use.end()) {
 				// found an entry to remove.
 			dprintf(D_FULLDEBUG,"removing auto cluster id %d\n",id);
+			forget_cluster(id);
 			cluster_map.erase( it );
 		}
 	}
@@ -629,6 +751,20 @@ bool AutoCluster::preSetAttribute(JobQueueJob &job, const char * attr, const cha
 	// the signature needs to be recomputed as it may have changed.
 	// Note we do this whether or not the transaction is committed - that
 	// is ok, and actually is probably more efficient than hitting disk.
+
+	// the attributes of the job's autocluster are the same as the job's ATTR_AUTO_CLUSTER_ATTRS,
+	// so when we still know them we can check the set rather than scanning the string.
+	if (job.autocluster_id > 0) {
+		auto it = cluster_sigs.find(job.autocluster_id);
+		if (it != cluster_sigs.end()) {
+			if (it->second.attr_set.count(attr)) {
+				removeFromAutocluster(job);
+				return true;
+			}
+			return false;
+		}
+	}
+
 	ExprTree * expr = job.Lookup(ATTR_AUTO_CLUSTER_ATTRS);
 	if (expr) {
 		std::string tmp;
@@ -26,6 +26,7 @@
 
 #include "condor_classad.h"
 #include <generic_stats.h>
+#include <unordered_map>
 
 class JobIdSet;
 class JobAggregationResults;
@@ -52,6 +53,23 @@ protected:
 	friend class JobAggregationResults;
 	typedef std::map<std::string,int> JobSigidMap;
 	JobSigidMap cluster_map;  // map of signature to a cluster id
+
+	// 128 bit hash of the significant attribute names and values of a job, so that jobs
+	// in an existing autocluster can be looked up without building the signature string.
+	struct JobSigHash {
+		uint64_t lo{0}, hi{0};
+		bool operator==(const JobSigHash & rhs) const { return lo == rhs.lo && hi == rhs.hi; }
+		struct hasher { size_t operator()(const JobSigHash & h) const { return (size_t)(h.lo ^ h.hi); } };
+	};
+	typedef std::unordered_map<JobSigHash, int, JobSigHash::hasher> JobSighashMap;
+	JobSighashMap cluster_hash_map; // map of signature hash to a cluster id
+	struct ClusterSig {
+		std::string attrs;            // the attributes in the signature, for ATTR_AUTO_CLUSTER_ATTRS
+		classad::References attr_set; // the same attributes, for preSetAttribute
+		std::vector<JobSigHash> hashes; // the hashes in cluster_hash_map that refer to this cluster
+	};
+	std::map<int, ClusterSig> cluster_sigs; // map of cluster id to its attributes and hashes
+	void forget_cluster(int id);
 #ifdef USE_AUTOCLUSTER_TO_JOBID_MAP
 	typedef std::map<int, JobIdSet> JobIdSetMap;
 	JobIdSetMap cluster_use; // map clusterId to a set of jobIds
@@ -0,0 +1,187 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2023, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+#include "condor_common.h"
+#include "condor_debug.h"
+#include "condor_config.h"
+#include "job_start_controller.h"
+
+	// the rate is halved when any of these is exceeded
+static const double MAX_DUTY_CYCLE = 0.95;		// fraction of time the main loop is busy
+static const double MAX_LOOP_LATENCY = 1.0;		// seconds busy per main loop cycle
+static const double MAX_SPAWN_TIME = 0.25;		// average seconds to spawn a shadow
+static const int MIN_FAILURES = 4;				// shadow failures, if also more than
+static const int MAX_FAILURES_PER_SPAWN = 4;	// one for every this many spawns
+
+JobStartController::JobStartController()
+	: m_enabled(false)
+	, m_interval(5)
+	, m_max_rate(0.0)
+	, m_min_free_memory(512)
+	, m_rate(0.0)
+	, m_this_second(0)
+	, m_starts_this_second(0)
+	, m_limited_by(NULL)
+	, m_held_back(false)
+	, m_starts(0)
+	, m_spawns(0)
+	, m_failures(0)
+	, m_spawn_time(0.0)
+	, m_last_duty_cycle(-1.0)
+	, m_last_loop_latency(-1.0)
+	, m_last_memory_available(-1)
+	, m_last_spawn_time(0.0)
+	, m_last_spawns(0)
+	, m_last_failures(0)
+{
+}
+
+void
+JobStartController::Config()
+{
+		// a fixed throttle configured with JOB_START_DELAY wins
+	m_enabled = param_boolean("JOB_START_ADAPTIVE", true) &&
+		param_integer("JOB_START_DELAY", 0) <= 0;
+	m_max_rate = param_integer("JOB_START_ADAPTIVE_MAX_RATE", 0, 0);
+	m_min_free_memory = param_integer("JOB_START_ADAPTIVE_MIN_FREE_MEMORY", 512, 0);
+
+	if (m_max_rate > 0 && (m_rate <= 0 || m_rate > m_max_rate)) {
+		m_rate = m_max_rate;
+	}
+}
+
+int
+JobStartController::NextStartDelay(time_t now)
+{
+	if (now != m_this_second) {
+		m_this_second = now;
+		m_starts_this_second = 0;
+	}
+	m_starts += 1;
+	if (m_rate <= 0 || ++m_starts_this_second < MAX(1, (int)m_rate)) {
+		return 0;
+	}
+	m_held_back = true;
+	return 1;
+}
+
+void
+JobStartController::ShadowSpawned(double spawn_time)
+{
+	m_spawns += 1;
+	m_spawn_time += spawn_time;
+}
+
+void
+JobStartController::ShadowFailed()
+{
+	m_failures += 1;
+}
+
+void
+JobStartController::Update(double duty_cycle, double loop_latency, long long memory_available)
+{
+	double spawn_time = m_spawns ? m_spawn_time / m_spawns : 0.0;
+
+	const char *limit = NULL;
+	if (duty_cycle > MAX_DUTY_CYCLE) {
+		limit = "MainLoopBusy";
+	} else if (loop_latency > MAX_LOOP_LATENCY) {
+		limit = "MainLoopLatency";
+	} else if (spawn_time > MAX_SPAWN_TIME) {
+		limit = "SpawnTime";
+	} else if (memory_available >= 0 && memory_available < m_min_free_memory) {
+		limit = "Memory";
+	} else if (m_failures >= MIN_FAILURES && m_failures * MAX_FAILURES_PER_SPAWN > m_spawns) {
+		limit = "ShadowFailures";
+	}
+
+	double old_rate = m_rate;
+	if (limit && m_rate > 0) {
+		m_rate = MAX(1.0, m_rate / 2);
+		m_limited_by = limit;
+	} else if (limit && m_starts > 0) {
+			// not throttled yet, so back off from the rate jobs were started at
+		m_rate = MAX(1.0, (double)m_starts / m_interval / 2);
+		m_limited_by = limit;
+	} else if (m_held_back && m_rate > 0) {
+		m_rate = m_rate + MAX(1.0, m_rate / 4);
+		if (m_max_rate > 0 && m_rate >= m_max_rate) {
+			m_rate = m_max_rate;
+			m_limited_by = "MaxRate";
+		} else {
+			m_limited_by = NULL;
+		}
+	}
+
+	if (fabs(m_rate - old_rate) > 1e-6) {
+		dprintf(D_FULLDEBUG,
+				"Job start rate %.1f -> %.1f/s (%s): %d starts, duty cycle %.2f, loop latency %.3fs, "
+				"%d spawns in %.3fs avg, %d failures, %lld MiB free\n",
+				old_rate, m_rate, limit ? limit : "held back", m_starts,
+				duty_cycle, loop_latency, m_spawns, spawn_time, m_failures, memory_available);
+	}
+
+	m_last_duty_cycle = duty_cycle;
+	m_last_loop_latency = loop_latency;
+	m_last_memory_available = memory_available;
+	m_last_spawn_time = spawn_time;
+	m_last_spawns = m_spawns;
+	m_last_failures = m_failures;
+
+	m_held_back = false;
+	m_starts = 0;
+	m_spawns = 0;
+	m_failures = 0;
+	m_spawn_time = 0.0;
+}
+
+void
+JobStartController::Publish(ClassAd &ad) const
+{
+	ad.Assign("JobStartAdaptive", m_enabled);
+	if ( ! m_enabled) {
+		ad.Delete("JobStartAdaptiveRate");
+		ad.Delete("JobStartAdaptiveLimitedBy");
+		ad.Delete("JobStartAdaptiveDutyCycle");
+		ad.Delete("JobStartAdaptiveLoopLatency");
+		ad.Delete("JobStartAdaptiveSpawnTime");
+		ad.Delete("JobStartAdaptiveSpawns");
+		ad.Delete("JobStartAdaptiveFailures");
+		ad.Delete("JobStartAdaptiveMemoryFree");
+		return;
+	}
+
+	if (m_rate > 0) {
+		ad.Assign("JobStartAdaptiveRate", m_rate);
+	} else {
+		ad.Delete("JobStartAdaptiveRate");
+	}
+	if (m_limited_by) {
+		ad.Assign("JobStartAdaptiveLimitedBy", m_limited_by);
+	} else {
+		ad.Delete("JobStartAdaptiveLimitedBy");
+	}
+	ad.Assign("JobStartAdaptiveDutyCycle", m_last_duty_cycle);
+	ad.Assign("JobStartAdaptiveLoopLatency", m_last_loop_latency);
+	ad.Assign("JobStartAdaptiveSpawnTime", m_last_spawn_time);
+	ad.Assign("JobStartAdaptiveSpawns", m_last_spawns);
+	ad.Assign("JobStartAdaptiveFailures", m_last_failures);
+	ad.Assign("JobStartAdaptiveMemoryFree", m_last_memory_available);
+}
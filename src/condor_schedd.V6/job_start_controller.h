@@ -0,0 +1,93 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2023, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+#ifndef _CONDOR_JOB_START_CONTROLLER_H
+#define _CONDOR_JOB_START_CONTROLLER_H
+
+#include "condor_classad.h"
+
+// Adaptive job start throttle (JOB_START_ADAPTIVE)
+//
+// Rather than starting a fixed JOB_START_COUNT jobs every JOB_START_DELAY
+// seconds, the schedd starts jobs as fast as it can, up to
+// JOB_START_ADAPTIVE_MAX_RATE a second if that is set, and the rate is
+// adjusted every Interval() seconds from what the schedd observed since the
+// last adjustment.  If the main loop was too busy, spawning shadows took too
+// long, memory ran low, or too many shadows failed to start, the rate is
+// halved, starting from the rate jobs were actually started at.  Otherwise,
+// if job starts were held back by the rate, it is raised by a quarter.
+//
+class JobStartController {
+ public:
+	JobStartController();
+
+	void Config();
+
+		// true when the adaptive throttle is used instead of the fixed one
+	bool Enabled() const { return m_enabled; }
+	int Interval() const { return m_interval; }
+		// jobs a second, 0 when starts are not throttled
+	double Rate() const { return m_rate; }
+
+		// Returns the delay before the next job start, 0 while the
+		// current second of the clock still has room under the rate.
+	int NextStartDelay() { return NextStartDelay(time(NULL)); }
+	int NextStartDelay(time_t now);
+
+		// Feedback about shadows spawned since the last Update()
+	void ShadowSpawned(double spawn_time);
+	void ShadowFailed();
+
+		// Adjust the rate.  duty_cycle is the fraction of the interval the
+		// main loop was busy, loop_latency the average time the main loop
+		// spent busy per cycle, and memory_available the free memory in MiB.
+		// Pass a negative value for anything that is not known.
+	void Update(double duty_cycle, double loop_latency, long long memory_available);
+
+		// publish the controller state in the schedd ad
+	void Publish(ClassAd &ad) const;
+
+ private:
+	bool m_enabled;
+	int m_interval;
+	double m_max_rate;
+	long long m_min_free_memory;	// MiB
+
+	double m_rate;				// 0 for no throttle
+	time_t m_this_second;
+	int m_starts_this_second;
+	const char *m_limited_by;	// why the rate last went down, or NULL
+
+		// observed since the last Update()
+	bool m_held_back;
+	int m_starts;
+	int m_spawns;
+	int m_failures;
+	double m_spawn_time;
+
+		// what the last Update() saw
+	double m_last_duty_cycle;
+	double m_last_loop_latency;
+	long long m_last_memory_available;
+	double m_last_spawn_time;
+	int m_last_spawns;
+	int m_last_failures;
+};
+
+#endif
@@ -28,6 +28,7 @@
 JobTransforms::JobTransforms()
 {
 	mset_ckpt = NULL;
+	num_uncompiled = 0;
 }
 
 JobTransforms::~JobTransforms()
@@ -44,6 +45,7 @@ JobTransforms::clear_transforms_list()
 		delete xfm;
 	}
 	transforms_list.Clear();
+	num_uncompiled = 0;
 }
 
 void 
@@ -135,12 +137,19 @@ JobTransforms::initAndReconfig()
 		// apply a broken rule over and over on each job submit.  
 		// TODO
 
+		// Pre-parse the rule so that it does not have to be parsed and expanded again
+		// for every job. Rules that use macros or temporary variables can't be compiled
+		// and are run through the macro stream parser as before.
+		if ( ! xfm->compile()) {
+			++num_uncompiled;
+		}
+
 		// Finally, append the xfm to the end our list (order is important here!)
 		transforms_list.Append(xfm);
 		std::string xfm_text;
 		dprintf(D_ALWAYS, 
-			"JOB_TRANSFORM_%s setup as transform rule #%d :\n%s\n",
-			name, transforms_list.Number(), xfm->getFormattedText(xfm_text, "\t") );
+			"JOB_TRANSFORM_%s setup as %stransform rule #%d :\n%s\n",
+			name, xfm->is_compiled() ? "compiled " : "", transforms_list.Number(), xfm->getFormattedText(xfm_text, "\t") );
 		xfm = NULL;  // we handed the xfm pointer off to our list
 
 	} // end of while loop thru job transform names	
@@ -168,8 +177,11 @@ JobTransforms::transformJob(
 	}
 
 	// Revert variables hashtable so it doesn't grow idefinitely
-	mset.rewind_to_state(mset_ckpt, false);
-	mset.set_factory_vars(jid.proc < 0, is_late_mat); // make ids visible to transform as temp variables
+	// compiled transforms don't use the hashtable, so we only need to do this for the others
+	if (num_uncompiled > 0) {
+		mset.rewind_to_state(mset_ckpt, false);
+		mset.set_factory_vars(jid.proc < 0, is_late_mat); // make ids visible to transform as temp variables
+	}
 
 	// Enable dirty tracking of ad attributes and mark them as clean,
 	// since after the transform we need to discover which attributes changed.
@@ -43,6 +43,7 @@ class JobTransforms {
 	SimpleList<MacroStreamXFormSource *> transforms_list;
 	XFormHash mset;
 	MACRO_SET_CHECKPOINT_HDR * mset_ckpt;
+	int num_uncompiled; // number of transforms that need the macro stream parser
 
 	int set_dirty_attributes(ClassAd *ad, int cluster, int proc, classad::References * attrs=nullptr);
 	void clear_transforms_list();
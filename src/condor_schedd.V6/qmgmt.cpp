@@ -217,6 +217,7 @@ static int next_proc_num = 0;
 static int jobs_added_this_transaction = 0;
 int active_cluster_num = -1;	// client is restricted to only insert jobs to the active cluster
 static bool JobQueueDirty = false;
+static std::string JobQueueCheckpointName; // job queue log name + .ckpt
 static bool in_DestroyJobQueue = false;
 static int in_walk_job_queue = 0;
 static time_t xact_start_time = 0;	// time at which the current transaction was started
@@ -233,6 +234,7 @@ typedef _condor_auto_accum_runtime< stats_entry_probe<double> > condor_auto_runt
 schedd_runtime_probe WalkJobQ_runtime;
 schedd_runtime_probe WalkJobQ_mark_idle_runtime;
 schedd_runtime_probe WalkJobQ_get_job_prio_runtime;
+schedd_runtime_probe MaterializeBatch_runtime;
 
 class Service;
 
@@ -476,6 +478,16 @@ GetJobQueueIteratorEnd()
 	return JobQueue->GetIteratorEnd();
 }
 
+JobQueuePayload
+GetJobQueuePayload(const JOB_ID_KEY &key)
+{
+	JobQueuePayload ad = NULL;
+	if (JobQueue && JobQueue->Lookup(key, ad)) {
+		return ad;
+	}
+	return NULL;
+}
+
 typedef JOB_ID_KEY_BUF JobQueueKeyBuf;
 static inline JobQueueKey& IdToKey(int cluster, int proc, JobQueueKeyBuf& key)
 {
@@ -827,6 +839,10 @@ JobMaterializeTimerCallback()
 		int system_limit = MIN(scheduler.getMaxMaterializedJobsPerCluster(), scheduler.getMaxJobsPerSubmission());
 		int owner_limit = scheduler.getMaxJobsPerOwner();
 		//system_limit = MIN(system_limit, scheduler.getMaxJobsRunning());
+		// materialize at most this many jobs for a factory before moving on to the next one,
+		// factories that hit this limit stay in the list and get another batch on the next tick.
+		int batch_size = scheduler.getMaterializeBatchSize();
+		bool more_to_do = false;
 
 		int total_new_jobs = 0;
 		// iterate the list of clusters needing work, removing them from the work list when they
@@ -874,10 +890,17 @@ JobMaterializeTimerCallback()
 						scheduler.getMaxMaterializedJobsPerCluster(), scheduler.getMaxJobsPerSubmission(), factory_owner_limit,
 						cad->ClusterSize());
 
+					double begin = _condor_debug_get_time_double();
 					TransactionWatcher txn;
 					int num_materialized = 0;
 					int cluster_size = cad->ClusterSize();
 					while ((cluster_size + num_materialized) < effective_limit) {
+						if (batch_size > 0 && num_materialized >= batch_size) {
+							// this batch is full, come back for the rest after servicing the other factories
+							remove_entry = false;
+							more_to_do = true;
+							break;
+						}
 						int retry_delay = 0; // will be set to non-zero when we should try again later.
 						int rv = 0;
 						if (CheckMaterializePolicyExpression(cad, num_materialized, retry_delay)) {
@@ -908,6 +931,8 @@ JobMaterializeTimerCallback()
 								num_materialized = 0;
 							}
 						}
+						MaterializeBatch_runtime += _condor_debug_get_time_double() - begin;
+						scheduler.stats.JobsMaterialized += num_materialized;
 						total_new_jobs += num_materialized;
 					} else {
 						int next_row = 0;
@@ -936,6 +961,11 @@ JobMaterializeTimerCallback()
 		if (total_new_jobs > 0) {
 			scheduler.needReschedule();
 		}
+		// some factories stopped at the batch size, so run again as soon as daemon core
+		// has serviced whatever else is pending rather than waiting for the next period.
+		if (more_to_do && job_materialize_timer_id > 0) {
+			daemonCore->Reset_Timer(job_materialize_timer_id, 0, 5);
+		}
 	}
 
 	if( ClustersNeedingMaterialize.empty() && job_materialize_timer_id > 0 ) {
@@ -1006,6 +1036,7 @@ DeferredClusterCleanupTimerCallback()
 			if (clusterad->factory) {
 				dprintf(D_MATERIALIZE | D_VERBOSE, "\tcluster %d has job factory, invoking it.\n", cluster_id);
 				int retry_delay = 0;
+				double begin = _condor_debug_get_time_double();
 				TransactionWatcher txn;
 				int num_materialized = MaterializeJobs(clusterad, txn, retry_delay);
 				if (num_materialized > 0) {
@@ -1019,7 +1050,13 @@ DeferredClusterCleanupTimerCallback()
 							num_materialized = 0;
 						}
 					}
+					MaterializeBatch_runtime += _condor_debug_get_time_double() - begin;
+					scheduler.stats.JobsMaterialized += num_materialized;
 					total_new_jobs += num_materialized;
+					// MaterializeJobs stopped at the batch size, hand the rest to the materialize timer
+					if (num_materialized > 0 && retry_delay > 0) {
+						ScheduleClusterForJobMaterializeNow(cluster_id);
+					}
 					// PRAGMA_REMIND("TJ: should we do_cleanup here if the transaction failed to commit?");
 					do_cleanup = false;
 				} else {
@@ -2067,6 +2104,14 @@ InitJobQueue(const char *job_queue_name,int max_historical_logs)
 #else
 	JobQueue = new JobQueueType(new ConstructClassAdLogTableEntry<JobQueuePayload>());
 #endif
+	JobQueueCheckpointName = job_queue_name;
+	JobQueueCheckpointName += ".ckpt";
+	if (param_integer("SCHEDD_JOB_QUEUE_CHECKPOINT_INTERVAL", 0) > 0) {
+		// load the checkpoint (if any) and replay only the part of the log after it.
+		JobQueue->SetCheckpointFilename(JobQueueCheckpointName.c_str());
+	}
+	// parse the job queue log on worker threads, the records are still applied in order
+	JobQueue->SetReplayThreads(param_integer("SCHEDD_JOB_QUEUE_LOG_REPLAY_THREADS", 0, 0, 256));
 	if( !JobQueue->InitLogFile(job_queue_name,max_historical_logs) ) {
 		EXCEPT("Failed to initialize job queue log!");
 	}
@@ -2577,6 +2622,28 @@ CleanJobQueue()
 }
 
 
+// called by a timer in the schedd to write a checkpoint of the job queue
+// so that a restart only needs to replay the job queue log written after it.
+void
+CheckpointJobQueue()
+{
+	if ( ! JobQueue || JobQueue->InTransaction()) {
+		return;
+	}
+	// checkpointing may have been enabled or disabled by a reconfig since the queue was loaded
+	if (param_integer("SCHEDD_JOB_QUEUE_CHECKPOINT_INTERVAL", 0) <= 0) {
+		JobQueue->SetCheckpointFilename(NULL);
+		return;
+	}
+	JobQueue->SetCheckpointFilename(JobQueueCheckpointName.c_str());
+
+	double begin = _condor_debug_get_time_double();
+	if (JobQueue->WriteCheckpoint()) {
+		dprintf(D_ALWAYS, "Checkpointed job queue in %.3f seconds\n", _condor_debug_get_time_double() - begin);
+	}
+}
+
+
 void
 DestroyJobQueue( void )
 {
@@ -2597,6 +2664,8 @@ DestroyJobQueue( void )
 		CleanJobQueue();
 	}
 	ASSERT( JobQueueDirty == false );
+		// a checkpoint written at shutdown means the next startup replays nothing.
+	CheckpointJobQueue();
 	delete JobQueue;
 	JobQueue = NULL;
 
@@ -2648,9 +2717,16 @@ int MaterializeJobs(JobQueueCluster * clusterad, TransactionWatcher &txn, int &
 		scheduler.getMaxMaterializedJobsPerCluster(), scheduler.getMaxJobsPerSubmission(), owner_limit,
 		clusterad->ClusterSize());
 
+	int batch_size = scheduler.getMaterializeBatchSize();
+
 	int num_materialized = 0;
 	int cluster_size = clusterad->ClusterSize();
 	while ((cluster_size + num_materialized) < effective_limit) {
+		if (batch_size > 0 && num_materialized >= batch_size) {
+			// there may be more jobs to materialize, but not in this transaction
+			retry_delay = 1;
+			break;
+		}
 		int retry = 0;
 		if ( ! CheckMaterializePolicyExpression(clusterad, num_materialized, retry)) {
 			retry_delay = retry;
@@ -8771,13 +8847,108 @@ bool UniverseUsesVanillaStartExpr(int universe)
 	}
 }
 
+/*
+ * Check whether a job that is runnable and not already matched may run on
+ * the claimed slot described by my_match_ad (which is a startd ad).  If it
+ * may not, and no other job in the same autocluster can either, set
+ * reject_autocluster.  START_VANILLA_UNIVERSE is left to the caller.
+ */
+bool JobCanReuseClaim(JobQueueJob * ad, ClassAd * my_match_ad, bool & reject_autocluster)
+{
+	ASSERT(ad);
+	ASSERT(my_match_ad);
+
+	bool restrict_to_user = false;
+	my_match_ad->LookupBool(ATTR_RESTRICT_TO_AUTHENTICATED_IDENTITY, restrict_to_user);
+	if (restrict_to_user) {
+		std::string match_user;
+		my_match_ad->LookupString(ATTR_AUTHENTICATED_IDENTITY, match_user);
+		if (!match_user.empty()) {
+			// TODO Get the owner from the JobQueueJob object.
+			//   Need to be careful about whether UID_DOMAIN is included.
+			std::string job_user;
+			ad->LookupString(ATTR_USER, job_user);
+			if (match_user != job_user) {
+				return false;
+			}
+		}
+	}
+
+		// Now check if the job and the claimed resource match.
+		// NOTE : the caller must have checked that the job is still runnable
+		// and not already matched.
+	if ( ! IsAMatch( ad, my_match_ad ) ) {
+			// Job and machine do not match.
+			// Assume that none of the other jobs in this auto-cluster will match.
+			// THIS IS A DANGEROUS ASSUMPTION - what if this job is no longer
+			// part of this autocluster?  TODO perhaps we should verify this
+			// job is still part of this autocluster here.
+		reject_autocluster = true;
+		return false;
+	}
+
+		// Make sure that the startd ranks this job >= the
+		// rank of the job that initially claimed it.
+		// We stashed that rank in the startd ad when
+		// the match was created.
+		// (As of 6.9.0, the startd does not reject reuse
+		// of the claim with lower RANK, but future versions
+		// very well may.)
+
+	double current_startd_rank;
+	if( my_match_ad->LookupFloat(ATTR_CURRENT_RANK, current_startd_rank) )
+	{
+		double new_startd_rank = 0;
+		if( EvalFloat(ATTR_RANK, my_match_ad, ad, new_startd_rank) )
+		{
+			if( new_startd_rank < current_startd_rank ) {
+				return false;
+			}
+		}
+	}
+
+		// If Concurrency Limits are in play it is
+		// important not to reuse a claim from one job
+		// that has one set of limits for a job that
+		// has a different set. This is because the
+		// Accountant is keeping track of limits based
+		// on the matches that are being handed out.
+		//
+		// A future optimization here may be to allow
+		// jobs with a subset of the limits given to
+		// the current match to reuse it.
+
+	std::string jobLimits, recordedLimits;
+	if (param_boolean("CLAIM_RECYCLING_CONSIDER_LIMITS", true)) {
+		ad->LookupString(ATTR_CONCURRENCY_LIMITS, jobLimits);
+		my_match_ad->LookupString(ATTR_MATCHED_CONCURRENCY_LIMITS,
+								  recordedLimits);
+		lower_case(jobLimits);
+		lower_case(recordedLimits);
+
+		if (jobLimits == recordedLimits) {
+			dprintf(D_FULLDEBUG,
+					"ConcurrencyLimits match, can reuse claim\n");
+		} else {
+			dprintf(D_FULLDEBUG,
+					"ConcurrencyLimits do not match, cannot "
+					"reuse claim\n");
+			reject_autocluster = true;
+			return false;
+		}
+	}
+
+	return true;
+}
+
 /*
  * Find the job with the highest priority that matches with
  * my_match_ad (which is a startd ad).  If user is NULL, get a job for
- * any user; o.w. only get jobs for specified user.
+ * any user; o.w. only get jobs for specified user.  If skip_next_jobs is
+ * true, pass over jobs already picked to run next on a busy claim.
  */
 void FindRunnableJob(PROC_ID & jobid, ClassAd* my_match_ad, 
-					 char const * user)
+					 char const * user, bool skip_next_jobs)
 {
 	JobQueueJob *ad;
 
@@ -8791,13 +8962,6 @@ void FindRunnableJob(PROC_ID & jobid, ClassAd* my_match_ad,
 
 	ASSERT(my_match_ad);
 
-	bool restrict_to_user = false;
-	std::string match_user;
-	my_match_ad->LookupBool(ATTR_RESTRICT_TO_AUTHENTICATED_IDENTITY, restrict_to_user);
-	if (restrict_to_user) {
-		my_match_ad->LookupString(ATTR_AUTHENTICATED_IDENTITY, match_user);
-	}
-
 		// indicate failure by setting proc to -1.  do this now
 		// so if we bail out early anywhere, we say we failed.
 	jobid.proc = -1;	
@@ -8862,6 +9026,11 @@ void FindRunnableJob(PROC_ID & jobid, ClassAd* my_match_ad,
 				continue;
 			}
 
+			if ( skip_next_jobs && scheduler.IsNextJobForClaim(p->id) ) {
+					// Another claim will run this job when its current job exits.
+				continue;
+			}
+
 			ad = GetJobAd( p->id.cluster, p->id.proc );
 			if (!ad) {
 					// This ad must have been deleted since we last built
@@ -8896,26 +9065,11 @@ void FindRunnableJob(PROC_ID & jobid, ClassAd* my_match_ad,
 				continue;
 			}
 
-			if (!match_user.empty()) {
-				// TODO Get the owner from the JobQueueJob object.
-				//   Need to be careful about whether UID_DOMAIN is included.
-				std::string job_user;
-				ad->LookupString(ATTR_USER, job_user);
-				if (match_user != job_user) {
-					continue;
+			bool reject_autocluster = false;
+			if ( ! JobCanReuseClaim( ad, my_match_ad, reject_autocluster ) ) {
+				if (reject_autocluster) {
+					PrioRecAutoClusterRejected->insert( p->auto_cluster_id, 1 );
 				}
-			}
-
-				// Now check if the job and the claimed resource match.
-				// NOTE : we must do this AFTER we ensure the job is still runnable, which
-				// is why we invoke Runnable() above first.
-			if ( ! IsAMatch( ad, my_match_ad ) ) {
-					// Job and machine do not match.
-					// Assume that none of the other jobs in this auto-cluster will match.
-					// THIS IS A DANGEROUS ASSUMPTION - what if this job is no longer
-					// part of this autocluster?  TODO perhaps we should verify this
-					// job is still part of this autocluster here.
-				PrioRecAutoClusterRejected->insert( p->auto_cluster_id, 1 );
 					// Move along to the next job in the prio rec array
 				continue;
 			}
@@ -8936,59 +9090,6 @@ void FindRunnableJob(PROC_ID & jobid, ClassAd* my_match_ad,
 			}
 #endif
 
-				// Make sure that the startd ranks this job >= the
-				// rank of the job that initially claimed it.
-				// We stashed that rank in the startd ad when
-				// the match was created.
-				// (As of 6.9.0, the startd does not reject reuse
-				// of the claim with lower RANK, but future versions
-				// very well may.)
-
-			double current_startd_rank;
-			if( my_match_ad &&
-				my_match_ad->LookupFloat(ATTR_CURRENT_RANK, current_startd_rank) )
-			{
-				double new_startd_rank = 0;
-				if( EvalFloat(ATTR_RANK, my_match_ad, ad, new_startd_rank) )
-				{
-					if( new_startd_rank < current_startd_rank ) {
-						continue;
-					}
-				}
-			}
-
-				// If Concurrency Limits are in play it is
-				// important not to reuse a claim from one job
-				// that has one set of limits for a job that
-				// has a different set. This is because the
-				// Accountant is keeping track of limits based
-				// on the matches that are being handed out.
-				//
-				// A future optimization here may be to allow
-				// jobs with a subset of the limits given to
-				// the current match to reuse it.
-
-			std::string jobLimits, recordedLimits;
-			if (param_boolean("CLAIM_RECYCLING_CONSIDER_LIMITS", true)) {
-				ad->LookupString(ATTR_CONCURRENCY_LIMITS, jobLimits);
-				my_match_ad->LookupString(ATTR_MATCHED_CONCURRENCY_LIMITS,
-										  recordedLimits);
-				lower_case(jobLimits);
-				lower_case(recordedLimits);
-
-				if (jobLimits == recordedLimits) {
-					dprintf(D_FULLDEBUG,
-							"ConcurrencyLimits match, can reuse claim\n");
-				} else {
-					dprintf(D_FULLDEBUG,
-							"ConcurrencyLimits do not match, cannot "
-							"reuse claim\n");
-					PrioRecAutoClusterRejected->
-						insert(p->auto_cluster_id, 1);
-					continue;
-				}
-			}
-
 			jobid = p->id; // success!
 			return;
 
@@ -651,6 +651,8 @@ private:
 #define JOB_QUEUE_ITERATOR_OPT_INCLUDE_JOBSETS      0x0002
 JobQueueLogType::filter_iterator GetJobQueueIterator(const classad::ExprTree &requirements, int timeslice_ms);
 JobQueueLogType::filter_iterator GetJobQueueIteratorEnd();
+// returns the job, cluster or jobset ad with the given key, or NULL if there isn't one
+JobQueuePayload GetJobQueuePayload(const JOB_ID_KEY &key);
 
 
 class schedd_runtime_probe;
@@ -671,6 +673,7 @@ void InitQmgmt();
 void InitJobQueue(const char *job_queue_name,int max_historical_logs);
 void PostInitJobQueue();
 void CleanJobQueue();
+void CheckpointJobQueue();
 bool setQSock( ReliSock* rsock );
 void unsetQSock();
 void MarkJobClean(PROC_ID job_id);
@@ -693,7 +696,8 @@ extern int N_PrioRecs;
 extern HashTable<int,int> *PrioRecAutoClusterRejected;
 extern int grow_prio_recs(int);
 
-extern void	FindRunnableJob(PROC_ID & jobid, ClassAd* my_match_ad, char const * user);
+extern bool	JobCanReuseClaim(JobQueueJob * ad, ClassAd* my_match_ad, bool & reject_autocluster);
+extern void	FindRunnableJob(PROC_ID & jobid, ClassAd* my_match_ad, char const * user, bool skip_next_jobs = false);
 extern int Runnable(PROC_ID*);
 extern int Runnable(JobQueueJob *job, const char *& reason);
 
@@ -115,6 +115,7 @@ extern GridUniverseLogic* _gridlogic;
 #include "condor_vm_universe_types.h"
 #include "enum_utils.h"
 #include "credmon_interface.h"
+#include "param_handle.h"
 
 #ifdef WIN32
 #define DIR_DELIM_STR "\\"
@@ -125,6 +126,12 @@ extern GridUniverseLogic* _gridlogic;
 extern char* Spool;
 extern char * Name;
 static char * NameInEnv = NULL;
+
+// knobs that are looked up once per job, match or submitter. these only
+// go back to the config table after a reconfig, see param_handle.h
+static param_handle<bool> UseGlobalJobPrios("USE_GLOBAL_JOB_PRIOS", false);
+static param_handle<bool> StarterHandlesAlives("STARTER_HANDLES_ALIVES", true);
+static param_handle<int> ScheddInterval("SCHEDD_INTERVAL", 300);
 extern char * JobHistoryFileName;
 extern char * PerJobHistoryDir;
 
@@ -188,6 +195,7 @@ schedd_runtime_probe WalkJobQ_fixAttrUser_runtime;
 schedd_runtime_probe WalkJobQ_updateSchedDInterval_runtime;
 
 int	WallClockCkptInterval = 0;
+int	JobQueueCkptInterval = 0;
 int STARTD_CONTACT_TIMEOUT = 45;  // how long to potentially block
 
 void UpdateJobProxyAttrs( PROC_ID job_id, const ClassAd &proxy_attrs )
@@ -373,10 +381,22 @@ UserIdentity::UserIdentity(const char *user, const char *domainname,
 
 struct job_data_transfer_t {
 	int mode;
+	priv_state xfer_priv;
+	bool user_owns_spool; // the spooled files belong to the user, not condor
 	std::vector<PROC_ID> *jobs;
+	// copies of the job ads, owned by the worker. the worker uses these rather
+	// than the job queue so that it can run on a thread.
+	std::vector<ClassAd *> *job_ads;
 	char peer_version[1]; // We'll malloc enough extra space for this
 };
 
+static void delete_job_ad_copies(std::vector<ClassAd *> * job_ads)
+{
+	if ( ! job_ads) return;
+	for (ClassAd * ad : *job_ads) { delete ad; }
+	delete job_ads;
+}
+
 match_rec::match_rec( char const* claim_id, char const* p, PROC_ID* job_id, 
 					  const ClassAd *match, char const *the_user, char const *my_pool,
 					  bool is_dedicated_arg ):
@@ -415,7 +435,8 @@ match_rec::match_rec( char const* claim_id, char const* p, PROC_ID* job_id,
 
 	bool suppress_sec_session = true;
 
-	if( param_boolean("SEC_ENABLE_MATCH_PASSWORD_AUTHENTICATION", true) ) {
+	static param_handle<bool> enable_match_password("SEC_ENABLE_MATCH_PASSWORD_AUTHENTICATION", true);
+	if( enable_match_password ) {
 		if( secSessionId() == NULL ) {
 			dprintf(D_FULLDEBUG,"SEC_ENABLE_MATCH_PASSWORD_AUTHENTICATION: did not create security session from claim id, because claim id does not contain session information: %s\n",publicClaimId());
 		}
@@ -475,7 +496,7 @@ match_rec::match_rec( char const* claim_id, char const* p, PROC_ID* job_id,
 		// assuming STARTER_HANDLES_ALIVES is set to the default of true.
 		// I think this is a reasonable compromise.  -Todd Tannenbaum 10/2014
 		m_startd_sends_alives = false;
-		if ( param_boolean("STARTER_HANDLES_ALIVES",true) ) {
+		if ( StarterHandlesAlives ) {
 			m_startd_sends_alives = true;
 		}
 	}
@@ -615,6 +636,9 @@ Scheduler::Scheduler() :
 	NonDurableLateMaterialize = false;
 	EnableJobQueueTimestamps = false;
 	MaxMaterializedJobsPerCluster = INT_MAX;
+	MaterializeBatchSize = 0;
+	PrefetchClaimJobs = false;
+	RecycleShadowsAcrossClaims = false;
 	MaxJobsSubmitted = INT_MAX;
 	MaxJobsPerOwner = INT_MAX;
 	MaxJobsPerSubmission = INT_MAX;
@@ -686,6 +710,7 @@ Scheduler::Scheduler() :
 
 	checkContactQueue_tid = -1;
 	checkReconnectQueue_tid = -1;
+	checkPrefetchQueue_tid = -1;
 	num_pending_startd_contacts = 0;
 	max_pending_startd_contacts = 0;
 
@@ -713,6 +738,10 @@ Scheduler::Scheduler() :
     m_userlog_file_cache_clear_interval = 60;
 
 	jobThrottleNextJobDelay = 0;
+	jobStartControlTimer = -1;
+	jobStartControlSelectWait = 0.0;
+	jobStartControlPumpTime = 0.0;
+	jobStartControlPumpCycles = 0;
 
 	JobStartCount = 0;
 	MaxNextJobDelay = 0;
@@ -833,6 +862,12 @@ Scheduler::~Scheduler()
 	if ( checkContactQueue_tid != -1 && daemonCore ) {
 		daemonCore->Cancel_Timer(checkContactQueue_tid);
 	}
+	if ( checkPrefetchQueue_tid != -1 && daemonCore ) {
+		daemonCore->Cancel_Timer(checkPrefetchQueue_tid);
+	}
+	if ( jobStartControlTimer != -1 && daemonCore ) {
+		daemonCore->Cancel_Timer(jobStartControlTimer);
+	}
 
 	Submitters.clear();
 
@@ -1255,8 +1290,9 @@ Scheduler::fill_submitter_ad(ClassAd & pAd, const SubmitterData & Owner, const s
 	}
 
 	std::string str;
-	if ( param_boolean("USE_GLOBAL_JOB_PRIOS",false) ) {
-		int max_entries = param_integer("MAX_GLOBAL_JOB_PRIOS",500);
+	if ( UseGlobalJobPrios ) {
+		static param_handle<int> max_global_job_prios("MAX_GLOBAL_JOB_PRIOS", 500);
+		int max_entries = max_global_job_prios;
 		int num_prios = (int)Owner.PrioSet.size();
 		if (num_prios > max_entries) {
 			pAd.Assign(ATTR_JOB_PRIO_ARRAY_OVERFLOW, num_prios);
@@ -1417,9 +1453,12 @@ Scheduler::count_jobs()
 	//dprintf_on_function_exit on_exit(true, D_FULLDEBUG, "count_jobs()\n");
 
 	 // copy owner data to old-owners table
-	time_t AbsentSubmitterLifetime = param_integer("ABSENT_SUBMITTER_LIFETIME", 60*60*24*7); // 1 week.
-	time_t AbsentSubmitterUpdateRate = param_integer("ABSENT_SUBMITTER_UPDATE_RATE", 60*5); // 5 min
-	time_t AbsentOwnerLifetime = param_integer("ABSENT_OWNER_LIFETIME", 60*5);
+	static param_handle<int> absent_submitter_lifetime("ABSENT_SUBMITTER_LIFETIME", 60*60*24*7); // 1 week.
+	static param_handle<int> absent_submitter_update_rate("ABSENT_SUBMITTER_UPDATE_RATE", 60*5); // 5 min
+	static param_handle<int> absent_owner_lifetime("ABSENT_OWNER_LIFETIME", 60*5);
+	time_t AbsentSubmitterLifetime = absent_submitter_lifetime;
+	time_t AbsentSubmitterUpdateRate = absent_submitter_update_rate;
+	time_t AbsentOwnerLifetime = absent_owner_lifetime;
 
 	JobsRunning = 0;
 	JobsIdle = 0;
@@ -1581,7 +1620,8 @@ Scheduler::count_jobs()
 
 	// set FlockLevel for owners
 	if (MaxFlockLevel) {
-		int flock_increment = param_integer("FLOCK_INCREMENT",1,1);
+		static param_handle<int> flock_increment_knob("FLOCK_INCREMENT", 1, 1);
+		int flock_increment = flock_increment_knob;
 
 		for (SubmitterDataMap::iterator it = Submitters.begin(); it != Submitters.end(); ++it) {
 			SubmitterData & SubDat = it->second;
@@ -1665,6 +1705,7 @@ Scheduler::count_jobs()
 	cad->Assign(ATTR_SCHEDD_SWAP_EXHAUSTED, (bool)SwapSpaceExhausted);
 
 	cad->Assign(ATTR_NUM_JOB_STARTS_DELAYED, RunnableJobQueue.size());
+	JobStartControl.Publish(*cad);
 	cad->Assign(ATTR_NUM_PENDING_CLAIMS, startdContactQueue.size() + num_pending_startd_contacts);
 
 	m_xfer_queue_mgr.publish(cad);
@@ -1720,9 +1761,10 @@ Scheduler::count_jobs()
 		// This is called at most every 5 seconds, meaning this can cause
 		// up to 300 / 5 * 2 = 120 sessions to be opened at a time per
 		// collector.
-	unsigned duration = 2*param_integer( "SCHEDD_INTERVAL", 300 );
+	unsigned duration = 2*ScheddInterval.get();
 	std::string capability;
-	if (param_boolean("SEC_ENABLE_IMPERSONATION_TOKENS", false) && SetupCollectorSession(duration, capability)) {
+	static param_handle<bool> enable_impersonation_tokens("SEC_ENABLE_IMPERSONATION_TOKENS", false);
+	if (enable_impersonation_tokens && SetupCollectorSession(duration, capability)) {
 		cad->InsertAttr(ATTR_CAPABILITY, capability);
 	}
 
@@ -1781,7 +1823,8 @@ Scheduler::count_jobs()
 
 	time_t time_now = time(nullptr);
 
-	if (param_boolean("SCHEDDS_ARE_SUBMITTERS", false) == false) {
+	static param_handle<bool> schedds_are_submitters("SCHEDDS_ARE_SUBMITTERS", false);
+	if (schedds_are_submitters.get() == false) {
 		// The usual case -- send one submitter ad per submitter
 		for (auto it = Submitters.begin(); it != Submitters.end(); ++it) {
 			updateSubmitterAd(it->second, pAd, nullptr, -1, time_now);
@@ -1818,12 +1861,13 @@ Scheduler::count_jobs()
 
 				// Same comment about potentially creating hundreds of sessions applies
 				// here as above for the primary collector...
-			unsigned duration = 2*param_integer( "SCHEDD_INTERVAL", 300 );
+			unsigned duration = 2*ScheddInterval.get();
 			std::string capability;
 			SetupNegotiatorSession(duration, flock_col->name(), capability);
 
 			// update submitter ad in this pool for each owner
-			if (param_boolean("SCHEDDS_ARE_SUBMITTERS_FOR_FLOCKERS", false) == false) {
+			static param_handle<bool> schedds_are_submitters_for_flockers("SCHEDDS_ARE_SUBMITTERS_FOR_FLOCKERS", false);
+			if (schedds_are_submitters_for_flockers.get() == false) {
 				for (auto it = Submitters.begin(); it != Submitters.end(); ++it) {
 					SubmitterData & SubDat = it->second;
 
@@ -2313,6 +2357,27 @@ void IncrementLiveJobCounter(LiveJobCounters & num, int universe, int status, in
 	}
 }
 
+// sort key for a QUERY_JOB_ADS that asks for the results in order.
+// ads are ordered by the value of the SortBy attribute, numbers before
+// strings before everything else, and then by job id.
+struct QuerySortKey {
+	JOB_ID_KEY id;
+	int kind; // 0 for number, 1 for string, 2 for anything else
+	double num;
+	std::string str;
+
+	QuerySortKey(const JOB_ID_KEY & jid) : id(jid), kind(2), num(0) {}
+	bool operator<(const QuerySortKey & rhs) const {
+		if (kind != rhs.kind) return kind < rhs.kind;
+		if (kind == 0 && num != rhs.num) return num < rhs.num;
+		if (kind == 1) {
+			int diff = strcasecmp(str.c_str(), rhs.str.c_str());
+			if (diff) return diff < 0;
+		}
+		return id < rhs.id;
+	}
+};
+
 struct QueryJobAdsContinuation : Service {
 
 	classad_shared_ptr<classad::ExprTree> requirements;
@@ -2327,8 +2392,16 @@ struct QueryJobAdsContinuation : Service {
 	bool unfinished_eom;
 	bool registered_socket;
 	bool send_server_time;
+	// when the query has a SortBy, the keys of the matching ads are gathered
+	// and sorted before any ads are sent.
+	bool sorting;
+	bool sorted;
+	std::string sort_attr; // empty to sort by job id only
+	std::vector<QuerySortKey> sorted_ids;
+	size_t sorted_pos;
 
 	QueryJobAdsContinuation(classad_shared_ptr<classad::ExprTree> requirements_, int limit, int timeslice_ms=0, int iter_opts=0, bool server_time=true);
+	void sort_by(const std::string & attr);
 	int finish(Stream *);
 };
 
@@ -2340,18 +2413,33 @@ QueryJobAdsContinuation::QueryJobAdsContinuation(classad_shared_ptr<classad::Exp
 	  summary_only(false),
 	  unfinished_eom(false),
 	  registered_socket(false),
-	  send_server_time(server_time)
+	  send_server_time(server_time),
+	  sorting(false),
+	  sorted(false),
+	  sorted_pos(0)
 {
 	it.set_options(iter_opts);
 	my_job_counts.clear_counters();
 }
 
+void
+QueryJobAdsContinuation::sort_by(const std::string & attr)
+{
+	sorting = true;
+	if (strcasecmp(attr.c_str(), "JobId") != MATCH &&
+		strcasecmp(attr.c_str(), ATTR_CLUSTER_ID) != MATCH &&
+		strcasecmp(attr.c_str(), ATTR_PROC_ID) != MATCH) {
+		sort_attr = attr;
+	}
+}
+
 int
 QueryJobAdsContinuation::finish(Stream *stream) {
 	ReliSock *sock = static_cast<ReliSock*>(stream);
 	JobQueueLogType::filter_iterator end = GetJobQueueIteratorEnd();
 	if (match_limit >= 0 && (match_count >= match_limit)) {
 		it = end;
+		sorted_pos = sorted_ids.size();
 	}
 	bool has_backlog = false;
 	int put_flags = PUT_CLASSAD_NON_BLOCKING | PUT_CLASSAD_NO_PRIVATE;
@@ -2370,12 +2458,48 @@ QueryJobAdsContinuation::finish(Stream *stream) {
 			return sendJobErrorAd(sock, 5, "Failed to write EOM to wire");
 		}
 	}
-	while ((it != end) && !has_backlog) {
-		JobQueuePayload ad = *it++;
-		if (!ad) {
-			// Return to DC in case if our time ran out.
-			has_backlog = true;
-			break;
+	if (sorting && ! sorted) {
+		// gather the keys of all of the matching ads before sending any of them,
+		// this uses much less memory than the ads themselves would on either end.
+		while (it != end) {
+			JobQueuePayload ad = *it++;
+			if (!ad) {
+				// Return to DC in case if our time ran out.
+				has_backlog = true;
+				break;
+			}
+			QuerySortKey key(ad->jid);
+			classad::Value val;
+			if ( ! sort_attr.empty() && ad->EvaluateAttr(sort_attr, val)) {
+				if (val.IsNumber(key.num)) {
+					key.kind = 0;
+				} else if (val.IsStringValue(key.str)) {
+					key.kind = 1;
+				}
+			}
+			sorted_ids.push_back(key);
+		}
+		if (it == end) {
+			std::sort(sorted_ids.begin(), sorted_ids.end());
+			sorted = true;
+		}
+	}
+	while ( ! has_backlog && (sorting ? (sorted && sorted_pos < sorted_ids.size()) : (it != end))) {
+		JobQueuePayload ad;
+		if (sorting) {
+			// the ad may have left the queue since we sorted, if we have been
+			// returning to DC between timeslices.
+			ad = GetJobQueuePayload(sorted_ids[sorted_pos++].id);
+			if (!ad) {
+				continue;
+			}
+		} else {
+			ad = *it++;
+			if (!ad) {
+				// Return to DC in case if our time ran out.
+				has_backlog = true;
+				break;
+			}
 		}
 		if (ad->IsJob()) {
 			JobQueueJob * job = dynamic_cast<JobQueueJob*>(ad);
@@ -2424,6 +2548,7 @@ QueryJobAdsContinuation::finish(Stream *stream) {
 		}
 		if (match_limit >= 0 && (match_count >= match_limit)) {
 			it = end;
+			sorted_pos = sorted_ids.size();
 		}
 	}
 	if (has_backlog && !registered_socket) {
@@ -2612,6 +2737,13 @@ int Scheduler::command_query_job_ads(int cmd, Stream* stream)
 	if (queryAd.EvaluateAttrBoolEquiv("SummaryOnly", summary_only) && summary_only) {
 		continuation->summary_only = true;
 	}
+	std::string sort_by;
+	if ( ! continuation->summary_only && queryAd.EvaluateAttrString("SortBy", sort_by) && ! sort_by.empty()) {
+		if (IsDebugCatAndVerbosity(dpf_level)) {
+			dprintf(dpf_level, "QUERY_JOB_ADS sorting results by %s\n", sort_by.c_str());
+		}
+		continuation->sort_by(sort_by);
+	}
 
 	ForkStatus fork_status = schedd_forker.NewJob();
 	if (fork_status == FORK_PARENT)
@@ -3273,7 +3405,7 @@ count_a_job(JobQueueBase* ad, const JOB_ID_KEY& /*jid*/, void*)
 
 			// Update Owner array PrioSet iff knob USE_GLOBAL_JOB_PRIOS is true
 			// and iff job is looking for more matches (max-hosts - cur_hosts)
-		if ( param_boolean("USE_GLOBAL_JOB_PRIOS",false) &&
+		if ( UseGlobalJobPrios &&
 			 ((max_hosts - cur_hosts) > 0) )
 		{
 			int job_prio;
@@ -3309,7 +3441,8 @@ count_a_job(JobQueueBase* ad, const JOB_ID_KEY& /*jid*/, void*)
 
 			// Update per-flock jobs idle
 		std::string flock_targets;
-		bool include_default_flock = param_boolean("FLOCK_BY_DEFAULT", true);
+		static param_handle<bool> flock_by_default("FLOCK_BY_DEFAULT", true);
+		bool include_default_flock = flock_by_default;
 		if (job->EvaluateAttrString(ATTR_FLOCK_TO, flock_targets)) {
 			StringList flock_list(flock_targets.c_str());
 			flock_list.rewind();
@@ -5010,6 +5143,21 @@ Scheduler::spoolJobFilesReaper(int tid,int exit_status)
 		cluster = (*jobs)[jobIndex].cluster;
 		proc = (*jobs)[jobIndex].proc;
 
+		/* for grid universe jobs there isn't a clear point
+		at which we're "about to start the job".  So we just
+		hand the sandbox directory over to the end user right now.
+		This is done here rather than in the worker, because the
+		worker may be on a thread, and must not look at the job queue.
+		*/
+		JobQueueJob * job = GetJobAd( cluster, proc );
+		if ( ! job) {
+			dprintf(D_ALWAYS, "(%d.%d) Job ad disappeared after spooling but before the sandbox directory could (potentially) be chowned to the user.  Skipping sandbox.  The job may encounter permissions problems.\n", cluster, proc);
+			continue;
+		}
+		if (job->Universe() == CONDOR_UNIVERSE_GRID) {
+			aboutToSpawnJobHandler( cluster, proc, NULL );
+		}
+
 		BeginTransaction();
 
 			// Set ATTR_STAGE_IN_FINISH if not already set.
@@ -5087,6 +5235,12 @@ Scheduler::generalJobFilesWorkerThread(void *arg, Stream* s)
 	std::vector<PROC_ID> *jobs = ((job_data_transfer_t *)arg)->jobs;
 	char *peer_version = ((job_data_transfer_t *)arg)->peer_version;
 	int mode = ((job_data_transfer_t *)arg)->mode;
+	priv_state xfer_priv = ((job_data_transfer_t *)arg)->xfer_priv;
+	bool user_owns_spool = ((job_data_transfer_t *)arg)->user_owns_spool;
+	// take ownership of the job ad copies, so they are freed however we return
+	std::unique_ptr<std::vector<ClassAd *>, void(*)(std::vector<ClassAd *> *)>
+		job_ads(((job_data_transfer_t *)arg)->job_ads, delete_job_ad_copies);
+	((job_data_transfer_t *)arg)->job_ads = NULL;
 	int result;
 	int old_timeout;
 	int cluster, proc;
@@ -5096,13 +5250,6 @@ Scheduler::generalJobFilesWorkerThread(void *arg, Stream* s)
 	 */
 	old_timeout = s->timeout(60 * 60 * 8);  
 
-	priv_state xfer_priv = PRIV_UNKNOWN;
-#if !defined(WIN32)
-	if ( param_boolean( "CHOWN_JOB_SPOOL_FILES", false ) == false ) {
-		xfer_priv = PRIV_USER;
-	}
-#endif
-
 	JobAdsArrayLen = jobs->size();
 	if ( mode == TRANSFER_DATA || mode == TRANSFER_DATA_WITH_PERMS ) {
 		// if sending sandboxes, first tell the client how many
@@ -5123,7 +5270,7 @@ Scheduler::generalJobFilesWorkerThread(void *arg, Stream* s)
 		FileTransfer ftrans;
 		cluster = (*jobs)[i].cluster;
 		proc = (*jobs)[i].proc;
-		ClassAd * ad = GetJobAd( cluster, proc );
+		ClassAd * ad = (*job_ads)[i];
 		if ( !ad ) {
 			dprintf( D_AUDIT | D_FAILURE, *rsock, "generalJobFilesWorkerThread(): "
 					 "job ad %d.%d not found\n",cluster,proc );
@@ -5140,7 +5287,7 @@ Scheduler::generalJobFilesWorkerThread(void *arg, Stream* s)
 		dPrintAd(D_JOB, *ad);
 
 #if !defined(WIN32)
-		if ( xfer_priv == PRIV_USER ) {
+		if ( user_owns_spool ) {
 			// If sending the output sandbox, first ensure that it's owned
 			// by the user, in case we were using the old chowning behavior
 			// when the job completed.
@@ -5149,6 +5296,8 @@ Scheduler::generalJobFilesWorkerThread(void *arg, Stream* s)
 			{
 				SpooledJobFiles::createJobSpoolDirectory( ad, PRIV_USER );
 			}
+		}
+		if ( xfer_priv == PRIV_USER ) {
 			std::string owner;
 			ad->LookupString( ATTR_OWNER, owner );
 			if ( !init_user_ids( owner.c_str(), NULL ) ) {
@@ -5249,32 +5398,6 @@ Scheduler::generalJobFilesWorkerThread(void *arg, Stream* s)
 	rsock->end_of_message();
 	s->timeout(old_timeout);
 
-	/* for grid universe jobs there isn't a clear point
-	at which we're "about to start the job".  So we just
-	hand the sandbox directory over to the end user right now.
-	*/
-	if ( mode == SPOOL_JOB_FILES || mode == SPOOL_JOB_FILES_WITH_PERMS ) {
-		for (i=0; i<JobAdsArrayLen; i++) {
-
-			cluster = (*jobs)[i].cluster;
-			proc = (*jobs)[i].proc;
-			ClassAd * ad = GetJobAd( cluster, proc );
-
-			if ( ! ad ) {
-				dprintf(D_ALWAYS, "(%d.%d) Job ad disappeared after spooling but before the sandbox directory could (potentially) be chowned to the user.  Skipping sandbox.  The job may encounter permissions problems.\n", cluster, proc);
-				continue;
-			}
-
-			int universe = CONDOR_UNIVERSE_VANILLA;
-			ad->LookupInteger(ATTR_JOB_UNIVERSE, universe);
-			FreeJobAd(ad);
-
-			if(universe == CONDOR_UNIVERSE_GRID) {
-				aboutToSpawnJobHandler( cluster, proc, NULL );
-			}
-		}
-	}
-
 	dprintf( D_AUDIT, *rsock, (answer==OK) ? "Transfer completed\n" :
 			 "Error received from client\n" );
    return ((answer == OK)?TRUE:FALSE);
@@ -5509,6 +5632,33 @@ Scheduler::spoolJobFiles(int mode, Stream* s)
 	strcpy(thread_arg->peer_version, peer_version.c_str());
 	thread_arg->jobs = jobs;
 
+		// transfer as the user, unless we chown the spooled files later.
+		// if we can't switch ids there is no point, and not calling
+		// init_user_ids keeps the worker thread safe.
+	thread_arg->xfer_priv = PRIV_UNKNOWN;
+	thread_arg->user_owns_spool = false;
+#if !defined(WIN32)
+	thread_arg->user_owns_spool = param_boolean( "CHOWN_JOB_SPOOL_FILES", false ) == false;
+	if ( can_switch_ids() && thread_arg->user_owns_spool ) {
+		thread_arg->xfer_priv = PRIV_USER;
+	}
+#endif
+
+		// hand the worker flattened copies of the job ads so that it does
+		// not need the job queue. this is what lets it run on a pooled
+		// thread (see CREATE_THREAD_POOL_SIZE) rather than in a forked child.
+	thread_arg->job_ads = new std::vector<ClassAd *>;
+	for (auto & jid : *jobs) {
+		ClassAd * copy = NULL;
+		ClassAd * ad = GetJobAd(jid.cluster, jid.proc);
+		if (ad) {
+			copy = new ClassAd(*ad);
+			ChainCollapse(*copy);
+		}
+		thread_arg->job_ads->push_back(copy);
+	}
+	std::vector<ClassAd *> * job_ads = thread_arg->job_ads;
+
 	switch(mode) {
 		// uploading files to the schedd
 		case SPOOL_JOB_FILES:
@@ -5528,7 +5678,8 @@ Scheduler::spoolJobFiles(int mode, Stream* s)
 					(ThreadStartFunc) &Scheduler::spoolJobFilesWorkerThread,
 					(void *)thread_arg,
 					s,
-					spool_reaper_id
+					spool_reaper_id,
+					true
 					);
 			break;
 
@@ -5549,7 +5700,8 @@ Scheduler::spoolJobFiles(int mode, Stream* s)
 					(ThreadStartFunc) &Scheduler::transferJobFilesWorkerThread,
 					(void *)thread_arg,
 					s,
-					transfer_reaper_id
+					transfer_reaper_id,
+					true
 					);
 			break;
 
@@ -5561,10 +5713,16 @@ Scheduler::spoolJobFiles(int mode, Stream* s)
 
 	if ( tid == FALSE ) {
 		free(thread_arg);
+		delete_job_ad_copies(job_ads);
 		delete jobs;
 		refuse(s);
 		return FALSE;
 	}
+		// a pooled or in-process worker owns the ad copies, a forked one has
+		// its own copy of them
+	if ( ! daemonCore->DoFakeCreateThread() && ! daemonCore->IsPooledThread(tid)) {
+		delete_job_ad_copies(job_ads);
+	}
 
 		// Place this tid into a hashtable so our reaper can finish up.
 	spoolJobFileWorkers->insert(tid, jobs);
@@ -7954,7 +8112,7 @@ Scheduler::contactStartd( ContactStartdArgs* args )
 	jobAd->Assign( ATTR_STARTD_SENDS_ALIVES, mrec->m_startd_sends_alives );	
 	// Tell the startd if to should not send alives if starter is alive
 	jobAd->Assign( ATTR_STARTER_HANDLES_ALIVES, 
-					param_boolean("STARTER_HANDLES_ALIVES",true) );
+					StarterHandlesAlives.get() );
 
 	// Setup to claim the slot asynchronously
 
@@ -8660,6 +8818,8 @@ Scheduler::StartJob(match_rec *rec)
 
 		// Now that the shadow has spawned, consider this match "ACTIVE"
 	rec->setStatus( M_ACTIVE );
+
+	PrefetchNextJobForClaim( rec );
 }
 
 bool
@@ -8671,6 +8831,33 @@ Scheduler::FindRunnableJobForClaim(match_rec* mrec)
 	new_job_id.cluster = -1;
 	new_job_id.proc = -1;
 
+	if( mrec->m_next_job.isJobKey() ) {
+			// A job was picked for this claim while the last one ran.
+			// Use it if it can still run here, and has not been matched
+			// to another slot by the negotiator in the meantime.
+		PROC_ID next_job_id = mrec->m_next_job;
+		SetMrecNextJobID( mrec, PROC_ID() );
+
+		const char *reason = "job was removed";
+		bool reject_autocluster = false;
+		JobQueueJob *job = GetJobAd( next_job_id );
+		if( mrec->my_match_ad && !ExitWhenDone && job &&
+			Runnable(job, reason) && !AlreadyMatched(&next_job_id) &&
+			JobCanReuseClaim(job, mrec->my_match_ad, reject_autocluster) &&
+			jobCanUseMatch(job, mrec->my_match_ad, mrec->getPool(), reason) )
+		{
+			dprintf(D_ALWAYS,
+					"match (%s) switching to job %d.%d\n",
+					mrec->description(), next_job_id.cluster, next_job_id.proc );
+
+			SetMrecJobID(mrec,next_job_id);
+			return true;
+		}
+		dprintf(D_FULLDEBUG,
+				"match (%s) can no longer run job %d.%d picked for it; searching for new job\n",
+				mrec->description(), next_job_id.cluster, next_job_id.proc );
+	}
+
 	if( mrec->my_match_ad && !ExitWhenDone ) {
 		FindRunnableJob(new_job_id,mrec->my_match_ad,mrec->user);
 	}
@@ -9595,12 +9782,14 @@ Scheduler::spawnJobHandlerRaw( shadow_rec* srec, const char* path,
 	   Someday, hopefully soon, we'll fix this and spawn the
 	   shadow/handler with PRIV_USER_FINAL... */
 	std::string daemon_sock = SharedPortEndpoint::GenerateEndpointName(name);
+	double spawn_begin = _condor_debug_get_time_double();
 	pid = daemonCore->Create_Process( path, args, PRIV_ROOT, rid, 
 	                                  true, true, env, NULL, fip, NULL, 
 	                                  std_fds_p, NULL, niceness,
 									  NULL, create_process_opts,
 									  NULL, NULL, daemon_sock.c_str());
 	if( pid == FALSE ) {
+		JobStartControl.ShadowFailed();
 		std::string arg_string;
 		args.GetArgsStringForDisplay(arg_string);
 		dprintf( D_FAILURE|D_ALWAYS, "spawnJobHandlerRaw: "
@@ -9618,6 +9807,8 @@ Scheduler::spawnJobHandlerRaw( shadow_rec* srec, const char* path,
 		return false;
 	} 
 
+	JobStartControl.ShadowSpawned(_condor_debug_get_time_double() - spawn_begin);
+
 		// if it worked, store the pid in our shadow record, and add
 		// this srec to our table of srec's by pid.
 	srec->pid = pid;
@@ -11441,7 +11632,8 @@ send_vacate(match_rec* match,int cmd)
 	msg->setTimeout( STARTD_CONTACT_TIMEOUT );
 	msg->setSecSessionId( match->secSessionId() );
 
-	if ( !startd->hasUDPCommandPort() || param_boolean("SCHEDD_SEND_VACATE_VIA_TCP",true) ) {
+	static param_handle<bool> send_vacate_via_tcp("SCHEDD_SEND_VACATE_VIA_TCP", true);
+	if ( !startd->hasUDPCommandPort() || send_vacate_via_tcp ) {
 		dprintf( D_FULLDEBUG, "Called send_vacate( %s, %d ) via TCP\n", 
 				 match->peer, cmd );
 		msg->setStreamType(Stream::reli_sock);
@@ -11761,12 +11953,21 @@ Scheduler::child_exit(int pid, int status)
 			 	  wExitStatus == JOB_EXEC_FAILED ) {
 				StartJobsFlag = FALSE;
 			}
+			if ( wExitStatus == JOB_NO_MEM ||
+				 wExitStatus == JOB_EXEC_FAILED ||
+				 wExitStatus == JOB_NOT_STARTED ||
+				 wExitStatus == JOB_EXCEPTION ) {
+				JobStartControl.ShadowFailed();
+			}
 
 	 	} else if( WIFSIGNALED(status) ) {
  			// The job died with a signal, so there's not much
  			// that we can do for it
 			dprintf( D_FAILURE|D_ALWAYS, "%s pid %d died with %s\n",
 					 name, pid, daemonCore->GetExceptionString(status) );
+			if ( ! srec_keep_claim_attributes ) {
+				JobStartControl.ShadowFailed();
+			}
 
 			// If the shadow was killed (i.e. by this schedd) and
 			// we are preserving the claim for reconnect, then
@@ -12704,6 +12905,9 @@ Scheduler::Init()
 	// default every hour
 	WallClockCkptInterval = param_integer( "WALL_CLOCK_CKPT_INTERVAL",60*60 );
 
+	// default is not to checkpoint the job queue
+	JobQueueCkptInterval = param_integer( "SCHEDD_JOB_QUEUE_CHECKPOINT_INTERVAL", 0, 0 );
+
 	JobStartDelay = param_integer( "JOB_START_DELAY", 0 );
 	
 	JobStartCount =	param_integer(
@@ -12716,6 +12920,8 @@ Scheduler::Init()
 
 	JobsThisBurst = -1;
 
+	JobStartControl.Config();
+
 		// Estimate that we can afford to use 80% of memory for shadows
 		// and each running shadow requires 800k of private memory.
 		// This works out to about 1 shadow per MB of total memory.
@@ -12747,6 +12953,16 @@ Scheduler::Init()
 	AllowLateMaterialize = param_boolean("SCHEDD_ALLOW_LATE_MATERIALIZE", false);
 	MaxMaterializedJobsPerCluster = param_integer("MAX_MATERIALIZED_JOBS_PER_CLUSTER", MaxMaterializedJobsPerCluster);
 	NonDurableLateMaterialize = param_boolean("SCHEDD_NON_DURABLE_LATE_MATERIALIZE", true);
+	MaterializeBatchSize = param_integer("SCHEDD_MATERIALIZE_BATCH_SIZE", 100, 0);
+
+	PrefetchClaimJobs = param_boolean("SCHEDD_PREFETCH_NEXT_JOB_FOR_CLAIM", true);
+	if ( ! PrefetchClaimJobs) {
+			// let go of the jobs picked for claims, so other claims can run them
+		while ( ! matchesByNextJobID.empty()) {
+			SetMrecNextJobID(matchesByNextJobID.begin()->second, PROC_ID());
+		}
+	}
+	RecycleShadowsAcrossClaims = param_boolean("SCHEDD_RECYCLE_SHADOWS_ACROSS_CLAIMS", false);
 
 	m_extendedSubmitCommands.Clear();
 	auto_free_ptr extended_cmds(param("EXTENDED_SUBMIT_COMMANDS"));
@@ -13552,7 +13768,7 @@ Scheduler::Register()
 void
 Scheduler::RegisterTimers()
 {
-	static int cleanid = -1, wallclocktid = -1;
+	static int cleanid = -1, wallclocktid = -1, jobqueueckptid = -1;
 	// Note: aliveid is a data member of the Scheduler class
 	static int oldQueueCleanInterval = -1;
 
@@ -13591,6 +13807,17 @@ Scheduler::RegisterTimers()
 		(TimerHandlercpp)&Scheduler::StartJobs,"StartJobs",this);
 	aliveid = daemonCore->Register_Timer(10, alive_interval,
 		(TimerHandlercpp)&Scheduler::sendAlives,"sendAlives", this);
+	if (JobStartControl.Enabled()) {
+		if (jobStartControlTimer < 0) {
+			jobStartControlTimer = daemonCore->Register_Timer(
+				JobStartControl.Interval(), JobStartControl.Interval(),
+				(TimerHandlercpp)&Scheduler::updateJobStartControl,
+				"updateJobStartControl", this);
+		}
+	} else if (jobStartControlTimer >= 0) {
+		daemonCore->Cancel_Timer(jobStartControlTimer);
+		jobStartControlTimer = -1;
+	}
     // Preset the job queue clean timer only upon cold start, or if the timer
     // value has been changed.  If the timer period has not changed, leave the
     // timer alone.  This will avoid undesirable behavior whereby timer is
@@ -13622,6 +13849,23 @@ Scheduler::RegisterTimers()
 		wallclocktid = -1;
 	}
 
+	if (JobQueueCkptInterval) {
+		if( jobqueueckptid != -1 ) {
+			daemonCore->Reset_Timer_Period(jobqueueckptid,JobQueueCkptInterval);
+		}
+		else {
+			jobqueueckptid = daemonCore->Register_Timer(JobQueueCkptInterval,
+												  JobQueueCkptInterval,
+												  CheckpointJobQueue,
+												  "CheckpointJobQueue");
+		}
+	} else {
+		if( jobqueueckptid != -1 ) {
+			daemonCore->Cancel_Timer( jobqueueckptid );
+		}
+		jobqueueckptid = -1;
+	}
+
 		// We've seen a test suite run where the schedd never called
 		// PeriodicExprHandler(). Add some debug statements so that
 		// we know why if it happens again.
@@ -14121,6 +14365,9 @@ Scheduler::unlinkMrec(match_rec* match)
 
 	matches->remove(match->claimId());
 
+		// let go of any job picked to run next on this claim
+	SetMrecNextJobID(match, PROC_ID());
+
 	PROC_ID jobId;
 	jobId.cluster = match->cluster;
 	jobId.proc = match->proc;
@@ -14196,6 +14443,13 @@ Scheduler::SetMrecJobID(match_rec *match, PROC_ID job_id) {
 	match->proc = job_id.proc;
 	if( match->proc != -1 ) {
 		ASSERT( matchesByJobID->insert(job_id, match) == 0 );
+
+			// if the job was picked to run next on another claim, that
+			// claim will have to find a different job when it gets there.
+		auto next = matchesByNextJobID.find(job_id);
+		if( next != matchesByNextJobID.end() && next->second != match ) {
+			SetMrecNextJobID(next->second, PROC_ID());
+		}
 	}
 }
 
@@ -14207,6 +14461,87 @@ Scheduler::SetMrecJobID(match_rec *match, int cluster, int proc) {
 	SetMrecJobID( match, job_id );
 }
 
+void
+Scheduler::SetMrecNextJobID(match_rec *match, PROC_ID job_id) {
+	if( match->m_next_job.isJobKey() ) {
+		matchesByNextJobID.erase(match->m_next_job);
+	}
+	match->m_next_job = job_id;
+	if( job_id.isJobKey() ) {
+		matchesByNextJobID[job_id] = match;
+	}
+}
+
+/*
+ * Queue a claim that has just started a job, so that once we are back in
+ * daemonCore we can pick the job it will run next.  Then when the shadow
+ * asks for a new job, or exits and the claim is reused, the job is ready
+ * without a search of the queue while the claim sits idle.
+ */
+void
+Scheduler::PrefetchNextJobForClaim(match_rec *match)
+{
+	if( !PrefetchClaimJobs || match->is_dedicated ) {
+		return;
+	}
+	prefetchClaimQueue.push(match->claimId());
+
+	if( checkPrefetchQueue_tid == -1 ) {
+		checkPrefetchQueue_tid = daemonCore->Register_Timer( 0,
+			(TimerHandlercpp)&Scheduler::checkPrefetchQueue,
+			"checkPrefetchQueue", this );
+	}
+	if( checkPrefetchQueue_tid == -1 ) {
+			// Error registering timer!
+		EXCEPT( "Can't register daemonCore timer!" );
+	}
+}
+
+void
+Scheduler::checkPrefetchQueue()
+{
+		// clear out the timer tid, since we made it here.
+	checkPrefetchQueue_tid = -1;
+
+		// Do a limited number of claims per pass, so that a burst of
+		// job starts does not hold up everything else the schedd does.
+	int count = 0;
+	while( !prefetchClaimQueue.empty() && count < 100 ) {
+		match_rec *mrec = FindMrecByClaimID(prefetchClaimQueue.front().c_str());
+		prefetchClaimQueue.pop();
+
+			// the claim may have gone away or stopped running its job
+		if( !PrefetchClaimJobs || !mrec || mrec->status != M_ACTIVE ||
+			!mrec->shadowRec || !mrec->my_match_ad || !mrec->user ||
+			mrec->m_next_job.isJobKey() || mrec->m_now_job.isJobKey() ||
+			ExitWhenDone )
+		{
+			continue;
+		}
+		++count;
+
+		PROC_ID next_job_id;
+		FindRunnableJob(next_job_id, mrec->my_match_ad, mrec->user, true);
+		if( next_job_id.proc < 0 ) {
+			continue;
+		}
+		JobQueueJob *job = GetJobAd(next_job_id);
+		if( !job || !JobCanFlock(*job, mrec->getPool()) ) {
+			continue;
+		}
+
+		dprintf(D_FULLDEBUG, "match (%s) will run job %d.%d next\n",
+				mrec->description(), next_job_id.cluster, next_job_id.proc);
+		SetMrecNextJobID(mrec, next_job_id);
+	}
+
+	if( !prefetchClaimQueue.empty() ) {
+		checkPrefetchQueue_tid = daemonCore->Register_Timer( 0,
+			(TimerHandlercpp)&Scheduler::checkPrefetchQueue,
+			"checkPrefetchQueue", this );
+	}
+}
+
 void
 Scheduler::RemoveShadowRecFromMrec( shadow_rec* shadow )
 {
@@ -14524,7 +14859,7 @@ Scheduler::sendAlives()
 {
 	match_rec	*mrec;
 	int		  	numsent=0;
-	bool starter_handles_alives = param_boolean("STARTER_HANDLES_ALIVES",true);
+	bool starter_handles_alives = StarterHandlesAlives;
 
 		/*
 		  we need to timestamp any job ad with the last time we sent a
@@ -15754,7 +16089,9 @@ Scheduler::jobThrottle( void )
 {
 	int delay;
 
-	if ( ++JobsThisBurst < JobStartCount ) {
+	if ( JobStartControl.Enabled() ) {
+		delay = JobStartControl.NextStartDelay();
+	} else if ( ++JobsThisBurst < JobStartCount ) {
 		delay = 0;
 	} else {
 		JobsThisBurst = 0;
@@ -15771,6 +16108,54 @@ Scheduler::jobThrottle( void )
 	return delay;
 }
 
+// Returns the memory available for new processes in MiB, or -1 if that
+// is not known.
+static long long
+available_memory_mb()
+{
+#ifdef LINUX
+	FILE *fp = safe_fopen_wrapper_follow("/proc/meminfo", "r");
+	if( !fp ) {
+		return -1;
+	}
+	char line[256];
+	long long kb = -1;
+	while( fgets(line, sizeof(line), fp) ) {
+		if( sscanf(line, "MemAvailable: %lld kB", &kb) == 1 ) {
+			break;
+		}
+	}
+	fclose(fp);
+	return kb < 0 ? -1 : kb / 1024;
+#else
+	return -1;
+#endif
+}
+
+// Feed what the main loop and the system looked like since the last call
+// to the adaptive job start throttle, so that it can adjust the rate.
+void
+Scheduler::updateJobStartControl()
+{
+	DaemonCore::Stats &dc_stats = daemonCore->dc_stats;
+	double select_wait = dc_stats.SelectWaittime.value - jobStartControlSelectWait;
+	double pump_time = dc_stats.PumpCycle.value.Sum - jobStartControlPumpTime;
+	int pump_cycles = dc_stats.PumpCycle.value.Count - jobStartControlPumpCycles;
+	jobStartControlSelectWait = dc_stats.SelectWaittime.value;
+	jobStartControlPumpTime = dc_stats.PumpCycle.value.Sum;
+	jobStartControlPumpCycles = dc_stats.PumpCycle.value.Count;
+
+		// the totals go backwards when daemon core statistics are reset
+	double duty_cycle = -1.0;
+	double loop_latency = -1.0;
+	if( pump_cycles > 0 && pump_time > 1e-9 && select_wait >= 0 && select_wait <= pump_time ) {
+		duty_cycle = 1.0 - select_wait / pump_time;
+		loop_latency = (pump_time - select_wait) / pump_cycles;
+	}
+
+	JobStartControl.Update(duty_cycle, loop_latency, available_memory_mb());
+}
+
 GridJobCounts *
 Scheduler::GetGridJobCounts(UserIdentity user_identity) {
 	GridJobCounts * gridcounts = 0;
@@ -16564,14 +16949,50 @@ Scheduler::RecycleShadow(int /*cmd*/, Stream *stream)
 		mrec->idle_timer_deadline = time(NULL) + mrec->keep_while_idle;
 	}
 
+		// FindRunnableJobForClaim deletes mrec when it relinquishes the
+		// claim, so save the user we need to look for a job on another claim.
+	std::string claim_user = mrec->user ? mrec->user : "";
 	if( !FindRunnableJobForClaim(mrec) ) {
-		dprintf(D_FULLDEBUG,
-			"No runnable jobs for shadow pid %d (was running job %d.%d); shadow will exit.\n",
-			shadow_pid, prev_job_id.cluster, prev_job_id.proc);
-		stream->encode();
-		stream->put((int)0);
-		stream->end_of_message();
-		return TRUE;
+		shadow_rec *next_srec = NULL;
+		if( RecycleShadowsAcrossClaims && !claim_user.empty() ) {
+			next_srec = TakeRunnableJobForShadow(claim_user.c_str());
+		}
+		if( !next_srec ) {
+			dprintf(D_FULLDEBUG,
+				"No runnable jobs for shadow pid %d (was running job %d.%d); shadow will exit.\n",
+				shadow_pid, prev_job_id.cluster, prev_job_id.proc);
+			stream->encode();
+			stream->put((int)0);
+			stream->end_of_message();
+			return TRUE;
+		}
+
+			// This claim is out of work, but another claim has a job
+			// waiting for a shadow to be spawned.  Rather than have this
+			// shadow exit and spawn a new one, give it that job.  This
+			// claim has already been relinquished, or kept idle, just as
+			// if the shadow had exited, so mrec must not be used here.
+		new_job_id = next_srec->job_id;
+		dprintf(D_ALWAYS,
+				"Shadow pid %d switching to job %d.%d on %s.\n",
+				shadow_pid, new_job_id.cluster, new_job_id.proc,
+				next_srec->match->description() );
+
+		time_t now = stats.Tick();
+		stats.ShadowsRecycled += 1;
+		stats.ShadowsRunning = numShadows;
+		OtherPoolStats.Tick(now);
+
+		delete_shadow_rec( srec );
+
+		srec = next_srec;
+		srec->pid = shadow_pid;
+		srec->prev_job_id = prev_job_id;
+		srec->recycle_shadow_stream = stream;
+		add_shadow_rec( srec );
+
+		callAboutToSpawnJobHandler(new_job_id.cluster, new_job_id.proc, srec);
+		return KEEP_STREAM;
 	}
 
 	new_job_id.cluster = mrec->cluster;
@@ -16603,10 +17024,51 @@ Scheduler::RecycleShadow(int /*cmd*/, Stream *stream)
 
 	mrec->setStatus( M_ACTIVE );
 
+	PrefetchNextJobForClaim( mrec );
+
 	callAboutToSpawnJobHandler(new_job_id.cluster, new_job_id.proc, srec);
 	return KEEP_STREAM;
 }
 
+// If the job at the head of the runnable job queue can run under a shadow
+// that is giving up a claim of the given user, take it off of the queue and
+// return its shadow record, which is not yet added to the shadow tables.
+// Only serial jobs of the same user qualify; anything else is left for
+// StartJobHandler().
+shadow_rec*
+Scheduler::TakeRunnableJobForShadow(char const *user)
+{
+	if( RunnableJobQueue.empty() || ExitWhenDone ) {
+		return NULL;
+	}
+
+	shadow_rec *srec = RunnableJobQueue.front();
+	match_rec *next_mrec = srec->match;
+	if( srec->pid || srec->is_reconnect || !next_mrec ||
+		next_mrec->m_now_job.isJobKey() ||
+		!user || !next_mrec->user || strcmp(user, next_mrec->user) != MATCH ||
+		(srec->universe != CONDOR_UNIVERSE_VANILLA &&
+		 srec->universe != CONDOR_UNIVERSE_JAVA &&
+		 srec->universe != CONDOR_UNIVERSE_VM) )
+	{
+		return NULL;
+	}
+
+	int status = -1;
+	JobQueueJob *job = GetJobAd(srec->job_id);
+	if( !job || !isStillRunnable(srec->job_id.cluster, srec->job_id.proc, status) ) {
+		return NULL;
+	}
+	bool wantPS = false;
+	job->LookupBool(ATTR_WANT_PARALLEL_SCHEDULING, wantPS);
+	if( wantPS ) {
+		return NULL;
+	}
+
+	RunnableJobQueue.pop();
+	return srec;
+}
+
 void
 Scheduler::finishRecycleShadow(shadow_rec *srec)
 {
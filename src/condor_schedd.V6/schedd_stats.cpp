@@ -187,6 +187,7 @@ void ScheddStatistics::InitMain()
 
    SCHEDD_STATS_ADD_RECENT(Pool, JobsSubmitted,        IF_BASICPUB);
    SCHEDD_STATS_ADD_RECENT(Pool, Autoclusters,         IF_BASICPUB);
+   SCHEDD_STATS_ADD_RECENT(Pool, JobsMaterialized,     IF_BASICPUB);
    SCHEDD_STATS_ADD_RECENT(Pool, ResourceRequestsSent,      IF_BASICPUB);
 
    SCHEDD_STATS_ADD_RECENT(Pool, ShadowsStarted,            IF_BASICPUB);
@@ -230,6 +231,9 @@ void ScheddStatistics::InitMain()
    extern stats_entry_abs<int> SCGetAutoClusterType;
    SCHEDD_STATS_ADD_VAL(Pool, SCGetAutoClusterType, IF_VERBOSEPUB);
 
+   // timings for late materialization, one sample per batch of jobs
+   SCHEDD_STATS_ADD_EXTERN_RUNTIME(Pool, MaterializeBatch, IF_VERBOSEPUB);
+
    //SCHEDD_STATS_PUB_DEBUG(Pool, JobsSubmitted,  IF_BASICPUB);
 }
 
@@ -105,6 +105,7 @@ typedef struct ScheddStatistics : public ScheddJobCounters {
    time_t RecentStatsTickTime;   // last time Recent values Advanced
 
    stats_entry_recent<int> Autoclusters;   // number of active autoclusters
+   stats_entry_recent<int> JobsMaterialized; // number of jobs materialized by job factories
    stats_entry_recent<int> ResourceRequestsSent;   // number of resource requests
 
    // These track how successful the schedd was at reconnecting to
@@ -65,6 +65,7 @@
 #include "job_transforms.h"
 #include "history_queue.h"
 #include "live_job_counters.h"
+#include "job_start_controller.h"
 
 extern  int         STARTD_CONTACT_TIMEOUT;
 const	int			NEGOTIATOR_CONTACT_TIMEOUT = 30;
@@ -319,6 +320,12 @@ class match_rec: public ClaimIdParser
 
 	PROC_ID m_now_job;
 
+		// Job picked for this claim while its current job runs, so that the
+		// next job can be handed to the shadow without searching the queue.
+		// NOTE: use SetMrecNextJobID() to change it, because this updates
+		// the index of jobs held for claims.
+	PROC_ID m_next_job;
+
 private:
 	std::string m_pool; // negotiator hostname if flocking; else empty
 };
@@ -532,6 +539,7 @@ class Scheduler : public Service
 	void			removeJobFromIndexes(const JOB_ID_KEY& job_id, int job_prio=0);
 	int				RecycleShadow(int cmd, Stream *stream);
 	void			finishRecycleShadow(shadow_rec *srec);
+	shadow_rec*		TakeRunnableJobForShadow(char const *user);
 	int				CmdDirectAttach(int cmd, Stream* stream);
 
 	int			FindGManagerPid(PROC_ID job_id);
@@ -556,12 +564,17 @@ class Scheduler : public Service
 	match_rec*      FindMrecByClaimID(char const *claim_id);
 	void            SetMrecJobID(match_rec *rec, int cluster, int proc);
 	void            SetMrecJobID(match_rec *match, PROC_ID job_id);
+	void            SetMrecNextJobID(match_rec *match, PROC_ID job_id);
+	void            PrefetchNextJobForClaim(match_rec *match);
 	shadow_rec*		FindSrecByPid(int);
 	shadow_rec*		FindSrecByProcID(PROC_ID);
 	void			RemoveShadowRecFromMrec(shadow_rec*);
 	void            sendSignalToShadow(pid_t pid,int sig,PROC_ID proc);
 	int				AlreadyMatched(PROC_ID*);
 	int				AlreadyMatched(JobQueueJob * job, int universe);
+		// true if the job has been picked to run next on a busy claim,
+		// so that other busy claims picking a next job should pass it by.
+	bool			IsNextJobForClaim(PROC_ID job_id) const { return matchesByNextJobID.count(job_id) > 0; }
 	void			ExpediteStartJobs() const;
 	void			StartJobs();
 	void			StartJob(match_rec *rec);
@@ -629,6 +642,7 @@ class Scheduler : public Service
 		*/
 	bool			enqueueReconnectJob( PROC_ID job );
 	void			checkReconnectQueue( void );
+	void			checkPrefetchQueue( void );
 	void			makeReconnectRecords( PROC_ID* job, const ClassAd* match_ad );
 
 	bool	spawnJobHandler( int cluster, int proc, shadow_rec* srec );
@@ -641,6 +655,7 @@ class Scheduler : public Service
 	char*			uidDomain( void ) { return UidDomain; };
 	std::string 		accountingDomain() const { return AccountingDomain; };
 	int				getMaxMaterializedJobsPerCluster() const { return MaxMaterializedJobsPerCluster; }
+	int				getMaterializeBatchSize() const { return MaterializeBatchSize; }
 	bool			getAllowLateMaterialize() const { return AllowLateMaterialize; }
 	bool			getNonDurableLateMaterialize() const { return NonDurableLateMaterialize; }
 	const ClassAd * getExtendedSubmitCommands() const { return &m_extendedSubmitCommands; }
@@ -788,6 +803,9 @@ private:
 	bool			NonDurableLateMaterialize;	// for testing, use non-durable transactions when materializing new jobs
 	bool			EnableJobQueueTimestamps;	// for testing
 	int				MaxMaterializedJobsPerCluster;
+	int				MaterializeBatchSize;	// max jobs to materialize for a factory in one transaction, 0 for no limit
+	bool			PrefetchClaimJobs;		// pick the next job for a claim while its current job runs
+	bool			RecycleShadowsAcrossClaims;	// give a shadow whose claim has no more work a job waiting for a shadow
 	char*			StartLocalUniverse; // expression for local jobs
 	char*			StartSchedulerUniverse; // expression for scheduler jobs
 	int				MaxRunningSchedulerJobsPerOwner;
@@ -829,6 +847,11 @@ private:
 	int				timeoutid;		// daemoncore timer id for timeout()
 	int				startjobsid;	// daemoncore timer id for StartJobs()
 	int				jobThrottleNextJobDelay;	// used by jobThrottle()
+	JobStartController JobStartControl;	// used by jobThrottle() in place of JobStartDelay/JobStartCount
+	int				jobStartControlTimer;	// DC Timer ID for updateJobStartControl()
+	double			jobStartControlSelectWait;	// main loop totals at the last update
+	double			jobStartControlPumpTime;
+	int				jobStartControlPumpCycles;
 
 	int				shadowReaperId; // daemoncore reaper id for shadows
 //	int 				dirtyNoticeId;
@@ -847,6 +870,12 @@ private:
 	std::vector<PROC_ID> jobsToReconnect;
 	int				checkReconnectQueue_tid;
 
+		// Claims to pick a next job for once their current job is running,
+		// and the jobs that have been picked.
+	std::queue<std::string> prefetchClaimQueue;
+	int				checkPrefetchQueue_tid;
+	std::map<PROC_ID, match_rec*> matchesByNextJobID;
+
 		// queue for sending hold/remove signals to shadows
 	SelfDrainingQueue stop_job_queue;
 		// queue for doing other "act_on_job_myself" calls
@@ -919,6 +948,7 @@ private:
 	static void		refuse( Stream* s );
 	void			tryNextJob();
 	int				jobThrottle( void );
+	void			updateJobStartControl();
 	void			initLocalStarterDir( void );
 	bool			jobExitCode( PROC_ID job_id, int exit_code );
 	double			calcSlotWeight(match_rec *mrec) const;
@@ -0,0 +1,204 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2023, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+// Checks that the adaptive job start throttle (JOB_START_ADAPTIVE) backs off
+// on each of its overload signals and speeds up while starts are held back,
+// and simulates a burst of job starts on a fast and a slow submit host to
+// show the rate it settles at.
+//
+// usage: test_job_start_controller [-v] [num_jobs]
+
+#include "condor_common.h"
+#include "condor_debug.h"
+#include "condor_config.h"
+#include "job_start_controller.h"
+
+#include <stdio.h>
+
+bool verbose = false;
+#define REQUIRE( condition ) \
+	if(! ( condition )) { \
+		fprintf( stderr, "Failed requirement '%s' on line %d.\n", #condition, __LINE__ ); \
+		return 1; \
+	} else if( verbose ) { \
+		fprintf( stdout, "Passed requirement '%s' on line %d.\n", #condition, __LINE__ ); \
+	}
+
+// start jobs for the second now, as the schedd's start job timer would: each
+// start schedules the next one after the delay NextStartDelay() returns,
+// returns the number started
+static int start_for_a_second(JobStartController & ctl, int backlog, time_t now)
+{
+	int started = 0;
+	while (started < backlog) {
+		++started;
+		if (ctl.NextStartDelay(now) > 0) { break; }
+	}
+	return started;
+}
+
+// Start num_jobs jobs on a host that can spawn capacity shadows a second
+// before its main loop is saturated.  Returns the average rate over the
+// second half of the burst, and the seconds it took in secs.
+static double simulate(JobStartController & ctl, int capacity, int num_jobs, int & secs)
+{
+	double late_rate = 0;
+	int late_ticks = 0;
+	int backlog = num_jobs;
+	secs = 0;
+	while (backlog > 0) {
+		int started = 0;
+		for (int ix = 0; ix < ctl.Interval() && backlog > 0; ++ix, ++secs) {
+			int n = start_for_a_second(ctl, std::min(backlog, capacity), 1000 + secs);
+			for (int jx = 0; jx < n; ++jx) { ctl.ShadowSpawned(0.01); }
+			backlog -= n;
+			started += n;
+		}
+		double per_sec = (double)started / ctl.Interval();
+		double duty_cycle = std::min(1.0, 0.2 + per_sec / capacity);
+		ctl.Update(duty_cycle, 0.001, 100000);
+		if (backlog < num_jobs / 2) {
+			late_rate += per_sec;
+			++late_ticks;
+		}
+		if (verbose) { printf("  %5d: %4d started, duty cycle %.2f, rate now %.1f\n", secs, started, duty_cycle, ctl.Rate()); }
+	}
+	return late_ticks ? late_rate / late_ticks : 0;
+}
+
+int main( int argc, char ** argv ) {
+	int num_jobs = 50000;
+	for (int ix = 1; ix < argc; ++ix) {
+		if (strcmp(argv[ix], "-v") == 0) { verbose = true; }
+		else { num_jobs = atoi(argv[ix]); }
+	}
+
+	config();
+	if (verbose) dprintf_set_tool_debug("TOOL", 0);
+
+	// on by default, but it can be turned off, and a fixed JOB_START_DELAY turns it off
+	JobStartController ctl;
+	ctl.Config();
+	REQUIRE( ctl.Enabled() );
+	param_insert("JOB_START_ADAPTIVE", "false");
+	ctl.Config();
+	REQUIRE( ! ctl.Enabled() );
+	param_insert("JOB_START_ADAPTIVE", "true");
+	param_insert("JOB_START_DELAY", "2");
+	ctl.Config();
+	REQUIRE( ! ctl.Enabled() );
+	ClassAd ad;
+	ad.Assign("JobStartAdaptiveRate", 1.0);
+	ctl.Publish(ad);
+	REQUIRE( ad.Lookup("JobStartAdaptiveRate") == NULL );
+
+	// it starts out not throttling at all, and stays that way while healthy
+	param_insert("JOB_START_DELAY", "0");
+	ctl.Config();
+	REQUIRE( ctl.Enabled() );
+	REQUIRE( ctl.Rate() == 0 );
+	time_t now = 1000;
+	REQUIRE( start_for_a_second(ctl, 1000, now) == 1000 );
+	ctl.Update(0.5, 0.01, 10000);
+	REQUIRE( ctl.Rate() == 0 );
+	ctl.Publish(ad);
+	REQUIRE( ad.Lookup("JobStartAdaptiveRate") == NULL );
+
+	// on overload it backs off to half the rate jobs were started at
+	for (int ix = 0; ix < 5; ++ix) { start_for_a_second(ctl, 100, ++now); }
+	ctl.Update(0.99, 0.01, 10000);
+	REQUIRE( ctl.Rate() == 50 );
+	std::string limited_by;
+	ctl.Publish(ad);
+	REQUIRE( ad.LookupString("JobStartAdaptiveLimitedBy", limited_by) && limited_by == "MainLoopBusy" );
+
+	// starts come in bursts of the rate each second of the clock, so a
+	// trickle of starts is never held back
+	REQUIRE( start_for_a_second(ctl, 1000, ++now) == 50 );
+	REQUIRE( start_for_a_second(ctl, 1000, now) == 1 );
+	REQUIRE( start_for_a_second(ctl, 1000, ++now) == 50 );
+	ctl.Update(0.5, 0.01, 10000); // held back, so it goes up
+	REQUIRE( ctl.Rate() == 62.5 );
+	for (int ix = 0; ix < 200; ++ix) {
+		REQUIRE( start_for_a_second(ctl, 10, now + ix) == 10 );
+	}
+	ctl.Update(0.5, 0.01, 10000); // not held back, so it stays put
+	REQUIRE( ctl.Rate() == 62.5 );
+
+	// JOB_START_ADAPTIVE_MAX_RATE caps it
+	param_insert("JOB_START_ADAPTIVE_MAX_RATE", "40");
+	ctl.Config();
+	REQUIRE( ctl.Rate() == 40 );
+	now += 1000;
+	start_for_a_second(ctl, 1000, now);
+	ctl.Update(0.5, 0.01, 10000);
+	REQUIRE( ctl.Rate() == 40 );
+	ctl.Publish(ad);
+	REQUIRE( ad.LookupString("JobStartAdaptiveLimitedBy", limited_by) && limited_by == "MaxRate" );
+
+	// each overload signal halves it
+	for (int ix = 0; ix < 5; ++ix) { start_for_a_second(ctl, 1000, ++now); }
+	ctl.Update(0.99, 0.01, 10000);
+	REQUIRE( ctl.Rate() == 20 );
+	ctl.Update(0.5, 2.0, 10000);
+	REQUIRE( ctl.Rate() == 10 );
+	ctl.ShadowSpawned(0.5);
+	ctl.Update(0.5, 0.01, 10000);
+	REQUIRE( ctl.Rate() == 5 );
+	ctl.Update(0.5, 0.01, 100);
+	REQUIRE( ctl.Rate() == 2.5 );
+	for (int ix = 0; ix < 8; ++ix) { ctl.ShadowSpawned(0.01); }
+	for (int ix = 0; ix < 4; ++ix) { ctl.ShadowFailed(); }
+	ctl.Update(0.5, 0.01, 10000);
+	REQUIRE( ctl.Rate() == 1.25 );
+	ctl.Publish(ad);
+	REQUIRE( ad.LookupString("JobStartAdaptiveLimitedBy", limited_by) && limited_by == "ShadowFailures" );
+	int failures = 0;
+	REQUIRE( ad.LookupInteger("JobStartAdaptiveFailures", failures) && failures == 4 );
+
+	// a few failures among many spawns are fine, and it never goes below 1
+	for (int ix = 0; ix < 40; ++ix) { ctl.ShadowSpawned(0.01); }
+	for (int ix = 0; ix < 4; ++ix) { ctl.ShadowFailed(); }
+	ctl.Update(0.5, 0.01, 10000);
+	REQUIRE( ctl.Rate() == 1.25 );
+	ctl.Update(0.99, 0.01, 10000);
+	ctl.Update(0.99, 0.01, 10000);
+	REQUIRE( ctl.Rate() == 1 );
+
+	// unknown signals do not hold it back
+	start_for_a_second(ctl, 1000, ++now);
+	ctl.Update(-1, -1, -1);
+	REQUIRE( ctl.Rate() == 2 );
+
+	// a burst of jobs on a host that can take a few hundred starts a second,
+	// and on one that can only take a few
+	param_insert("JOB_START_ADAPTIVE_MAX_RATE", "0");
+	int fast_secs = 0, slow_secs = 0;
+	JobStartController fast, slow;
+	fast.Config();
+	slow.Config();
+	double fast_rate = simulate(fast, 400, num_jobs, fast_secs);
+	double slow_rate = simulate(slow, 20, num_jobs / 10, slow_secs);
+	REQUIRE( fast_rate > 150 );
+	REQUIRE( slow_rate > 5 && slow_rate < 20 );
+
+	printf("%d jobs on a fast host: %ds at %.1f/s, %d jobs on a slow host: %ds at %.1f/s\n",
+		num_jobs, fast_secs, fast_rate, num_jobs / 10, slow_secs, slow_rate);
+	return 0;
+}
@@ -25,6 +25,7 @@
 #include "startd_hibernator.h"
 #include "startd_named_classad_list.h"
 #include "classad_merge.h"
+#include "classad_batch.h"
 #include "overflow.h"
 #include <math.h>
 #include "credmon_interface.h"
@@ -38,6 +39,7 @@
 #include "slot_builder.h"
 
 #include "strcasestr.h"
+#include "param_handle.h"
 
 struct slotOrderSorter {
    bool operator()(const Resource *r1, const Resource *r2) {
@@ -147,6 +149,12 @@ void ResMgr::Stats::Init()
    STATS_POOL_ADD(daemonCore->dc_stats.Pool, "ResMgr", WalkUpdate, IF_VERBOSEPUB);
    STATS_POOL_ADD(daemonCore->dc_stats.Pool, "ResMgr", WalkOther, IF_VERBOSEPUB);
    STATS_POOL_ADD(daemonCore->dc_stats.Pool, "ResMgr", Drain, IF_VERBOSEPUB);
+
+   // 100us to 10s
+   static const double slot_policy_eval_levels[] = { 0.0001, 0.001, 0.01, 0.1, 1.0, 10.0 };
+   SlotPolicyEval.set_levels(slot_policy_eval_levels, COUNTOF(slot_policy_eval_levels));
+   STATS_POOL_ADD(daemonCore->dc_stats.Pool, "ResMgr", SlotPolicyEval, IF_VERBOSEPUB);
+   STATS_POOL_ADD(daemonCore->dc_stats.Pool, "ResMgr", SlotPolicyEvalRuntime, IF_VERBOSEPUB);
 }
 
 double ResMgr::Stats::BeginRuntime(stats_recent_counter_timer &  /*probe*/)
@@ -210,6 +218,11 @@ ResMgr::~ResMgr()
 #endif /* HAVE_HIBERNATION */
 
 
+	if (m_batch_update_tid != -1) {
+		daemonCore->Cancel_Timer(m_batch_update_tid);
+		m_batch_update_tid = -1;
+	}
+
 	for (auto rip : slots) { delete rip; }
 	slots.clear();
 	for( i=0; i<max_types; i++ ) {
@@ -231,6 +244,9 @@ ResMgr::init_config_classad( void )
 {
 	if( config_classad ) delete config_classad;
 	config_classad = new ClassAd();
+	// slots that are (re)initialized from now on get a new base ad,
+	// the old one lives until the last slot that uses it goes away
+	m_slot_base_ad.reset();
 
 		// First, bring in everything we know we need
 	configInsert( config_classad, "START", true );
@@ -476,6 +492,8 @@ ResMgr::init_resources( void )
 #endif // LINUX
 
     stats.Init();
+	config_policy_threads();
+	config_update_batching();
 
     m_attr->init_machine_resources();
 
@@ -585,6 +603,8 @@ ResMgr::reconfig_resources( void )
 #endif /* HAVE_HIBERNATE */
 
 	m_attr->ReconfigOfflineDevIds();
+	config_policy_threads();
+	config_update_batching();
 
 		// Tell each resource to reconfig itself.
 	walk(&Resource::reconfig);
@@ -630,6 +650,56 @@ ResMgr::walk( VoidResourceMember memberfunc )
 	stats.EndWalk(memberfunc, currenttime);
 }
 
+void
+ResMgr::parallel_walk( const std::function<void(Resource*)> & fn )
+{
+	// the slots vector cannot change while we are in here, since the main
+	// thread is blocked in parallel_for until all of the slots are done.
+	m_policy_pool.parallel_for(slots.size(), [this, &fn](size_t ix) {
+		Resource * rip = slots[ix];
+		if (rip) fn(rip);
+	});
+}
+
+void
+ResMgr::config_policy_threads( void )
+{
+	int num_threads = param_integer("STARTD_POLICY_EVAL_THREADS", 0, 0, 256);
+	if (num_threads != m_policy_pool.size()) {
+		num_threads = m_policy_pool.start(num_threads);
+		dprintf(D_ALWAYS, "Using %d threads for slot policy evaluation\n", num_threads);
+	}
+}
+
+void
+ResMgr::eval_state_all( void )
+{
+	if ( ! m_policy_pool.size()) {
+		walk( &Resource::eval_state );
+		return;
+	}
+
+	double runtime = stats.BeginRuntime(stats.WalkEvalState);
+
+	// refresh load hacks and cross-slot attrs into every slot before we
+	// evaluate anything. then evaluate each slot's policy expressions on the
+	// worker threads, and finally make the state transitions here, in slot order.
+	walk( [](Resource * rip) { rip->prepare_eval_state(); rip->prepare_policy_cache(); } );
+	unsigned int epoch = ++m_policy_epoch;
+	parallel_walk( [this, epoch](Resource * rip) {
+		double begin = _condor_debug_get_time_double();
+		rip->prime_policy_cache(epoch);
+		double elapsed = _condor_debug_get_time_double() - begin;
+		stats.SlotPolicyEval += elapsed;
+		stats.SlotPolicyEvalRuntime += elapsed;
+	} );
+	walk( [](Resource * rip) { rip->eval_state_primed(); } );
+	// nothing primed during this walk may be used after it
+	invalidatePolicyCaches();
+
+	stats.EndRuntime(stats.WalkEvalState, runtime);
+}
+
 double
 ResMgr::sum( ResourceFloatMember memberfunc )
 {
@@ -938,6 +1008,101 @@ ResMgr::send_update( int cmd, ClassAd* public_ad, ClassAd* private_ad,
 }
 
 
+std::shared_ptr<ClassAd>
+ResMgr::slot_base_ad( void )
+{
+	if ( ! m_slot_base_ad) {
+		ASSERT(config_classad);
+		m_slot_base_ad = std::make_shared<ClassAd>(*config_classad);
+		// the same machine wide attributes that Resource::publish_static writes
+		// into every slot, so that they can be pruned from the slot config ads
+		daemonCore->publish(m_slot_base_ad.get());
+		m_attr->publish_static(m_slot_base_ad.get());
+		publish_static(m_slot_base_ad.get());
+	}
+	return m_slot_base_ad;
+}
+
+void
+ResMgr::config_update_batching( void )
+{
+	m_batch_updates = param_boolean("STARTD_BATCH_COLLECTOR_UPDATES", false);
+	m_batch_max_ads = param_integer("STARTD_BATCH_UPDATE_MAX_ADS", 100, 2);
+}
+
+void
+ResMgr::queue_batched_update( Resource* rip )
+{
+	m_batch_pending.push_back(rip);
+	if (m_batch_update_tid == -1) {
+		m_batch_update_tid = daemonCore->Register_Timer(0,
+						(TimerHandlercpp)&ResMgr::send_batched_updates,
+						"send_batched_updates", this);
+	}
+}
+
+void
+ResMgr::cancel_batched_update( Resource* rip )
+{
+	m_batch_pending.erase(std::remove(m_batch_pending.begin(), m_batch_pending.end(), rip),
+						  m_batch_pending.end());
+}
+
+// send the updates for all queued slots, the attributes that are the
+// same in all of the slot ads (most of the machine attributes) are
+// sent only once per message.
+void
+ResMgr::send_batched_updates( void )
+{
+	m_batch_update_tid = -1;
+
+	std::vector<Resource*> pending;
+	pending.swap(m_batch_pending);
+
+	std::deque<ClassAd> pub_ads, pvt_ads;
+	for (Resource * rip : pending) {
+		rip->batched_update_sent();
+		if ( ! rip->can_batch_update()) {
+			rip->do_update();
+			continue;
+		}
+		pub_ads.emplace_back();
+		pvt_ads.emplace_back();
+		rip->publish_update_ads(pub_ads.back(), pvt_ads.back());
+	}
+
+	// these are never factored out of the items, the collector needs them
+	// to make the hash key, and the ad sequence numbers are keyed on them
+	static const AttrNameSet keep_in_each = { ATTR_NAME, ATTR_MY_TYPE, ATTR_MACHINE };
+
+	size_t ix = 0;
+	while (ix < pub_ads.size()) {
+		size_t count = MIN(pub_ads.size() - ix, (size_t)m_batch_max_ads);
+		int rval;
+		if (count == 1) {
+			rval = send_update(UPDATE_STARTD_AD, &pub_ads[ix], &pvt_ads[ix], true);
+		} else {
+			std::vector<ClassAd*> pubs, pvts;
+			for (size_t jj = ix; jj < ix + count; ++jj) {
+				pubs.push_back(&pub_ads[jj]);
+				pvts.push_back(&pvt_ads[jj]);
+			}
+			ClassAd pub_batch, pvt_batch;
+			int shared = PackClassAdBatch(pub_batch, pubs, &keep_in_each, true);
+			PackClassAdBatch(pvt_batch, pvts, &keep_in_each, false);
+			dprintf(D_FULLDEBUG, "Sending batched update of %d slots, %d shared attributes\n",
+					(int)count, shared);
+			rval = send_update(UPDATE_STARTD_ADS_BATCHED, &pub_batch, &pvt_batch, true);
+		}
+		if (rval) {
+			dprintf(D_FULLDEBUG, "Sent update to %d collector(s)\n", rval);
+		} else {
+			dprintf(D_ALWAYS, "Error sending update to collector(s)\n");
+		}
+		ix += count;
+	}
+}
+
 void
 ResMgr::update_all( void )
 {
@@ -961,7 +1126,7 @@ ResMgr::update_all( void )
 		// Evaluate the state change policy expressions (like PREEMPT)
 		// For certain changes this will trigger an update to the collector
 		// (all that really does is register a timer)
-	walk( &Resource::eval_state );
+	eval_state_all();
 
 		// If we didn't update b/c of the eval_state, we need to
 		// actually do the update now. Tj 2020 sez: this is a lie, was it ever true?
@@ -997,7 +1162,7 @@ ResMgr::eval_all( void )
 #endif
 		num_updates = 0;
 		compute_dynamic(false);
-		walk( &Resource::eval_state );
+		eval_state_all();
 		report_updates();
 		check_polling();
 #if HAVE_HIBERNATION
@@ -1253,11 +1418,18 @@ ResMgr::compute_dynamic(bool for_update)
 		// Now that we have an updated internal classad for each
 		// resource, we can "compute" anything where we need to
 		// evaluate classad expressions to get the answer.
-	walk( &Resource::compute_evaluated );
-
 		// Next, we can publish any results from that to our internal
 		// classads to make sure those are still up-to-date
-	walk( [](Resource* rip) { rip->refresh_classad_evaluated(); } );
+	if (m_policy_pool.size()) {
+		// both of these touch only the slot's own ad, so they can be done
+		// together on the policy eval threads
+		double walktime = stats.BeginRuntime(stats.WalkOther);
+		parallel_walk( [](Resource* rip) { rip->compute_evaluated(); rip->refresh_classad_evaluated(); } );
+		stats.EndRuntime(stats.WalkOther, walktime);
+	} else {
+		walk( &Resource::compute_evaluated );
+		walk( [](Resource* rip) { rip->refresh_classad_evaluated(); } );
+	}
 
 		// Finally, now that all the internal classads are up to date
 		// with all the attributes they could possibly have, we can
@@ -1414,8 +1586,10 @@ ResMgr::publishSlotAttrs( ClassAd* cap )
 		return;
 	}
 	// experimental flags new for 8.9.7, evaluate STARTD_SLOT_ATTRS and insert valid literals only
-	bool as_literal = param_boolean("STARTD_EVAL_SLOT_ATTRS", false);
-	bool valid_only = ! param_boolean("STARTD_EVAL_SLOT_ATTRS_DEBUG", false);
+	static param_handle<bool> eval_slot_attrs("STARTD_EVAL_SLOT_ATTRS", false);
+	static param_handle<bool> eval_slot_attrs_debug("STARTD_EVAL_SLOT_ATTRS_DEBUG", false);
+	bool as_literal = eval_slot_attrs;
+	bool valid_only = ! eval_slot_attrs_debug;
 	for (Resource* rip : slots) {
 		rip->publish_SlotAttrs( cap, as_literal, valid_only );
 	}
@@ -53,6 +53,7 @@
 #endif /* HAVE_BACKFILL */
 
 #include "generic_stats.h"
+#include "worker_pool.h"
 
 #ifndef NUM_ELEMENTS
 #define NUM_ELEMENTS(_ary)   (sizeof(_ary) / sizeof((_ary)[0]))
@@ -176,6 +177,17 @@ public:
 		// Evaluate the state of all resources.
 	void	eval_all( void );
 
+		// primed policy values cached in each Resource are valid only
+		// while they carry the current epoch.
+	unsigned int policyEpoch() const { return m_policy_epoch; }
+	void	invalidatePolicyCaches() { ++m_policy_epoch; }
+
+		// when STARTD_BATCH_COLLECTOR_UPDATES is true, slots that need an update
+		// are queued here and sent to the collector together in one message
+	bool	batchingUpdates() const { return m_batch_updates; }
+	void	queue_batched_update( Resource* rip );
+	void	cancel_batched_update( Resource* rip );
+
 		// Evaluate and send updates for all resources.
 	void	eval_and_update_all( void );
 
@@ -230,6 +242,25 @@ private:
 	// function.  
 	void resource_sort( ComparisonFunc );
 
+	// evaluate state change policy for all slots, in parallel if
+	// STARTD_POLICY_EVAL_THREADS is non-zero
+	void	eval_state_all( void );
+	// like walk, but calls fn on the policy eval threads. fn must be thread safe
+	void	parallel_walk( const std::function<void(Resource*)> & fn );
+	void	config_policy_threads( void );
+
+	WorkerPool		m_policy_pool;
+	unsigned int	m_policy_epoch = 0;
+
+	void	config_update_batching( void );
+	void	send_batched_updates( void );
+	std::vector<Resource*> m_batch_pending;
+	int		m_batch_update_tid = -1;
+	int		m_batch_max_ads = 0;
+	bool	m_batch_updates = false;
+
+	std::shared_ptr<ClassAd> m_slot_base_ad;
+
 public:
 	// Manipulate the supplemental Class Ad list
 	int		adlist_register( StartdNamedClassAd *ad );
@@ -282,6 +313,9 @@ public:
 	ClassAd*	extras_classad;
 
 	void		init_config_classad( void );
+		// the config_classad plus the machine wide static attributes. the config
+		// ad of each slot chains to this and only holds what differs from it
+	std::shared_ptr<ClassAd> slot_base_ad( void );
 	void		updateExtrasClassAd( ClassAd * cap );
 
 	void		addResource( Resource* );
@@ -356,6 +390,9 @@ public:
        stats_recent_counter_timer WalkUpdate;
        stats_recent_counter_timer WalkOther;
        stats_recent_counter_timer Drain;
+       // time taken to evaluate the policy of each slot, added by the policy eval threads
+       stats_entry_recent_histogram_ts<double> SlotPolicyEval;
+       stats_entry_recent_ts<double> SlotPolicyEvalRuntime;
 
        // TJ: for now these stats will be registered in the DC pool.
        void Init(void);
@@ -36,6 +36,7 @@
 #endif
 
 #include "stat_info.h"
+#include "param_handle.h"
 
 #ifndef max
 #define max(x,y) (((x) < (y)) ? (y) : (x))
@@ -43,6 +44,9 @@
 
 std::vector<SlotType> SlotType::types(10);
 static bool warned_startd_attrs_once = false; // used to prevent repetition of the warning about mixing STARTD_ATTRS and STARTD_EXPRS
+// knobs that are looked up on every publish or claim, these are only looked up again after a reconfig
+static param_handle<bool> AdvertisePslotRollup("ADVERTISE_PSLOT_ROLLUP_INFORMATION", true);
+static param_handle<bool> ClaimPartitionableLeftovers("CLAIM_PARTITIONABLE_LEFTOVERS", true);
 
 const char * SlotType::type_param(const char * name)
 {
@@ -337,6 +341,10 @@ Resource::~Resource()
 		}
 		update_tid = -1;
 	}
+	if (r_update_queued) {
+		resmgr->cancel_batched_update(this);
+		r_update_queued = false;
+	}
 
 #if HAVE_JOB_HOOKS
 	if (m_next_fetch_work_tid != -1) {
@@ -1204,7 +1212,11 @@ Resource::init_classad()
 	if (r_config_classad) {
 		delete r_config_classad;
 	}
-	r_config_classad = new ClassAd( *resmgr->config_classad );
+	// the config ad holds only what is specific to this slot, everything
+	// that is the same for all slots is found through the chained base ad
+	r_config_base = resmgr->slot_base_ad();
+	r_config_classad = new ClassAd();
+	r_config_classad->ChainToAd(r_config_base.get());
 
 	// make an ephemeral ad that we will occasionally discard
 	// this catches all state updates
@@ -1214,6 +1226,7 @@ Resource::init_classad()
 		// put in slottype overrides of the config_classad
 	this->publish_slot_config_overrides(r_config_classad);
 	this->publish_static(r_config_classad);
+	r_config_classad->PruneChildAd();
 #ifdef USE_STARTD_LATCHES  // more generic mechanism for CpuBusy
 	// the latches need access to the r_config_classad?
 	this->reconfig_latches();
@@ -1282,6 +1295,11 @@ void Resource::state_or_activity_changed(time_t now, bool /*state_changed*/, boo
 {
 	r_state->publish(r_classad);
 
+	// any primed policy values are stale now, and if other slots can see
+	// our state through STARTD_SLOT_ATTRS, so are theirs.
+	clear_policy_cache();
+	if (startd_slot_attrs) { resmgr->invalidatePolicyCaches(); }
+
 	// hack! TJ has seen ads where EnterredCurrentActivity is
 	// ahead of MyCurrentTime and that confuses condor_status.
 	// TODO: fix things so that can't happen and then remove this...
@@ -1294,6 +1312,13 @@ void Resource::state_or_activity_changed(time_t now, bool /*state_changed*/, boo
 
 void
 Resource::eval_state( void )
+{
+	prepare_eval_state();
+	r_state->eval_policy();
+};
+
+void
+Resource::prepare_eval_state( void )
 {
 	// we may need to modify the load average in our internal
 	// policy classad if we're currently running a COD job or have
@@ -1305,9 +1330,123 @@ Resource::eval_state( void )
 	// before we evaluate our state, we should refresh cross-slot attrs
 	//PRAGMA_REMIND("tj: revisit this with SlotEval?")
 	resmgr->publishSlotAttrs( r_classad );
+}
 
+// called by ResMgr::eval_all after prepare_eval_state and prime_policy_cache
+// if some other slot changed state since we were primed, and that could have
+// changed our cross-slot attrs, the cache is stale and we start over.
+void
+Resource::eval_state_primed( void )
+{
+	if (r_policy_epoch != resmgr->policyEpoch()) {
+		clear_policy_cache();
+		eval_state();
+		return;
+	}
 	r_state->eval_policy();
-};
+	clear_policy_cache();
+}
+
+void
+Resource::prepare_policy_cache( void )
+{
+	if ( ! r_policy_match_ad) {
+		r_policy_match_ad.reset(new classad::MatchClassAd());
+	}
+}
+
+void
+Resource::prime_policy_cache( unsigned int epoch )
+{
+	r_policy_cache.clear();
+	r_policy_epoch = epoch;
+	if ( ! r_classad || ! r_policy_match_ad) {
+		return;
+	}
+
+	// prime only the expressions that ResState::eval_policy will look at
+	switch (state()) {
+	case claimed_state:
+		if (activity() == suspended_act && isSuspendedForCOD()) {
+			break;
+		}
+		prime_policy_expr("PREEMPT", true);
+		prime_policy_expr("SUSPEND", true);
+		prime_policy_expr("CONTINUE", true);
+		prime_policy_expr("START", false);
+		break;
+	case preempting_state:
+		prime_policy_expr("KILL", true);
+		break;
+	case unclaimed_state:
+	case owner_state:
+		prime_policy_expr(ATTR_IS_OWNER, false);
+#if HAVE_BACKFILL
+		prime_policy_expr("START_BACKFILL", false);
+#endif
+		break;
+#if HAVE_BACKFILL
+	case backfill_state:
+		prime_policy_expr("EVICT_BACKFILL", false);
+		break;
+#endif
+	default:
+		break;
+	}
+}
+
+// the worker thread equivalent of eval_expr, it uses the slot's private
+// MatchClassAd rather than the global one that EvalBool uses.
+void
+Resource::prime_policy_expr( const char* expr_name, bool check_vanilla )
+{
+	if (check_vanilla && r_cur) {
+		if (r_cur->universe() == CONDOR_UNIVERSE_VANILLA) {
+			std::string tmp_expr_name(expr_name); tmp_expr_name += "_VANILLA";
+			prime_policy_expr(tmp_expr_name.c_str(), false);
+		} else if (r_cur->universe() == CONDOR_UNIVERSE_VM) {
+			std::string tmp_expr_name(expr_name); tmp_expr_name += "_VM";
+			prime_policy_expr(tmp_expr_name.c_str(), false);
+		}
+	}
+
+	ClassAd * target = r_cur ? r_cur->ad() : nullptr;
+	bool value = false;
+	bool ok = false;
+	if ( ! target || target == r_classad) {
+		ok = r_classad->EvaluateAttrBoolEquiv(expr_name, value);
+	} else {
+		r_policy_match_ad->ReplaceLeftAd(r_classad);
+		r_policy_match_ad->ReplaceRightAd(target);
+		if (r_classad->Lookup(expr_name)) {
+			ok = r_classad->EvaluateAttrBoolEquiv(expr_name, value);
+		} else if (target->Lookup(expr_name)) {
+			ok = target->EvaluateAttrBoolEquiv(expr_name, value);
+		}
+		r_policy_match_ad->RemoveLeftAd();
+		r_policy_match_ad->RemoveRightAd();
+	}
+	// failures are not cached, so that eval_expr evaluates them again on the
+	// main thread and logs them as it always has
+	if (ok) {
+		r_policy_cache[expr_name] = value;
+	}
+}
+
+bool
+Resource::policy_cache_lookup( const char* expr_name, int & rc, bool & value )
+{
+	if (r_policy_cache.empty() || r_policy_epoch != resmgr->policyEpoch()) {
+		return false;
+	}
+	auto found = r_policy_cache.find(expr_name);
+	if (found == r_policy_cache.end()) {
+		return false;
+	}
+	rc = 1;
+	value = found->second;
+	return true;
+}
 
 
 void
@@ -1333,9 +1472,20 @@ Resource::update_needed( WhyFor /*why*/ )
 	//dprintf(D_ZKM, "Resource::update_needed(%d) %s\n",
 	//	why, update_tid < 0 ? "queuing timer" : "timer already queued");
 
+	// batched updates ignore UPDATE_SPREAD_TIME, the point is to send
+	// all of the slots that changed together
+	if (resmgr->batchingUpdates()) {
+		if ( ! r_update_queued && update_tid == -1) {
+			r_update_queued = true;
+			resmgr->queue_batched_update(this);
+		}
+		return;
+	}
+
 	// If we haven't already queued an update, queue one.
 	int delay = 0;
-	int updateSpreadTime = param_integer( "UPDATE_SPREAD_TIME", 0 );
+	static param_handle<int> update_spread_time("UPDATE_SPREAD_TIME", 0);
+	int updateSpreadTime = update_spread_time;
 	if( update_tid == -1 ) {
 		if( r_id > 0 && updateSpreadTime > 0 ) {
 			// If we were doing rate limiting, this would be integer
@@ -1445,7 +1595,8 @@ Resource::process_update_ad(ClassAd & public_ad, int snapshot) // change the upd
 			}
 			if(! StartdCronJobParams::attributeIsSumMetric( name ) ) { continue; }
 			if(! StartdCronJobParams::getResourceNameFromAttributeName( name, resourceName )) { continue; }
-			if(! param_boolean( "ADVERTISE_CMR_UPTIME_SECONDS", false )) {
+			static param_handle<bool> advertise_cmr_uptime("ADVERTISE_CMR_UPTIME_SECONDS", false);
+			if(! advertise_cmr_uptime) {
 				deleteList.push_back( name );
 			}
 
@@ -1533,12 +1684,8 @@ Resource::process_update_ad(ClassAd & public_ad, int snapshot) // change the upd
 }
 
 void
-Resource::do_update( void )
+Resource::publish_update_ads( ClassAd & public_ad, ClassAd & private_ad )
 {
-	int rval;
-	ClassAd private_ad;
-	ClassAd public_ad;
-
 	// Get the public and private ads
 	publish_single_slot_ad(public_ad, 0, Resource::Purpose::for_update);
 
@@ -1550,6 +1697,16 @@ Resource::do_update( void )
 #if defined(WANT_CONTRIB) && defined(WITH_MANAGEMENT)
 	StartdPluginManager::Update(&public_ad, &private_ad);
 #endif
+}
+
+void
+Resource::do_update( void )
+{
+	int rval;
+	ClassAd private_ad;
+	ClassAd public_ad;
+
+	publish_update_ads(public_ad, private_ad);
 
 	std::string priorState;
 
@@ -2212,8 +2369,12 @@ Resource::eval_expr( const char* expr_name, bool fatal, bool check_vanilla )
 		}
 			// otherwise, fall through and try the non-vm version
 	}
-	bool btmp;
-	if( (EvalBool(expr_name, r_classad, r_cur ? r_cur->ad() : NULL , btmp) ) == 0 ) {
+	bool btmp = false;
+	int rc = 0;
+	if ( ! policy_cache_lookup(expr_name, rc, btmp)) {
+		rc = EvalBool(expr_name, r_classad, r_cur ? r_cur->ad() : NULL , btmp);
+	}
+	if( rc == 0 ) {
 		
 		char *p = param(expr_name);
 
@@ -2424,7 +2585,8 @@ void Resource::publish_static(ClassAd* cap)
 	cap->Assign(ATTR_STARTD_IP_ADDR, daemonCore->InfoCommandSinfulString());
 	cap->Assign(ATTR_NAME, r_name);
 
-	cap->Assign(ATTR_IS_LOCAL_STARTD, param_boolean("IS_LOCAL_STARTD", false));
+	static param_handle<bool> is_local_startd("IS_LOCAL_STARTD", false);
+	cap->Assign(ATTR_IS_LOCAL_STARTD, is_local_startd.get());
 
 	{
 		// Since the Rank expression itself only lives in the
@@ -2565,7 +2727,7 @@ void Resource::publish_static(ClassAd* cap)
 			cap->Assign(ATTR_SLOT_TYPE, "Dynamic");
 			cap->Assign(ATTR_PARENT_SLOT_ID, r_id);
 			cap->Assign(ATTR_DSLOT_ID, r_sub_id);
-			if ( param_boolean("ADVERTISE_PSLOT_ROLLUP_INFORMATION", true) ) {
+			if ( AdvertisePslotRollup ) {
 				// the Negotiator uses this to determine if the p-slot will have rollup from the d-slot
 				cap->Assign(ATTR_PSLOT_ROLLUP_INFORMATION, true);
 			}
@@ -3861,7 +4023,8 @@ Resource * create_dslot(Resource * rip, ClassAd * req_classad, Claim* &leftover_
             if( !EvalInteger( schedd_requested_attr.c_str(), req_classad, mach_classad, swap ) ) {
                 if( !EvalInteger( ATTR_REQUEST_VIRTUAL_MEMORY, req_classad, mach_classad, swap ) ) {
 						// Schedd didn't set it, user didn't request it
-					if (param_boolean("PROPORTIONAL_SWAP_ASSIGNMENT", false)) {
+					static param_handle<bool> proportional_swap("PROPORTIONAL_SWAP_ASSIGNMENT", false);
+					if (proportional_swap) {
 						// set swap to same percentage of swap as we have of physical memory
 						double mpcent = 100.0 * double(memory) / double(rip->r_attr->get_mach_attr()->phys_mem());
 						formatstr_cat(restmp, "swap=%d%%", int(mpcent));
@@ -3966,7 +4129,7 @@ Resource * create_dslot(Resource * rip, ClassAd * req_classad, Claim* &leftover_
 			// the claim protocol enhancement to accept leftovers
 		req_classad->LookupBool("_condor_SEND_LEFTOVERS",scheddWantsLeftovers);
 		if ( scheddWantsLeftovers && 
-			 param_boolean("CLAIM_PARTITIONABLE_LEFTOVERS",true) &&
+			 ClaimPartitionableLeftovers &&
 			 rip->r_has_cp == false )
 		{
 			leftover_claim = rip->r_cur;
@@ -3989,7 +4152,7 @@ Resource::publishDynamicChildSummaries(ClassAd *cap)
 	cap->Assign(ATTR_NUM_DYNAMIC_SLOTS, (long long)m_children.size());
 
 		// If not set, turn off the whole thing
-	if (param_boolean("ADVERTISE_PSLOT_ROLLUP_INFORMATION", true) == false) {
+	if (AdvertisePslotRollup.get() == false) {
 		return;
 	}
 
@@ -167,6 +167,18 @@ public:
 
 	// refresh ad and evaluate state change policy
 	void	eval_state(void);
+	// the two halves of eval_state, used by ResMgr::eval_all when policy
+	// expressions are evaluated in parallel by STARTD_POLICY_EVAL_THREADS.
+	void	prepare_eval_state(void);
+	void	eval_state_primed(void);
+	// evaluate the policy expressions that eval_policy will need in the current state
+	// and cache the results.  This is called on a worker thread, so it must touch only
+	// this slot's ads and must not dprintf, param or EXCEPT.  Expressions that do not
+	// evaluate cleanly are not cached and will be evaluated again on the main thread.
+	void	prime_policy_cache(unsigned int epoch);
+	// create the private MatchClassAd used by prime_policy_cache (main thread only)
+	void	prepare_policy_cache();
+	void	clear_policy_cache() { r_policy_cache.clear(); }
 
 		// does this resource need polling frequency for compute/eval?
 	bool	needsPolling( void );
@@ -334,6 +346,9 @@ public:
 	void	update_walk_for_timer() { update_needed(wf_timer); } // for use with Walk where arguments are not permitted
 	void	update_walk_for_vm_change() { update_needed(wf_vmChange); } // for use with Walk where arguments are not permitted
 	void	do_update( void );			// Actually update the CM
+	void	publish_update_ads( ClassAd & public_ad, ClassAd & private_ad ); // build the ads do_update sends
+	bool	can_batch_update( void ) const { return workingCM.empty(); }
+	void	batched_update_sent( void ) { r_update_queued = false; }
 	void    process_update_ad(ClassAd & ad, int snapshot=0); // change the update ad before we send it 
     int     update_with_ack( void );    // Actually update the CM and wait for an ACK, used when hibernating.
 	void	final_update( void );		// Send a final update to the CM
@@ -401,6 +416,7 @@ public:
 		// Data members
 	ResState*		r_state;	// Startd state object, contains state and activity
 	ClassAd*		r_config_classad; // Static/Base Resource classad (contains everything in config file)
+	std::shared_ptr<ClassAd> r_config_base; // chained parent of r_config_classad, shared by all slots
 	ClassAd*		r_classad;  // Chained child of r_config_classad, cleaned out and rebuild frequently, publish writes into this one
 	Claim*			r_cur;		// Info about the current claim
 	Claim*			r_pre;		// Info about the possibly preempting claim
@@ -488,6 +504,7 @@ private:
 	IdDispenser* m_id_dispenser;
 
 	int			update_tid;	// DaemonCore timer id for update delay
+	bool		r_update_queued{false};	// waiting in the ResMgr batched update queue
 
 #ifdef USE_STARTD_LATCHES  // more generic mechanism for CpuBusy
 #else
@@ -505,6 +522,15 @@ private:
 	void	endCODLoadHack( void );
 	int		eval_expr( const char* expr_name, bool fatal, bool check_vanilla );
 
+	// results of policy expressions evaluated by prime_policy_cache, only valid
+	// while r_policy_epoch matches the ResMgr policy epoch. Only expressions that
+	// evaluated cleanly are here.
+	std::map<std::string, bool, classad::CaseIgnLTStr> r_policy_cache;
+	unsigned int r_policy_epoch{0};
+	std::unique_ptr<classad::MatchClassAd> r_policy_match_ad;
+	bool	policy_cache_lookup( const char* expr_name, int & rc, bool & value );
+	void	prime_policy_expr( const char* expr_name, bool check_vanilla );
+
 	std::string m_execute_dir;
 	std::string m_execute_partition_id;
 
@@ -0,0 +1,102 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2023, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ * 
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+
+#include "condor_common.h"
+#include "condor_classad.h"
+#include "classad_batch.h"
+
+int PackClassAdBatch(ClassAd & batch, const std::vector<ClassAd*> & ads,
+					 const AttrNameSet * keep_in_each, bool strip_private)
+{
+	AttrNameSet shared;
+
+	// an attribute is shared when every ad has an identical expression for it,
+	// so it is enough to check the attributes of the first ad.
+	if ( ! ads.empty()) {
+		for (auto & [name, expr] : *ads[0]) {
+			if (strip_private && ClassAdAttributeIsPrivateAny(name)) continue;
+			if (keep_in_each && keep_in_each->count(name)) continue;
+			if (strcasecmp(name.c_str(), ATTR_BATCHED_ADS) == 0) continue;
+			bool same = true;
+			for (size_t ix = 1; ix < ads.size(); ++ix) {
+				ExprTree * other = ads[ix]->Lookup(name);
+				if ( ! other || ! other->SameAs(expr)) {
+					same = false;
+					break;
+				}
+			}
+			if (same) {
+				shared.insert(name);
+				batch.Insert(name, expr->Copy());
+			}
+		}
+	}
+
+	std::vector<ExprTree*> items;
+	items.reserve(ads.size());
+	for (auto * ad : ads) {
+		ClassAd * item = new ClassAd();
+		for (auto & [name, expr] : *ad) {
+			if (shared.count(name)) continue;
+			if (strip_private && ClassAdAttributeIsPrivateAny(name)) continue;
+			item->Insert(name, expr->Copy());
+		}
+		items.push_back(item);
+	}
+	batch.Insert(ATTR_BATCHED_ADS, classad::ExprList::MakeExprList(items));
+
+	return (int)shared.size();
+}
+
+bool GetClassAdBatchItems(ClassAd & batch, std::vector<ClassAd*> & items)
+{
+	items.clear();
+	ExprTree * tree = batch.Lookup(ATTR_BATCHED_ADS);
+	if ( ! tree) {
+		return false;
+	}
+	tree = const_cast<ExprTree*>(tree->self());
+	if (tree->GetKind() != ExprTree::EXPR_LIST_NODE) {
+		return false;
+	}
+	std::vector<ExprTree*> list;
+	static_cast<classad::ExprList*>(tree)->GetComponents(list);
+	for (auto * elem : list) {
+		elem = const_cast<ExprTree*>(elem->self());
+		if (elem->GetKind() != ExprTree::CLASSAD_NODE) {
+			items.clear();
+			return false;
+		}
+		items.push_back(static_cast<ClassAd*>(elem));
+	}
+	return true;
+}
+
+void UnpackClassAdBatchItem(const ClassAd & batch, const ClassAd & item, ClassAd & ad)
+{
+	for (auto & [name, expr] : batch) {
+		if (strcasecmp(name.c_str(), ATTR_BATCHED_ADS) == 0) continue;
+		ad.Insert(name, expr->Copy());
+	}
+	// item attributes win over the shared ones
+	for (auto & [name, expr] : item) {
+		ad.Insert(name, expr->Copy());
+	}
+}
@@ -0,0 +1,64 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2023, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ * 
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+
+#ifndef CLASSAD_BATCH_H
+#define CLASSAD_BATCH_H
+
+#include "condor_common.h"
+#include "condor_classad.h"
+
+// A batch ad carries several ads of the same kind in a single message.
+// Attributes that have the same expression in every ad of the batch are
+// stored once at the top level of the batch ad, the attributes that differ
+// are stored in a nested ad per item in the list attribute BatchedAds.
+//
+//   [ Arch="X86_64"; ...shared...; BatchedAds = { [ Name="slot1@host"; ...], [ Name="slot2@host"; ...] } ]
+//
+// The items of the public and private batch are parallel, item N of the
+// private batch belongs to item N of the public batch.
+#define ATTR_BATCHED_ADS "BatchedAds"
+
+/** Pack ads into a batch ad.
+ *  @param batch The batch ad, it should be empty on entry
+ *  @param ads The ads to pack, they are not modified
+ *  @param keep_in_each Attributes that are always stored in each item
+ *         even when they have the same value in all of the ads
+ *  @param strip_private true to leave out private attributes. putClassAd does
+ *         not look inside of nested ads, so this must be done when packing.
+ *         A batch that keeps them must be sent with ATTR_BATCHED_ADS in the
+ *         encrypted attributes, as DCCollector does for the private ad
+ *  @return the number of attributes that were factored out into the top level
+ */
+int PackClassAdBatch(ClassAd & batch, const std::vector<ClassAd*> & ads,
+					 const AttrNameSet * keep_in_each, bool strip_private);
+
+/** Get pointers to the nested item ads of a batch ad. the pointers are owned
+ *  by the batch ad. Returns false if the ad is not a well formed batch ad.
+ */
+bool GetClassAdBatchItems(ClassAd & batch, std::vector<ClassAd*> & items);
+
+/** Rebuild a flat ad from the shared attributes of batch and a single item
+ *  @param batch The batch ad
+ *  @param item One of the items returned by GetClassAdBatchItems
+ *  @param ad The ad to populate, it should be empty on entry
+ */
+void UnpackClassAdBatchItem(const ClassAd & batch, const ClassAd & item, ClassAd & ad);
+
+#endif
@@ -181,6 +181,20 @@ public:
 
   time_t GetOrigLogBirthdate() { return ClassAdLog<K,AD>::GetOrigLogBirthdate(); }
 
+  /** Set the file used to checkpoint the repository. Set it before InitLogFile
+      to load from the checkpoint and replay only the log written after it.
+  */
+  void SetCheckpointFilename(const char * filename) { ClassAdLog<K,AD>::SetCheckpointFilename(filename); }
+
+  /** Write a binary checkpoint of the repository, fails if a transaction is active.
+    @return true on success
+  */
+  bool WriteCheckpoint() { return ClassAdLog<K,AD>::WriteCheckpoint(); }
+
+  /** Set the number of worker threads used to parse the log in InitLogFile, 0 to parse serially.
+  */
+  void SetReplayThreads(int num_threads) { ClassAdLog<K,AD>::SetReplayThreads(num_threads); }
+
   //@}
   //------------------------------------------------------------------------
   /**@name Method to control the class-ads in the repository
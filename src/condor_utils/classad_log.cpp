@@ -30,9 +30,13 @@
 #include "classad_merge.h"
 #include "condor_fsync.h"
 #include "condor_attributes.h"
+#include "condor_blkng_full_disk_io.h"
+#include "worker_pool.h"
+#include "classad/classadCache.h"
 
 #if defined(UNIX)
 #include "ClassAdLogPlugin.h"
+#include <sys/mman.h>
 #endif
 
 /***** Prevent calling free multiple times in this code *****/
@@ -64,6 +68,198 @@ const ConstructClassAdLogTableEntry<ClassAd*> DefaultMakeClassAdLogTableEntry;
 #endif
 
 
+// A block of whole log records that is read and parsed by a worker thread
+// during a parallel replay.
+struct ClassAdLogReplayChunk {
+	std::string text;        // the records, always ends with a newline
+	long long offset{0};     // offset of the start of text in the log
+	std::vector<LogRecord*> recs;
+	bool ok{false};
+	bool done{false};
+	~ClassAdLogReplayChunk() { for (auto * rec : recs) { delete rec; } }
+};
+
+// creates an empty log record of the given type, or NULL if the type is not valid
+static LogRecord *
+NewLogEntry(int type, const ConstructLogEntry & ctor)
+{
+	switch(type) {
+		case CondorLogOp_Error: return new LogRecordError();
+		case CondorLogOp_NewClassAd: return new LogNewClassAd("", "", "", ctor);
+		case CondorLogOp_DestroyClassAd: return new LogDestroyClassAd("", ctor);
+		case CondorLogOp_SetAttribute: return new LogSetAttribute("", "", "");
+		case CondorLogOp_DeleteAttribute: return new LogDeleteAttribute("", "");
+		case CondorLogOp_BeginTransaction: return new LogBeginTransaction();
+		case CondorLogOp_EndTransaction: return new LogEndTransaction();
+		case CondorLogOp_LogHistoricalSequenceNumber: return new LogHistoricalSequenceNumber(0,0);
+	}
+	return NULL;
+}
+
+// The worker thread version of InstantiateLogEntry. It parses SetAttribute values
+// and keeps the result for Play, and rather than trying to recover from a bad record
+// it returns a LogRecordError so that the caller can fall back to a serial replay.
+static LogRecord *
+InstantiateLogEntryForReplay(FILE *fp, unsigned long /*recnum*/, int type, const ConstructLogEntry & ctor)
+{
+	LogRecord * log_rec = NewLogEntry(type, ctor);
+	if ( ! log_rec) {
+		return NULL;
+	}
+	int rval;
+	if (type == CondorLogOp_SetAttribute) {
+		rval = ((LogSetAttribute*)log_rec)->ReadBodyAndParse(fp);
+	} else {
+		rval = log_rec->ReadBody(fp);
+	}
+	if (rval < 0 || log_rec->get_op_type() == CondorLogOp_Error) {
+		delete log_rec;
+		return new LogRecordError();
+	}
+	return log_rec;
+}
+
+// runs on a worker thread.
+static bool
+ParseClassAdLogChunk(ClassAdLogReplayChunk & chunk, const ConstructLogEntry & maker)
+{
+	FILE * fp = fmemopen(&chunk.text[0], chunk.text.size(), "r");
+	if ( ! fp) {
+		return false;
+	}
+	bool ok = true;
+	LogRecord * rec;
+	while ((rec = ReadLogEntry(fp, 0, InstantiateLogEntryForReplay, maker)) != NULL) {
+		chunk.recs.push_back(rec);
+		if (rec->get_op_type() == CondorLogOp_Error) {
+			ok = false;
+			break;
+		}
+	}
+	// every byte of the chunk must belong to a good record
+	ok = ok && ftell(fp) == (long)chunk.text.size();
+	fclose(fp);
+	return ok;
+}
+
+// Replay the log from the current position of log_fp using worker threads to read and
+// parse the records.  The log is split into blocks of whole records; the blocks are parsed
+// in parallel and the records applied by calling replay_record for each one in log order
+// on this thread. Since records are applied here, in order, transactions may span blocks.
+// When this returns log_fp is positioned after the last record that was applied, which
+// is either the end of the log, an incomplete last line, or the start of a block that
+// did not parse. count and next_log_entry_pos are updated for the applied records.
+static void
+ParallelReplayClassAdLog(
+	FILE * log_fp,
+	int num_threads,
+	const ConstructLogEntry & maker,
+	unsigned long & count,
+	long long & next_log_entry_pos,
+	const std::function<bool(LogRecord*)> & replay_record)
+{
+#if defined(WIN32)
+	// no fmemopen, so always replay serially
+	(void)log_fp; (void)num_threads; (void)maker; (void)count; (void)next_log_entry_pos; (void)replay_record;
+#else
+	const size_t block_size = 1024*1024;
+
+	// the classad function table is initialized on first use, make sure that
+	// happens here rather than on a worker thread.
+	classad::ExprTree * warm = NULL;
+	if (ParseClassAdRvalExpr("isUndefined(x)", warm) == 0) { delete warm; }
+
+	WorkerPool pool;
+	pool.start(num_threads);
+
+	std::mutex mtx;
+	std::condition_variable cv;
+	std::deque<std::shared_ptr<ClassAdLogReplayChunk>> inflight;
+	const size_t max_inflight = 2 * (size_t)num_threads + 1;
+
+	long long read_offset = ftell(log_fp);
+	long long applied_offset = read_offset;
+	std::string carry; // the start of a record that did not fit in the last block
+	bool eof = false;
+	bool failed = false;
+	unsigned long num_records = 0;
+	double begin = _condor_debug_get_time_double();
+
+	while ( ! failed) {
+		// keep the workers busy
+		while ( ! eof && inflight.size() < max_inflight) {
+			auto chunk = std::make_shared<ClassAdLogReplayChunk>();
+			chunk->text.swap(carry);
+			size_t cb = chunk->text.size();
+			chunk->text.resize(cb + block_size);
+			size_t got = fread(&chunk->text[cb], 1, block_size, log_fp);
+			chunk->text.resize(cb + got);
+			if ( ! got) {
+				eof = true;
+				carry.swap(chunk->text);
+				break;
+			}
+			size_t end = chunk->text.rfind('\n');
+			if (end == std::string::npos) {
+				// a single record longer than a block, keep reading
+				carry.swap(chunk->text);
+				continue;
+			}
+			carry.assign(chunk->text, end+1, std::string::npos);
+			chunk->text.resize(end+1);
+			chunk->offset = read_offset;
+			read_offset += chunk->text.size();
+
+			inflight.push_back(chunk);
+			pool.submit([chunk, &maker, &mtx, &cv]() {
+				bool ok = ParseClassAdLogChunk(*chunk, maker);
+				std::unique_lock<std::mutex> guard(mtx);
+				chunk->ok = ok;
+				chunk->done = true;
+				cv.notify_all();
+			});
+		}
+		if (inflight.empty()) {
+			break;
+		}
+
+		auto chunk = inflight.front();
+		{
+			std::unique_lock<std::mutex> guard(mtx);
+			cv.wait(guard, [&chunk]{ return chunk->done; });
+		}
+		inflight.pop_front();
+		if ( ! chunk->ok) {
+			failed = true;
+			break;
+		}
+		for (auto * rec : chunk->recs) {
+			++count;
+			// the records are all good, so this does not fail
+			replay_record(rec);
+		}
+		num_records += chunk->recs.size();
+		chunk->recs.clear(); // replay_record took ownership of the records
+		applied_offset = chunk->offset + chunk->text.size();
+		next_log_entry_pos = applied_offset;
+	}
+
+	// wait for any work still in progress before the pool and the chunks go away
+	pool.stop();
+	inflight.clear();
+
+	if (failed) {
+		dprintf(D_ALWAYS, "Could not parse log at offset %lld on a worker thread, continuing serially\n", applied_offset);
+	}
+	dprintf(D_FULLDEBUG, "Replayed %lu log records using %d threads in %.3f seconds\n",
+		num_records, num_threads, _condor_debug_get_time_double() - begin);
+
+	clearerr(log_fp);
+	fseek(log_fp, applied_offset, SEEK_SET);
+#endif
+}
+
+
 // non-templatized worker function that implements the log loading functionality of ClassAdLog
 //
 FILE* LoadClassAdLog(
@@ -74,7 +270,9 @@ FILE* LoadClassAdLog(
 	time_t & m_original_log_birthdate,
 	bool & is_clean,
 	bool & requires_successful_cleaning,
-	MyString & errmsg)
+	MyString & errmsg,
+	const char * checkpoint_filename,
+	int replay_threads)
 {
 	FILE* log_fp = NULL;
 	Transaction * active_transaction = NULL;
@@ -103,23 +301,30 @@ FILE* LoadClassAdLog(
 	unsigned long count = 0;
 	long long next_log_entry_pos = 0;
     long long curr_log_entry_pos = 0;
-	while ((log_rec = ReadLogEntry(log_fp, 1+count, InstantiateLogEntry, maker)) != 0) {
-        curr_log_entry_pos = next_log_entry_pos;
-		next_log_entry_pos = ftell(log_fp);
-		count++;
+
+	// if there is a checkpoint that matches this log, load it and then
+	// replay only the records that were written after it.
+	bool from_checkpoint = false;
+	if (checkpoint_filename) {
+		long long ckpt_offset = LoadClassAdLogCheckpoint(checkpoint_filename, log_fp, la, maker,
+			historical_sequence_number, m_original_log_birthdate, errmsg);
+		if (ckpt_offset > 0) {
+			count = 1; // the sequence number record was checked by the checkpoint loader
+			next_log_entry_pos = ckpt_offset;
+			from_checkpoint = true;
+		}
+	}
+	// apply a record that has been read from the log, returns false if the record is bad
+	auto replay_record = [&](LogRecord * log_rec) -> bool {
 		switch (log_rec->get_op_type()) {
 		case CondorLogOp_Error:
 			// this is defensive, ought to be caught in InstantiateLogEntry()
-			errmsg.formatstr("ERROR: in log %s transaction record %lu was bad (byte offset %lld)\n", filename, count, curr_log_entry_pos);
-			fclose(log_fp); log_fp = NULL;
-
-			delete active_transaction;
-			return NULL;
-			break;
+			return false;
 		case CondorLogOp_BeginTransaction:
 			// this file contains transactions, so it must not
-			// have been cleanly shut down
-			is_clean = false;
+			// have been cleanly shut down. when we started from a checkpoint
+			// transactions in the tail are expected, and are no reason to rotate.
+			if ( ! from_checkpoint) { is_clean = false; }
 			if (active_transaction) {
 				errmsg.formatstr_cat("Warning: Encountered nested transactions, log may be bogus...\n");
 			} else {
@@ -153,6 +358,29 @@ FILE* LoadClassAdLog(
 				delete log_rec;
 			}
 		}
+		return true;
+	};
+
+	// Read and parse the log on worker threads, applying the records here in order.
+	// This stops short of any part of the log that it can't parse, which is then
+	// read by the loop below so that bad records are handled as they always have been.
+	if (replay_threads > 0) {
+		ParallelReplayClassAdLog(log_fp, replay_threads, maker, count, next_log_entry_pos, replay_record);
+		curr_log_entry_pos = next_log_entry_pos;
+	}
+
+	while ((log_rec = ReadLogEntry(log_fp, 1+count, InstantiateLogEntry, maker)) != 0) {
+        curr_log_entry_pos = next_log_entry_pos;
+		next_log_entry_pos = ftell(log_fp);
+		count++;
+		if ( ! replay_record(log_rec)) {
+			errmsg.formatstr("ERROR: in log %s transaction record %lu was bad (byte offset %lld)\n", filename, count, curr_log_entry_pos);
+			fclose(log_fp); log_fp = NULL;
+
+			delete log_rec;
+			delete active_transaction;
+			return NULL;
+		}
 	}
 	long long final_log_entry_pos = ftell(log_fp);
 	if( next_log_entry_pos != final_log_entry_pos ) {
@@ -600,6 +828,295 @@ bool WriteClassAdLogState(
 	return true;
 }
 
+// The checkpoint file is a header, followed by each ad, followed by an end marker.
+// All integers are written in host byte order, and strings are a 32 bit length followed
+// by the bytes of the string.  Attribute values are stored unparsed so that loading
+// can use the lazy parse of the classad cache.
+//
+//   header:  magic, byte order mark, sequence number, birthdate, log offset, number of ads
+//   each ad: key, mytype, targettype, number of attributes, then name,value for each attribute
+//   trailer: end magic
+//
+static const char CLASSAD_LOG_CKPT_MAGIC[8] = { 'C','A','L','C','K','P','T','1' };
+static const char CLASSAD_LOG_CKPT_END[8] = { 'C','A','L','C','K','E','N','D' };
+static const uint32_t CLASSAD_LOG_CKPT_BOM = 0x01020304;
+
+static bool ckpt_put(FILE* fp, const void * data, size_t cb)
+{
+	return fwrite(data, 1, cb, fp) == cb;
+}
+
+static bool ckpt_put_str(FILE* fp, const char * str, size_t cb)
+{
+	uint32_t len = (uint32_t)cb;
+	return ckpt_put(fp, &len, sizeof(len)) && ( ! len || ckpt_put(fp, str, len));
+}
+
+// reads the fields of a checkpoint from a buffer, any read past the end of the buffer fails
+class CheckpointReader {
+public:
+	CheckpointReader(const char * data, size_t cb) : ptr(data), end(data + cb) {}
+	template <typename T> bool get(T & val) {
+		if ((size_t)(end - ptr) < sizeof(T)) return false;
+		memcpy(&val, ptr, sizeof(T));
+		ptr += sizeof(T);
+		return true;
+	}
+	bool get_str(std::string & str) {
+		uint32_t len;
+		if ( ! get(len) || (size_t)(end - ptr) < len) return false;
+		str.assign(ptr, len);
+		ptr += len;
+		return true;
+	}
+	bool get_magic(const char (&magic)[8]) {
+		if ((size_t)(end - ptr) < sizeof(magic) || memcmp(ptr, magic, sizeof(magic)) != 0) return false;
+		ptr += sizeof(magic);
+		return true;
+	}
+	bool at_end() const { return ptr == end; }
+private:
+	const char * ptr;
+	const char * end;
+};
+
+bool WriteClassAdLogCheckpoint(
+	const char * checkpoint_filename,
+	FILE * log_fp,
+	unsigned long historical_sequence_number,
+	time_t original_log_birthdate,
+	LoggableClassAdTable & la,
+	MyString & errmsg)
+{
+	// the log must already be flushed so that the offset covers every committed record
+	int64_t log_offset = ftell(log_fp);
+	if (log_offset <= 0) {
+		errmsg.formatstr("could not determine offset of log, errno = %d", errno);
+		return false;
+	}
+
+	MyString tmp_filename;
+	tmp_filename.formatstr("%s.tmp", checkpoint_filename);
+	int fd = safe_create_replace_if_exists(tmp_filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_LARGEFILE | _O_NOINHERIT | _O_BINARY, 0600);
+	if (fd < 0) {
+		errmsg.formatstr("failed to create %s, errno = %d (%s)", tmp_filename.c_str(), errno, strerror(errno));
+		return false;
+	}
+	FILE * fp = fdopen(fd, "wb");
+	if ( ! fp) {
+		errmsg.formatstr("failed to fdopen %s, errno = %d", tmp_filename.c_str(), errno);
+		close(fd);
+		unlink(tmp_filename.c_str());
+		return false;
+	}
+
+	// the count of ads goes into the header, so count them first.
+	uint64_t num_ads = 0;
+	const char * key;
+	ClassAd * ad;
+	la.startIterations();
+	while (la.nextIteration(key, ad)) { ++num_ads; }
+
+	uint64_t seq = historical_sequence_number;
+	int64_t birthdate = original_log_birthdate;
+	bool ok = ckpt_put(fp, CLASSAD_LOG_CKPT_MAGIC, sizeof(CLASSAD_LOG_CKPT_MAGIC)) &&
+		ckpt_put(fp, &CLASSAD_LOG_CKPT_BOM, sizeof(CLASSAD_LOG_CKPT_BOM)) &&
+		ckpt_put(fp, &seq, sizeof(seq)) &&
+		ckpt_put(fp, &birthdate, sizeof(birthdate)) &&
+		ckpt_put(fp, &log_offset, sizeof(log_offset)) &&
+		ckpt_put(fp, &num_ads, sizeof(num_ads));
+
+	std::string value;
+	la.startIterations();
+	while (ok && la.nextIteration(key, ad)) {
+		const char * mytype = GetMyTypeName(*ad);
+		const char * targettype = GetTargetTypeName(*ad);
+		ok = ckpt_put_str(fp, key, strlen(key)) &&
+			ckpt_put_str(fp, mytype, strlen(mytype)) &&
+			ckpt_put_str(fp, targettype, strlen(targettype));
+
+			// Unchain the ad, as WriteClassAdLogState does, so that only the attributes
+			// of this ad are written.  The chain is re-established by the owner of the
+			// table after loading, just as it is after replaying the log.
+		classad::ClassAd *chain = ad->GetChainedParentAd();
+		ad->Unchain();
+		uint32_t num_attrs = 0;
+		for (auto itr = ad->begin(); itr != ad->end(); itr++) { if (itr->second) ++num_attrs; }
+		ok = ok && ckpt_put(fp, &num_attrs, sizeof(num_attrs));
+		for (auto itr = ad->begin(); ok && itr != ad->end(); itr++) {
+			if ( ! itr->second) continue;
+			value.clear();
+			ExprTreeToString(itr->second, value);
+			ok = ckpt_put_str(fp, itr->first.c_str(), itr->first.size()) &&
+				ckpt_put_str(fp, value.c_str(), value.size());
+		}
+		ad->ChainToAd(chain);
+	}
+	ok = ok && ckpt_put(fp, CLASSAD_LOG_CKPT_END, sizeof(CLASSAD_LOG_CKPT_END));
+
+	if ( ! ok || fflush(fp) != 0 || condor_fdatasync(fileno(fp)) < 0) {
+		errmsg.formatstr("write to %s failed, errno = %d", tmp_filename.c_str(), errno);
+		fclose(fp);
+		unlink(tmp_filename.c_str());
+		return false;
+	}
+	fclose(fp);
+
+	if (rotate_file(tmp_filename.c_str(), checkpoint_filename) < 0) {
+		errmsg.formatstr("failed to rotate %s to %s", tmp_filename.c_str(), checkpoint_filename);
+		unlink(tmp_filename.c_str());
+		return false;
+	}
+
+	dprintf(D_FULLDEBUG, "Wrote checkpoint %s of %llu ads at log offset %lld\n",
+		checkpoint_filename, (unsigned long long)num_ads, (long long)log_offset);
+	return true;
+}
+
+long long LoadClassAdLogCheckpoint(
+	const char * checkpoint_filename,
+	FILE * log_fp,
+	LoggableClassAdTable & la,
+	const ConstructLogEntry& maker,
+	unsigned long & historical_sequence_number,
+	time_t & m_original_log_birthdate,
+	MyString & errmsg)
+{
+	int fd = safe_open_wrapper_follow(checkpoint_filename, O_RDONLY | O_LARGEFILE | _O_NOINHERIT | _O_BINARY);
+	if (fd < 0) {
+		if (errno != ENOENT) {
+			errmsg.formatstr_cat("Warning: could not open checkpoint %s, errno = %d, replaying the whole log\n", checkpoint_filename, errno);
+		}
+		return 0;
+	}
+
+	// The checkpoint is only valid for the log that it was written against, which we know
+	// by the sequence number record at the start of the log. Since the log is only ever
+	// appended to until it is rotated, and rotation increases the sequence number, a log
+	// that starts with the same record and is at least as long as the checkpoint offset
+	// contains the checkpointed state followed by any records written since.
+	unsigned long log_seq = 0;
+	time_t log_birthdate = 0;
+	long long log_size = 0;
+	LogRecord * log_rec = ReadLogEntry(log_fp, 1, InstantiateLogEntry, maker);
+	if (log_rec && log_rec->get_op_type() == CondorLogOp_LogHistoricalSequenceNumber) {
+		log_seq = ((LogHistoricalSequenceNumber *)log_rec)->get_historical_sequence_number();
+		log_birthdate = ((LogHistoricalSequenceNumber *)log_rec)->get_timestamp();
+	}
+	delete log_rec;
+	if (fseek(log_fp, 0, SEEK_END) == 0) { log_size = ftell(log_fp); }
+	fseek(log_fp, 0, SEEK_SET);
+
+	struct stat si;
+	if (fstat(fd, &si) < 0 || si.st_size <= 0) {
+		close(fd);
+		return 0;
+	}
+	size_t cb = (size_t)si.st_size;
+
+#if defined(UNIX)
+	// map the whole checkpoint rather than reading it
+	void * map = mmap(NULL, cb, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED) {
+		errmsg.formatstr_cat("Warning: could not map checkpoint %s, errno = %d, replaying the whole log\n", checkpoint_filename, errno);
+		return 0;
+	}
+	madvise(map, cb, MADV_SEQUENTIAL);
+	const char * data = (const char *)map;
+#else
+	std::string buf(cb, '\0');
+	bool read_ok = full_read(fd, &buf[0], cb) == (ssize_t)cb;
+	close(fd);
+	if ( ! read_ok) {
+		errmsg.formatstr_cat("Warning: could not read checkpoint %s, replaying the whole log\n", checkpoint_filename);
+		return 0;
+	}
+	const char * data = buf.data();
+#endif
+
+	CheckpointReader rdr(data, cb);
+	uint32_t bom = 0;
+	uint64_t seq = 0, num_ads = 0;
+	int64_t birthdate = 0, log_offset = 0;
+	bool ok = rdr.get_magic(CLASSAD_LOG_CKPT_MAGIC) &&
+		rdr.get(bom) && bom == CLASSAD_LOG_CKPT_BOM &&
+		rdr.get(seq) && rdr.get(birthdate) && rdr.get(log_offset) && rdr.get(num_ads) &&
+		cb >= sizeof(CLASSAD_LOG_CKPT_END) &&
+		memcmp(data + cb - sizeof(CLASSAD_LOG_CKPT_END), CLASSAD_LOG_CKPT_END, sizeof(CLASSAD_LOG_CKPT_END)) == 0;
+
+	long long result = 0;
+	if ( ! ok) {
+		errmsg.formatstr_cat("Warning: checkpoint %s is not valid, replaying the whole log\n", checkpoint_filename);
+	} else if (seq != log_seq || (time_t)birthdate != log_birthdate || log_offset <= 0 || log_offset > log_size) {
+		dprintf(D_ALWAYS, "Checkpoint %s does not match the log, replaying the whole log\n", checkpoint_filename);
+	} else {
+		std::vector<std::string> loaded;
+		loaded.reserve(num_ads);
+		std::string key, mytype, targettype, name, value;
+		for (uint64_t ix = 0; ok && ix < num_ads; ++ix) {
+			uint32_t num_attrs = 0;
+			ok = rdr.get_str(key) && rdr.get_str(mytype) && rdr.get_str(targettype) && rdr.get(num_attrs);
+			if ( ! ok) break;
+
+			ClassAd *ad = maker.New(key.c_str(), mytype.c_str());
+			SetMyTypeName(*ad, mytype.c_str());
+			SetTargetTypeName(*ad, targettype.c_str());
+			ad->EnableDirtyTracking();
+			for (uint32_t jx = 0; ok && jx < num_attrs; ++jx) {
+				ok = rdr.get_str(name) && rdr.get_str(value) && ad->InsertViaCache(name, value, true);
+			}
+			if ( ! ok || ! la.insert(key.c_str(), ad)) {
+				maker.Delete(ad);
+				ok = false;
+				break;
+			}
+			ad->ClearAllDirtyFlags();
+			loaded.push_back(key);
+		}
+		ok = ok && rdr.get_magic(CLASSAD_LOG_CKPT_END) && rdr.at_end();
+
+		if (ok) {
+#if defined(UNIX)
+			// let the plugins see the loaded ads just as if they had been read from the log
+			for (auto & ad_key : loaded) {
+				ClassAd * ad = NULL;
+				if ( ! la.lookup(ad_key.c_str(), ad)) continue;
+				ClassAdLogPluginManager::NewClassAd(ad_key.c_str());
+				for (auto itr = ad->begin(); itr != ad->end(); itr++) {
+					value.clear();
+					ExprTreeToString(itr->second, value);
+					ClassAdLogPluginManager::SetAttribute(ad_key.c_str(), itr->first.c_str(), value.c_str());
+				}
+			}
+#endif
+			historical_sequence_number = (unsigned long)seq;
+			m_original_log_birthdate = (time_t)birthdate;
+			result = log_offset;
+		} else {
+			errmsg.formatstr_cat("Warning: checkpoint %s is corrupt, replaying the whole log\n", checkpoint_filename);
+			for (auto & ad_key : loaded) {
+				ClassAd * ad = NULL;
+				if (la.lookup(ad_key.c_str(), ad)) {
+					maker.Delete(ad);
+					la.remove(ad_key.c_str());
+				}
+			}
+		}
+	}
+
+#if defined(UNIX)
+	munmap(map, cb);
+#endif
+
+	if (result > 0) {
+		fseek(log_fp, result, SEEK_SET);
+		dprintf(D_ALWAYS, "Loaded %llu ads from checkpoint %s, replaying the log from offset %lld\n",
+			(unsigned long long)num_ads, checkpoint_filename, result);
+	}
+	return result;
+}
+
 LogHistoricalSequenceNumber::LogHistoricalSequenceNumber(unsigned long historical_sequence_number_arg,time_t timestamp_arg)
 {
 	op_type = CondorLogOp_LogHistoricalSequenceNumber;
@@ -802,6 +1319,7 @@ LogSetAttribute::LogSetAttribute(const char *k, const char *n, const char *val,
 		value = strdup("UNDEFINED");
 	}
 	is_dirty = dirty;
+	keep_parsed_value = false;
 }
 
 
@@ -824,7 +1342,19 @@ LogSetAttribute::Play(void *data_structure)
 		return -1;
 
 	std::string attr(name);
-	if (ad->InsertViaCache(attr, value)) {
+	bool inserted;
+	if (keep_parsed_value && value_expr) {
+		// the value was already parsed when the record was read, so don't parse it again.
+		ExprTree * tree = value_expr;
+		value_expr = NULL;
+		if (classad::ClassAdGetExpressionCaching() && attr[0] != '\'') {
+			tree = classad::CachedExprEnvelope::cache(attr, tree, value);
+		}
+		inserted = ad->Insert(attr, tree);
+	} else {
+		inserted = ad->InsertViaCache(attr, value);
+	}
+	if (inserted) {
 		rval = TRUE;
 	} else {
 		rval = FALSE;
@@ -883,7 +1413,7 @@ LogSetAttribute::WriteBody(FILE* fp)
 }
 
 int
-LogSetAttribute::ReadBody(FILE* fp)
+LogSetAttribute::ReadKeyNameValue(FILE* fp)
 {
 	int rval, rval1;
 
@@ -905,6 +1435,16 @@ LogSetAttribute::ReadBody(FILE* fp)
 	if (rval < 0) {
 		return rval;
 	}
+	return rval + rval1;
+}
+
+int
+LogSetAttribute::ReadBody(FILE* fp)
+{
+	int rval = ReadKeyNameValue(fp);
+	if (rval < 0) {
+		return rval;
+	}
 
 	if (value_expr) delete value_expr;
 	value_expr = NULL;
@@ -917,7 +1457,25 @@ LogSetAttribute::ReadBody(FILE* fp)
 			dprintf(D_ALWAYS, "WARNING: strict classad parsing failed for expression: %s\n", value);
 		}
 	}
-	return rval + rval1;
+	return rval;
+}
+
+int
+LogSetAttribute::ReadBodyAndParse(FILE* fp)
+{
+	int rval = ReadKeyNameValue(fp);
+	if (rval < 0) {
+		return rval;
+	}
+
+	if (value_expr) delete value_expr;
+	value_expr = NULL;
+	if (ParseClassAdRvalExpr(value, value_expr)) {
+		value_expr = NULL;
+		return -1;
+	}
+	keep_parsed_value = true;
+	return rval;
 }
 
 
@@ -1060,36 +1618,9 @@ LogDeleteAttribute::ReadBody(FILE* fp)
 LogRecord	*
 InstantiateLogEntry(FILE *fp, unsigned long recnum, int type, const ConstructLogEntry & ctor)
 {
-	LogRecord	*log_rec;
-
-	switch(type) {
-        case CondorLogOp_Error:
-            log_rec = new LogRecordError();
-            break;
-	    case CondorLogOp_NewClassAd:
-		    log_rec = new LogNewClassAd("", "", "", ctor);
-			break;
-	    case CondorLogOp_DestroyClassAd:
-		    log_rec = new LogDestroyClassAd("", ctor);
-			break;
-	    case CondorLogOp_SetAttribute:
-		    log_rec = new LogSetAttribute("", "", "");
-			break;
-	    case CondorLogOp_DeleteAttribute:
-		    log_rec = new LogDeleteAttribute("", "");
-			break;
-		case CondorLogOp_BeginTransaction:
-			log_rec = new LogBeginTransaction();
-			break;
-		case CondorLogOp_EndTransaction:
-			log_rec = new LogEndTransaction();
-			break;
-		case CondorLogOp_LogHistoricalSequenceNumber:
-			log_rec = new LogHistoricalSequenceNumber(0,0);
-			break;
-	    default:
-		    return NULL;
-			break;
+	LogRecord	*log_rec = NewLogEntry(type, ctor);
+	if ( ! log_rec) {
+		return NULL;
 	}
 
 	long long pos = ftell(fp);
@@ -214,6 +214,16 @@ public:
 
 	time_t GetOrigLogBirthdate() {return m_original_log_birthdate;}
 
+	// Set the file used to checkpoint the table; must be called before InitLogFile.
+	// When set, InitLogFile will load the checkpoint and replay only the log tail after it,
+	// and TruncLog will refresh the checkpoint after rotating the log.
+	void SetCheckpointFilename(const char * filename) { checkpoint_filename_buf = filename ? filename : ""; }
+	// Write a checkpoint of the current table, fails if there is an active transaction
+	bool WriteCheckpoint();
+
+	// Set the number of worker threads InitLogFile uses to parse the log, 0 (the default) to parse serially.
+	void SetReplayThreads(int num_threads) { replay_threads = num_threads; }
+
 protected:
 	/** Returns handle to active transaction.  Upon return of this
 		method, any active transaction is forgotten.  It is the caller's
@@ -244,6 +254,9 @@ private:
 
 	char const *logFilename() { return log_filename_buf.c_str(); }
 	MyString log_filename_buf;
+	char const *checkpointFilename() { return checkpoint_filename_buf.empty() ? NULL : checkpoint_filename_buf.c_str(); }
+	MyString checkpoint_filename_buf;
+	int replay_threads;
 	Transaction *active_transaction;
 	int max_historical_logs;
 	unsigned long historical_sequence_number;
@@ -375,14 +388,21 @@ public:
 	char const *get_value() { return value; }
     ExprTree* get_expr() { return value_expr; }
 
+	// Like ReadBody, but keeps the parsed value so that Play inserts it rather than
+	// parsing the value a second time.  It does not consult the config or log anything,
+	// so it can be called on a worker thread. returns -1 if the value does not parse.
+	int ReadBodyAndParse(FILE* fp);
+
 private:
 	virtual int WriteBody(FILE* fp);
 	virtual int ReadBody(FILE* fp);
+	int ReadKeyNameValue(FILE* fp);
 
 	char *key;
 	char *name;
 	char *value;
 	bool is_dirty;
+	bool keep_parsed_value; // set by ReadBodyAndParse, Play will insert value_expr
     ExprTree* value_expr;    
 };
 
@@ -469,7 +489,32 @@ FILE* LoadClassAdLog(
 	time_t & m_original_log_birthdate, // in,out
 	bool & is_clean,  // out: true if log was shutdown cleanly
 	bool & requires_successful_cleaning, // out: true if log must be cleaned (i.e rotated) before it can be written to again.
-	MyString & errmsg);             // out, contains error or warning messages
+	MyString & errmsg,              // out, contains error or warning messages
+	const char * checkpoint_filename = NULL, // in: optional checkpoint to load before replaying the log
+	int replay_threads = 0);        // in: number of worker threads used to parse the log, 0 to parse serially
+
+// A checkpoint is a length-prefixed binary dump of the committed state of the table
+// along with the sequence number, birthdate and byte offset of the log at the time it was
+// written.  When the checkpoint matches the log, LoadClassAdLog loads the checkpoint in bulk and
+// replays only the part of the log that was written after it, rather than parsing the whole log.
+bool WriteClassAdLogCheckpoint(
+	const char * checkpoint_filename, // in
+	FILE * log_fp,                  // in: the log, must be flushed and have no open transaction
+	unsigned long historical_sequence_number, // in
+	time_t original_log_birthdate,  // in
+	LoggableClassAdTable & la,      // in
+	MyString & errmsg);             // out
+
+// returns the log offset to resume replay from, or 0 if the checkpoint could not be used
+// in which case the table is left empty and the log must be replayed from the start.
+long long LoadClassAdLogCheckpoint(
+	const char * checkpoint_filename, // in
+	FILE * log_fp,                  // in: log positioned at the start
+	LoggableClassAdTable & la,      // in
+	const ConstructLogEntry& maker, // in
+	unsigned long & historical_sequence_number, // out
+	time_t & m_original_log_birthdate, // out
+	MyString & errmsg);             // out
 
 int FlushClassAdLog(FILE* fp, bool force);
 
@@ -525,7 +570,8 @@ ClassAdLog<K,AD>::InitLogFile(const char *filename,int max_historical_logs_arg)
 	log_fp = LoadClassAdLog(filename,
 		la, this->GetTableEntryMaker(),
 		historical_sequence_number, m_original_log_birthdate,
-		is_clean, requires_successful_cleaning, errmsg);
+		is_clean, requires_successful_cleaning, errmsg,
+		checkpointFilename(), replay_threads);
 
 	if ( ! log_fp) {
 		dprintf(D_ALWAYS, "%s", errmsg.c_str());
@@ -553,6 +599,7 @@ ClassAdLog<K,AD>::ClassAdLog(const ConstructLogEntry* maker)
 	: table(hashFunction)
 	, make_table_entry(maker)
 	, log_fp(nullptr)
+	, replay_threads(0)
 	, active_transaction(nullptr)
 	, max_historical_logs(0)
 	, historical_sequence_number(0)
@@ -665,9 +712,40 @@ ClassAdLog<K,AD>::TruncLog()
 		dprintf(D_ALWAYS, "%s", errmsg.c_str());
 	}
 
+	// rotation changes the sequence number of the log, so the old checkpoint no longer matches.
+	if (rotated && checkpointFilename()) {
+		WriteCheckpoint();
+	}
+
 	return rotated;
 }
 
+template <typename K, typename AD>
+bool
+ClassAdLog<K,AD>::WriteCheckpoint()
+{
+	if ( ! checkpointFilename() || ! log_fp) {
+		return false;
+	}
+	if (active_transaction) {
+		dprintf(D_FULLDEBUG, "Not checkpointing ClassAd log %s because a transaction is active\n", logFilename());
+		return false;
+	}
+
+	// the checkpoint records the log offset, so everything before it must be in the file
+	FlushLog();
+
+	MyString errmsg;
+	ClassAdLogTable<K,AD> la(table);
+	bool success = WriteClassAdLogCheckpoint(checkpointFilename(), log_fp,
+		historical_sequence_number, m_original_log_birthdate,
+		la, errmsg);
+	if ( ! success) {
+		dprintf(D_ALWAYS, "Failed to checkpoint ClassAd log %s: %s\n", logFilename(), errmsg.c_str());
+	}
+	return success;
+}
+
 template <typename K, typename AD>
 void
 ClassAdLog<K,AD>::StopLog()
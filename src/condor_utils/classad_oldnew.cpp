@@ -620,11 +620,12 @@ int _putClassAd( Stream *sock, const classad::ClassAd& ad, int options,
 	classad::AttrList::const_iterator itor;
 	classad::AttrList::const_iterator itor_end;
 
-	bool haveChainedAd = false;
-
-	const classad::ClassAd *chainedAd = ad.GetChainedParentAd();
-	if(chainedAd){
-		haveChainedAd = true;
+	// the chained parent ads are sent first, farthest ancestor first, so that
+	// when there are duplicates the attributes of the nearer ad override them.
+	// the collector chains startd slot ads two deep (private -> public -> machine)
+	std::vector<const classad::ClassAd *> chain;
+	for (const classad::ClassAd * link = &ad; link; link = link->GetChainedParentAd()) {
+		chain.push_back(link);
 	}
 
 	bool crypto_is_noop = sock->prepare_crypto_for_secret_is_noop();
@@ -633,24 +634,14 @@ int _putClassAd( Stream *sock, const classad::ClassAd& ad, int options,
 	// where we care (when selectively encrypting them or when excluding
 	// them).
 	int private_count = 0;
-	for(int pass = 0; pass < 2; pass++){
+	for (auto link = chain.rbegin(); link != chain.rend(); ++link) {
 
 		/*
-		* Count the number of chained attributes on the first
-		*   pass (if any!), then the number of attrs in this classad on
-		*   pass number 2.
+		* Count the number of attributes in each of the chained ads,
+		*   then the number of attrs in this classad.
 		*/
-		if(pass == 0){
-			if(!haveChainedAd){
-				continue;
-			}
-			itor = chainedAd->begin();
-			itor_end = chainedAd->end();
-		}
-		else {
-			itor = ad.begin();
-			itor_end = ad.end();
-		}
+		itor = (*link)->begin();
+		itor_end = (*link)->end();
 
 		for(;itor != itor_end; itor++) {
 			std::string const &attr = itor->first;
@@ -689,22 +680,9 @@ int _putClassAd( Stream *sock, const classad::ClassAd& ad, int options,
 		return false;
 	}
 
-	for(int pass = 0; pass < 2; pass++){
-		if(pass == 0) {
-			/* need to copy the chained attrs first, so if
-				*  there are duplicates, the non-chained attrs
-				*  will override them
-				*/
-			if(!haveChainedAd){
-				continue;
-			}
-			itor = chainedAd->begin();
-			itor_end = chainedAd->end();
-		} 
-		else {
-			itor = ad.begin();
-			itor_end = ad.end();
-		}
+	for (auto link = chain.rbegin(); link != chain.rend(); ++link) {
+		itor = (*link)->begin();
+		itor_end = (*link)->end();
 
 		for(;itor != itor_end; itor++) {
 			std::string const &attr = itor->first;
@@ -180,6 +180,7 @@ const struct Translation DCTranslation[] = {
 	{ "STARTER_PEEK", STARTER_PEEK },
 	{ "SHARED_PORT_CONNECT", SHARED_PORT_CONNECT },
 	{ "SHARED_PORT_PASS_SOCK", SHARED_PORT_PASS_SOCK },
+	{ "SHARED_PORT_PASS_SOCKS", SHARED_PORT_PASS_SOCKS },
 	{ "RECYCLE_SHADOW", RECYCLE_SHADOW },
         { "CLEAR_DIRTY_JOB_ATTRS", CLEAR_DIRTY_JOB_ATTRS },
         { "UPDATE_JOBAD", UPDATE_JOBAD },
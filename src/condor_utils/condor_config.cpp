@@ -86,6 +86,7 @@
 #include "which.h"
 #include "classad_helpers.h"
 #include <algorithm> // for std::sort
+#include <atomic>
 #include "CondorError.h"
 
 // define this to keep param who's values match defaults from going into to runtime param table.
@@ -118,10 +119,19 @@ void param_default_set_use(const char * name, int use, MACRO_SET & set);
 
 // Global variables
 static MACRO_DEFAULTS ConfigMacroDefaults = { 0, NULL, NULL };
+// bumped whenever the ConfigMacroSet may have changed, see param_generation()
+static std::atomic<unsigned int> ConfigGeneration(1);
 static MACRO_SET ConfigMacroSet = {
 	0, 0,
 	/* CONFIG_OPT_WANT_META | CONFIG_OPT_KEEP_DEFAULT | */ 0,
 	0, NULL, NULL, ALLOCATION_POOL(), std::vector<const char*>(), &ConfigMacroDefaults, NULL };
+// a worker thread that has installed a ParamSnapshot reads that rather than
+// the ConfigMacroSet, so that the main thread can reconfig while it runs.
+static thread_local MACRO_SET * ThreadConfigMacroSet = NULL;
+static inline MACRO_SET & ActiveConfigMacroSet()
+{
+	return ThreadConfigMacroSet ? *ThreadConfigMacroSet : ConfigMacroSet;
+}
 const MACRO_SOURCE DetectedMacro = { true,  false, 0, -2, -1, -2 };
 //const MACRO_SOURCE DefaultMacro  = { true,  false, 1, -2, -1, -2 };
 const MACRO_SOURCE EnvMacro      = { false, false, 2, -2, -1, -2 };
@@ -401,22 +411,22 @@ bool config_continue_if_no_config(bool contin)
 
 void config_dump_sources(FILE * fh, const char * sep)
 {
-	for (int ii = 0; ii < (int)ConfigMacroSet.sources.size(); ++ii) {
-		fprintf(fh, "%s%s", ConfigMacroSet.sources[ii], sep);
+	for (int ii = 0; ii < (int)ActiveConfigMacroSet().sources.size(); ++ii) {
+		fprintf(fh, "%s%s", ActiveConfigMacroSet().sources[ii], sep);
 	}
 }
 
 const char* config_source_by_id(int source_id)
 {
-	if (source_id >= 0 && source_id < (int)ConfigMacroSet.sources.size())
-		return ConfigMacroSet.sources[source_id];
+	if (source_id >= 0 && source_id < (int)ActiveConfigMacroSet().sources.size())
+		return ActiveConfigMacroSet().sources[source_id];
 	return NULL;
 }
 
 void config_dump_string_pool(FILE * fh, const char * sep)
 {
 	int cEmptyStrings = 0;
-	ALLOCATION_POOL * ap = &ConfigMacroSet.apool;
+	ALLOCATION_POOL * ap = &ActiveConfigMacroSet().apool;
 	for (int ii = 0; ii < ap->cMaxHunks; ++ii) {
 		if (ii > ap->nHunk) break;
 		ALLOC_HUNK * ph = &ap->phunks[ii];
@@ -684,7 +694,7 @@ bool validate_config(bool abort_if_invalid, int opt)
 
 void foreach_param(int options, bool (*fn)(void* user, HASHITER& it), void* user)
 {
-	HASHITER it = hash_iter_begin(ConfigMacroSet, options);
+	HASHITER it = hash_iter_begin(ActiveConfigMacroSet(), options);
 	while ( ! hash_iter_done(it)) {
 		if ( ! fn(user, it))
 			break;
@@ -695,7 +705,7 @@ void foreach_param(int options, bool (*fn)(void* user, HASHITER& it), void* user
 
 void foreach_param_matching(Regex & re, int options, bool (*fn)(void* user, HASHITER& it), void* user)
 {
-	HASHITER it = hash_iter_begin(ConfigMacroSet, options);
+	HASHITER it = hash_iter_begin(ActiveConfigMacroSet(), options);
 	while ( ! hash_iter_done(it)) {
 		const char *name = hash_iter_key(it);
 		if (re.match(name)) {
@@ -711,7 +721,7 @@ void foreach_param_matching(Regex & re, int options, bool (*fn)(void* user, HASH
 
 int param_names_matching(Regex& re, std::vector<std::string>& names) {
     const int s0 = (int)names.size();
-    HASHITER it = hash_iter_begin(ConfigMacroSet);
+    HASHITER it = hash_iter_begin(ActiveConfigMacroSet());
     for (;  !hash_iter_done(it);  hash_iter_next(it)) {
 		const char *name = hash_iter_key(it);
 		if (re.match(name)) names.push_back(name);
@@ -1024,9 +1034,73 @@ real_config(const char* host, int wantsQuiet, int config_options, const char * r
 		// Re-initialize the ClassAd compat data (in case if CLASSAD_USER_LIBS is set).
 	ClassAdReconfig();
 
+		// tell cached param values (param_handle) that they need to be looked up again
+	++ConfigGeneration;
+
 	return true;
 }
 
+unsigned int param_generation()
+{
+	return ConfigGeneration.load(std::memory_order_acquire);
+}
+
+// a copy of the config table that owns all of its strings. the defaults
+// table is shared, it is static, but the use counts are not kept.
+class ParamSnapshot {
+public:
+	ParamSnapshot()
+		: set{ 0, 0, 0, 0, NULL, NULL, ALLOCATION_POOL(), std::vector<const char*>(), NULL, NULL }
+		, defaults{ 0, NULL, NULL }
+	{}
+	~ParamSnapshot() { delete [] set.table; }
+	MACRO_SET set;
+	MACRO_DEFAULTS defaults;
+};
+
+std::shared_ptr<ParamSnapshot> param_snapshot()
+{
+	const MACRO_SET & config = ConfigMacroSet;
+	std::shared_ptr<ParamSnapshot> snap = std::make_shared<ParamSnapshot>();
+	MACRO_SET & set = snap->set;
+
+	set.options = config.options & ~CONFIG_OPT_WANT_META;
+	if (config.defaults) {
+		snap->defaults.size = config.defaults->size;
+		snap->defaults.table = config.defaults->table;
+		set.defaults = &snap->defaults;
+	}
+
+	int cb = 0;
+	for (int ix = 0; ix < config.size; ++ix) {
+		if (config.table[ix].key) cb += (int)strlen(config.table[ix].key) + 1;
+		if (config.table[ix].raw_value) cb += (int)strlen(config.table[ix].raw_value) + 1;
+	}
+	for (const char * source : config.sources) {
+		if (source) cb += (int)strlen(source) + 1;
+	}
+	set.apool.reserve(cb);
+
+	set.table = new MACRO_ITEM[MAX(config.size, 1)];
+	set.allocation_size = MAX(config.size, 1);
+	set.size = config.size;
+	set.sorted = config.sorted;
+	for (int ix = 0; ix < config.size; ++ix) {
+		const MACRO_ITEM & item = config.table[ix];
+		set.table[ix].key = item.key ? set.apool.insert(item.key) : NULL;
+		set.table[ix].raw_value = item.raw_value ? set.apool.insert(item.raw_value) : NULL;
+	}
+	for (const char * source : config.sources) {
+		set.sources.push_back(source ? set.apool.insert(source) : NULL);
+	}
+	return snap;
+}
+
+void param_use_snapshot(ParamSnapshot * snapshot)
+{
+	ThreadConfigMacroSet = snapshot ? &snapshot->set : NULL;
+}
+
 
 void
 process_config_source( const char* file, int depth, const char* name,
@@ -1872,6 +1946,7 @@ param_insert(const char * name, const char * value)
 	MACRO_EVAL_CONTEXT ctx;
 	init_macro_eval_context(ctx);
 	insert_macro(name, value, ConfigMacroSet, WireMacro, ctx);
+	++ConfigGeneration;
 }
 
 // set the value of a param equal to the given pointer. if the param is
@@ -1898,6 +1973,7 @@ const char * set_live_param_value(const char * name, const char * live_value)
 	} else {
 		pitem->raw_value = live_value;
 	}
+	++ConfigGeneration;
 	return old_value;
 }
 
@@ -1971,7 +2047,7 @@ clear_global_config_table()
 
 MACRO_SET * param_get_macro_set()
 {
-	return &ConfigMacroSet;
+	return &ActiveConfigMacroSet();
 }
 
 bool param_defined_by_config(const char *name)
@@ -1980,7 +2056,7 @@ bool param_defined_by_config(const char *name)
 	init_macro_eval_context(ctx);
 	ctx.without_default = true;
 
-	const char * pval = lookup_macro(name, ConfigMacroSet, ctx);
+	const char * pval = lookup_macro(name, ActiveConfigMacroSet(), ctx);
 	return pval != NULL;
 }
 
@@ -1988,7 +2064,7 @@ const char * param_unexpanded(const char *name)
 {
 	MACRO_EVAL_CONTEXT ctx;
 	init_macro_eval_context(ctx);
-	const char * pval = lookup_macro(name, ConfigMacroSet, ctx);
+	const char * pval = lookup_macro(name, ActiveConfigMacroSet(), ctx);
 	if (pval && ! pval[0]) return NULL;
 	return pval;
 }
@@ -2006,7 +2082,7 @@ unsigned int expand_defined_config_macros (std::string &value)
 {
 	MACRO_EVAL_CONTEXT ctx;
 	init_macro_eval_context(ctx);
-	return expand_defined_macros(value, ConfigMacroSet, ctx);
+	return expand_defined_macros(value, ActiveConfigMacroSet(), ctx);
 }
 
 
@@ -2029,7 +2105,7 @@ char*
 param_ctx(const char* name, MACRO_EVAL_CONTEXT & ctx)
 {
 
-	const char * pval = lookup_macro(name, ConfigMacroSet, ctx);
+	const char * pval = lookup_macro(name, ActiveConfigMacroSet(), ctx);
 	if ( ! pval || ! pval[0]) {
 		// If we don't find any value at all, return NULL
 		return NULL;
@@ -2038,7 +2114,7 @@ param_ctx(const char* name, MACRO_EVAL_CONTEXT & ctx)
 	// if we get here, it means that we found a val of note, so expand it and
 	// return the canonical value of it. expand_macro returns allocated memory.
 	// note that expand_macro will first try and expand
-	char * expanded_val = expand_macro(pval, ConfigMacroSet, ctx);
+	char * expanded_val = expand_macro(pval, ActiveConfigMacroSet(), ctx);
 	if ( ! expanded_val) {
 		return NULL;
 	}
@@ -2615,7 +2691,7 @@ expand_param( const char *str )
 {
 	MACRO_EVAL_CONTEXT ctx;
 	init_macro_eval_context(ctx);
-	return expand_macro(str, ConfigMacroSet, ctx);
+	return expand_macro(str, ActiveConfigMacroSet(), ctx);
 }
 
 char *
@@ -2624,7 +2700,7 @@ expand_param(const char *str, const char * localname, const char *subsys, int us
 	MACRO_EVAL_CONTEXT ctx = { localname, subsys, NULL, false, (char)use, 0, 0 };
 	if (ctx.localname && ! ctx.localname[0]) ctx.localname = NULL;
 	if (ctx.subsys && ! ctx.subsys[0]) ctx.subsys = NULL;
-	return expand_macro(str, ConfigMacroSet, ctx);
+	return expand_macro(str, ActiveConfigMacroSet(), ctx);
 }
 
 const char *
@@ -2671,7 +2747,7 @@ bool param_find_item (
 	MyString & name_found, // out
 	HASHITER& it)          //
 {
-	it = HASHITER(ConfigMacroSet, 0);
+	it = HASHITER(ActiveConfigMacroSet(), 0);
 	if (subsys && ! subsys[0]) subsys = NULL;
 	if (local && ! local[0]) local = NULL;
 	it.id = it.set.defaults ? it.set.defaults->size : 0;
@@ -2683,7 +2759,7 @@ bool param_find_item (
 	//PRAGMA_REMIND("tj: remove subsys.local.knob support in the 8.5 devel series")
 	if (subsys && local) {
 		name_found.formatstr("%s.%s", subsys, local);
-		pi = find_macro_item(name, name_found.c_str(), ConfigMacroSet);
+		pi = find_macro_item(name, name_found.c_str(), ActiveConfigMacroSet());
 		if (pi) {
 			name_found = pi->key;
 			it.ix = (int)(pi - it.set.table);
@@ -2692,7 +2768,7 @@ bool param_find_item (
 	}
 #endif
 	if (local) {
-		pi = find_macro_item(name, local, ConfigMacroSet);
+		pi = find_macro_item(name, local, ActiveConfigMacroSet());
 		if (pi) {
 			name_found = pi->key;
 			it.ix = (int)(pi - it.set.table);
@@ -2700,7 +2776,7 @@ bool param_find_item (
 		}
 	}
 	if (subsys) {
-		pi = find_macro_item(name, subsys, ConfigMacroSet);
+		pi = find_macro_item(name, subsys, ActiveConfigMacroSet());
 		if (pi) {
 			name_found = pi->key;
 			it.ix = (int)(pi - it.set.table);
@@ -2719,7 +2795,7 @@ bool param_find_item (
 		}
 	}
 
-	pi = find_macro_item(name, NULL, ConfigMacroSet);
+	pi = find_macro_item(name, NULL, ActiveConfigMacroSet());
 	if (pi) {
 		name_found = pi->key;
 		it.ix = (int)(pi - it.set.table);
@@ -2803,7 +2879,7 @@ const char * param_get_info(
 	name_used.clear();
 
 	MyString ms;
-	HASHITER it(ConfigMacroSet, 0);
+	HASHITER it(ActiveConfigMacroSet(), 0);
 	if (param_find_item(name, subsys, local, ms, it)) {
 		name_used = ms;
 		val = hash_iter_value(it);
@@ -2967,6 +3043,7 @@ config_insert( const char* attrName, const char* attrValue )
 	MACRO_EVAL_CONTEXT ctx;
 	init_macro_eval_context(ctx);
 	insert_macro(attrName, attrValue, ConfigMacroSet, WireMacro, ctx);
+	++ConfigGeneration;
 }
 
 int macro_stats(MACRO_SET& set, struct _macro_stats &stats)
@@ -3002,7 +3079,7 @@ int macro_stats(MACRO_SET& set, struct _macro_stats &stats)
 
 int  get_config_stats(struct _macro_stats *pstats)
 {
-	return macro_stats(ConfigMacroSet, *pstats);
+	return macro_stats(ActiveConfigMacroSet(), *pstats);
 }
 
 
@@ -3553,7 +3630,7 @@ int write_macros_to_file(const char* pathname, MACRO_SET& macro_set, int options
 }
 
 int write_config_file(const char* pathname, int options) {
-	return write_macros_to_file(pathname, ConfigMacroSet, options);
+	return write_macros_to_file(pathname, ActiveConfigMacroSet(), options);
 }
 
 // so that condor_config_val can test config if expressions.
@@ -3563,7 +3640,7 @@ bool config_test_if_expression(const char * expr, bool & result, const char * lo
 	MACRO_EVAL_CONTEXT ctx = { localname, subsys, NULL, false, 0, 0, 0 };
 	if (ctx.localname && !ctx.localname[0]) ctx.localname = NULL;
 	if (ctx.subsys && !ctx.subsys[0]) ctx.subsys = NULL;
-	return Test_config_if_expression(expr, result, err_reason, ConfigMacroSet, ctx);
+	return Test_config_if_expression(expr, result, err_reason, ActiveConfigMacroSet(), ctx);
 }
 
 /* End code for runtime support for modifying a daemon's config source. */
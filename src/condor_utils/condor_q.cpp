@@ -403,6 +403,9 @@ CondorQ::fetchQueueFromHostAndProcessV2(const char *host,
 	request_ad.Insert(ATTR_REQUIREMENTS, expr);
 
 	request_ad.Assign(ATTR_SEND_SERVER_TIME, requestservertime);
+	if ( ! sortby.empty()) {
+		request_ad.Assign("SortBy", sortby);
+	}
 
 	char *projection = attrs.print_to_delimed_string("\n");
 	if (projection) {
@@ -511,7 +514,13 @@ CondorQ::fetchQueueFromHostAndProcessV2(const char *host,
 
 	int rval = 0;
 	do {
-		ad = new ClassAd();
+		// reuse the ad when the process_func did not keep the last one, so
+		// that streaming a large query does not allocate an ad per job.
+		if (ad) {
+			ad->Clear();
+		} else {
+			ad = new ClassAd();
+		}
 		if ( ! getClassAd(sock, *ad) || ! sock->end_of_message()) {
 			rval = Q_SCHEDD_COMMUNICATION_ERROR;
 			break;
@@ -539,13 +548,10 @@ CondorQ::fetchQueueFromHostAndProcessV2(const char *host,
 			break;
 		}
 		// Note: According to condor_q.h, process_func() will return false if taking
-		// ownership of ad, so only delete if it returns true, else set to NULL
-		// so we don't delete it here.  Either way, next set ad to NULL since either
-		// it has been deleted or will be deleted later by process_func().
-		if (process_func(process_func_data, ad)) {
-			delete ad;
+		// ownership of ad, in which case set ad to NULL so we don't delete or reuse it.
+		if ( ! process_func(process_func_data, ad)) {
+			ad = NULL;
 		}
-		ad = NULL;
 	} while (true);
 
 	// Make sure ad is not leaked no matter how we break out of the above loop.
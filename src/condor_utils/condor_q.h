@@ -129,6 +129,9 @@ class CondorQ
 	int  rawQuery(std::string & str) { return query.makeQuery(str); }
 
 	void requestServerTime(bool request) { requestservertime = request; }
+	// ask the schedd to send the results in order of this attribute and then by job id.
+	// "JobId" sorts by job id only.  schedds that do not know how to sort ignore this.
+	void requestSortBy(const char * attr) { sortby = attr ? attr : ""; }
 
   private:
 	GenericQuery query;
@@ -145,6 +148,7 @@ class CondorQ
 	char schedd[MAXSCHEDDLEN];
 	bool defaulting_operator;
 	bool requestservertime;
+	std::string sortby;
 	time_t scheddBirthdate;
 	
 	// helper functions
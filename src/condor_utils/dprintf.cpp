@@ -70,6 +70,12 @@
 #endif
 
 #include <sstream>
+#if !defined(WIN32) && defined(HAVE_PTHREADS)
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
 
 // call when you want to insure that dprintfs are thread safe on Linux regardless of
 // wether daemon core threads are enabled. thread safety cannot be disabled once enabled
@@ -219,6 +225,11 @@ int		LockFd = -1;
 
 bool	log_keep_open = false;
 
+// set by dprintf_config from <SUBSYS>_LOG_ASYNC, LOG_ASYNC_BUFFER_SIZE and
+// LOG_ASYNC_FLUSH_INTERVAL. a buffer size of 0 disables the async log writer
+long long DebugAsyncBufferSize = 0;
+int		DebugAsyncFlushInterval = 100;
+
 static bool DebugRotateLog = true;
 
 static	int DprintfBroken = 0;
@@ -500,10 +511,11 @@ const char* _format_global_header(int cat_and_flags, int hdr_flags, DebugHeaderI
 	return buf;
 }
 
-void
-_dprintf_global_func(int cat_and_flags, int hdr_flags, DebugHeaderInfo & info, const char* message, DebugFileInfo* dbgInfo)
+// format the header, message and backtrace (if any) of a log record into a
+// static buffer, returns the buffer and sets len to the size of the record.
+static const char *
+_format_global_record(int cat_and_flags, int hdr_flags, DebugHeaderInfo & info, const char* message, DebugFileInfo* dbgInfo, int & len)
 {
-	int start_pos = 0;
 	int bufpos = 0;
 	int rc = 0;
 	static char* buffer = NULL;
@@ -614,6 +626,18 @@ _dprintf_global_func(int cat_and_flags, int hdr_flags, DebugHeaderInfo & info, c
 	#endif // HAVE_BACKTRACE
 	}
 
+	len = bufpos;
+	return buffer;
+}
+
+void
+_dprintf_global_func(int cat_and_flags, int hdr_flags, DebugHeaderInfo & info, const char* message, DebugFileInfo* dbgInfo)
+{
+	int start_pos = 0;
+	int bufpos = 0;
+	int rc = 0;
+	const char * buffer = _format_global_record(cat_and_flags, hdr_flags, info, message, dbgInfo, bufpos);
+
 		// We attempt to write the log record with one call to
 		// write(), because then O_APPEND will ensure (on
 		// compliant file systems) that writes from different
@@ -634,6 +658,272 @@ _dprintf_global_func(int cat_and_flags, int hdr_flags, DebugHeaderInfo & info, c
 	}
 }
 
+#if !defined(WIN32) && defined(HAVE_PTHREADS)
+
+// The async log writer. When it is active, dprintf formats records for log files
+// into a pending buffer per output (indexed like DebugLogs) and returns, and the
+// writer thread writes each buffer with a single write() once per flush interval.
+//
+// The pending buffers are protected by _condor_dprintf_critsec like the rest of the
+// dprintf state, the writer thread only holds it while it writes out a batch.
+// Opening the log, checking its size and rotating it still happen on the thread
+// that calls dprintf, once per batch rather than once per message, so the writer
+// thread never has to change priv state.  When the pending buffers reach the
+// configured size the thread calling dprintf writes them out itself, so memory
+// use is bounded and no messages are dropped.
+struct DprintfLogWriter {
+	std::vector<std::string> pending;
+	size_t pending_bytes{0};
+	size_t max_bytes{0};
+	int flush_interval{100}; // milliseconds
+	bool active{false};      // dprintf is handing log file records to the writer
+	int write_errno{0};      // the first write() failure, reported by the next dprintf
+
+	std::thread * thread{nullptr};
+	std::mutex mtx;          // protects the fields below
+	std::condition_variable cv;
+	bool wake{false};        // there is a new batch
+	bool flush_now{false};   // the pending buffers are half full, don't wait
+	bool stopping{false};
+};
+// never freed, the writer thread may still be waiting on it while the process exits
+static DprintfLogWriter * LogWriter = NULL;
+
+// write out the pending records for all outputs, caller must hold _condor_dprintf_critsec
+static void
+log_writer_drain()
+{
+	for (size_t ix = 0; ix < LogWriter->pending.size(); ++ix) {
+		std::string & buf = LogWriter->pending[ix];
+		if (buf.empty()) {
+			continue;
+		}
+		FILE * fp = (ix < DebugLogs->size()) ? (*DebugLogs)[ix].debugFP : NULL;
+		const char * ptr = buf.data();
+		size_t left = fp ? buf.size() : 0;
+		while (left > 0) {
+			ssize_t rc = write(fileno(fp), ptr, left);
+			if (rc > 0) {
+				ptr += rc;
+				left -= rc;
+			} else if (errno != EINTR) {
+				if ( ! LogWriter->write_errno) { LogWriter->write_errno = errno; }
+				break;
+			}
+		}
+		LogWriter->pending_bytes -= buf.size();
+		buf.clear(); // keeps the allocation for the next batch
+	}
+}
+
+static void
+log_writer_main()
+{
+	for (;;) {
+		{
+			std::unique_lock<std::mutex> guard(LogWriter->mtx);
+			LogWriter->cv.wait(guard, []{ return LogWriter->wake || LogWriter->stopping; });
+			// let the batch fill up for a while before we write it
+			LogWriter->cv.wait_for(guard, std::chrono::milliseconds(LogWriter->flush_interval),
+				[]{ return LogWriter->flush_now || LogWriter->stopping; });
+			if (LogWriter->stopping) {
+				return;
+			}
+			LogWriter->wake = false;
+			LogWriter->flush_now = false;
+		}
+		pthread_mutex_lock(&_condor_dprintf_critsec);
+		log_writer_drain();
+		pthread_mutex_unlock(&_condor_dprintf_critsec);
+	}
+}
+
+// called by _condor_dprintf_va in place of debug_lock_it/dprintfFunc/debug_unlock_it
+// for log files when the writer is active. caller must hold _condor_dprintf_critsec
+static void
+log_writer_append(int cat_and_flags, int hdr_flags, DebugHeaderInfo & info, const char* message, int ixOutput)
+{
+	DebugFileInfo * it = &(*DebugLogs)[ixOutput];
+	std::string & buf = LogWriter->pending[ixOutput];
+
+	if (LogWriter->write_errno) {
+		int err = LogWriter->write_errno;
+		LogWriter->write_errno = 0;
+		_condor_dprintf_exit(err, "Error writing debug log\n");
+	}
+
+	// the first record of a batch does the open, size check and rotation that a
+	// synchronous dprintf would do for every record.
+	if (buf.empty() && ! debug_lock_it(it, NULL, 0, it->dont_panic)) {
+		return;
+	}
+
+	int len = 0;
+	const char * record = _format_global_record(cat_and_flags, hdr_flags, info, message, it, len);
+	bool was_empty = LogWriter->pending_bytes == 0;
+	buf.append(record, len);
+	LogWriter->pending_bytes += len;
+
+	if (LogWriter->pending_bytes >= LogWriter->max_bytes) {
+		// the writer has fallen behind, write the batch here rather than use more memory
+		log_writer_drain();
+	} else if (was_empty || LogWriter->pending_bytes >= LogWriter->max_bytes/2) {
+		std::unique_lock<std::mutex> guard(LogWriter->mtx);
+		if (was_empty) { LogWriter->wake = true; }
+		if (LogWriter->pending_bytes >= LogWriter->max_bytes/2) { LogWriter->flush_now = true; }
+		LogWriter->cv.notify_one();
+	}
+}
+
+static void
+log_writer_atfork_prepare()
+{
+	// make sure the writer thread is not in the middle of a batch when we fork
+	pthread_mutex_lock(&_condor_dprintf_critsec);
+}
+
+static void
+log_writer_atfork_parent()
+{
+	pthread_mutex_unlock(&_condor_dprintf_critsec);
+}
+
+static void
+log_writer_atfork_child()
+{
+	// there is no writer thread in the child, and the parent will write out
+	// whatever was pending, so the child goes back to synchronous writes.
+	// the old writer state is leaked rather than freed, its mutex may be held.
+	LogWriter = NULL;
+
+	// the critsec is still owned by the parent's thread id, so it can't be unlocked here.
+	pthread_mutexattr_t attr;
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+	pthread_mutex_init(&_condor_dprintf_critsec, &attr);
+	pthread_mutexattr_destroy(&attr);
+}
+
+static void
+log_writer_atexit()
+{
+	if (LogWriter && LogWriter->active) {
+		pthread_mutex_lock(&_condor_dprintf_critsec);
+		log_writer_drain();
+		LogWriter->active = false;
+		pthread_mutex_unlock(&_condor_dprintf_critsec);
+	}
+}
+
+// start the writer thread if the config asks for it and there is a log file
+// that it can write to. called by dprintf_set_outputs after the outputs are set
+void
+dprintf_start_log_writer()
+{
+	static bool registered = false;
+
+	// the writer needs a log file that is kept open and does not need
+	// to be locked around each write.
+	if (DebugAsyncBufferSize <= 0 || ! log_keep_open || DebugShouldLockToAppend || ! DebugLogs) {
+		return;
+	}
+	bool any_files = false;
+	for (auto & out : *DebugLogs) {
+		if (out.outputTarget == FILE_OUT && out.dprintfFunc == _dprintf_global_func) { any_files = true; }
+	}
+	if ( ! any_files) {
+		return;
+	}
+
+	if ( ! registered) {
+		pthread_atfork(log_writer_atfork_prepare, log_writer_atfork_parent, log_writer_atfork_child);
+		atexit(log_writer_atexit);
+		registered = true;
+	}
+	if ( ! LogWriter) {
+		LogWriter = new DprintfLogWriter;
+	}
+
+	dprintf_make_thread_safe();
+	LogWriter->pending.assign(DebugLogs->size(), std::string());
+	LogWriter->pending_bytes = 0;
+	LogWriter->max_bytes = (size_t)DebugAsyncBufferSize;
+	LogWriter->flush_interval = DebugAsyncFlushInterval;
+	LogWriter->write_errno = 0;
+	LogWriter->wake = LogWriter->flush_now = LogWriter->stopping = false;
+
+	// the writer thread starts with all signals blocked so that signal
+	// handlers only ever run on the threads that expect them.
+	sigset_t mask, omask;
+	sigfillset(&mask);
+	pthread_sigmask(SIG_SETMASK, &mask, &omask);
+	LogWriter->thread = new std::thread(log_writer_main);
+	pthread_sigmask(SIG_SETMASK, &omask, NULL);
+
+	LogWriter->active = true;
+	_EXCEPT_Flush = dprintf_flush_log_writer;
+}
+
+// write out anything pending and stop the writer thread.  called by
+// dprintf_set_outputs before the outputs are changed.
+void
+dprintf_stop_log_writer()
+{
+	if ( ! LogWriter || ! LogWriter->thread) {
+		return;
+	}
+	{
+		std::unique_lock<std::mutex> guard(LogWriter->mtx);
+		LogWriter->stopping = true;
+	}
+	LogWriter->cv.notify_all();
+	LogWriter->thread->join();
+	delete LogWriter->thread;
+	LogWriter->thread = NULL;
+
+	pthread_mutex_lock(&_condor_dprintf_critsec);
+	log_writer_drain();
+	LogWriter->active = false;
+	pthread_mutex_unlock(&_condor_dprintf_critsec);
+}
+
+void
+dprintf_flush_log_writer()
+{
+	if (LogWriter && LogWriter->active) {
+		pthread_mutex_lock(&_condor_dprintf_critsec);
+		log_writer_drain();
+		pthread_mutex_unlock(&_condor_dprintf_critsec);
+	}
+}
+
+void
+dprintf_flush_log_writer_on_crash()
+{
+	// we are in a fatal signal handler, so no locks and no allocation. this
+	// may repeat or tear a record the writer thread is writing at the moment.
+	if ( ! LogWriter || ! LogWriter->active || ! DebugLogs) {
+		return;
+	}
+	LogWriter->active = false;
+	for (size_t ix = 0; ix < LogWriter->pending.size() && ix < DebugLogs->size(); ++ix) {
+		const std::string & buf = LogWriter->pending[ix];
+		FILE * fp = (*DebugLogs)[ix].debugFP;
+		if (fp && ! buf.empty()) {
+			(void) write(fileno(fp), buf.data(), buf.size());
+		}
+	}
+}
+
+#else // WIN32 or no pthreads, the async log writer is not supported
+
+void dprintf_start_log_writer() {}
+void dprintf_stop_log_writer() {}
+void dprintf_flush_log_writer() {}
+void dprintf_flush_log_writer_on_crash() {}
+
+#endif
+
 /* _condor_dfprintf_va
  * This function is used internally by the dprintf system wherever
  * it wants to write directly to the open debug log.
@@ -1000,6 +1290,13 @@ _condor_dprintf_va( int cat_and_flags, DPF_IDENT ident, const char* fmt, va_list
 				case SYSLOG: break;
 				default:
 				case FILE_OUT:
+#if !defined(WIN32) && defined(HAVE_PTHREADS)
+					if (LogWriter && LogWriter->active && it->dprintfFunc == _dprintf_global_func &&
+						ixOutput < (int)LogWriter->pending.size()) {
+						log_writer_append(cat_and_flags, hdr_flags, info, message_buffer, ixOutput);
+						continue;
+					}
+#endif
 					debug_lock_it(&(*it), NULL, 0, it->dont_panic);
 					funlock_it = true;
 					break;
@@ -1801,6 +2098,10 @@ _condor_dprintf_exit( int error_code, const char* msg )
 		if( ! wrote_warning ) {
 			fprintf( stderr, "%s%s%s\n", header, msg, tail );
 		}
+			/* Write out what we can of the messages that were waiting
+			   for the async log writer */
+		dprintf_flush_log_writer();
+
 			/* First, set a flag so we know not to try to keep using
 			   dprintf during the rest of this */
 		DprintfBroken = 1;
@@ -2423,16 +2724,28 @@ dprintf_dump_stack(void) {
 static int ParentLockFd = -1;
 static bool ParentDebugRotateLog = true;
 
+#if defined(HAVE_PTHREADS)
+static bool ParentLogWriterActive = false;
+#endif
+
 void
 dprintf_before_shared_mem_clone() {
 	ParentLockFd = LockFd;
 	ParentDebugRotateLog = DebugRotateLog;
+#if defined(HAVE_PTHREADS)
+	// the cloned child writes synchronously, so anything pending must go first
+	dprintf_flush_log_writer();
+	ParentLogWriterActive = LogWriter && LogWriter->active;
+#endif
 }
 
 void
 dprintf_after_shared_mem_clone() {
 	LockFd = ParentLockFd;
 	DebugRotateLog = ParentDebugRotateLog;
+#if defined(HAVE_PTHREADS)
+	if (LogWriter) { LogWriter->active = ParentLogWriterActive; }
+#endif
 }
 
 void
@@ -2450,6 +2763,11 @@ dprintf_init_fork_child( bool cloned ) {
 	// and child that can result in the parent writing to a rotated log
 	// file.
 	DebugRotateLog = false;
+#if defined(HAVE_PTHREADS)
+	// a forked child has already dropped the writer in log_writer_atfork_child,
+	// a cloned child shares it with the parent, but must not hand it records.
+	if (LogWriter) { LogWriter->active = false; }
+#endif
 	if ( !cloned ) {
 		log_keep_open = false;
 		std::vector<DebugFileInfo>::iterator it;
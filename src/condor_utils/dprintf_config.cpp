@@ -39,6 +39,8 @@ extern char		*DebugLock;
 extern const char* const _condor_DebugCategoryNames[D_CATEGORY_COUNT];
 extern int		DebugContinueOnOpenFailure;
 extern bool		log_keep_open;
+extern long long DebugAsyncBufferSize;
+extern int		DebugAsyncFlushInterval;
 extern char*	DebugTimeFormat;
 extern int		DebugLockIsMutex;
 extern char*	DebugLogDir;
@@ -354,6 +356,14 @@ dprintf_config( const char *subsys, struct dprintf_output_settings *p_info /* =
 		log_keep_open = param_boolean(pname, log_open_default);//dprintf_param_funcs->param_boolean(pname, log_open_default);
 	}
 
+	(void)snprintf(pname, sizeof(pname), "%s_LOG_ASYNC", subsys);
+	if (param_boolean(pname, false)) {
+		DebugAsyncBufferSize = (long long)param_integer("LOG_ASYNC_BUFFER_SIZE", 1024, 16, INT_MAX/1024) * 1024;
+		DebugAsyncFlushInterval = param_integer("LOG_ASYNC_FLUSH_INTERVAL", 100, 1, 10000);
+	} else {
+		DebugAsyncBufferSize = 0;
+	}
+
 	/*
 	If LOGS_USE_TIMESTAMP is enabled, we will print out Unix timestamps
 	instead of the standard date format in all the log messages
@@ -43,6 +43,10 @@ void dprintf_set_outputs(const struct dprintf_output_settings *p_info, int c_inf
 {
 	static int first_time = 1;
 
+	// the async log writer indexes its buffers by output, so it must
+	// write them out before the outputs change.
+	dprintf_stop_log_writer();
+
 	std::vector<DebugFileInfo> *debugLogsOld = DebugLogs;
 	DebugLogs = new std::vector<DebugFileInfo>();
 
@@ -205,6 +209,8 @@ void dprintf_set_outputs(const struct dprintf_output_settings *p_info, int c_inf
 		delete debugLogsOld;
 	}
 
+	dprintf_start_log_writer();
+
 	_condor_dprintf_saved_lines();
 }
 
@@ -50,6 +50,7 @@ int		_EXCEPT_Errno;
 const char	*_EXCEPT_File;
 int		(*_EXCEPT_Cleanup)(int,int,const char*);
 void	(*_EXCEPT_Reporter)(const char * msg, int line, const char * file) = NULL;
+void	(*_EXCEPT_Flush)(void) = NULL;
 
 extern int		_condor_dprintf_works;
 
@@ -86,6 +87,11 @@ _EXCEPT_(const char *fmt, ...)
 
 	va_end(pvar);
 
+	// don't lose the log messages that explain why we are going away
+	if( _EXCEPT_Flush ) {
+		(*_EXCEPT_Flush)();
+	}
+
 	if( _condor_except_should_dump_core ) {
 		abort();
 	}
@@ -1558,6 +1558,15 @@ bool stats_entry_ema_base<T>::HasEMAHorizonNamed(char const *horizon_name) const
 	return false;
 }
 
+// threads are given shards round robin as they first touch a thread safe probe,
+// so a small number of worker threads each get a shard of their own.
+unsigned int stats_entry_shard_index()
+{
+	static std::atomic<unsigned int> next_shard(0);
+	static thread_local unsigned int shard = next_shard.fetch_add(1, std::memory_order_relaxed) % STATS_ENTRY_SHARDS;
+	return shard;
+}
+
 // Force template instantiation
 // C++ note:
 // We used to have a dummy function that make various templated objects
@@ -1578,6 +1587,11 @@ template class stats_entry_recent_histogram<long long>;
 template class stats_entry_recent_histogram<long>;
 template class stats_entry_recent_histogram<int>;
 template class stats_entry_recent_histogram<double>;
+template class stats_entry_recent_ts<int>;
+template class stats_entry_recent_ts<int64_t>;
+template class stats_entry_recent_ts<double>;
+template class stats_entry_recent_histogram_ts<int64_t>;
+template class stats_entry_recent_histogram_ts<double>;
 template class stats_entry_ema_base<int>;
 template class stats_entry_ema_base<double>;
 template class stats_entry_ema_base<uint64_t>;
@@ -26,6 +26,7 @@
 //     * use stats_entry_recent<T> for probes that need a value and a recent value (i.e. number of jobs that have finished)
 //     * use stats_entry_probe<T>  for general statistics value (min,max,avg,std)
 //     * use stats_recent_counter_timer for runtime accumulators (int count, double runtime with overall and recent)
+//     * use stats_entry_recent_ts<T> or stats_entry_recent_histogram_ts<T> for probes that are updated from other threads
 //     * use stats_ema for exponential moving averages
 //     * use stats_sum_ema_rate for computing a running total and exponential moving averages of the rate of change
 //   * use Add() or Set() methods of the probes (+= and =) to update the probe
@@ -1466,6 +1467,141 @@ public:
    static FN_STATS_ENTRY_ADVANCE GetFnAdvance() { return (FN_STATS_ENTRY_ADVANCE)&stats_entry_recent_histogram<T>::AdvanceBy; };
 };
 
+// --------------------------------------------------------------------
+//  thread safe versions of the Recent probes
+//
+// Add() may be called from any thread, such as a WorkerPool worker. it only
+// does a relaxed atomic add to a shard picked by the calling thread, so
+// threads adding to the same probe do not take a lock or fight over a
+// cache line. the shards are folded into the probe by the thread that owns
+// it (usually the main thread) when it calls Publish, AdvanceBy or Clear, so
+// the published attributes are exactly those of the non-thread safe probe.
+// all other methods are main thread only, as they are for the base class.
+//
+#include <atomic>
+#include <memory>
+
+#define STATS_ENTRY_SHARDS 8
+// returns the shard [0,STATS_ENTRY_SHARDS) to be used by the calling thread
+unsigned int stats_entry_shard_index();
+
+template <typename T>
+class stats_entry_recent_ts : public stats_entry_recent<T> {
+public:
+   stats_entry_recent_ts(int cRecentMax=0) : stats_entry_recent<T>(cRecentMax) {}
+
+   // thread safe
+   void Add(T val) { shards[stats_entry_shard_index()].val.fetch_add(val, std::memory_order_relaxed); }
+   stats_entry_recent_ts<T>& operator+=(T val) { Add(val); return *this; }
+
+   // move the values added by other threads into the probe
+   void Fold() {
+      T sum(0);
+      for (auto & shard : shards) { sum += shard.val.exchange(0, std::memory_order_relaxed); }
+      if (sum != 0) { stats_entry_recent<T>::Add(sum); }
+   }
+
+   void Publish(ClassAd & ad, const char * pattr, int flags) const {
+      const_cast<stats_entry_recent_ts<T>*>(this)->Fold();
+      stats_entry_recent<T>::Publish(ad, pattr, flags);
+   }
+   void AdvanceBy(int cSlots) {
+      // values added since the last advance belong to the slot being retired
+      Fold();
+      stats_entry_recent<T>::AdvanceBy(cSlots);
+   }
+   void Clear() {
+      for (auto & shard : shards) { shard.val.store(0, std::memory_order_relaxed); }
+      stats_entry_recent<T>::Clear();
+   }
+
+   static FN_STATS_ENTRY_ADVANCE GetFnAdvance() { return (FN_STATS_ENTRY_ADVANCE)&stats_entry_recent_ts<T>::AdvanceBy; };
+   static void Delete(stats_entry_recent_ts<T> * probe) { delete probe; }
+
+private:
+   struct alignas(64) shard_t { std::atomic<T> val{0}; };
+   shard_t shards[STATS_ENTRY_SHARDS];
+};
+
+// set_levels must be called before any thread calls Add
+template <typename T>
+class stats_entry_recent_histogram_ts : public stats_entry_recent_histogram<T> {
+public:
+   stats_entry_recent_histogram_ts(const T* vlevels = 0, int num_levels = 0)
+      : stats_entry_recent_histogram<T>(vlevels, num_levels)
+   {
+      alloc_shards();
+   }
+
+   bool set_levels(const T* vlevels, int num_levels) {
+      bool ret = stats_entry_recent_histogram<T>::set_levels(vlevels, num_levels);
+      alloc_shards();
+      return ret;
+   }
+
+   // thread safe
+   T Add(T val) {
+      if ( ! shards[0]) return val;
+      int ix = 0;
+      while (ix < this->value.cLevels && val >= this->value.levels[ix])
+         ++ix;
+      shards[stats_entry_shard_index()][ix].fetch_add(1, std::memory_order_relaxed);
+      return val;
+   }
+   T operator+=(T val) { return Add(val); }
+
+   // move the values added by other threads into the probe
+   void Fold() {
+      if ( ! shards[0]) return;
+      stats_histogram<T> sum(this->value.levels, this->value.cLevels);
+      bool any = false;
+      for (auto & shard : shards) {
+         for (int ix = 0; ix <= sum.cLevels; ++ix) {
+            int cnt = shard[ix].exchange(0, std::memory_order_relaxed);
+            if (cnt) { sum.data[ix] += cnt; any = true; }
+         }
+      }
+      if ( ! any) return;
+      this->value.Accumulate(sum);
+      if (this->buf.MaxSize() > 0) {
+         if (this->buf.empty())
+            this->buf.PushZero();
+         if (this->buf[0].cLevels <= 0)
+            this->buf[0].set_levels(this->value.levels, this->value.cLevels);
+         this->buf[0].Accumulate(sum);
+      }
+      this->recent_dirty = true;
+   }
+
+   void Publish(ClassAd & ad, const char * pattr, int flags) {
+      Fold();
+      stats_entry_recent_histogram<T>::Publish(ad, pattr, flags);
+   }
+   void AdvanceBy(int cSlots) {
+      Fold();
+      stats_entry_recent_histogram<T>::AdvanceBy(cSlots);
+   }
+   void Clear() {
+      for (auto & shard : shards) {
+         if (shard) for (int ix = 0; ix <= this->value.cLevels; ++ix) shard[ix].store(0, std::memory_order_relaxed);
+      }
+      stats_entry_recent_histogram<T>::Clear();
+   }
+
+   static FN_STATS_ENTRY_ADVANCE GetFnAdvance() { return (FN_STATS_ENTRY_ADVANCE)&stats_entry_recent_histogram_ts<T>::AdvanceBy; };
+   static void Delete(stats_entry_recent_histogram_ts<T> * probe) { delete probe; }
+
+private:
+   void alloc_shards() {
+      if (shards[0] || this->value.cLevels <= 0) return;
+      for (auto & shard : shards) {
+         shard.reset(new std::atomic<int>[this->value.cLevels + 1]);
+         for (int ix = 0; ix <= this->value.cLevels; ++ix) shard[ix].store(0, std::memory_order_relaxed);
+      }
+   }
+   std::unique_ptr<std::atomic<int>[]> shards[STATS_ENTRY_SHARDS];
+};
+
 //-----------------------------------------------------------------------------
 // A statistics probe designed to keep track of accumulated running time
 // of a data set.  keeps a count of times that time was added and
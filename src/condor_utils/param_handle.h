@@ -0,0 +1,93 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2023, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+#ifndef _CONDOR_PARAM_HANDLE_H
+#define _CONDOR_PARAM_HANDLE_H
+
+#include "condor_config.h"
+
+#include <limits>
+#include <string>
+
+// A param_handle holds the parsed value of a single config knob and only does
+// the lookup, $() expansion and conversion again when the config has changed
+// (as indicated by param_generation()). Use it in place of param_integer() and
+// friends in code that runs once per job, match or update, typically as a
+// function static or a class member:
+//
+//   static param_handle<bool> use_global_prios("USE_GLOBAL_JOB_PRIOS", false);
+//   if (use_global_prios) { ... }
+//
+// The lookup is the same as the equivalent param_integer/param_boolean/etc call
+// with the same arguments, including the use of the default from the param table.
+// Like param() itself, get() is not thread safe and should only be called from
+// the main thread.
+//
+inline void param_handle_lookup(const char * name, int & value, int def, int min_value, int max_value) {
+	value = param_integer(name, def, min_value, max_value);
+}
+inline void param_handle_lookup(const char * name, long long & value, long long def, long long min_value, long long max_value) {
+	param_longlong(name, value, true, def, true, min_value, max_value);
+}
+inline void param_handle_lookup(const char * name, double & value, double def, double min_value, double max_value) {
+	value = param_double(name, def, min_value, max_value);
+}
+inline void param_handle_lookup(const char * name, bool & value, bool def, bool /*min_value*/, bool /*max_value*/) {
+	value = param_boolean(name, def);
+}
+inline void param_handle_lookup(const char * name, std::string & value, const std::string & def, const std::string & /*min_value*/, const std::string & /*max_value*/) {
+	if ( ! param(value, name, def.c_str())) { value = def; }
+}
+
+template <class T>
+class param_handle {
+public:
+	param_handle(const char * _name, const T & _def = T(),
+		const T & _min = std::numeric_limits<T>::lowest(),
+		const T & _max = (std::numeric_limits<T>::max)())
+		: knob(_name), def_value(_def), min_value(_min), max_value(_max), value(_def), generation(0)
+	{}
+
+	// returns the current value of the knob, looking it up again if the config has changed.
+	const T & get() {
+		unsigned int gen = param_generation();
+		if (gen != generation) {
+			generation = gen;
+			param_handle_lookup(knob, value, def_value, min_value, max_value);
+		}
+		return value;
+	}
+	operator const T &() { return get(); }
+
+	// force the next get() to do the lookup, for use when the default has changed.
+	void invalidate() { generation = 0; }
+	void set_default(const T & _def) { if ( ! (_def == def_value)) { def_value = _def; invalidate(); } }
+
+	const char * name() const { return knob; }
+
+private:
+	const char * knob;
+	T def_value;
+	T min_value;
+	T max_value;
+	T value;
+	unsigned int generation; // param_generation() when value was looked up, 0 for never
+};
+
+#endif // _CONDOR_PARAM_HANDLE_H
@@ -82,9 +82,13 @@ GCC_DIAG_OFF(float-equal)
 class DeltaClassAd
 {
 public:
-	DeltaClassAd(ClassAd & _ad) : ad(_ad) {}
+	DeltaClassAd(ClassAd & _ad) : ad(_ad), rec(NULL) {}
 	virtual ~DeltaClassAd() {};
 
+	// when set, every attribute inserted or assigned is also copied into the given ad
+	// whether or not it ends up in the underlying ad. used to compile proc templates
+	void record_into(ClassAd * _rec) { rec = _rec; }
+
 	bool Insert(const std::string & attr, ExprTree * tree);
 	bool Assign(const char* attr, bool val);
 	bool Assign(const char* attr, double val);
@@ -101,6 +105,7 @@ public:
 
 protected:
 	ClassAd& ad;
+	ClassAd* rec;
 
 	ExprTree * HasParentTree(const std::string & attr, classad::ExprTree::NodeKind kind);
 	const classad::Value * HasParentValue(const std::string & attr, classad::Value::ValueType vt);
@@ -139,6 +144,7 @@ const classad::Value * DeltaClassAd::HasParentValue(const std::string & attr, cl
 
 bool DeltaClassAd::Insert(const std::string & attr, ExprTree * tree)
 {
+	if (rec) rec->Insert(attr, tree->Copy());
 	ExprTree * t2 = HasParentTree(attr, tree->GetKind());
 	if (t2 && tree->SameAs(t2)) {
 		delete tree;
@@ -150,6 +156,7 @@ bool DeltaClassAd::Insert(const std::string & attr, ExprTree * tree)
 
 bool DeltaClassAd::Assign(const char* attr, bool val)
 {
+	if (rec) rec->Assign(attr, val);
 	bool bval = ! val;
 	const classad::Value * pval = HasParentValue(attr, classad::Value::BOOLEAN_VALUE);
 	if (pval && pval->IsBooleanValue(bval) && (val == bval)) {
@@ -161,6 +168,7 @@ bool DeltaClassAd::Assign(const char* attr, bool val)
 
 bool DeltaClassAd::Assign(const char* attr, double val)
 {
+	if (rec) rec->Assign(attr, val);
 	double dval = -val;
 	const classad::Value * pval = HasParentValue(attr, classad::Value::REAL_VALUE);
 	if (pval && pval->IsRealValue(dval) && (val == dval)) {
@@ -172,6 +180,7 @@ bool DeltaClassAd::Assign(const char* attr, double val)
 
 bool DeltaClassAd::Assign(const char* attr, long long val)
 {
+	if (rec) rec->Assign(attr, val);
 	long long ival = -val;
 	const classad::Value * pval = HasParentValue(attr, classad::Value::INTEGER_VALUE);
 	if (pval && pval->IsIntegerValue(ival) && (val == ival)) {
@@ -183,6 +192,7 @@ bool DeltaClassAd::Assign(const char* attr, long long val)
 
 bool DeltaClassAd::Assign(const char* attr, const char * val)
 {
+	if (rec) rec->Assign(attr, val);
 	const char * cstr = NULL;
 	const classad::Value * pval = HasParentValue(attr, classad::Value::STRING_VALUE);
 	if (val && pval && pval->IsStringValue(cstr) && cstr && (MATCH == strcmp(cstr, val))) {
@@ -534,6 +544,7 @@ SubmitHash::SubmitHash()
 	, already_warned_notification_never(false)
 	, already_warned_require_gpus(false)
 	, UseDefaultResourceParams(true)
+	, trackedKeys(NULL)
 	, s_method(1)
 {
 	SubmitMacroSet.initialize(CONFIG_OPT_WANT_META | CONFIG_OPT_KEEP_DEFAULTS | CONFIG_OPT_SUBMIT_SYNTAX);
@@ -921,6 +932,11 @@ char * SubmitHash::submit_param( const char* name, const char* alt_name ) const
 {
 	if (abort_code) return NULL;
 
+	if (trackedKeys) {
+		trackedKeys->insert(name);
+		if (alt_name) trackedKeys->insert(alt_name);
+	}
+
 	bool used_alt = false;
 	const char *pval = lookup_macro(name, const_cast<MACRO_SET&>(SubmitMacroSet), const_cast<MACRO_EVAL_CONTEXT&>(mctx));
 	char * pval_expanded = NULL;
@@ -995,6 +1011,7 @@ bool SubmitHash::submit_param_exists(const char* name, const char * alt_name, st
 void SubmitHash::set_submit_param( const char *name, const char *value )
 {
 	MACRO_EVAL_CONTEXT ctx = this->mctx; ctx.use_mask = 2;
+	mark_proc_template_stale(name, value);
 	insert_macro(name, value, SubmitMacroSet, DefaultMacro, ctx);
 }
 
@@ -1058,6 +1075,7 @@ int SubmitHash::submit_param_bool(const char* name, const char * alt_name, bool
 void SubmitHash::set_arg_variable(const char* name, const char * value)
 {
 	MACRO_EVAL_CONTEXT ctx = mctx; ctx.use_mask = 0;
+	mark_proc_template_stale(name, value);
 	insert_macro(name, value, SubmitMacroSet, ArgumentMacro, ctx);
 }
 
@@ -1076,6 +1094,7 @@ void SubmitHash::set_live_submit_variable( const char *name, const char *live_va
 	if ( ! pitem) {
 		insert_macro(name, "", SubmitMacroSet, LiveMacro, ctx);
 		pitem = find_macro_item(name, NULL, SubmitMacroSet);
+		procTemplate.clear(); // a new live variable changes what keys are per-proc
 	}
 	ASSERT(pitem);
 	pitem->raw_value = live_value;
@@ -1310,6 +1329,7 @@ void SubmitHash::clear()
 	SubmitMacroSet.apool.clear();
 	SubmitMacroSet.sources.clear();
 	setup_macro_defaults(); // setup a defaults table for the macro_set. have to re-do this because we cleared the apool
+	procTemplate.clear();
 }
 
 
@@ -2786,6 +2806,8 @@ int SubmitHash::SetForcedAttributes()
 			continue;
 		}
 
+		if (trackedKeys) trackedKeys->insert(hash_iter_key(it));
+
 		char * value = NULL;
 		if (raw_value && raw_value[0]) {
 			value = expand_macro(raw_value);
@@ -7874,6 +7896,7 @@ int SubmitHash::set_cluster_ad(ClassAd * ad)
 	job = NULL;
 	delete procAd;
 	procAd = NULL;
+	procTemplate.clear();
 
 	if ( ! ad) {
 		this->clusterAd = NULL;
@@ -7905,6 +7928,7 @@ int SubmitHash::init_base_ad(time_t submit_time_in, const char * username)
 	delete procAd; procAd = NULL;
 	baseJob.Clear();
 	base_job_is_cluster_ad = 0;
+	procTemplate.clear();
 
 	// set up types of the ad
 	SetMyTypeName (baseJob, JOB_ADTYPE);
@@ -8071,6 +8095,183 @@ bool SubmitHash::fold_job_into_base_ad(int cluster_id, ClassAd * jobad)
 }
 
 
+enum {
+	BUILD_STEP_READS_JOB = 0x01,    // step looks at job attributes that earlier steps may have assigned
+	BUILD_STEP_ALWAYS = 0x02,       // step is run for every proc, even when there is a proc template
+	BUILD_STEP_NOT_LATE_MAT = 0x04, // step is skipped when late materializing
+};
+
+const struct SubmitHash::_build_step * SubmitHash::BuildSteps(size_t & num_steps)
+{
+	static const struct _build_step steps[] = {
+		{ &SubmitHash::SetIWD, 0 },		// must be called very early
+
+		{ &SubmitHash::SetExecutable, BUILD_STEP_READS_JOB }, /* factory:ok */
+		{ &SubmitHash::SetArguments, 0 }, /* factory:ok */
+		{ &SubmitHash::SetGridParams, BUILD_STEP_READS_JOB }, /* factory:ok */
+		{ &SubmitHash::SetVMParams, BUILD_STEP_READS_JOB }, /* factory:ok */
+		{ &SubmitHash::SetJavaVMArgs, 0 }, /* factory:ok */
+		{ &SubmitHash::SetParallelParams, BUILD_STEP_READS_JOB }, /* factory:ok */
+
+		{ &SubmitHash::SetEnvironment, 0 }, /* factory:ok */
+
+		{ &SubmitHash::SetJobStatus, 0 }, /* run always, factory:ok as long as hold keyword isn't pruned */
+
+		{ &SubmitHash::SetTDP, 0 },	/* factory:ok as long as transfer fixed or tdp_cmd not pruned */ // before SetTransferFile() and SetRequirements()
+		{ &SubmitHash::SetStdin, BUILD_STEP_READS_JOB }, /* factory:ok */
+		{ &SubmitHash::SetStdout, BUILD_STEP_READS_JOB }, /* factory:ok */
+		{ &SubmitHash::SetStderr, BUILD_STEP_READS_JOB }, /* factory:ok */
+		{ &SubmitHash::SetGSICredentials, 0 }, /* factory:ok */
+
+		{ &SubmitHash::SetNotification, 0 }, /* factory:ok */
+		{ &SubmitHash::SetRank, 0 }, /* factory:ok */
+		{ &SubmitHash::SetPeriodicExpressions, 0 }, /* factory:ok */
+		{ &SubmitHash::SetLeaveInQueue, 0 }, /* factory:ok */
+		{ &SubmitHash::SetJobRetries, 0 }, /* factory:ok */
+		{ &SubmitHash::SetKillSig, 0 }, /* factory:ok  */
+
+		// Orthogonal to all other functions.  This position is arbitrary.
+		{ &SubmitHash::SetContainerSpecial, 0 },
+
+		{ &SubmitHash::SetRequestResources, BUILD_STEP_READS_JOB }, /* n attrs, prunable by pattern, factory:ok */
+		{ &SubmitHash::SetConcurrencyLimits, 0 }, /* 2 attrs, prunable, factory:ok */
+		{ &SubmitHash::SetAccountingGroup, 0 }, /* 3 attrs, prunable, factory:ok */
+		{ &SubmitHash::SetOAuth, 0 }, /* 1 attr, prunable, factory:ok */
+
+		{ &SubmitHash::SetSimpleJobExprs, 0 },
+		{ &SubmitHash::SetExtendedJobExprs, 0 },
+
+		{ &SubmitHash::SetJobDeferral, 0 }, /* 4 attrs, prunable */
+
+		{ &SubmitHash::SetImageSize, BUILD_STEP_READS_JOB },	/* run always, factory:ok */
+		{ &SubmitHash::SetTransferFiles, BUILD_STEP_READS_JOB }, /* run once if */
+
+		{ &SubmitHash::SetAutoAttributes, BUILD_STEP_READS_JOB },
+		{ &SubmitHash::ReportCommonMistakes, BUILD_STEP_READS_JOB },
+
+		// When we are NOT late materializing, set SUBMIT_ATTRS attributes that are +Attr or My.Attr second-to-last
+		{ &SubmitHash::SetForcedSubmitAttrs, BUILD_STEP_NOT_LATE_MAT },
+
+		// SetForcedAttributes should be last so that it trumps values
+		// set by normal submit attributes. it also sets the ProcId
+		{ &SubmitHash::SetForcedAttributes, BUILD_STEP_ALWAYS },
+
+		// process and validate JOBSET.* attributes
+		// and verify that the jobset membership request is valid (i.e. jobset memebership is a cluster attribute, not a job attribute)
+		{ &SubmitHash::ProcessJobsetAttributes, BUILD_STEP_ALWAYS | BUILD_STEP_READS_JOB },
+
+		// Must be called _after_ SetTransferFiles(), SetJobDeferral(),
+		// SetCronTab(), SetPerFileEncryption(), SetAutoAttributes().
+		// and after SetForcedAttributes()
+		{ &SubmitHash::SetRequirements, BUILD_STEP_READS_JOB },
+
+		// This must come after all things that modify the input file list
+		{ &SubmitHash::FixupTransferInputFiles, BUILD_STEP_READS_JOB },
+	};
+	num_steps = COUNTOF(steps);
+	return steps;
+}
+
+// returns true if the value of the submit key can be different for each proc in a cluster
+// because it is one of the per-proc variables or it refers to one, directly or indirectly.
+bool SubmitHash::key_is_per_proc(const char * key, classad::References & proc_vars)
+{
+	if (proc_vars.count(key)) {
+		return true;
+	}
+
+	MACRO_EVAL_CONTEXT ctx = mctx; ctx.use_mask = 0;
+	const char * raw_value = lookup_macro(key, SubmitMacroSet, ctx);
+	if ( ! raw_value || ! strchr(raw_value, '$')) {
+		return false;
+	}
+
+	// expand everything but the per-proc variables, if any expansions were skipped
+	// the value depends on them.
+	std::string value(raw_value);
+	return selective_expand_macro(value, proc_vars, SubmitMacroSet, ctx) != 0;
+}
+
+// called after building the first chained proc of a cluster with key tracking turned on.
+// step_keys has the submit keys looked up by each build step, we use them to decide which steps
+// must be re-run for each proc. A step must be re-run if any of its keys are per-proc, or if it reads
+// job attributes and some earlier step must be re-run.
+void SubmitHash::compile_proc_template(std::vector<classad::References> & step_keys)
+{
+	classad::References proc_vars;
+	proc_vars.insert("Process");
+	proc_vars.insert("ProcId");
+	proc_vars.insert("Step");
+	proc_vars.insert("Row");
+	proc_vars.insert("ItemIndex");
+	proc_vars.insert("Node");
+	proc_vars.insert("Item");
+
+	// the queue foreach variables are per-proc, $RANDOM_CHOICE and $RANDOM_INTEGER
+	// have a different value each time they are expanded, so we can't use a template at all.
+	bool has_random = false;
+	HASHITER it = hash_iter_begin(SubmitMacroSet, HASHITER_NO_DEFAULTS);
+	for ( ; ! hash_iter_done(it); hash_iter_next(it)) {
+		const char * key = hash_iter_key(it);
+		MACRO_META * pmeta = hash_iter_meta(it);
+		if (pmeta && pmeta->source_id == LiveMacro.id &&
+			strcasecmp(key, SUBMIT_KEY_Cluster) && strcasecmp(key, "ClusterId")) {
+			proc_vars.insert(key);
+		}
+		const char * val = hash_iter_value(it);
+		if (val && strstr(val, "$RANDOM_")) {
+			has_random = true;
+		}
+	}
+	hash_iter_delete(&it);
+
+	size_t num_steps = 0;
+	const struct _build_step * steps = BuildSteps(num_steps);
+	bool any_per_proc = has_random;
+	int num_rerun = 0;
+	for (size_t ix = 0; ix < num_steps; ++ix) {
+		bool per_proc = has_random || (any_per_proc && (steps[ix].flags & BUILD_STEP_READS_JOB));
+		for (auto key = step_keys[ix].begin(); ! per_proc && key != step_keys[ix].end(); ++key) {
+			per_proc = key_is_per_proc(key->c_str(), proc_vars);
+		}
+		any_per_proc = any_per_proc || per_proc;
+
+		_proc_template_step & step = procTemplate.steps[ix];
+		step.rerun = per_proc || (steps[ix].flags & BUILD_STEP_ALWAYS);
+		if (step.rerun) {
+			step.assigns.Clear();
+			++num_rerun;
+		}
+	}
+
+	procTemplate.cluster = jid.cluster;
+	procTemplate.universe = JobUniverse;
+	procTemplate.interactive = IsInteractiveJob;
+	procTemplate.remote = IsRemoteJob;
+	procTemplate.stale = false;
+	dprintf(D_FULLDEBUG, "Compiled proc template for cluster %d, %d of %d steps will be run for each proc\n",
+		jid.cluster, num_rerun, (int)num_steps);
+}
+
+// returns true if the proc template was compiled for the current cluster and nothing
+// that went into compiling it has changed since.
+bool SubmitHash::proc_template_is_current()
+{
+	return procTemplate.cluster == jid.cluster && ! procTemplate.stale &&
+		procTemplate.universe == JobUniverse &&
+		procTemplate.interactive == IsInteractiveJob && procTemplate.remote == IsRemoteJob;
+}
+
+// the submit keys can be changed between queue statements of the same cluster by set_submit_param
+// or set_arg_variable. build steps also set some keys, so only a new value makes the template stale.
+void SubmitHash::mark_proc_template_stale(const char * name, const char * value)
+{
+	MACRO_ITEM* pitem = find_macro_item(name, NULL, SubmitMacroSet);
+	if ( ! pitem || ! pitem->raw_value || ! value || strcmp(pitem->raw_value, value)) {
+		procTemplate.stale = true;
+	}
+}
+
 ClassAd* SubmitHash::make_job_ad (
 	JOB_ID_KEY job_id, // ClusterId and ProcId
 	int item_index, // Row or ItemIndex
@@ -8140,69 +8341,49 @@ ClassAd* SubmitHash::make_job_ad (
 	JobDisableFileChecks = submit_param_bool(SUBMIT_CMD_skip_filechecks, NULL, false);
 	//PRAGMA_REMIND("TODO: several bits of grid code are ignoring JobDisableFileChecks and bypassing FnCheckFile, check to see if that is kosher.")
 
-	SetIWD();		// must be called very early
-
-	SetExecutable(); /* factory:ok */
-	SetArguments(); /* factory:ok */
-	SetGridParams(); /* factory:ok */
-	SetVMParams(); /* factory:ok */
-	SetJavaVMArgs(); /* factory:ok */
-	SetParallelParams(); /* factory:ok */
-
-	SetEnvironment(); /* factory:ok */
-
-	SetJobStatus(); /* run always, factory:ok as long as hold keyword isn't pruned */
-
-	SetTDP();	/* factory:ok as long as transfer fixed or tdp_cmd not pruned */ // before SetTransferFile() and SetRequirements()
-	SetStdin(); /* factory:ok */
-	SetStdout(); /* factory:ok */
-	SetStderr(); /* factory:ok */
-	SetGSICredentials(); /* factory:ok */
+	size_t num_steps = 0;
+	const struct _build_step * steps = BuildSteps(num_steps);
 
-	SetNotification(); /* factory:ok */
-	SetRank(); /* factory:ok */
-	SetPeriodicExpressions(); /* factory:ok */
-	SetLeaveInQueue(); /* factory:ok */
-	SetJobRetries(); /* factory:ok */
-	SetKillSig(); /* factory:ok  */
-
-	// Orthogonal to all other functions.  This position is arbitrary.
-	SetContainerSpecial();
-
-	SetRequestResources(); /* n attrs, prunable by pattern, factory:ok */
-	SetConcurrencyLimits(); /* 2 attrs, prunable, factory:ok */
-	SetAccountingGroup(); /* 3 attrs, prunable, factory:ok */
-	SetOAuth(); /* 1 attr, prunable, factory:ok */
-
-	SetSimpleJobExprs();
-	SetExtendedJobExprs();
-
-	SetJobDeferral(); /* 4 attrs, prunable */
-
-	SetImageSize();	/* run always, factory:ok */
-	SetTransferFiles(); /* run once if */
-
-	SetAutoAttributes();
-	ReportCommonMistakes();
-
-		// When we are NOT late materializing, set SUBMIT_ATTRS attributes that are +Attr or My.Attr second-to-last
-	if ( ! clusterAd) { SetForcedSubmitAttrs(); }
-
-		// SetForcedAttributes should be last so that it trumps values
-		// set by normal submit attributes
-	SetForcedAttributes();
-
-		// process and validate JOBSET.* attributes
-		// and verify that the jobset membership request is valid (i.e. jobset memebership is a cluster attribute, not a job attribute)
-	ProcessJobsetAttributes();
+	// a proc that is chained to the cluster ad is built from the proc template if we have one for this cluster
+	// otherwise we compile the template while we build it.
+	bool use_template = false;
+	bool compile_template = false;
+	std::vector<classad::References> step_keys;
+	if (procAd->GetChainedParentAd()) {
+		if (proc_template_is_current()) {
+			use_template = true;
+		} else if (param_boolean("SUBMIT_USE_PROC_TEMPLATE", true)) {
+			compile_template = true;
+			procTemplate.clear();
+			procTemplate.steps.resize(num_steps);
+			step_keys.resize(num_steps);
+		}
+	}
 
-	// Must be called _after_ SetTransferFiles(), SetJobDeferral(),
-	// SetCronTab(), SetPerFileEncryption(), SetAutoAttributes().
-	// and after SetForcedAttributes()
-	SetRequirements();
+	for (size_t ix = 0; ix < num_steps; ++ix) {
+		if ((steps[ix].flags & BUILD_STEP_NOT_LATE_MAT) && clusterAd) {
+			continue;
+		}
+		if (use_template && ! procTemplate.steps[ix].rerun) {
+			// this step does not depend on anything that changes from proc to proc
+			// so just copy the attributes that it assigned when we compiled the template
+			for (auto & [attr, tree] : procTemplate.steps[ix].assigns) {
+				job->Insert(attr, tree->Copy());
+			}
+			continue;
+		}
+		if (compile_template) {
+			trackedKeys = &step_keys[ix];
+			job->record_into(&procTemplate.steps[ix].assigns);
+		}
+		(this->*(steps[ix].build))();
+		trackedKeys = NULL;
+		job->record_into(NULL);
+	}
 
-	// This must come after all things that modify the input file list
-	FixupTransferInputFiles();
+	if (compile_template && ! abort_code) {
+		compile_proc_template(step_keys);
+	}
 
 	// if we aborted in any of the steps above, then delete the job and return NULL.
 	if (abort_code) {
@@ -8899,6 +9080,7 @@ int SubmitHash::parse_file(FILE* fp, MACRO_SOURCE & source, std::string & errmsg
 	MACRO_EVAL_CONTEXT ctx = mctx; ctx.use_mask = 2;
 	MacroStreamYourFile ms(fp, source);
 
+	procTemplate.stale = true;
 	return Parse_macros(ms,
 		0, SubmitMacroSet, READ_MACROS_SUBMIT_SYNTAX,
 		&ctx, errmsg, parse_q, parse_pv);
@@ -8908,6 +9090,7 @@ int SubmitHash::parse_file(FILE* fp, MACRO_SOURCE & source, std::string & errmsg
 int SubmitHash::parse_mem(MacroStreamMemoryFile &fp, std::string & errmsg, FNSUBMITPARSE parse_q, void* parse_pv)
 {
 	MACRO_EVAL_CONTEXT ctx = mctx; ctx.use_mask = 2;
+	procTemplate.stale = true;
 	return Parse_macros(fp,
 		0, SubmitMacroSet, READ_MACROS_SUBMIT_SYNTAX,
 		&ctx, errmsg, parse_q, parse_pv);
@@ -8916,6 +9099,7 @@ int SubmitHash::parse_mem(MacroStreamMemoryFile &fp, std::string & errmsg, FNSUB
 
 int SubmitHash::process_q_line(MACRO_SOURCE & source, char* line, std::string & errmsg, FNSUBMITPARSE parse_q, void* parse_pv)
 {
+	procTemplate.stale = true;
 	return parse_q(parse_pv, source, SubmitMacroSet, line, errmsg);
 }
 
@@ -8948,6 +9132,7 @@ int SubmitHash::parse_up_to_q_line(MacroStream &ms, std::string & errmsg, char**
 
 	//PRAGMA_REMIND("move firstread (used by Parse_macros) and at_eof() into MacroStream class")
 
+	procTemplate.stale = true;
 	int err = Parse_macros(ms,
 		0, SubmitMacroSet, READ_MACROS_SUBMIT_SYNTAX,
 		&ctx, errmsg, parse_q_callback, &args);
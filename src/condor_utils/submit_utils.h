@@ -620,6 +620,7 @@ public:
 		jid.cluster = 0; jid.proc = 0;
 		clusterAd = NULL;
 		base_job_is_cluster_ad = 0;
+		procTemplate.clear();
 	}
 
 	int AssignJobExpr (const char *attr, const char * expr, const char * source_label=NULL);
@@ -660,7 +661,7 @@ public:
 	// job needs the countMatches classad function to match
 	bool NeedsCountMatchesFunc() const { return HasRequireResAttr; };
 
-	MACRO_SET& macros() { return SubmitMacroSet; }
+	MACRO_SET& macros() { procTemplate.stale = true; return SubmitMacroSet; } // the caller may change the submit keys
 	int getUniverse() const  { return JobUniverse; }
 	int getClusterId() const { return jid.cluster; }
 	int getProcId() const    { return jid.proc; }
@@ -751,6 +752,37 @@ protected:
 	};
 	const struct _build_job_attrs* SaBuild();
 
+	// the steps that make_job_ad runs to build a job, in the order that they must be run.
+	struct _build_step {
+		int (SubmitHash::*build)();
+		int flags; // BUILD_STEP_* flags
+	};
+	static const struct _build_step* BuildSteps(size_t & num_steps);
+
+	// the proc template is compiled while building the first proc of a cluster that is chained to
+	// the cluster ad. For each build step it records whether the step must be re-run for each proc
+	// because it depends on per-proc values, and if not, the job attributes that the step assigned.
+	// later procs of the cluster copy those attributes rather than re-running the step.
+	struct _proc_template_step {
+		bool rerun{true};
+		ClassAd assigns;
+	};
+	struct _proc_template {
+		int cluster{0}; // the cluster the template is for, 0 if there is no template
+		int universe{0};
+		bool interactive{false};
+		bool remote{false};
+		// set when the submit keys change after the template was compiled (i.e. between queue statements)
+		bool stale{false};
+		std::vector<_proc_template_step> steps;
+		void clear() { cluster = 0; steps.clear(); }
+	} procTemplate;
+	bool proc_template_is_current();
+	void mark_proc_template_stale(const char * name, const char * value);
+	mutable classad::References * trackedKeys; // when not NULL, submit_param adds the names it looks up to this set
+	bool key_is_per_proc(const char * key, classad::References & proc_vars);
+	void compile_proc_template(std::vector<classad::References> & step_keys);
+
 	// worker functions that build up the job from the hashtable
 	// they pass data between themselves by setting class variables
 	// so the must be called in a specific order.
@@ -0,0 +1,122 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2023, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+// Sends messages of various sizes over a local socket pair with and
+// without AES-GCM encryption, checks that they arrive intact, and times
+// the throughput of each.
+//
+// usage: test_cedar_aesgcm [-v] [megabytes]
+
+#include "condor_common.h"
+#include "condor_debug.h"
+#include "reli_sock.h"
+#include "CryptKey.h"
+
+#include <stdio.h>
+#include <thread>
+#include <vector>
+
+bool verbose = false;
+#define REQUIRE( condition ) \
+	if(! ( condition )) { \
+		fprintf( stderr, "Failed requirement '%s' on line %d.\n", #condition, __LINE__ ); \
+		return 1; \
+	} else if( verbose ) { \
+		fprintf( stdout, "Passed requirement '%s' on line %d.\n", #condition, __LINE__ ); \
+	}
+
+// fill a message with bytes that depend on the message number, so that
+// dropped, reordered or corrupted data is noticed by the receiver
+static void fill_message(std::vector<unsigned char> & msg, int num)
+{
+	for (size_t ix = 0; ix < msg.size(); ++ix) {
+		msg[ix] = (unsigned char)(ix * 31 + num);
+	}
+}
+
+// send num_msgs messages of msg_size bytes from one end of a socket pair to
+// the other, returns 0 on success and the throughput in MB/s in mbps.
+static int run(KeyInfo * key, int msg_size, int num_msgs, double & mbps)
+{
+	int fds[2];
+	REQUIRE( socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0 );
+
+	ReliSock sender, receiver;
+	sender.assignDomainSocket(fds[0]);
+	receiver.assignDomainSocket(fds[1]);
+	if (key) {
+		REQUIRE( sender.set_crypto_key(true, key) );
+		REQUIRE( receiver.set_crypto_key(true, key) );
+	}
+
+	bool send_ok = true;
+	double dstart = _condor_debug_get_time_double();
+	std::thread th([&sender, &send_ok, msg_size, num_msgs]() {
+		std::vector<unsigned char> msg(msg_size);
+		sender.encode();
+		for (int num = 0; num < num_msgs && send_ok; ++num) {
+			fill_message(msg, num);
+			send_ok = sender.put_bytes(msg.data(), msg_size) == msg_size && sender.end_of_message();
+		}
+	});
+
+	bool recv_ok = true;
+	std::vector<unsigned char> msg(msg_size), expected(msg_size);
+	receiver.decode();
+	for (int num = 0; num < num_msgs && recv_ok; ++num) {
+		recv_ok = receiver.get_bytes(msg.data(), msg_size) == msg_size && receiver.end_of_message();
+		fill_message(expected, num);
+		recv_ok = recv_ok && msg == expected;
+	}
+	th.join();
+	double elapsed = _condor_debug_get_time_double() - dstart;
+
+	REQUIRE( send_ok );
+	REQUIRE( recv_ok );
+	mbps = ((double)msg_size * num_msgs) / (1024.0 * 1024.0) / elapsed;
+	return 0;
+}
+
+int main( int argc, char ** argv ) {
+	int megabytes = 256;
+	for (int ix = 1; ix < argc; ++ix) {
+		if (strcmp(argv[ix], "-v") == 0) { verbose = true; }
+		else { megabytes = atoi(argv[ix]); }
+	}
+
+	unsigned char key_data[32];
+	for (int ix = 0; ix < (int)sizeof(key_data); ++ix) { key_data[ix] = (unsigned char)(ix * 7 + 1); }
+	KeyInfo key(key_data, sizeof(key_data), CONDOR_AESGCM, 0);
+
+	// sizes that fall on either side of the old and new packet sizes
+	const int sizes[] = { 100, 4096, 4097, 65536, 65537, 256*1024, 1024*1024 };
+	for (int msg_size : sizes) {
+		int num_msgs = (int)(((long long)megabytes * 1024 * 1024) / msg_size);
+		if (num_msgs < 1) { num_msgs = 1; }
+		if (num_msgs > 200000) { num_msgs = 200000; }
+
+		double plain_mbps = 0, aes_mbps = 0;
+		if (run(NULL, msg_size, num_msgs, plain_mbps)) { return 1; }
+		if (run(&key, msg_size, num_msgs, aes_mbps)) { return 1; }
+		printf("%8d byte messages x %6d: plain %8.1f MB/s, aes-gcm %8.1f MB/s\n",
+			msg_size, num_msgs, plain_mbps, aes_mbps);
+	}
+
+	return 0;
+}
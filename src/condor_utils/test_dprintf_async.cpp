@@ -0,0 +1,142 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2023, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+// Checks that the async log writer (<SUBSYS>_LOG_ASYNC) writes every message
+// exactly once, rotates the log, survives fork and flushes at exit, and times
+// dprintf with and without it.
+//
+// usage: test_dprintf_async [-v] [num_messages]
+
+#include "condor_common.h"
+#include "condor_debug.h"
+#include "condor_config.h"
+#include "subsystem_info.h"
+
+#include <stdio.h>
+#include <fstream>
+
+bool verbose = false;
+#define REQUIRE( condition ) \
+	if(! ( condition )) { \
+		fprintf( stderr, "Failed requirement '%s' on line %d.\n", #condition, __LINE__ ); \
+		return 1; \
+	} else if( verbose ) { \
+		fprintf( stdout, "Passed requirement '%s' on line %d.\n", #condition, __LINE__ ); \
+	}
+
+// count the lines in the file that contain the given text
+static int count_lines(const std::string & file, const char * text)
+{
+	std::ifstream in(file);
+	std::string line;
+	int count = 0;
+	while (std::getline(in, line)) {
+		if (line.find(text) != std::string::npos) { ++count; }
+	}
+	return count;
+}
+
+static void configure(const std::string & log, bool async, const char * max_log = "0")
+{
+	param_insert("TEST_DPRINTF_ASYNC_LOG", log.c_str());
+	param_insert("TEST_DPRINTF_ASYNC_LOG_ASYNC", async ? "true" : "false");
+	param_insert("MAX_TEST_DPRINTF_ASYNC_LOG", max_log);
+	dprintf_config("TEST_DPRINTF_ASYNC");
+}
+
+static double log_messages(const char * tag, int num_messages)
+{
+	double dstart = _condor_debug_get_time_double();
+	for (int ix = 0; ix < num_messages; ++ix) {
+		dprintf(D_ALWAYS, "%s message %d of %d, with some more text to make it a typical length\n", tag, ix, num_messages);
+	}
+	return _condor_debug_get_time_double() - dstart;
+}
+
+int main( int argc, char ** argv ) {
+	int num_messages = 200000;
+	for (int ix = 1; ix < argc; ++ix) {
+		if (strcmp(argv[ix], "-v") == 0) { verbose = true; }
+		else { num_messages = atoi(argv[ix]); }
+	}
+
+	char dir[] = "/tmp/test_dprintf_asyncXXXXXX";
+	REQUIRE( mkdtemp(dir) != NULL );
+	std::string sync_log = std::string(dir) + "/SyncLog";
+	std::string async_log = std::string(dir) + "/AsyncLog";
+	std::string rotate_log = std::string(dir) + "/RotateLog";
+	std::string fork_log = std::string(dir) + "/ForkLog";
+
+	set_mySubSystem("TEST_DPRINTF_ASYNC", false, SUBSYSTEM_TYPE_TOOL);
+	param_insert("LOG", dir);
+	param_insert("LOG_ASYNC_FLUSH_INTERVAL", "20");
+
+	configure(sync_log, false);
+	double sync_secs = log_messages("sync", num_messages);
+	REQUIRE( count_lines(sync_log, "sync message") == num_messages );
+
+	configure(async_log, true);
+	double async_secs = log_messages("async", num_messages);
+	dprintf_flush_log_writer();
+	REQUIRE( count_lines(async_log, "async message") == num_messages );
+
+	// messages are written by the writer thread without a flush, in order
+	dprintf(D_ALWAYS, "async last message\n");
+	sleep(1);
+	REQUIRE( count_lines(async_log, "async last message") == 1 );
+
+	// the log is still rotated, a batch at a time
+	configure(rotate_log, true, "100000");
+	log_messages("rotate", 20000);
+	dprintf_flush_log_writer();
+	struct stat st;
+	REQUIRE( stat((rotate_log + ".old").c_str(), &st) == 0 );
+	REQUIRE( stat(rotate_log.c_str(), &st) == 0 && st.st_size < 100000 + 1024*1024 );
+
+	// a forked child writes synchronously and does not write what the parent had pending,
+	// a child that starts its own writer has it flushed by exit()
+	configure(fork_log, true);
+	dprintf(D_ALWAYS, "parent before fork\n");
+	pid_t pid = fork();
+	if (pid == 0) {
+		dprintf(D_ALWAYS, "child without writer\n");
+		configure(fork_log, true);
+		log_messages("child", 1000);
+		exit(0);
+	}
+	REQUIRE( pid > 0 );
+	int status = 0;
+	REQUIRE( waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0 );
+	dprintf_flush_log_writer();
+	REQUIRE( count_lines(fork_log, "parent before fork") == 1 );
+	REQUIRE( count_lines(fork_log, "child without writer") == 1 );
+	REQUIRE( count_lines(fork_log, "child message") == 1000 );
+
+	configure("2>", false);
+	unlink(sync_log.c_str());
+	unlink(async_log.c_str());
+	unlink(rotate_log.c_str());
+	unlink((rotate_log + ".old").c_str());
+	unlink(fork_log.c_str());
+	rmdir(dir);
+
+	printf("%d messages: sync %.3fs (%.0f/s), async %.3fs (%.0f/s)\n", num_messages,
+		sync_secs, num_messages / sync_secs, async_secs, num_messages / async_secs);
+	return 0;
+}
@@ -0,0 +1,133 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2023, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+// Checks that SecMan::WriteSessionSnapshot and ReadSessionSnapshot restore
+// the sessions that should survive a restart, and drop the rest.
+//
+// usage: test_session_snapshot [-v] [num_sessions]
+
+#include "condor_common.h"
+#include "condor_debug.h"
+#include "condor_config.h"
+#include "condor_attributes.h"
+#include "condor_secman.h"
+#include "KeyCache.h"
+#include "secure_file.h"
+
+#include <stdio.h>
+
+bool verbose = false;
+#define REQUIRE( condition ) \
+	if(! ( condition )) { \
+		fprintf( stderr, "Failed requirement '%s' on line %d.\n", #condition, __LINE__ ); \
+		return 1; \
+	} else if( verbose ) { \
+		fprintf( stdout, "Passed requirement '%s' on line %d.\n", #condition, __LINE__ ); \
+	}
+
+static void add_session(SecMan & secman, const std::string & id, const char * addr, bool negotiated, int expiration, const char * token_id = NULL)
+{
+	unsigned char key_data[32];
+	for (int ix = 0; ix < 32; ++ix) { key_data[ix] = (unsigned char)(id.size() + ix); }
+	std::vector<KeyInfo*> keys;
+	keys.push_back(new KeyInfo(key_data, 32, CONDOR_AESGCM, 0));
+	keys.push_back(new KeyInfo(key_data, 24, CONDOR_BLOWFISH, 0));
+
+	ClassAd policy;
+	policy.Assign(ATTR_SEC_NEGOTIATED_SESSION, negotiated);
+	policy.Assign(ATTR_SEC_USER, "condor@pool");
+	policy.Assign(ATTR_SEC_SID, id);
+	if (token_id) { policy.Assign(ATTR_TOKEN_ID, token_id); }
+
+	KeyCacheEntry entry(id, addr, keys, &policy, expiration, 3600);
+	secman.session_cache->insert(entry);
+}
+
+int main( int argc, char ** argv ) {
+	int num_sessions = 10000;
+	for (int ix = 1; ix < argc; ++ix) {
+		if (strcmp(argv[ix], "-v") == 0) { verbose = true; }
+		else { num_sessions = atoi(argv[ix]); }
+	}
+
+	char dir[] = "/tmp/test_session_snapshotXXXXXX";
+	REQUIRE( mkdtemp(dir) != NULL );
+	std::string signing_key = std::string(dir) + "/POOL";
+	std::string snapshot = std::string(dir) + "/sessions";
+	const char pool_key[] = "not a very secret signing key";
+	REQUIRE( write_secure_file(signing_key.c_str(), pool_key, sizeof(pool_key)-1, false) );
+	param_insert("SEC_TOKEN_POOL_SIGNING_KEY_FILE", signing_key.c_str());
+	param_insert("SEC_TOKEN_REVOCATION_EXPR", "jti == \"revoked\"");
+
+	SecMan secman;
+	secman.session_cache->clear();
+	time_t now = time(NULL);
+	add_session(secman, "good", "", true, now + 3600);
+	add_session(secman, "good_token", "", true, now + 3600, "fine");
+	add_session(secman, "revoked_token", "", true, now + 3600, "revoked");
+	add_session(secman, "outgoing", "<127.0.0.1:9618>", true, now + 3600);
+	add_session(secman, "family", "", false, 0);
+	add_session(secman, "expiring", "", true, now + 10);
+	for (int ix = 0; ix < num_sessions; ++ix) {
+		add_session(secman, "bulk" + std::to_string(ix), "", true, now + 3600);
+	}
+
+	double dstart = _condor_debug_get_time_double();
+	REQUIRE( secman.WriteSessionSnapshot(snapshot.c_str()) == num_sessions + 3 );
+	double write_secs = _condor_debug_get_time_double() - dstart;
+
+	// the daemon restarts...
+	secman.session_cache->clear();
+	dstart = _condor_debug_get_time_double();
+	REQUIRE( secman.ReadSessionSnapshot(snapshot.c_str()) == num_sessions + 2 );
+	double read_secs = _condor_debug_get_time_double() - dstart;
+
+	KeyCacheEntry * entry = NULL;
+	REQUIRE( secman.session_cache->lookup("good", entry) );
+	REQUIRE( entry->key(CONDOR_AESGCM) && entry->key(CONDOR_AESGCM)->getKeyLength() == 32 );
+	REQUIRE( entry->key(CONDOR_BLOWFISH) && entry->key(CONDOR_BLOWFISH)->getKeyLength() == 24 );
+	REQUIRE( memcmp(entry->key(CONDOR_AESGCM)->getKeyData(), entry->key(CONDOR_BLOWFISH)->getKeyData(), 24) == 0 );
+	REQUIRE( entry->key()->getProtocol() == CONDOR_AESGCM );
+	REQUIRE( entry->lifetimeExpiration() == now + 3600 );
+	std::string user;
+	REQUIRE( entry->policy() && entry->policy()->LookupString(ATTR_SEC_USER, user) && user == "condor@pool" );
+	REQUIRE( secman.session_cache->lookup("good_token", entry) );
+	REQUIRE( ! secman.session_cache->lookup("revoked_token", entry) );
+	REQUIRE( ! secman.session_cache->lookup("outgoing", entry) );
+	REQUIRE( ! secman.session_cache->lookup("family", entry) );
+	REQUIRE( ! secman.session_cache->lookup("expiring", entry) );
+
+	// the snapshot is only good for one restart
+	REQUIRE( access(snapshot.c_str(), F_OK) != 0 );
+	REQUIRE( secman.ReadSessionSnapshot(snapshot.c_str()) == -1 );
+
+	// a snapshot written with a different signing key is ignored
+	REQUIRE( secman.WriteSessionSnapshot(snapshot.c_str()) == num_sessions + 2 );
+	const char other_key[] = "a different signing key";
+	REQUIRE( replace_secure_file(signing_key.c_str(), ".tmp", other_key, sizeof(other_key)-1, false) );
+	secman.session_cache->clear();
+	REQUIRE( secman.ReadSessionSnapshot(snapshot.c_str()) == -1 );
+	REQUIRE( secman.session_cache->count() == 0 );
+
+	unlink(signing_key.c_str());
+	rmdir(dir);
+
+	printf("%d sessions: write %.3fs, read %.3fs\n", num_sessions + 2, write_secs, read_secs);
+	return 0;
+}
@@ -0,0 +1,135 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2023, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+// Checks that the thread safe statistics probes publish the same attributes
+// as the plain probes when they are updated from many threads, and times
+// the updates.
+//
+// usage: test_stats_threads [-v] [adds_per_thread]
+
+#include "condor_common.h"
+#include "condor_debug.h"
+#include "condor_classad.h"
+#include "generic_stats.h"
+
+#include <stdio.h>
+#include <thread>
+#include <vector>
+
+bool verbose = false;
+#define REQUIRE( condition ) \
+	if(! ( condition )) { \
+		fprintf( stderr, "Failed requirement '%s' on line %d.\n", #condition, __LINE__ ); \
+		return 1; \
+	} else if( verbose ) { \
+		fprintf( stdout, "Passed requirement '%s' on line %d.\n", #condition, __LINE__ ); \
+	}
+
+static const double levels[] = { 0.001, 0.01, 0.1, 1.0 };
+static const int num_threads = 8;
+
+static double sample(int thread, int ix) { return (double)((thread + ix) % 5) * 0.005; }
+
+static bool same_attr(ClassAd & a, ClassAd & b, const char * attr)
+{
+	std::string sa, sb;
+	ExprTree * ea = a.Lookup(attr);
+	ExprTree * eb = b.Lookup(attr);
+	if ( ! ea || ! eb) { return false; }
+	sa = ExprTreeToString(ea);
+	sb = ExprTreeToString(eb);
+	if (verbose) { printf("%s = %s / %s\n", attr, sa.c_str(), sb.c_str()); }
+	return sa == sb;
+}
+
+int main( int argc, char ** argv ) {
+	int num_adds = 1000000;
+	for (int ix = 1; ix < argc; ++ix) {
+		if (strcmp(argv[ix], "-v") == 0) { verbose = true; }
+		else { num_adds = atoi(argv[ix]); }
+	}
+
+	stats_entry_recent<int> count(4);
+	stats_entry_recent_histogram<double> hist(levels, COUNTOF(levels));
+	hist.SetRecentMax(4);
+	stats_entry_recent_ts<int> count_ts(4);
+	stats_entry_recent_histogram_ts<double> hist_ts(levels, COUNTOF(levels));
+	hist_ts.SetRecentMax(4);
+
+	// the same samples, on one thread into the plain probes and on many
+	// threads into the thread safe ones, advancing the recent window between rounds
+	double ts_secs = 0;
+	for (int round = 0; round < 3; ++round) {
+		for (int th = 0; th < num_threads; ++th) {
+			for (int ix = 0; ix < num_adds; ++ix) {
+				count += 1;
+				hist += sample(th, ix);
+			}
+		}
+
+		double dstart = _condor_debug_get_time_double();
+		std::vector<std::thread> threads;
+		for (int th = 0; th < num_threads; ++th) {
+			threads.emplace_back([&count_ts, &hist_ts, th, num_adds]() {
+				for (int ix = 0; ix < num_adds; ++ix) {
+					count_ts += 1;
+					hist_ts += sample(th, ix);
+				}
+			});
+		}
+		for (auto & th : threads) { th.join(); }
+		ts_secs += _condor_debug_get_time_double() - dstart;
+
+		count.AdvanceBy(1);
+		hist.AdvanceBy(1);
+		count_ts.AdvanceBy(1);
+		hist_ts.AdvanceBy(1);
+	}
+
+	// some adds that have not been folded yet when we publish
+	count += 7; count_ts += 7;
+	hist += 0.5; hist_ts += 0.5;
+
+	ClassAd ad, ad_ts;
+	count.Publish(ad, "Count", count.PubDefault);
+	hist.Publish(ad, "Hist", hist.PubDefault);
+	count_ts.Publish(ad_ts, "Count", count_ts.PubDefault);
+	hist_ts.Publish(ad_ts, "Hist", hist_ts.PubDefault);
+
+	REQUIRE( count.value == num_threads * num_adds * 3 + 7 );
+	REQUIRE( same_attr(ad, ad_ts, "Count") );
+	REQUIRE( same_attr(ad, ad_ts, "RecentCount") );
+	REQUIRE( same_attr(ad, ad_ts, "Hist") );
+	REQUIRE( same_attr(ad, ad_ts, "RecentHist") );
+
+	// Clear drops adds that were not yet folded
+	count_ts += 3;
+	hist_ts += 0.5;
+	count_ts.Clear();
+	hist_ts.Clear();
+	ClassAd cleared;
+	count_ts.Publish(cleared, "Count", count_ts.PubDefault);
+	int value = -1;
+	REQUIRE( cleared.LookupInteger("Count", value) && value == 0 );
+	REQUIRE( hist_ts.value.data[0] == 0 && hist_ts.value.data[4] == 0 );
+
+	printf("%d threads x %d adds x 3 rounds: %.3fs (%.0f adds/s)\n", num_threads, num_adds,
+		ts_secs, (3.0 * num_threads * num_adds) / ts_secs);
+	return 0;
+}
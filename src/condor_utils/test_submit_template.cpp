@@ -0,0 +1,163 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2023, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+// Checks that the jobs SubmitHash builds from a proc template are the same as the
+// jobs it builds by running every submit command, including when the submit
+// commands change between the queue statements of a cluster.
+//
+// usage: test_submit_template [-v] [procs_per_queue]
+
+#include "condor_common.h"
+#include "condor_debug.h"
+#include "condor_config.h"
+#include "condor_attributes.h"
+#include "submit_utils.h"
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+bool verbose = false;
+#define REQUIRE( condition ) \
+	if(! ( condition )) { \
+		fprintf( stderr, "Failed requirement '%s' on line %d.\n", #condition, __LINE__ ); \
+		return 1; \
+	} else if( verbose ) { \
+		fprintf( stdout, "Passed requirement '%s' on line %d.\n", #condition, __LINE__ ); \
+	}
+
+static const char * submit_text =
+	"executable = /bin/true\n"
+	"universe = vanilla\n"
+	"request_memory = 100\n"
+	"arguments = first\n"
+	"output = out.txt\n"
+	"queue\n"
+	"arguments = second\n"
+	"output = out2.txt\n"
+	"queue\n"
+	"output = out$(Process).txt\n"
+	"queue\n";
+
+// the job as the schedd would see it, the proc ad flattened onto the cluster ad
+// less the attributes that change from one call to the next
+static void flatten_job(ClassAd * job, std::string & out)
+{
+	ClassAd ad;
+	if (job->GetChainedParentAd()) { ad.Update(*job->GetChainedParentAd()); }
+	ad.Update(*job);
+	ad.Delete(ATTR_Q_DATE);
+	ad.Delete(ATTR_ENTERED_CURRENT_STATUS);
+	out.clear();
+	sPrintAd(out, ad);
+}
+
+// builds procs_per_queue jobs for each queue statement of submit_text into one cluster.
+// after every queue statement a value is also changed with set_submit_param
+// the way the python bindings do, and another with set_arg_variable.
+static int build_cluster(bool use_template, int procs_per_queue, std::vector<std::string> & jobs)
+{
+	param_insert("SUBMIT_USE_PROC_TEMPLATE", use_template ? "true" : "false");
+
+	SubmitHash hash;
+	hash.init(JSM_CONDOR_SUBMIT);
+	hash.setDisableFileChecks(true);
+	hash.init_base_ad(1700000000, "tester");
+
+	MACRO_SOURCE source;
+	hash.insert_source("test_submit_template", source);
+	MacroStreamMemoryFile ms(submit_text, -1, source);
+
+	jobs.clear();
+	int proc = 0;
+	for (int queue_num = 0; ; ++queue_num) {
+		std::string errmsg;
+		char * qline = NULL;
+		REQUIRE(hash.parse_up_to_q_line(ms, errmsg, &qline) == 0);
+		if ( ! qline) break;
+
+		for (int step = 0; step < procs_per_queue; ++step) {
+			if (step == 1) {
+				char rank[32];
+				snprintf(rank, sizeof(rank), "%d", queue_num);
+				hash.set_submit_param("rank", rank);
+			} else if (step == 2) {
+				char memory[32];
+				snprintf(memory, sizeof(memory), "%d", 200 + queue_num);
+				hash.set_arg_variable("request_memory", memory);
+			}
+			ClassAd * job = hash.make_job_ad(JOB_ID_KEY(1, proc), proc, step, false, false, NULL, NULL);
+			REQUIRE(job != NULL);
+			jobs.emplace_back();
+			flatten_job(job, jobs.back());
+			++proc;
+		}
+	}
+	return 0;
+}
+
+static int check_attr(const std::string & job, const char * attr, const char * value)
+{
+	std::string line(attr); line += " = "; line += value; line += "\n";
+	if (job.find(line) == std::string::npos) {
+		fprintf(stderr, "expected %s", line.c_str());
+		return 1;
+	}
+	return 0;
+}
+
+int main( int argc, char ** argv ) {
+	int procs_per_queue = 3;
+	for (int ix = 1; ix < argc; ++ix) {
+		if (strcmp(argv[ix], "-v") == 0) { verbose = true; }
+		else { procs_per_queue = atoi(argv[ix]); }
+	}
+	if (procs_per_queue < 3) procs_per_queue = 3;
+
+	config_ex(CONFIG_OPT_NO_EXIT | CONFIG_OPT_WANT_META);
+
+	std::vector<std::string> templated, untemplated;
+	REQUIRE(build_cluster(true, procs_per_queue, templated) == 0);
+	REQUIRE(build_cluster(false, procs_per_queue, untemplated) == 0);
+	REQUIRE(templated.size() == (size_t)(3 * procs_per_queue));
+	REQUIRE(templated.size() == untemplated.size());
+
+	for (size_t ix = 0; ix < templated.size(); ++ix) {
+		if (templated[ix] != untemplated[ix]) {
+			fprintf(stderr, "job %d differs with and without the template\n%s\n----\n%s\n",
+				(int)ix, templated[ix].c_str(), untemplated[ix].c_str());
+		}
+		REQUIRE(templated[ix] == untemplated[ix]);
+	}
+
+	// the jobs of each queue statement see the submit commands that precede it
+	int last = 3 * procs_per_queue - 1;
+	REQUIRE(check_attr(templated[procs_per_queue - 1], ATTR_JOB_ARGUMENTS1, "\"first\"") == 0);
+	REQUIRE(check_attr(templated[procs_per_queue - 1], ATTR_JOB_OUTPUT, "\"out.txt\"") == 0);
+	REQUIRE(check_attr(templated[procs_per_queue], ATTR_JOB_ARGUMENTS1, "\"second\"") == 0);
+	REQUIRE(check_attr(templated[procs_per_queue + 1], ATTR_JOB_OUTPUT, "\"out2.txt\"") == 0);
+	REQUIRE(check_attr(templated[procs_per_queue + 1], ATTR_RANK, "1") == 0);
+	std::string out; formatstr(out, "\"out%d.txt\"", last);
+	REQUIRE(check_attr(templated[last], ATTR_JOB_OUTPUT, out.c_str()) == 0);
+	REQUIRE(check_attr(templated[last], ATTR_RANK, "2") == 0);
+	REQUIRE(check_attr(templated[last], ATTR_REQUEST_MEMORY, "202") == 0);
+	REQUIRE(check_attr(templated[procs_per_queue + 1], ATTR_REQUEST_MEMORY, "200") == 0);
+
+	return 0;
+}
@@ -0,0 +1,187 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2023, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+// Checks the ordering semantics of the DaemonCore TimerManager and
+// times creating, resetting, firing and cancelling a large number of timers.
+//
+// usage: test_timer_manager [-v] [num_timers]
+
+#include "condor_common.h"
+#include "condor_debug.h"
+#include "condor_daemon_core.h"
+
+#include <stdio.h>
+#include <vector>
+
+bool verbose = false;
+#define REQUIRE( condition ) \
+	if(! ( condition )) { \
+		fprintf( stderr, "Failed requirement '%s' on line %d.\n", #condition, __LINE__ ); \
+		return 1; \
+	} else if( verbose ) { \
+		fprintf( stdout, "Passed requirement '%s' on line %d.\n", #condition, __LINE__ ); \
+	}
+
+static std::vector<int> fired;
+static int next_tag = 0;
+static TimerManager * tm = NULL;
+static int added_from_handler = -1;
+
+static void record_fire() { fired.push_back(next_tag++); }
+static void count_fire() { ++next_tag; }
+static void add_timer_from_handler() {
+	fired.push_back(next_tag++);
+	added_from_handler = tm->NewTimer(0, count_fire, "added_from_handler");
+}
+
+// a handler that cancels its own timer, then cancels or resets it again
+static int self_id = -1;
+static int self_rc[2];
+static void cancel_self_twice() {
+	self_rc[0] = tm->CancelTimer(self_id);
+	self_rc[1] = tm->CancelTimer(self_id);
+}
+static void cancel_then_reset_self() {
+	self_rc[0] = tm->CancelTimer(self_id);
+	self_rc[1] = tm->ResetTimer(self_id, 0);
+}
+
+static int test_semantics()
+{
+	// timers that are due at the same time fire in the order they were created
+	fired.clear(); next_tag = 0;
+	int ids[5];
+	for (int ix = 0; ix < 5; ++ix) {
+		ids[ix] = tm->NewTimer(0, record_fire, "same_when");
+		REQUIRE( ids[ix] >= 0 );
+	}
+	// a far away timer is not fired, and a cancelled timer is not fired
+	int far = tm->NewTimer(1000, record_fire, "far");
+	REQUIRE( tm->CancelTimer(ids[2]) == 0 );
+	REQUIRE( tm->CancelTimer(ids[2]) == -1 );
+
+	int num_fired = 0;
+	int next = tm->Timeout(&num_fired);
+	REQUIRE( num_fired == 4 );
+	REQUIRE( fired.size() == 4 );
+	for (int ix = 0; ix < 4; ++ix) { REQUIRE( fired[ix] == ix ); }
+	REQUIRE( next > 900 && next <= 1000 );
+	REQUIRE( tm->GetNextRuntime(far) > time(NULL) + 900 );
+
+	// resetting the far timer to now makes it fire next time
+	REQUIRE( tm->ResetTimer(far, 0) == 0 );
+	fired.clear();
+	tm->Timeout(&num_fired);
+	REQUIRE( num_fired == 1 );
+	REQUIRE( tm->GetNextRuntime(far) == 0 ); // one-shot timers are deleted once they fire
+
+	// a periodic timer is requeued after it fires
+	int periodic = tm->NewTimer(0, count_fire, "periodic", 500);
+	tm->Timeout(&num_fired);
+	REQUIRE( num_fired == 1 );
+	REQUIRE( tm->GetNextRuntime(periodic) >= time(NULL) + 499 );
+	REQUIRE( tm->ResetTimerPeriod(periodic, 10) == 0 );
+	REQUIRE( tm->GetNextRuntime(periodic) <= time(NULL) + 10 );
+	REQUIRE( tm->CancelTimer(periodic) == 0 );
+
+	// a timer added by a handler is not fired until the next Timeout, even though it is due,
+	// and the timers behind it still fire in this one.
+	fired.clear(); next_tag = 0;
+	tm->NewTimer(0, add_timer_from_handler, "adds_timer");
+	tm->NewTimer(0, record_fire, "after_adder");
+	tm->Timeout(&num_fired);
+	REQUIRE( num_fired == 2 );
+	REQUIRE( fired.size() == 2 );
+	REQUIRE( added_from_handler >= 0 );
+	REQUIRE( tm->GetNextRuntime(added_from_handler) != 0 );
+	tm->Timeout(&num_fired);
+	REQUIRE( num_fired == 1 );
+	REQUIRE( tm->GetNextRuntime(added_from_handler) == 0 );
+
+	// once a handler cancels its own timer, the id is gone
+	self_id = tm->NewTimer(0, cancel_self_twice, "cancel_self_twice", 10);
+	tm->Timeout(&num_fired);
+	REQUIRE( num_fired == 1 );
+	REQUIRE( self_rc[0] == 0 && self_rc[1] == -1 );
+	REQUIRE( tm->GetNextRuntime(self_id) == 0 );
+
+	self_id = tm->NewTimer(0, cancel_then_reset_self, "cancel_then_reset_self", 10);
+	tm->Timeout(&num_fired);
+	REQUIRE( num_fired == 1 );
+	REQUIRE( self_rc[0] == 0 && self_rc[1] == -1 );
+	REQUIRE( tm->GetNextRuntime(self_id) == 0 );
+	REQUIRE( tm->CancelTimer(self_id) == -1 );
+
+	return 0;
+}
+
+static int bench(int num_timers)
+{
+	std::vector<int> ids(num_timers);
+	srand(42);
+
+	double dstart = _condor_debug_get_time_double();
+	for (int ix = 0; ix < num_timers; ++ix) {
+		ids[ix] = tm->NewTimer(100 + (rand() % 100000), count_fire, "bench", 0);
+	}
+	double create_time = _condor_debug_get_time_double() - dstart;
+
+	dstart = _condor_debug_get_time_double();
+	for (int ix = 0; ix < num_timers; ++ix) {
+		tm->ResetTimer(ids[ix], 100 + (rand() % 100000));
+	}
+	double reset_time = _condor_debug_get_time_double() - dstart;
+
+	// make half of them due now, and fire them
+	for (int ix = 0; ix < num_timers; ix += 2) {
+		tm->ResetTimer(ids[ix], 0);
+	}
+	next_tag = 0;
+	dstart = _condor_debug_get_time_double();
+	int num_fired = 0;
+	tm->Timeout(&num_fired);
+	double fire_time = _condor_debug_get_time_double() - dstart;
+	REQUIRE( num_fired == (num_timers + 1) / 2 );
+
+	dstart = _condor_debug_get_time_double();
+	for (int ix = 1; ix < num_timers; ix += 2) {
+		REQUIRE( tm->CancelTimer(ids[ix]) == 0 );
+	}
+	double cancel_time = _condor_debug_get_time_double() - dstart;
+
+	printf("%d timers: create %.3fs, reset %.3fs, fire %d %.3fs, cancel %d %.3fs\n",
+		num_timers, create_time, reset_time, num_fired, fire_time, num_timers / 2, cancel_time);
+	return 0;
+}
+
+int main( int argc, char ** argv ) {
+	int num_timers = 100000;
+	for (int ix = 1; ix < argc; ++ix) {
+		if (strcmp(argv[ix], "-v") == 0) { verbose = true; }
+		else { num_timers = atoi(argv[ix]); }
+	}
+
+	tm = &TimerManager::GetTimerManager();
+
+	if (test_semantics()) { return 1; }
+	tm->CancelAllTimers();
+	if (bench(num_timers)) { return 1; }
+
+	return 0;
+}
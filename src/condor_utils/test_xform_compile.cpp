@@ -0,0 +1,156 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2023, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+// Checks that a compiled MacroStreamXFormSource transforms an ad exactly the
+// way the macro stream parser does, that transforms that need the parser are
+// not compiled, and times applying a set of transforms both ways.
+//
+// usage: test_xform_compile [-v] [num_ads]
+
+#include "condor_common.h"
+#include "condor_debug.h"
+#include "condor_config.h"
+#include "condor_classad.h"
+#include "xform_utils.h"
+
+#include <stdio.h>
+#include <memory>
+#include <vector>
+
+bool verbose = false;
+#define REQUIRE( condition ) \
+	if(! ( condition )) { \
+		fprintf( stderr, "Failed requirement '%s' on line %d.\n", #condition, __LINE__ ); \
+		return 1; \
+	} else if( verbose ) { \
+		fprintf( stdout, "Passed requirement '%s' on line %d.\n", #condition, __LINE__ ); \
+	}
+
+// transforms that can be compiled
+static const char * const compilable[] = {
+	"SET Foo 1\nSET Bar = \"bar\"\nSET Sum Foo + 2\n",
+	"DEFAULT RequestMemory 1024\nDEFAULT Owner \"nobody\"\n",
+	"EVALSET Doubled RequestCpus * 2\nEVALSET Name strcat(Owner, \"@site\")\nEVALSET List { 1, RequestCpus }\n",
+	"# a comment\nCOPY Owner OrigOwner\nRENAME Cmd Executable\nDELETE JobPrio\n",
+	"COPY /^Request(.*)/ Orig\\1\nDELETE /^Disk/\n",
+	"RENAME /^Env(.*)$/ Environment\\1\n", // any $ keeps a transform from being compiled, even in a regex
+	"SET Broken = (1 +\nSET After 2\n",
+	"REQUIREMENTS Owner == \"alice\"\nSET Site \"here\"\n",
+};
+
+// transforms that need the macro stream parser
+static const char * const uncompilable[] = {
+	"tmp = 10\nSET Foo $(tmp)\n",
+	"EVALMACRO Mem RequestMemory * 2\nSET Memory $(Mem)\n",
+	"SET Foo $(MY.Owner)\n",
+	"if true\nSET Foo 1\nendif\n",
+	"SET Foo 1 + \\\n 2\n",
+};
+
+static void make_ad(ClassAd & ad, int ix)
+{
+	ad.Assign("Owner", ix & 1 ? "alice" : "bob");
+	ad.Assign("RequestCpus", 1 + (ix % 4));
+	if (ix % 3) { ad.Assign("RequestMemory", 512 * ix); }
+	ad.Assign("RequestDisk", 100);
+	ad.Assign("DiskUsage", 10);
+	ad.Assign("Cmd", "/bin/sleep");
+	ad.Assign("JobPrio", ix);
+	ad.Assign("EnvVars", "A=1");
+}
+
+static std::string unparse(ClassAd & ad)
+{
+	std::string buf;
+	classad::References attrs;
+	sGetAdAttrs(attrs, ad);
+	sPrintAdAttrs(buf, ad, attrs);
+	return buf;
+}
+
+static int open_xfm(MacroStreamXFormSource & xfm, const char * text)
+{
+	std::string errmsg;
+	int offset = 0;
+	return xfm.open(text, offset, errmsg);
+}
+
+int main( int argc, char ** argv ) {
+	int num_ads = 20000;
+	for (int ix = 1; ix < argc; ++ix) {
+		if (strcmp(argv[ix], "-v") == 0) { verbose = true; }
+		else { num_ads = atoi(argv[ix]); }
+	}
+
+	XFormHash mset;
+	mset.init();
+	MACRO_SET_CHECKPOINT_HDR * ckpt = mset.save_state();
+	std::string errmsg;
+
+	std::vector<std::unique_ptr<MacroStreamXFormSource>> parsed, compiled;
+	for (const char * text : compilable) {
+		parsed.emplace_back(new MacroStreamXFormSource("parsed"));
+		compiled.emplace_back(new MacroStreamXFormSource("compiled"));
+		REQUIRE( open_xfm(*parsed.back(), text) >= 0 );
+		REQUIRE( open_xfm(*compiled.back(), text) >= 0 );
+		bool has_dollar = strchr(text, '$') != NULL;
+		REQUIRE( compiled.back()->compile() == ! has_dollar );
+	}
+	for (const char * text : uncompilable) {
+		MacroStreamXFormSource xfm("uncompiled");
+		REQUIRE( open_xfm(xfm, text) >= 0 );
+		REQUIRE( ! xfm.compile() );
+		REQUIRE( ! xfm.is_compiled() );
+	}
+
+	// each transform gives the same ad either way
+	for (int ix = 0; ix < 16; ++ix) {
+		for (size_t jj = 0; jj < parsed.size(); ++jj) {
+			ClassAd ad1, ad2;
+			make_ad(ad1, ix);
+			make_ad(ad2, ix);
+			mset.rewind_to_state(ckpt, false);
+			REQUIRE( TransformClassAd(&ad1, *parsed[jj], mset, errmsg) == 0 );
+			mset.rewind_to_state(ckpt, false);
+			REQUIRE( TransformClassAd(&ad2, *compiled[jj], mset, errmsg) == 0 );
+			if (verbose && ix == 0) { fprintf(stdout, "%s\n", unparse(ad2).c_str()); }
+			REQUIRE( unparse(ad1) == unparse(ad2) );
+		}
+	}
+
+	// a cluster worth of ads with all of the transforms applied, both ways
+	double secs[2];
+	for (int pass = 0; pass < 2; ++pass) {
+		auto & xfms = pass ? compiled : parsed;
+		double dstart = _condor_debug_get_time_double();
+		for (int ix = 0; ix < num_ads; ++ix) {
+			ClassAd ad;
+			make_ad(ad, ix);
+			mset.rewind_to_state(ckpt, false);
+			for (auto & xfm : xfms) {
+				if (xfm->matches(&ad)) { TransformClassAd(&ad, *xfm, mset, errmsg); }
+			}
+		}
+		secs[pass] = _condor_debug_get_time_double() - dstart;
+	}
+
+	printf("%d ads x %d transforms: parsed %.3fs, compiled %.3fs\n",
+		num_ads, (int)parsed.size(), secs[0], secs[1]);
+	return 0;
+}
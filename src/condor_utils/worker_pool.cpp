@@ -0,0 +1,148 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2023, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+#include "condor_common.h"
+#include "condor_debug.h"
+#include "worker_pool.h"
+
+int WorkerPool::start(int num_threads)
+{
+	if (num_threads == size()) {
+		return size();
+	}
+	stop();
+
+	if (num_threads <= 0) {
+		return 0;
+	}
+
+	// once there are threads, dprintf must take its lock
+	dprintf_make_thread_safe();
+
+	std::unique_lock<std::mutex> guard(mtx);
+	stopping = false;
+	for (int ii = 0; ii < num_threads; ++ii) {
+		workers.emplace_back(&WorkerPool::worker_main, this);
+	}
+	return size();
+}
+
+void WorkerPool::stop()
+{
+	if (workers.empty()) {
+		return;
+	}
+	{
+		std::unique_lock<std::mutex> guard(mtx);
+		stopping = true;
+	}
+	cv.notify_all();
+	for (auto & th : workers) {
+		if (th.joinable()) th.join();
+	}
+	workers.clear();
+	stopping = false;
+}
+
+size_t WorkerPool::pending()
+{
+	std::unique_lock<std::mutex> guard(mtx);
+	return tasks.size();
+}
+
+void WorkerPool::submit(std::function<void()> task)
+{
+	if (workers.empty()) {
+		task();
+		return;
+	}
+	{
+		std::unique_lock<std::mutex> guard(mtx);
+		tasks.emplace_back(std::move(task));
+	}
+	cv.notify_one();
+}
+
+void WorkerPool::worker_main()
+{
+	for (;;) {
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> guard(mtx);
+			cv.wait(guard, [this]{ return stopping || ! tasks.empty(); });
+			if (tasks.empty()) {
+				// stopping and nothing left to do
+				return;
+			}
+			task = std::move(tasks.front());
+			tasks.pop_front();
+			++running;
+		}
+		task();
+		std::unique_lock<std::mutex> guard(mtx);
+		--running;
+	}
+}
+
+bool WorkerPool::busy()
+{
+	std::unique_lock<std::mutex> guard(mtx);
+	return running > 0 || ! tasks.empty();
+}
+
+void WorkerPool::parallel_for(size_t count, const std::function<void(size_t)> & fn)
+{
+	if ( ! count) {
+		return;
+	}
+	if (workers.empty() || count == 1) {
+		for (size_t ix = 0; ix < count; ++ix) { fn(ix); }
+		return;
+	}
+
+	// items are handed out by a shared atomic index so that a slow item
+	// does not hold up the rest of a statically assigned chunk
+	struct ForState {
+		std::atomic<size_t> next{0};
+		size_t helpers_running{0};
+		std::mutex mtx;
+		std::condition_variable done;
+	} state;
+
+	auto drain = [&state, &fn, count]() {
+		for (size_t ix = state.next++; ix < count; ix = state.next++) {
+			fn(ix);
+		}
+	};
+
+	size_t helpers = std::min(workers.size(), count - 1);
+	state.helpers_running = helpers;
+	for (size_t ii = 0; ii < helpers; ++ii) {
+		submit([&state, &drain]() {
+			drain();
+			std::unique_lock<std::mutex> guard(state.mtx);
+			if (--state.helpers_running == 0) { state.done.notify_one(); }
+		});
+	}
+
+	// the caller does its share of the work, then waits for the helpers.
+	drain();
+	std::unique_lock<std::mutex> guard(state.mtx);
+	state.done.wait(guard, [&state]{ return state.helpers_running == 0; });
+}
@@ -0,0 +1,80 @@
+/***************************************************************
+ *
+ * Copyright (C) 1990-2023, Condor Team, Computer Sciences Department,
+ * University of Wisconsin-Madison, WI.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you
+ * may not use this file except in compliance with the License.  You may
+ * obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ ***************************************************************/
+
+#ifndef _CONDOR_WORKER_POOL_H
+#define _CONDOR_WORKER_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A small fixed size pool of real OS threads for CPU bound work that the
+// caller has made thread safe.  Unlike CondorThreads, the workers do NOT
+// hold the daemon-core big lock, so the work handed to the pool must not
+// touch daemon-core, the param table or any other main-thread only state.
+//
+// There are two ways to use the pool
+//   * parallel_for() runs fn(ix) for every ix in [0,count) and does not return
+//     until all of them have completed. the calling thread helps with the work.
+//   * submit() queues a single task to be run asynchronously, the caller is
+//     responsible for noticing when the task is done.
+//
+// A pool of size 0 is valid, in which case parallel_for runs serially on
+// the calling thread and submit runs the task inline.
+//
+class WorkerPool
+{
+public:
+	WorkerPool() = default;
+	~WorkerPool() { stop(); }
+
+	WorkerPool(const WorkerPool &) = delete;
+	WorkerPool & operator=(const WorkerPool &) = delete;
+
+	// start (or restart) the pool with the given number of worker threads.
+	// returns the number of workers actually running
+	int start(int num_threads);
+	// wait for queued tasks to finish and then join all of the workers
+	void stop();
+	int size() const { return (int)workers.size(); }
+
+	void parallel_for(size_t count, const std::function<void(size_t)> & fn);
+	void submit(std::function<void()> task);
+
+	// number of tasks queued but not yet started
+	size_t pending();
+	// true if there are tasks queued or running
+	bool busy();
+
+private:
+	void worker_main();
+
+	std::vector<std::thread> workers;
+	std::deque<std::function<void()>> tasks;
+	std::mutex mtx;
+	std::condition_variable cv;
+	size_t running{0}; // tasks started but not yet finished
+	bool stopping{false};
+};
+
+#endif // _CONDOR_WORKER_POOL_H
@@ -723,6 +723,21 @@ static const char * is_non_trivial_iterate(const char * is_transform)
 	return iter_args;
 }
 
+// A single transform statement, pre-parsed by MacroStreamXFormSource::compile()
+// or parsed on the fly by ParseRulesCallback.
+struct XFormRule {
+	struct pcre2_free { void operator()(pcre2_code * re) const { pcre2_code_free(re); } };
+
+	int kw{0};                 // one of the kw_ values below
+	std::string attr;          // the first argument, usually an attribute name
+	bool attr_is_regex{false}; // the first argument is a regex rather than an attribute name
+	uint32_t regex_flags{0};
+	bool has_rhs{false};       // there was something after the first argument
+	std::string rhs;           // the remainder of the statement (set by compile only)
+	std::unique_ptr<pcre2_code, pcre2_free> re;     // compiled regex, for COPY, RENAME and DELETE
+	std::unique_ptr<classad::ExprTree> expr;        // parsed rhs, for SET, DEFAULT and EVALSET
+};
+
 MacroStreamXFormSource::MacroStreamXFormSource(const char *nam)
 	: MacroStreamCharSource()
 	, requirements(), universe(0), checkpoint(NULL)
@@ -732,6 +747,7 @@ MacroStreamXFormSource::MacroStreamXFormSource(const char *nam)
 	, iterate_init_state(0)
 	, iterate_args(NULL)
 	, curr_item(NULL)
+	, compiled(false)
 {
 	if (nam) name = nam;
 	ctx.init("XFORM");
@@ -750,6 +766,8 @@ int MacroStreamXFormSource::setUniverse(const char * uni) {
 
 int MacroStreamXFormSource::open(StringList & lines, const MACRO_SOURCE & FileSource, std::string & errmsg)
 {
+	compiled = false;
+	rules.clear();
 	for (const char *line = lines.first(); line; line = lines.next()) {
 		const char * p;
 		if (NULL != (p = is_xform_statement(line, "name"))) {
@@ -790,6 +808,9 @@ int MacroStreamXFormSource::open(StringList & lines, const MACRO_SOURCE & FileSo
 // that has no iteration/transform statements
 int MacroStreamXFormSource::open(const char * statements_in, int & offset, std::string & errmsg)
 {
+	compiled = false;
+	rules.clear();
+
 	const char * statements = statements_in + offset;
 	size_t cb = strlen(statements);
 	char * buf = (char*)malloc(cb + 2);
@@ -1480,16 +1501,17 @@ static ExprTree * XFormCopyValueToTree(classad::Value & val)
 	return tree;
 }
 
-static int ValidateRulesCallback(void* /*pv*/, MACRO_SOURCE& /*source*/, MACRO_SET& /*mset*/, char * line, std::string & errmsg)
+// parse the keyword and first argument of a transform statement into rule,
+// and set rhs to point to the remainder of the line, or NULL if there is none.
+// returns 0 if the statement should be applied, 1 if it should be ignored and < 0 if it is invalid
+static int ParseRuleStatement(const char * line, XFormRule & rule, const char * & rhs, std::string & errmsg)
 {
-	//struct _parse_rules_args * pargs = (struct _parse_rules_args*)pv;
-	//XFormHash & mset = pargs->mset;
-	//MacroStreamXFormSource & xform = pargs->xfm;
+	rhs = NULL;
 
 	// give the line to our tokener so we can parse it.
 	tokener toke(line);
-	if ( ! toke.next()) return 0; // keep scanning
-	if (toke.matches("#")) return 0; // not expecting this, but in case...
+	if ( ! toke.next()) return 1; // keep scanning
+	if (toke.matches("#")) return 1; // not expecting this, but in case...
 
 	// get keyword
 	const Keyword * pkw = ActionKeywords.lookup_token(toke);
@@ -1499,82 +1521,23 @@ static int ValidateRulesCallback(void* /*pv*/, MACRO_SOURCE& /*source*/, MACRO_S
 		return -1;
 	}
 	// there must be something after the keyword
-	if ( ! toke.next()) { return (pkw->value == kw_TRANSFORM) ? 0 : -1; }
+	if ( ! toke.next()) { return (pkw->value == kw_TRANSFORM) ? 1 : -1; }
+	rule.kw = pkw->value;
 
 	toke.mark_after(); // in case we want to capture the remainder of the line.
 
 	// the first argument will always be an attribute name
 	// in some cases, that attribute name is is allowed to be a regex,
 	// if it is a regex it will begin with a /
-	std::string attr;
-	uint32_t regex_flags = 0;
 	if ((pkw->options & kw_opt_regex) && toke.is_regex()) {
-		std::string opts;
-		if ( ! toke.copy_regex(attr, regex_flags)) {
+		rule.attr_is_regex = true;
+		if ( ! toke.copy_regex(rule.attr, rule.regex_flags)) {
 			errmsg = "invalid regex";
 			return -1;
 		}
-		regex_flags |= PCRE2_CASELESS;
-	} else {
-		toke.copy_token(attr);
-		// if attr ends with , or =, just strip those off. the tokener only splits on whitespace, not other characters
-		if (attr.size() > 0 && (attr[attr.size()-1] == ',' || attr[attr.size()-1] == '=')) { attr[attr.size()-1] = 0; }
-	}
-
-	return 0; // line is valid, keep scanning.
-}
-
-// this gets called while parsing the submit file to process lines
-// that don't look like valid key=value pairs.  
-// return 0 to keep scanning the file, ! 0 to stop scanning. non-zero return values will
-// be passed back out of Parse_macros
-//
-static int ParseRulesCallback(void* pv, MACRO_SOURCE& source, MACRO_SET& /*mset*/, char * line, std::string & errmsg)
-{
-	struct _parse_rules_args * pargs = (struct _parse_rules_args*)pv;
-	void (*log)(struct _parse_rules_args & args, bool is_error, const char * fn, ...) = pargs->fnlog;
-	const bool log_steps = log && ((pargs->options & XFORM_UTILS_LOG_STEPS) != 0);
-	//const bool is_tool = (pargs->options & 1) != 0;
-	ClassAd * ad = pargs->ad;
-	XFormHash & mset = pargs->mset;
-	MacroStreamXFormSource & xform = pargs->xfm;
-
-	classad::ClassAdParser parser;
-	parser.SetOldClassAd(true);
-	std::string tmp3;
-
-	// give the line to our tokener so we can parse it.
-	tokener toke(line);
-	if ( ! toke.next()) return 0; // keep scanning
-	if (toke.matches("#")) return 0; // not expecting this, but in case...
-
-	// get keyword
-	const Keyword * pkw = ActionKeywords.lookup_token(toke);
-	if ( ! pkw) {
-		std::string tok; toke.copy_token(tok);
-		formatstr(errmsg, "%s is not a valid transform keyword\n", tok.c_str());
-		return -1;
-	}
-	// there must be something after the keyword
-	if ( ! toke.next()) { return (pkw->value == kw_TRANSFORM) ? 0 : -1; }
-
-	toke.mark_after(); // in case we want to capture the remainder of the line.
-
-	// the first argument will always be an attribute name
-	// in some cases, that attribute name is is allowed to be a regex,
-	// if it is a regex it will begin with a /
-	std::string attr;
-	bool attr_is_regex = false;
-	uint32_t regex_flags = 0;
-	if ((pkw->options & kw_opt_regex) && toke.is_regex()) {
-		std::string opts;
-		attr_is_regex = true;
-		if ( ! toke.copy_regex(attr, regex_flags)) {
-			errmsg = "invalid regex";
-			return -1;
-		}
-		regex_flags |= PCRE2_CASELESS;
+		rule.regex_flags |= PCRE2_CASELESS;
 	} else {
+		std::string & attr = rule.attr;
 		toke.copy_token(attr);
 		// if attr ends with , or =, just strip those off. the tokener only splits on whitespace, not other characters
 		if (attr.size() > 0 && (attr[attr.size()-1] == ',' || attr[attr.size()-1] == '=')) { attr[attr.size()-1] = 0; }
@@ -1588,43 +1551,70 @@ static int ParseRulesCallback(void* pv, MACRO_SOURCE& source, MACRO_SET& /*mset*
 		}
 	}
 
-	// if there is a remainder of the line, macro expand it.
+	// if there is a remainder of the line, return a pointer to it
 	size_t off = toke.offset(); // current pointer
-	auto_free_ptr rhs(NULL);
 	if (off > 0) {
 		if (toke.is_quoted_string()) --off;
-		rhs.set(mset.expand_macro(line + off, xform.context()));
+		rhs = line + off;
+		rule.has_rhs = true;
 	}
+	return 0;
+}
 
-	// at this point
-	// pkw   identifies the keyword
-	// attr  contains the first word after the keyword, thisis usually an attribute name
-	// rhs   has the macro-expanded remainder of the line
+static int ValidateRulesCallback(void* /*pv*/, MACRO_SOURCE& /*source*/, MACRO_SET& /*mset*/, char * line, std::string & errmsg)
+{
+	//struct _parse_rules_args * pargs = (struct _parse_rules_args*)pv;
+	//XFormHash & mset = pargs->mset;
+	//MacroStreamXFormSource & xform = pargs->xfm;
 
-	//std::string expr_string;
-	//if ( ! toke.at_end()) { toke.copy_to_end(expr_string); }
+	XFormRule rule;
+	const char * rhs = NULL;
+	if (ParseRuleStatement(line, rule, rhs, errmsg) < 0) {
+		return -1;
+	}
+	return 0; // line is valid, keep scanning.
+}
 
-	switch (pkw->value) {
+// apply a single parsed transform statement to the ad.
+// rhs is the macro-expanded remainder of the statement, if the rule was compiled
+// the rhs expression and attribute regex will already have been parsed.
+static void ApplyRule(const XFormRule & rule, const char * rhs, MACRO_SOURCE& source, struct _parse_rules_args * pargs)
+{
+	void (*log)(struct _parse_rules_args & args, bool is_error, const char * fn, ...) = pargs->fnlog;
+	const bool log_steps = log && ((pargs->options & XFORM_UTILS_LOG_STEPS) != 0);
+	ClassAd * ad = pargs->ad;
+	XFormHash & mset = pargs->mset;
+	MacroStreamXFormSource & xform = pargs->xfm;
+	const std::string & attr = rule.attr;
+
+	std::string tmp3;
+
+	// at this point
+	// rule.kw   identifies the keyword
+	// attr      contains the first word after the keyword, thisis usually an attribute name
+	// rhs       has the macro-expanded remainder of the line
+
+	switch (rule.kw) {
 	// these keywords are envelope information
 	case kw_NAME:
-		if (log_steps) log(*pargs, false, "NAME %s\n", rhs.ptr());
+		if (log_steps) log(*pargs, false, "NAME %s\n", rhs);
 		break;
 	case kw_UNIVERSE:
 		if (log_steps) log(*pargs, false, "UNIVERSE %d\n", CondorUniverseNumberEx(attr.c_str()));
 		break;
 	case kw_REQUIREMENTS:
-		if (log_steps) log(*pargs, false, "REQUIREMENTS %s\n", rhs.ptr());
+		if (log_steps) log(*pargs, false, "REQUIREMENTS %s\n", rhs);
 		break;
 
 		// evaluate an expression, then set a value into the ad.
 	case kw_EVALMACRO:
-		if (log_steps) log(*pargs, false, "EVALMACRO %s to %s\n", attr.c_str(), rhs.ptr());
+		if (log_steps) log(*pargs, false, "EVALMACRO %s to %s\n", attr.c_str(), rhs);
 		if ( ! rhs) {
 			if (log) log(*pargs, true, "ERROR: EVALMACRO %s has no value", attr.c_str());
 		} else {
 			classad::Value val;
-			if ( ! ad->EvaluateExpr(rhs.ptr(), val)) {
-				if (log) log(*pargs, true, "ERROR: EVALMACRO %s could not evaluate : %s\n", attr.c_str(), rhs.ptr());
+			if ( ! ad->EvaluateExpr(rhs, val)) {
+				if (log) log(*pargs, true, "ERROR: EVALMACRO %s could not evaluate : %s\n", attr.c_str(), rhs);
 			} else {
 				XFormValueToString(val, tmp3);
 				insert_macro(attr.c_str(), tmp3.c_str(), mset.macros(), source, xform.context());
@@ -1653,23 +1643,32 @@ static int ParseRulesCallback(void* pv, MACRO_SOURCE& source, MACRO_SET& /*mset*
 
 	// these keywords manipulate the ad
 	case kw_DEFAULT:
-		if (log_steps) log(*pargs, false, "DEFAULT %s to %s\n", attr.c_str(), rhs.ptr());
+		if (log_steps) log(*pargs, false, "DEFAULT %s to %s\n", attr.c_str(), rhs);
 		if (ad->Lookup(attr) != NULL) {
 			// this attribute already has a value.
 			break;
 		}
 		// fall through
 	case kw_SET:
-		if (log_steps) log(*pargs, false, "SET %s to %s\n", attr.c_str(), rhs.ptr());
+		if (log_steps) log(*pargs, false, "SET %s to %s\n", attr.c_str(), rhs);
 		if ( ! rhs) {
 			if (log) log(*pargs, true, "ERROR: SET %s has no value", attr.c_str());
 		} else {
 			ExprTree * expr = NULL;
-			if ( ! parser.ParseExpression(rhs.ptr(), expr, true)) {
-				if (log) log(*pargs, true, "ERROR: SET %s invalid expression : %s\n", attr.c_str(), rhs.ptr());
+			if (rule.expr) {
+				expr = rule.expr->Copy();
+			} else {
+				classad::ClassAdParser parser;
+				parser.SetOldClassAd(true);
+				if ( ! parser.ParseExpression(rhs, expr, true)) {
+					expr = NULL;
+				}
+			}
+			if ( ! expr) {
+				if (log) log(*pargs, true, "ERROR: SET %s invalid expression : %s\n", attr.c_str(), rhs);
 			} else {
 				if ( ! ad->Insert(attr, expr)) {
-					if (log) log(*pargs, true, "ERROR: could not set %s to %s\n", attr.c_str(), rhs.ptr());
+					if (log) log(*pargs, true, "ERROR: could not set %s to %s\n", attr.c_str(), rhs);
 					delete expr;
 				}
 			}
@@ -1677,13 +1676,14 @@ static int ParseRulesCallback(void* pv, MACRO_SOURCE& source, MACRO_SET& /*mset*
 		break;
 
 	case kw_EVALSET:
-		if (log_steps) log(*pargs, false, "EVALSET %s to %s\n", attr.c_str(), rhs.ptr());
+		if (log_steps) log(*pargs, false, "EVALSET %s to %s\n", attr.c_str(), rhs);
 		if ( ! rhs) {
 			if (log) log(*pargs, true, "ERROR: EVALSET %s has no value", attr.c_str());
 		} else {
 			classad::Value val;
-			if ( ! ad->EvaluateExpr(rhs.ptr(), val)) {
-				if (log) log(*pargs, true, "ERROR: EVALSET %s could not evaluate : %s\n", attr.c_str(), rhs.ptr());
+			bool evaluated = rule.expr ? ad->EvaluateExpr(rule.expr.get(), val) : ad->EvaluateExpr(rhs, val);
+			if ( ! evaluated) {
+				if (log) log(*pargs, true, "ERROR: EVALSET %s could not evaluate : %s\n", attr.c_str(), rhs);
 			} else {
 				ExprTree * tree = XFormCopyValueToTree(val);
 				if ( ! ad->Insert(attr, tree)) {
@@ -1699,29 +1699,142 @@ static int ParseRulesCallback(void* pv, MACRO_SOURCE& source, MACRO_SET& /*mset*
 	case kw_DELETE:
 	case kw_RENAME:
 	case kw_COPY:
-		if (attr_is_regex) {
-			int errorcode;
-			PCRE2_SIZE erroffset;
-			PCRE2_SPTR attr_pcre2str = reinterpret_cast<const unsigned char *>(attr.c_str());
-			pcre2_code * re = pcre2_compile(attr_pcre2str, PCRE2_ZERO_TERMINATED, regex_flags, &errorcode, &erroffset, NULL);
-			if (! re) {
-				if (log) log(*pargs, true, "ERROR: Error compiling regex '%s'. %d. this entry will be ignored.\n", attr.c_str(), errorcode);
-			} else {
-				DoRegexAttrOp(pkw->value, ad, re, regex_flags, rhs.ptr(), pargs);
-				pcre2_code_free(re);
+		if (rule.attr_is_regex) {
+			pcre2_code * re = rule.re.get();
+			if ( ! re) {
+				int errorcode;
+				PCRE2_SIZE erroffset;
+				PCRE2_SPTR attr_pcre2str = reinterpret_cast<const unsigned char *>(attr.c_str());
+				re = pcre2_compile(attr_pcre2str, PCRE2_ZERO_TERMINATED, rule.regex_flags, &errorcode, &erroffset, NULL);
+				if (! re) {
+					if (log) log(*pargs, true, "ERROR: Error compiling regex '%s'. %d. this entry will be ignored.\n", attr.c_str(), errorcode);
+					break;
+				}
 			}
+			DoRegexAttrOp(rule.kw, ad, re, rule.regex_flags, rhs, pargs);
+			if (re != rule.re.get()) { pcre2_code_free(re); }
 		} else {
-			switch (pkw->value) {
+			switch (rule.kw) {
 				case kw_DELETE: DoDeleteAttr(ad, attr, pargs); break;
-				case kw_RENAME: DoRenameAttr(ad, attr, rhs.ptr(), pargs); break;
-				case kw_COPY:   DoCopyAttr(ad, attr, rhs.ptr(), pargs); break;
+				case kw_RENAME: DoRenameAttr(ad, attr, rhs, pargs); break;
+				case kw_COPY:   DoCopyAttr(ad, attr, rhs, pargs); break;
 			}
 		}
 	}
+}
+
+// this gets called while parsing the submit file to process lines
+// that don't look like valid key=value pairs.  
+// return 0 to keep scanning the file, ! 0 to stop scanning. non-zero return values will
+// be passed back out of Parse_macros
+//
+static int ParseRulesCallback(void* pv, MACRO_SOURCE& source, MACRO_SET& /*mset*/, char * line, std::string & errmsg)
+{
+	struct _parse_rules_args * pargs = (struct _parse_rules_args*)pv;
+	//const bool is_tool = (pargs->options & 1) != 0;
 
+	XFormRule rule;
+	const char * remainder = NULL;
+	int rval = ParseRuleStatement(line, rule, remainder, errmsg);
+	if (rval) {
+		return (rval < 0) ? -1 : 0;
+	}
+
+	// if there is a remainder of the line, macro expand it.
+	auto_free_ptr rhs(NULL);
+	if (remainder) {
+		rhs.set(pargs->mset.expand_macro(remainder, pargs->xfm.context()));
+	}
+
+	ApplyRule(rule, rhs.ptr(), source, pargs);
 	return 0; // line handled, keep scanning.
 }
 
+bool MacroStreamXFormSource::compile()
+{
+	compiled = false;
+	rules.clear();
+
+	// iterating transforms need the macro stream parser to set the iteration variables
+	if (iterate_args || fp_iter) {
+		return false;
+	}
+
+	std::string errmsg;
+	StringTokenIterator lines(file_string.ptr() ? file_string.ptr() : "", 128, "\n");
+	for (const char * line = lines.first(); line; line = lines.next()) {
+		std::string buf(line);
+		trim(buf);
+		if (buf.empty() || buf[0] == '#') {
+			continue;
+		}
+		// statements that refer to macros need to be expanded for each ad, and continued lines
+		// are joined by the macro stream parser, so leave those to TransformClassAd to parse
+		if (buf.find('$') != std::string::npos || buf.back() == '\\') {
+			rules.clear();
+			return false;
+		}
+		// the macro stream parser only hands a line to the transform parser when the first word is
+		// followed by another word that is not an assignment operator.  anything else is a macro
+		// assignment or an if/include statement.
+		size_t ixsp = buf.find_first_of(" \t");
+		if (ixsp == std::string::npos || buf.find_first_of("=:@") < ixsp) {
+			rules.clear();
+			return false;
+		}
+		size_t ixarg = buf.find_first_not_of(" \t", ixsp);
+		if (strchr("=:@", buf[ixarg])) {
+			rules.clear();
+			return false;
+		}
+
+		XFormRule rule;
+		const char * rhs = NULL;
+		int rval = ParseRuleStatement(buf.c_str(), rule, rhs, errmsg);
+		if (rval > 0) continue;
+		// EVALMACRO sets a temporary variable, which is only useful to the macro stream parser
+		if (rval < 0 || rule.kw == kw_EVALMACRO) {
+			rules.clear();
+			return false;
+		}
+		if (rhs) { rule.rhs = rhs; }
+
+		switch (rule.kw) {
+		case kw_SET:
+		case kw_DEFAULT:
+			if (rhs) {
+				classad::ClassAdParser parser;
+				parser.SetOldClassAd(true);
+				classad::ExprTree * tree = NULL;
+				if (parser.ParseExpression(rule.rhs, tree, true)) { rule.expr.reset(tree); }
+			}
+			break;
+		case kw_EVALSET:
+			if (rhs) {
+				// parse the same way that ClassAd::EvaluateExpr does
+				classad::ClassAdParser parser;
+				classad::ExprTree * tree = NULL;
+				if (parser.ParseExpression(rule.rhs, tree)) { rule.expr.reset(tree); }
+			}
+			break;
+		case kw_DELETE:
+		case kw_RENAME:
+		case kw_COPY:
+			if (rule.attr_is_regex) {
+				int errorcode;
+				PCRE2_SIZE erroffset;
+				PCRE2_SPTR attr_pcre2str = reinterpret_cast<const unsigned char *>(rule.attr.c_str());
+				rule.re.reset(pcre2_compile(attr_pcre2str, PCRE2_ZERO_TERMINATED, rule.regex_flags, &errorcode, &erroffset, NULL));
+			}
+			break;
+		}
+		rules.push_back(std::move(rule));
+	}
+
+	compiled = true;
+	return true;
+}
+
 static void ParseRulesStdLog(struct _parse_rules_args & ra, bool is_error, const char * fmt, ...)
 {
 	va_list args;
@@ -1767,6 +1880,14 @@ int TransformClassAd (
 		}
 	}
 
+	// compiled rules were parsed once when the transform was loaded, so just apply them
+	if (xfm.is_compiled()) {
+		for (const auto & rule : xfm.compiledRules()) {
+			ApplyRule(rule, rule.has_rhs ? rule.rhs.c_str() : NULL, xfm.source(), &args);
+		}
+		return 0;
+	}
+
 	xfm.rewind();
 	int rval = Parse_macros(xfm, 0, mset.macros(), READ_MACROS_SUBMIT_SYNTAX, &ctx, errmsg, ParseRulesCallback, &args);
 	if (rval) {
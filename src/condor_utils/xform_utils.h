@@ -24,6 +24,7 @@
 
 class MacroStreamXFormSource;
 class XFormHash;
+struct XFormRule;
 
 // in-place transform of a single ad 
 // using the transform rules in xfm,
@@ -98,6 +99,14 @@ public:
 
 	bool matches(ClassAd * candidate_ad);
 
+	// pre-parse the statements into a list of rules that TransformClassAd can apply
+	// without going through the macro stream parser for each ad.  returns false and
+	// leaves the source uncompiled when the statements use macros, temporary variables or
+	// iteration, since those need the macro stream parser to have the correct meaning.
+	bool compile();
+	bool is_compiled() const { return compiled; }
+	const std::vector<XFormRule> & compiledRules() const { return rules; }
+
 	const char * getName() { return name.c_str(); }
 	const char * setName(const char * nam) { name = nam; return getName(); }
 	int getUniverse() const { return universe; }
@@ -145,6 +154,10 @@ protected:
 	auto_free_ptr iterate_args; // copy of the arguments from the ITERATE line, set by load()
 	auto_free_ptr curr_item; // so we can destructively edit the current item from the items list
 
+	// set by compile()
+	bool compiled;
+	std::vector<XFormRule> rules;
+
 	int set_iter_item(XFormHash &mset, const char* item);
 	int init_iterator(XFormHash &mset, std::string & errmsg);
 	//int report_empty_items(XFormHash& mset, std::string errmsg);